@@ -2,6 +2,7 @@
 #define CONFIG_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 // ===================== XCASH Version =====================
 #define XCASH_DPOPS_CURRENT_VERSION "xCash Labs DPoPs V. 2.0.0"
@@ -11,7 +12,10 @@
 // ===================== Blockchain Settings =====================
 #define XCASH_WALLET_PREFIX "XCK" // The prefix of a XCK address
 #define XCASH_SIGN_DATA_PREFIX "SigV2"
+#define XCASH_SIGN_DATA_PREFIX_V1 "SigV1"
+#define XCASH_MESSAGE_SIGNING_DOMAIN "MoneroMessageSignature" // hash key of SigV2 message hashes (signed with its NUL)
 #define XCASH_PROOF_OF_STAKE_BLOCK_HEIGHT 1
+#define DELEGATES_HASH_V2_HEIGHT UINT64_MAX // First block height whose VRF_DATA carries the SHA-256 sum delegates hash; below it the MD5 hash is sent and both are accepted. Lower to the agreed fork height once every verifier runs a release that accepts both
 #define CRYPTONOTE_DISPLAY_DECIMAL_POINT 6
 #define XCASH_ATOMIC_UNITS 1000000ULL  // 1 XCASH = 1,000,000 atomic units
 #define MAX_SIBLINGS 15
@@ -29,9 +33,58 @@
 #define CONNECT_TIMEOUT_SEC 4
 #define RECEIVE_TIMEOUT_SEC 5
 #define SEND_TIMEOUT_MS 4000
-#define NET_MULTI_WORKERS 12
 #define CONNECT_RETRY_COUNT 2   /* total attempts per addr: 2 = one retry */
 #define CONNECT_RETRY_JITTER_MS 120
+#define NET_SERVER_CONSENSUS_WORKERS 4 /* workers reserved for VRF / vote / block verify messages */
+#define NET_SERVER_SYNC_WORKERS 4      /* workers for node-to-node sync traffic (also take consensus) */
+#define NET_SERVER_PUBLIC_WORKERS 8    /* workers for wallet-facing messages (also take the above) */
+#define NET_SERVER_QUEUE_MAX 1024      /* messages waiting per dispatch class before new ones are shed */
+#define NET_SERVER_QUEUE_MAX_BYTES (64 * 1024 * 1024) /* compressed bytes held by one class's waiting and running jobs */
+#define NET_SERVER_PEER_MAX_JOBS 16    /* waiting and running jobs per peer IP */
+#define NET_SERVER_PEER_CONSENSUS_RESERVE 4 /* of those, slots only consensus messages may use */
+#define NET_SERVER_PEEK_BYTES 256      /* message prefix inflated by the reactor to read message_settings */
+#define NET_DISPATCH_WAIT_WARN_MS 1000 /* consensus queue wait that is logged as a warning */
+#define NET_SERVER_MAX_EVENTS 256      /* epoll_wait batch size */
+#define NET_SERVER_SWEEP_MS 1000       /* idle connection sweep interval */
+#define NET_FRAME_MAGIC 0x02           /* first byte of a length-prefixed DPoPS frame */
+#define NET_FRAME_HEADER_SIZE 5        /* magic + 4-byte big-endian body length */
+#define NET_MAX_FRAME_SIZE (16 * 1024 * 1024)  /* largest inbound frame body accepted */
+#define NET_SERVER_RBUF_KEEP 65536     /* read buffers above this are released once drained */
+#define NET_SERVER_PEER_IDLE_SEC 120   /* idle limit for connections that have sent framed (DPoPS) data */
+#define NET_POOL_MAX_ENTRIES 128       /* pooled outbound connections (host, port) */
+#define NET_POOL_IDLE_MS 90000         /* pooled connections idle longer than this are closed; < server peer idle */
+#define NET_MULTI_PACE_BURST 8         /* DPoPS sends started per pacing tick */
+#define NET_MULTI_PACE_MS 2            /* pacing tick between DPoPS send bursts */
+#define NET_MULTI_MAX_EVENTS 128       /* epoll_wait batch size of the outbound I/O thread */
+#define NET_MULTI_RESOLVE_THREADS 4    /* threads resolving outbound host names the DNS cache missed */
+#define NET_QUORUM_BROADCAST_TIMEOUT_MS 3000 /* longest Part 4 waits for a majority to accept the VRF data */
+#define NET_SCORE_MAX_ENTRIES 256      /* outbound hosts tracked for RTT and failures */
+#define NET_CONNECT_TIMEOUT_MIN_MS 750 /* floor for the RTT-derived connect timeout */
+#define NET_BREAKER_FAIL_ROUNDS 3      /* consecutive rounds with a failed send before a host is skipped */
+#define NET_BREAKER_PROBE_MS 15000     /* connect probe interval for skipped hosts */
+#define DNS_CACHE_MAX_ENTRIES 512      /* cached (hostname, family) lookups */
+#define DNS_CACHE_MAX_ADDRS 8          /* addresses kept per cached hostname */
+#define DNS_CACHE_TTL_SEC 300          /* lifetime of a successful lookup */
+#define DNS_CACHE_NEG_TTL_SEC 30       /* lifetime of a definitive failure (no such name); temporary ones are not cached */
+#define DNS_CACHE_REFRESH_PCT 80       /* entries used past this share of their TTL are refreshed in the background */
+#define JSON_SCAN_MAX_DEPTH 32         /* nesting limit of the one-pass RPC response scanner */
+#define HTTP_STATS_MAX_ENDPOINTS 32    /* distinct RPC endpoints (port, url, method) with latency counters */
+#define HTTP_STATS_ENDPOINT_LENGTH 96  /* "port url method" label of an RPC endpoint */
+#define SIGNATURE_CACHE_SHARDS 16      /* independently locked shards of the verified-signature cache */
+#define SIGNATURE_CACHE_SHARD_ENTRIES 256 /* entries per shard */
+#define SIGNATURE_CACHE_WAYS 4         /* entries probed per lookup; the oldest of them is replaced on insert */
+#define SIGNATURE_CACHE_TTL_SEC 600    /* lifetime of a verified signature that is not bound to a round */
+#define RESERVE_PROOF_VERIFIERS 4      /* concurrent wallet check_reserve_proof calls during the reserve_proofs scan */
+#define RESERVE_PROOF_QUEUE_DEPTH 256  /* proofs read ahead of the verifiers */
+#define RESERVE_PROOF_CURSOR_BATCH 100 /* reserve_proofs documents fetched per cursor round trip */
+#define RESERVE_PROOF_PROGRESS_SEC 30  /* interval of the scan progress line */
+#define RESERVE_PROOF_RECHECK_SLICES 32 /* each scan re-checks one slice of the unchanged proofs */
+#define RESERVE_PROOF_MAX_AGE_BLOCKS 10080 /* proofs not re-proven for this many blocks are always re-checked */
+#define DELEGATES_REGISTRY_WATCH_AWAIT_MS 1000 /* longest a delegates change stream poll blocks (bounds shutdown) */
+#define DELEGATES_REGISTRY_WATCH_RETRY_SEC 5   /* pause before reopening a failed delegates change stream */
+#define DELEGATES_MERKLE_FANOUT 8              /* children per node of the delegates sync tree (two levels, FANOUT^2 leaves) */
+#define DB_BULK_BATCH_SIZE 1000               /* writes sent per bulk round trip when a caller does not choose */
+#define DB_BULK_MAX_ERRORS 32                 /* per-item bulk write errors kept for the caller */
 
 // ===================== Network Block String =====================
 #define EXTRA_NONCE_TAG "02"
@@ -69,10 +122,12 @@
 #define VRF_BETA_LENGTH 128
 #define VRF_BETA_BYTES (VRF_BETA_LENGTH / 2)
 #define SHA256_HASH_SIZE 32
+#define MD5_HASH_SIZE 16
 #define SHA256_DIGEST_SIZE 64
 #define DB_HASH_SIZE 128
 #define BLOCK_HEIGHT_LENGTH 32
 #define SIGNATURE_BIN_LEN 64
+#define XCASH_KEY_LENGTH 32
 #define SYNC_TOKEN_LEN 32
 #define VOTE_HASH_LEN 64
 
@@ -81,6 +136,8 @@
 #define DATABASE_NAME "XCASH_PROOF_OF_STAKE"
 #define DB_COLLECTION_DELEGATES "delegates"
 #define DB_COLLECTION_RESERVE_PROOFS "reserve_proofs"
+#define DB_COLLECTION_RESERVE_PROOF_LEDGER "reserve_proofs_ledger"
+#define DB_COLLECTION_DELEGATES_DIGEST "delegates_digest"
 #define DB_COLLECTION_STATISTICS "statistics"
 #define DB_COLLECTION_ROUNDS "consensus_rounds"
 #define DB_COLLECTION_BLOCKS_FOUND "blocks_found"
@@ -109,6 +166,7 @@
 
 // ===================== XCASH LABS DPOPS =====================
 #define BLOCK_VERIFIERS_TOTAL_AMOUNT 55
+#define VRF_DATA_BATCH_MAX (BLOCK_VERIFIERS_TOTAL_AMOUNT * 2) // VRF_DATA proofs queued per round for batch verification
 #define BLOCK_VERIFIERS_AMOUNT 50
 #define BLOCK_VERIFIERS_SETTINGS 3
 #define VOTE_PARAMETER_AMOUNT 5
@@ -145,8 +203,6 @@
 #define MAJORITY_PERCENT 70
 #define SEED_REGISTRATION_TIME_UTC 1756684860ULL  // 2025-09-01 00:01:00 UTC
 
-#define MAX_ACTIVE_CLIENTS 200
-
 #define WAKEUP_SKEW_SEC 10 
 
 #define CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW 60
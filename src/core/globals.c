@@ -12,6 +12,8 @@ double delegate_fee_percent = 5.0;
 uint64_t minimum_payout = 5000;
 bool startup_complete = false;
 bool is_seed_node = false;
+bool signature_wallet_check = false;
+bool framed_messages = false;
 int network_data_nodes_amount = 0;
 delegates_t delegates_all[BLOCK_VERIFIERS_TOTAL_AMOUNT] = {0};
 delegates_timer_t delegates_timer_all[BLOCK_VERIFIERS_TOTAL_AMOUNT] = {0};
@@ -23,7 +25,8 @@ unsigned char secret_key_data[crypto_vrf_SECRETKEYBYTES] = {0};
 char secret_key[VRF_SECRET_KEY_LENGTH +1] = {0};
 char vrf_public_key[VRF_PUBLIC_KEY_LENGTH + 1] = {0};
 char current_round_part[3] = "1";
-char delegates_hash[SHA256_HASH_SIZE + 1] = {0};
+char delegates_hash[(SHA256_HASH_SIZE * 2) + 1] = {0};
+char delegates_hash_md5[(MD5_HASH_SIZE * 2) + 1] = {0};
 char delegate_ip_address[IP_LENGTH+1] = {0};
 
 pthread_mutex_t delegates_all_lock = PTHREAD_MUTEX_INITIALIZER;
@@ -38,6 +41,7 @@ atomic_bool wait_for_vrf_message       = ATOMIC_VAR_INIT(true);
 atomic_bool shutdown_requested         = ATOMIC_VAR_INIT(false);
 
 block_verifiers_list_t current_block_verifiers_list;
+uint32_t current_block_verifiers_generation = 0;
 NetworkNode network_nodes[] = {
     {"XCK1gUSXCuV4KANQz78YYFQuxeGzPwUtzToqnNGXwjFgjULzWQiYbdC9iJRPiLDqn1ijo9HpfXsDzSRjgKZAwK7x2fTAQZBLXF", "seeds.xcashseeds.us",
       "5b4a41a7018baf13484a1ecee2c8d166d9dca7ea5e570df9303a58f7d544ee15",0},
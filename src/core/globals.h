@@ -23,6 +23,8 @@ extern double delegate_fee_percent;
 extern uint64_t minimum_payout;
 extern bool startup_complete;
 extern bool is_seed_node;   // True if node is a seed node - network_data_node_settings is same as seed node, removed
+extern bool signature_wallet_check;  // Also verify wallet signatures over the wallet RPC and report disagreements
+extern bool framed_messages;  // Send DPoPS messages as length-prefixed frames (every peer must accept them)
 extern int network_data_nodes_amount; // Number of network data nodes
 extern delegates_t delegates_all[BLOCK_VERIFIERS_TOTAL_AMOUNT];
 extern delegates_timer_t delegates_timer_all[BLOCK_VERIFIERS_TOTAL_AMOUNT];
@@ -33,10 +35,12 @@ extern unsigned char secret_key_data[crypto_vrf_SECRETKEYBYTES]; // Holds the se
 extern char secret_key[VRF_SECRET_KEY_LENGTH +1]; // Holds the secret key text for signing block verifier messages
 extern char vrf_public_key[VRF_PUBLIC_KEY_LENGTH + 1]; 
 extern char current_round_part[3]; // The current round part
-extern char delegates_hash[SHA256_HASH_SIZE + 1];
+extern char delegates_hash[(SHA256_HASH_SIZE * 2) + 1];
+extern char delegates_hash_md5[(MD5_HASH_SIZE * 2) + 1]; // Pre DELEGATES_HASH_V2_HEIGHT delegates hash
 extern char sync_token[SYNC_TOKEN_LEN + 1];
 extern char delegate_ip_address[IP_LENGTH+1];
 extern block_verifiers_list_t current_block_verifiers_list; // The list of block verifiers name, public address and IP address for the current round
+extern uint32_t current_block_verifiers_generation; // Bumped under current_block_verifiers_lock whenever the list is rebuilt
 // Locks
 extern pthread_mutex_t delegates_all_lock;
 extern pthread_mutex_t current_block_verifiers_lock;
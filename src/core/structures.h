@@ -85,6 +85,15 @@ typedef enum {
     XMSG_NONE = XMSG_MESSAGES_COUNT
 } xcash_msg_t;
 
+// Inbound message, parsed once by handle_srv_message() and passed to the validators and handlers
+typedef struct {
+    const char *data;                                 // JSON text as received
+    struct cJSON *root;                               // parsed document, owned by handle_srv_message()
+    xcash_msg_t type;
+    char message_settings[128];
+    char public_address[XCASH_WALLET_LENGTH + 1];     // empty if the message has none
+} xcash_msg_env_t;
+
 typedef enum {
     LIMIT_REMOVE = 0,  // Remove from limiter list
     LIMIT_CHECK = 1    // Enforce limit (check & add)
@@ -0,0 +1,295 @@
+#include "db_bulk.h"
+
+/*
+ * Batched writes over mongoc_bulk_operation_t.
+ *
+ * Writes are queued with db_bulk_upsert / db_bulk_update / db_bulk_remove and sent batch_size at a
+ * time, so N writes cost about N / batch_size round trips (each waiting for the collection's write
+ * concern) instead of N. Counts from every batch are summed into a db_bulk_result_t, and write errors
+ * are reported against the index the write was added at, so callers can still act per item.
+ *
+ * An unordered bulk keeps going past a failed write. An ordered bulk stops at the first failure:
+ * the rest of that batch is not applied by the server and later writes are not sent.
+ */
+
+static void bulk_record_error(db_bulk_t* b, size_t index, size_t count, int32_t code, const char* message) {
+  db_bulk_result_t* r = &b->result;
+  r->error_count += count;
+  if (r->error_entries < DB_BULK_MAX_ERRORS) {
+    db_bulk_error_t* e = &r->errors[r->error_entries++];
+    e->index = index;
+    e->count = count;
+    e->code = code;
+    snprintf(e->message, sizeof(e->message), "%s", message ? message : "");
+  }
+}
+
+// An ordered bulk applies nothing from index on
+static void bulk_stop(db_bulk_t* b, size_t index) {
+  b->stopped = true;
+  if (index < b->result.stopped_at) b->result.stopped_at = index;
+}
+
+static int64_t bulk_reply_count(const bson_t* reply, const char* field) {
+  bson_iter_t it;
+  return bson_iter_init_find(&it, reply, field) ? bson_iter_as_int64(&it) : 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_init
+Description: Prepares a batched writer for a collection
+Parameters:
+  b - The writer, finished with db_bulk_finish
+  collection - The collection; owned by the caller and must outlive the writer
+  ordered - Stop at the first failed write instead of applying the rest
+  batch_size - Writes per round trip, 0 for DB_BULK_BATCH_SIZE
+Return: true on success, false on bad arguments
+---------------------------------------------------------------------------------------------------------*/
+bool db_bulk_init(db_bulk_t* b, mongoc_collection_t* collection, bool ordered, size_t batch_size) {
+  if (!b) return false;
+  memset(b, 0, sizeof(*b));
+  b->result.stopped_at = SIZE_MAX;
+  if (!collection) return false;
+  b->collection = collection;
+  b->ordered = ordered;
+  b->batch_size = batch_size ? batch_size : DB_BULK_BATCH_SIZE;
+  return true;
+}
+
+// Opens the pending batch if needed; false once an ordered bulk has stopped
+static bool bulk_begin(db_bulk_t* b) {
+  if (!b || !b->collection || b->stopped) return false;
+  if (b->bulk) return true;
+
+  bson_t* opts = BCON_NEW("ordered", BCON_BOOL(b->ordered));
+  b->bulk = mongoc_collection_create_bulk_operation_with_opts(b->collection, opts);
+  bson_destroy(opts);
+  b->batch_start = b->added;
+  b->queued = 0;
+  if (!b->bulk) {
+    ERROR_PRINT("Failed to create bulk operation");
+    return false;
+  }
+  return true;
+}
+
+// Counts a write the driver accepted or rejected, sending the batch when it is full
+static bool bulk_added(db_bulk_t* b, bool accepted, const bson_error_t* error) {
+  size_t index = b->added++;
+  b->result.added = b->added;
+  if (!accepted) {
+    // Rejected before it was sent (e.g. an invalid update document): a per-item error
+    // Whatever was queued before it goes out now, so a batch always covers consecutive indexes
+    bulk_record_error(b, index, 1, (int32_t)error->code, error->message);
+    db_bulk_flush(b);
+    if (b->ordered) bulk_stop(b, index + 1);
+    return false;
+  }
+  b->queued++;
+  if (b->queued >= b->batch_size) return db_bulk_flush(b);
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_upsert
+Description: Queues a replace of the document with the same _id, inserting it if there is none
+Parameters:
+  b - The writer
+  doc - The whole document, with _id
+Return: true if queued, false if the document has no _id, was rejected or the bulk has stopped
+---------------------------------------------------------------------------------------------------------*/
+bool db_bulk_upsert(db_bulk_t* b, const bson_t* doc) {
+  if (!bulk_begin(b)) return false;
+
+  bson_iter_t id;
+  if (!doc || !bson_iter_init_find(&id, doc, "_id")) {
+    bson_error_t error = {0};
+    snprintf(error.message, sizeof(error.message), "upsert document has no _id");
+    return bulk_added(b, false, &error);
+  }
+
+  bson_t selector = BSON_INITIALIZER;
+  bson_append_value(&selector, "_id", -1, bson_iter_value(&id));
+  bson_t* opts = BCON_NEW("upsert", BCON_BOOL(true));
+  bson_error_t error = {0};
+  bool ok = mongoc_bulk_operation_replace_one_with_opts(b->bulk, &selector, doc, opts, &error);
+  bson_destroy(opts);
+  bson_destroy(&selector);
+  return bulk_added(b, ok, &error);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_update
+Description: Queues an update_one
+Parameters:
+  b - The writer
+  filter - Selects the document
+  update - Update operators ($set, $inc, ...)
+  upsert - Insert when nothing matches
+Return: true if queued, false if it was rejected or the bulk has stopped
+---------------------------------------------------------------------------------------------------------*/
+bool db_bulk_update(db_bulk_t* b, const bson_t* filter, const bson_t* update, bool upsert) {
+  if (!bulk_begin(b)) return false;
+
+  bson_t* opts = BCON_NEW("upsert", BCON_BOOL(upsert));
+  bson_error_t error = {0};
+  bool ok = mongoc_bulk_operation_update_one_with_opts(b->bulk, filter, update, opts, &error);
+  bson_destroy(opts);
+  return bulk_added(b, ok, &error);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_remove
+Description: Queues a delete_one
+Parameters:
+  b - The writer
+  filter - Selects the document
+Return: true if queued, false if it was rejected or the bulk has stopped
+---------------------------------------------------------------------------------------------------------*/
+bool db_bulk_remove(db_bulk_t* b, const bson_t* filter) {
+  if (!bulk_begin(b)) return false;
+
+  bson_error_t error = {0};
+  bool ok = mongoc_bulk_operation_remove_one_with_opts(b->bulk, filter, NULL, &error);
+  return bulk_added(b, ok, &error);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_flush
+Description: Sends the pending batch and folds its reply into the result
+Parameters:
+  b - The writer
+Return: true if every write of the batch succeeded (or nothing was pending), false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool db_bulk_flush(db_bulk_t* b) {
+  if (!b || !b->bulk) return true;
+
+  mongoc_bulk_operation_t* bulk = b->bulk;
+  size_t start = b->batch_start;
+  size_t queued = b->queued;
+  b->bulk = NULL;
+  b->queued = 0;
+  b->batch_start = b->added;
+
+  if (queued == 0) {
+    mongoc_bulk_operation_destroy(bulk);
+    return true;
+  }
+
+  bson_t reply;
+  bson_error_t error = {0};
+  bool ok = mongoc_bulk_operation_execute(bulk, &reply, &error) != 0;
+  mongoc_bulk_operation_destroy(bulk);
+
+  db_bulk_result_t* r = &b->result;
+  r->batches++;
+  r->matched += bulk_reply_count(&reply, "nMatched");
+  r->modified += bulk_reply_count(&reply, "nModified");
+  r->upserted += bulk_reply_count(&reply, "nUpserted");
+  r->removed += bulk_reply_count(&reply, "nRemoved");
+
+  // Per-item errors carry the write's index within this batch
+  size_t reported = 0;
+  size_t first_failed = queued;
+  bson_iter_t it, arr;
+  if (bson_iter_init_find(&it, &reply, "writeErrors") && BSON_ITER_HOLDS_ARRAY(&it) && bson_iter_recurse(&it, &arr)) {
+    while (bson_iter_next(&arr)) {
+      bson_iter_t item;
+      if (!BSON_ITER_HOLDS_DOCUMENT(&arr) || !bson_iter_recurse(&arr, &item)) continue;
+      size_t index = 0;
+      int32_t code = 0;
+      const char* message = "";
+      while (bson_iter_next(&item)) {
+        const char* key = bson_iter_key(&item);
+        if (strcmp(key, "index") == 0) index = (size_t)bson_iter_as_int64(&item);
+        else if (strcmp(key, "code") == 0) code = (int32_t)bson_iter_as_int64(&item);
+        else if (strcmp(key, "errmsg") == 0 && BSON_ITER_HOLDS_UTF8(&item)) message = bson_iter_utf8(&item, NULL);
+      }
+      if (index >= queued) index = queued - 1;
+      if (index < first_failed) first_failed = index;
+      bulk_record_error(b, start + index, 1, code, message);
+      reported++;
+    }
+  }
+
+  // Applied but not acknowledged by the write concern: the whole batch may roll back
+  if (bson_iter_init_find(&it, &reply, "writeConcernErrors") && BSON_ITER_HOLDS_ARRAY(&it) &&
+      bson_iter_recurse(&it, &arr) && bson_iter_next(&arr)) {
+    bulk_record_error(b, start, queued, (int32_t)error.code, error.message);
+    reported = queued;
+    first_failed = 0;
+  }
+
+  // Failed with nothing itemised (network, auth, ...): nothing in the batch is known to have applied
+  if (!ok && reported == 0) {
+    bulk_record_error(b, start, queued, (int32_t)error.code, error.message);
+    first_failed = 0;
+  }
+
+  if (!ok) {
+    WARNING_PRINT("Bulk write of %zu operations failed: %s", queued, error.message);
+  }
+
+  if (b->ordered && first_failed < queued) {
+    r->executed += first_failed + 1;
+    bulk_stop(b, start + first_failed + 1);
+  } else {
+    r->executed += queued;
+  }
+  bson_destroy(&reply);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_finish
+Description: Sends what is pending and releases the writer
+Parameters:
+  b - The writer
+  out - [out] Optional, the summed result of every batch
+Return: true if every write that was added succeeded, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool db_bulk_finish(db_bulk_t* b, db_bulk_result_t* out) {
+  if (!b) return false;
+  if (!b->stopped) db_bulk_flush(b);
+  if (b->bulk) {
+    mongoc_bulk_operation_destroy(b->bulk);
+    b->bulk = NULL;
+  }
+  bool ok = b->result.error_count == 0 && b->result.stopped_at == SIZE_MAX;
+  if (out) *out = b->result;
+  b->collection = NULL;
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_item_error
+Description: The recorded error covering the write added at index
+Parameters:
+  r - The result from db_bulk_finish
+  index - 0 based, in the order writes were added
+Return: The error, or NULL if none was recorded for it
+---------------------------------------------------------------------------------------------------------*/
+const db_bulk_error_t* db_bulk_item_error(const db_bulk_result_t* r, size_t index) {
+  if (!r) return NULL;
+  for (size_t i = 0; i < r->error_entries; i++) {
+    const db_bulk_error_t* e = &r->errors[i];
+    if (index >= e->index && index < e->index + e->count) return e;
+  }
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_bulk_item_ok
+Description: Whether the write added at index was sent and succeeded
+Parameters:
+  r - The result from db_bulk_finish
+  index - 0 based, in the order writes were added
+Return: true if it is known to have succeeded; false if it failed, was not sent, or more writes failed
+  than DB_BULK_MAX_ERRORS could record
+---------------------------------------------------------------------------------------------------------*/
+bool db_bulk_item_ok(const db_bulk_result_t* r, size_t index) {
+  if (!r || index >= r->added || index >= r->stopped_at || db_bulk_item_error(r, index)) return false;
+  size_t recorded = 0;
+  for (size_t i = 0; i < r->error_entries; i++) recorded += r->errors[i].count;
+  return recorded == r->error_count;
+}
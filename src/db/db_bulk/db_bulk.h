@@ -0,0 +1,58 @@
+#ifndef DB_BULK_H_   /* Include guard */
+#define DB_BULK_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <mongoc/mongoc.h>
+#include <bson/bson.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+
+// One failed write, or a run of writes that failed together (a batch lost to a network error)
+typedef struct {
+  size_t index;          // position of the write in the order it was added
+  size_t count;          // writes covered, 1 for a per-item error
+  int32_t code;
+  char message[128];
+} db_bulk_error_t;
+
+typedef struct {
+  int64_t matched;
+  int64_t modified;
+  int64_t upserted;
+  int64_t removed;
+  size_t batches;        // round trips made
+  size_t added;          // writes added
+  size_t executed;       // writes the server was asked to apply
+  size_t stopped_at;     // first write not applied after an ordered bulk failed, SIZE_MAX if none
+  size_t error_count;    // failed writes, including any not kept in errors[]
+  size_t error_entries;  // entries used in errors[]
+  db_bulk_error_t errors[DB_BULK_MAX_ERRORS];
+} db_bulk_result_t;
+
+typedef struct {
+  mongoc_collection_t* collection;
+  mongoc_bulk_operation_t* bulk;
+  bool ordered;
+  bool stopped;          // ordered and a write failed: nothing more is sent
+  size_t batch_size;
+  size_t added;          // writes added so far
+  size_t batch_start;    // index of the first write of the pending batch
+  size_t queued;         // writes in the pending batch
+  db_bulk_result_t result;
+} db_bulk_t;
+
+bool db_bulk_init(db_bulk_t* b, mongoc_collection_t* collection, bool ordered, size_t batch_size);
+bool db_bulk_upsert(db_bulk_t* b, const bson_t* doc);
+bool db_bulk_update(db_bulk_t* b, const bson_t* filter, const bson_t* update, bool upsert);
+bool db_bulk_remove(db_bulk_t* b, const bson_t* filter);
+bool db_bulk_flush(db_bulk_t* b);
+bool db_bulk_finish(db_bulk_t* b, db_bulk_result_t* out);
+const db_bulk_error_t* db_bulk_item_error(const db_bulk_result_t* r, size_t index);
+bool db_bulk_item_ok(const db_bulk_result_t* r, size_t index);
+
+#endif
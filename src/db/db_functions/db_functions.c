@@ -39,6 +39,11 @@ static inline bson_t* create_bson_document(const char* DATA, bson_error_t* error
   return bson_new_from_json((const uint8_t*)DATA, -1, error);
 }
 
+// Writes to the delegates collection are mirrored into the in-memory delegates registry
+static inline bool is_delegates_collection(const char* DATABASE, const char* COLLECTION) {
+  return DATABASE && COLLECTION && strcmp(DATABASE, DATABASE_NAME) == 0 && strcmp(COLLECTION, DB_COLLECTION_DELEGATES) == 0;
+}
+
 // Function to count documents in a collection based on a filter
 int count_documents_in_collection(const char* DATABASE, const char* COLLECTION, const char* DATA) {
   mongoc_client_t* database_client_thread = get_temporary_connection();
@@ -153,6 +158,14 @@ int insert_document_into_collection_bson(const char* DATABASE, const char* COLLE
 
   mongoc_collection_destroy(coll);
   release_temporary_connection(client);
+
+  bson_iter_t id_it;
+  if (is_delegates_collection(DATABASE, COLLECTION) && bson_iter_init_find(&id_it, document, "_id")) {
+    bson_t id_filter = BSON_INITIALIZER;
+    bson_append_iter(&id_filter, "_id", -1, &id_it);
+    delegates_registry_refresh(&id_filter);
+    bson_destroy(&id_filter);
+  }
   return XCASH_OK;
 }
 
@@ -234,6 +247,7 @@ bool delegates_apply_vote_total(const char* delegate_pubaddr, int64_t new_total)
   }
 
   ok = true;
+  delegates_registry_refresh(&filter);
 
 cleanup:
   bson_destroy(&reply);
@@ -409,6 +423,8 @@ int update_document_from_collection_bson(const char* DATABASE, const char* COLLE
   bson_destroy(&update_doc);
   mongoc_collection_destroy(collection);
   mongoc_client_pool_push(database_client_thread_pool, database_client_thread);
+
+  if (is_delegates_collection(DATABASE, COLLECTION)) delegates_registry_refresh(filter);
   return XCASH_OK;
 }
 
@@ -430,6 +446,7 @@ int delete_document_from_collection(const char* DATABASE, const char* COLLECTION
     return handle_error("Failed to delete document", document, NULL, collection, database_client_thread);
   }
 
+  if (is_delegates_collection(DATABASE, COLLECTION)) delegates_registry_refresh(document);
   free_resources(document, NULL, collection, database_client_thread);
   return XCASH_OK;
 }
@@ -960,6 +977,8 @@ bool db_upsert_doc(const char* db_name, const char* collection_name, const bson_
     if (!mongoc_collection_replace_one(collection, &query, doc, opts, NULL, error)) {
       ERROR_PRINT("Failed to upsert document: %s", error->message);
       result = false;
+    } else if (is_delegates_collection(db_name, collection_name)) {
+      delegates_registry_refresh(&query);
     }
   } else {
     char* str = bson_as_legacy_extended_json(doc, NULL);
@@ -999,12 +1018,13 @@ bool db_upsert_multi_docs(const char* db_name, const char* collection_name, cons
     return false;
   }
 
-  bson_t* opts = BCON_NEW("upsert", BCON_BOOL(true));
+  // Ordered, so the first bad document stops the write as the per-document loop used to
+  db_bulk_t bulk;
+  db_bulk_result_t bulk_result;
+  db_bulk_init(&bulk, collection, true, 0);
 
   if (bson_iter_init(&iter, docs)) {
-    bson_iter_t child;
     while (bson_iter_next(&iter)) {
-      bson_t query = BSON_INITIALIZER;
       const uint8_t* data;
       uint32_t len;
       bson_t sub_doc;
@@ -1012,33 +1032,28 @@ bool db_upsert_multi_docs(const char* db_name, const char* collection_name, cons
       bson_iter_document(&iter, &len, &data);
       bson_init_static(&sub_doc, data, len);
 
-      if (bson_iter_init_find(&child, &sub_doc, "_id")) {
-        bson_append_value(&query, "_id", -1, bson_iter_value(&child));
-      } else {
-        char* str = bson_as_legacy_extended_json(&sub_doc, NULL);
-        ERROR_PRINT("Failed to find '_id' in upsert document: %s", str);
-        free(str);
-
-        result = false;
-        bson_destroy(&query);
-        break;
-      }
+      if (!db_bulk_upsert(&bulk, &sub_doc) && bulk.stopped) break;
+    }
+  }
 
-      if (!mongoc_collection_replace_one(collection, &query, &sub_doc, opts, NULL, error)) {
-        ERROR_PRINT("Failed to upsert document: %s", error->message);
-        result = false;
-        bson_destroy(&query);
-        break;
-      }
-      bson_destroy(&query);
+  if (!db_bulk_finish(&bulk, &bulk_result)) {
+    const db_bulk_error_t* e = bulk_result.error_entries ? &bulk_result.errors[0] : NULL;
+    ERROR_PRINT("Failed to upsert document %zu of %zu: %s", e ? e->index : 0, bulk_result.added,
+                e ? e->message : "unknown error");
+    if (error && e) {
+      error->code = (uint32_t)e->code;
+      snprintf(error->message, sizeof(error->message), "%s", e->message);
     }
+    result = false;
   }
 
   // Cleanup
-  bson_destroy(opts);
   mongoc_collection_destroy(collection);
   mongoc_client_pool_push(database_client_thread_pool, client);
 
+  // A whole-collection sync: read it back once rather than per document
+  if (is_delegates_collection(db_name, collection_name)) delegates_registry_load();
+
   return result;
 }
 
@@ -1076,6 +1091,7 @@ bool db_delete_doc(const char* db_name, const char* collection_name, const bson_
   mongoc_collection_destroy(collection);
   mongoc_client_pool_push(database_client_thread_pool, client);
 
+  if (is_delegates_collection(db_name, collection_name)) delegates_registry_refresh(query);
   return true;
 }
 
@@ -1102,6 +1118,8 @@ bool db_drop(const char* db_name, const char* collection_name, bson_error_t* err
   result = mongoc_collection_drop(collection, error);
   if (!result) {
     ERROR_PRINT("Can't drop %s, error: %s", collection_name, error->message);
+  } else if (is_delegates_collection(db_name, collection_name)) {
+    delegates_registry_clear();
   }
 
   mongoc_collection_destroy(collection);
@@ -1373,7 +1391,7 @@ bool fetch_reserve_proof_fields_by_id(
 
 /*---------------------------------------------------------------------------------------------------------
 Name: get_delegate_fee
-Description: Retrieves `delegate_fee` (double) from the collections table for the current wallet.
+Description: Retrieves `delegate_fee` (double) of the current wallet from the delegates registry.
 Parameters:
   out_fee - [out] Receives the delegate fee as a double (e.g., 5.0 for 5%)
 Return:  XCASH_OK (1) on success, XCASH_ERROR (0) if missing / not a double / error
@@ -1384,58 +1402,12 @@ int get_delegate_fee(double* out_fee) {
     return XCASH_ERROR;
   }
 
-  mongoc_client_t* client = mongoc_client_pool_pop(database_client_thread_pool);
-  if (!client) {
-    ERROR_PRINT("get_delegate_fee: client pool pop failed");
-    return XCASH_ERROR;
-  }
-
-  mongoc_collection_t* coll =
-      mongoc_client_get_collection(client, DATABASE_NAME, DB_COLLECTION_DELEGATES);
-  if (!coll) {
-    ERROR_PRINT("get_delegate_fee: get_collection failed");
-    mongoc_client_pool_push(database_client_thread_pool, client);
-    return XCASH_ERROR;
-  }
-
-  // Filter: { public_address: "<xcash_wallet_public_address>" }
-  bson_t filter;
-  bson_init(&filter);
-  BSON_APPEND_UTF8(&filter, "public_address", xcash_wallet_public_address);
-
-  // Projection: { delegate_fee: 1 }
-  bson_t proj;
-  bson_init(&proj);
-  BSON_APPEND_INT32(&proj, "delegate_fee", 1);
-
-  bson_t opts;
-  bson_init(&opts);
-  BSON_APPEND_DOCUMENT(&opts, "projection", &proj);
-  BSON_APPEND_INT32(&opts, "limit", 1);
-
-  mongoc_cursor_t* cur = mongoc_collection_find_with_opts(coll, &filter, &opts, NULL);
-  const bson_t* doc = NULL;
   double fee = 0.0;
-  bool ok = false;
-
-  if (cur && mongoc_cursor_next(cur, &doc)) {
-    bson_iter_t it;
-    if (bson_iter_init_find(&it, doc, "delegate_fee") &&
-        bson_iter_type(&it) == BSON_TYPE_DOUBLE) {
-      fee = bson_iter_double(&it);
-      ok = true;
-    } else {
-      WARNING_PRINT("Delegate_fee is not stored in the correct format");
-    }
+  bool ok = delegates_registry_get_double(DELEGATES_KEY_ADDRESS, xcash_wallet_public_address, "delegate_fee", &fee);
+  if (!ok && delegates_registry_has(DELEGATES_KEY_ADDRESS, xcash_wallet_public_address)) {
+    WARNING_PRINT("Delegate_fee is not stored in the correct format");
   }
 
-  if (cur) mongoc_cursor_destroy(cur);
-  bson_destroy(&opts);
-  bson_destroy(&proj);
-  bson_destroy(&filter);
-  mongoc_collection_destroy(coll);
-  mongoc_client_pool_push(database_client_thread_pool, client);
-
   if (!ok) {
     ERROR_PRINT("get_delegate_fee: delegate_fee not found as double for %s",
                 xcash_wallet_public_address);
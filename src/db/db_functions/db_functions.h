@@ -12,6 +12,8 @@
 #include "string_functions.h"
 #include "network_functions.h"
 #include "network_wallet_functions.h"
+#include "delegates_registry.h"
+#include "db_bulk.h"
 
 int count_documents_in_collection(const char* DATABASE, const char* COLLECTION, const char* DATA);
 int count_all_documents_in_collection(const char* DATABASE, const char* COLLECTION);
@@ -0,0 +1,348 @@
+#include "db_snapshot.h"
+
+/*
+ * Binary collection snapshots for DB sync.
+ *
+ *   "XDS1" | uint32 LE document count | raw BSON document ... | SHA-256 of the documents
+ *
+ * Every BSON document starts with its own int32 length, so the documents need no framing of their
+ * own. Export copies the bytes the cursor returns straight into the buffer and hashes them as it
+ * goes; the count in the header is only known at the end, so it is checked against the documents
+ * rather than hashed. Import checks the bounds and the trailing hash once, then hands the documents
+ * to a bulk write as they are. Nothing is converted to or from extended JSON.
+ */
+
+static bool snap_reserve(db_snapshot_t* snap, size_t extra) {
+  if (snap->len + extra <= snap->cap) return true;
+  size_t cap = snap->cap ? snap->cap : 16384;
+  while (cap < snap->len + extra) cap *= 2;
+  uint8_t* n = realloc(snap->data, cap);
+  if (!n) return false;
+  snap->data = n;
+  snap->cap = cap;
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_begin
+Description: Starts an empty snapshot
+Parameters:
+  snap - [out] The snapshot, released with db_snapshot_free
+Return: true on success, false on an allocation or digest failure
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_begin(db_snapshot_t* snap) {
+  memset(snap, 0, sizeof(*snap));
+  snap->ctx = EVP_MD_CTX_new();
+  if (!snap->ctx || EVP_DigestInit_ex(snap->ctx, EVP_sha256(), NULL) != 1 ||
+      !snap_reserve(snap, DB_SNAPSHOT_HEADER_SIZE)) {
+    db_snapshot_free(snap);
+    return false;
+  }
+  memcpy(snap->data, DB_SNAPSHOT_MAGIC, 4);
+  memset(snap->data + 4, 0, 4);
+  snap->len = DB_SNAPSHOT_HEADER_SIZE;
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_add
+Description: Appends one document as is
+Parameters:
+  snap - The snapshot
+  doc - The document
+Return: true on success, false on an allocation or digest failure
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_add(db_snapshot_t* snap, const bson_t* doc) {
+  if (!snap->ctx || !doc || !snap_reserve(snap, doc->len)) return false;
+  memcpy(snap->data + snap->len, bson_get_data(doc), doc->len);
+  if (EVP_DigestUpdate(snap->ctx, snap->data + snap->len, doc->len) != 1) return false;
+  snap->len += doc->len;
+  snap->count++;
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_add_all
+Description: Appends every sub-document of docs, in the "0", "1", ... layout of db_find_doc
+Parameters:
+  snap - The snapshot
+  docs - The documents
+Return: true on success, false on a malformed entry or a failed append
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_add_all(db_snapshot_t* snap, const bson_t* docs) {
+  bson_iter_t it;
+  if (!bson_iter_init(&it, docs)) return false;
+  while (bson_iter_next(&it)) {
+    const uint8_t* data;
+    uint32_t len;
+    bson_t doc;
+    if (!BSON_ITER_HOLDS_DOCUMENT(&it)) return false;
+    bson_iter_document(&it, &len, &data);
+    if (!bson_init_static(&doc, data, len) || !db_snapshot_add(snap, &doc)) return false;
+  }
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_finish
+Description: Writes the document count and appends the SHA-256; no documents can be added afterwards
+Parameters:
+  snap - The snapshot
+Return: true on success, false on an allocation or digest failure
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_finish(db_snapshot_t* snap) {
+  if (!snap->ctx || !snap_reserve(snap, SHA256_HASH_SIZE)) return false;
+  uint32_t c = snap->count;
+  uint8_t count_le[4] = {(uint8_t)c, (uint8_t)(c >> 8), (uint8_t)(c >> 16), (uint8_t)(c >> 24)};
+  memcpy(snap->data + 4, count_le, sizeof(count_le));
+
+  unsigned int dlen = 0;
+  bool ok = EVP_DigestFinal_ex(snap->ctx, snap->data + snap->len, &dlen) == 1;
+  EVP_MD_CTX_free(snap->ctx);
+  snap->ctx = NULL;
+  if (ok) snap->len += SHA256_HASH_SIZE;
+  return ok;
+}
+
+void db_snapshot_free(db_snapshot_t* snap) {
+  if (!snap) return;
+  if (snap->ctx) EVP_MD_CTX_free(snap->ctx);
+  free(snap->data);
+  memset(snap, 0, sizeof(*snap));
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_export
+Description: Snapshots a whole collection, copying each document from the cursor into the buffer
+Parameters:
+  db_name - The database name
+  collection_name - The collection name
+  snap - [out] The finished snapshot, released with db_snapshot_free
+Return: true on success, false on a database or allocation error
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_export(const char* db_name, const char* collection_name, db_snapshot_t* snap) {
+  if (!db_snapshot_begin(snap)) return false;
+
+  mongoc_client_t* client = mongoc_client_pool_pop(database_client_thread_pool);
+  if (!client) {
+    ERROR_PRINT("Failed to pop client from pool");
+    db_snapshot_free(snap);
+    return false;
+  }
+  mongoc_collection_t* collection = mongoc_client_get_collection(client, db_name, collection_name);
+  bson_t query = BSON_INITIALIZER;
+  mongoc_cursor_t* cursor = collection ? mongoc_collection_find_with_opts(collection, &query, NULL, NULL) : NULL;
+
+  bool ok = cursor != NULL;
+  const bson_t* doc;
+  while (ok && mongoc_cursor_next(cursor, &doc)) {
+    ok = db_snapshot_add(snap, doc);
+  }
+  bson_error_t error;
+  if (cursor && mongoc_cursor_error(cursor, &error)) {
+    ERROR_PRINT("Snapshot of %s failed: %s", collection_name, error.message);
+    ok = false;
+  }
+
+  if (cursor) mongoc_cursor_destroy(cursor);
+  bson_destroy(&query);
+  if (collection) mongoc_collection_destroy(collection);
+  mongoc_client_pool_push(database_client_thread_pool, client);
+
+  ok = ok && db_snapshot_finish(snap);
+  if (!ok) db_snapshot_free(snap);
+  return ok;
+}
+
+// Walks the documents of a snapshot already checked by db_snapshot_verify
+static const uint8_t* snap_next(const uint8_t* p, const uint8_t* end, bson_t* doc) {
+  if (p + 4 > end) return NULL;
+  uint32_t len = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  if (len < 5 || len > (size_t)(end - p) || !bson_init_static(doc, p, len)) return NULL;
+  return p + len;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_verify
+Description: Checks the magic, the document bounds, the document count and the trailing SHA-256
+Parameters:
+  data - The snapshot
+  len - Its length
+  count - [out] Number of documents
+Return: true if the snapshot is intact, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_verify(const uint8_t* data, size_t len, uint32_t* count) {
+  if (!data || len < DB_SNAPSHOT_HEADER_SIZE + SHA256_HASH_SIZE || memcmp(data, DB_SNAPSHOT_MAGIC, 4) != 0) {
+    return false;
+  }
+  const uint8_t* end = data + len - SHA256_HASH_SIZE;
+  uint32_t expected = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) |
+                      ((uint32_t)data[7] << 24);
+
+  uint32_t n = 0;
+  bson_t doc;
+  const uint8_t* p = data + DB_SNAPSHOT_HEADER_SIZE;
+  while (p < end) {
+    p = snap_next(p, end, &doc);
+    if (!p) return false;
+    n++;
+  }
+  if (n != expected) return false;
+
+  uint8_t digest[SHA256_HASH_SIZE];
+  const uint8_t* docs = data + DB_SNAPSHOT_HEADER_SIZE;
+  bool ok = EVP_Digest(docs, (size_t)(end - docs), digest, NULL, EVP_sha256(), NULL) == 1;
+  if (!ok || memcmp(digest, end, SHA256_HASH_SIZE) != 0) return false;
+
+  if (count) *count = n;
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_to_bson
+Description: Copies the documents of a verified snapshot into the "0", "1", ... layout of db_find_doc
+Parameters:
+  data - The snapshot
+  len - Its length
+  out - [out] An initialized document
+Return: true on success, false on a malformed snapshot
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_to_bson(const uint8_t* data, size_t len, bson_t* out) {
+  if (!data || len < DB_SNAPSHOT_HEADER_SIZE + SHA256_HASH_SIZE || !out) return false;
+  const uint8_t* end = data + len - SHA256_HASH_SIZE;
+  const uint8_t* p = data + DB_SNAPSHOT_HEADER_SIZE;
+  uint32_t n = 0;
+  bson_t doc;
+  while (p < end) {
+    p = snap_next(p, end, &doc);
+    if (!p) return false;
+    char key[16];
+    snprintf(key, sizeof(key), "%u", n++);
+    bson_append_document(out, key, -1, &doc);
+  }
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_import
+Description: Upserts every document of a verified snapshot by _id with an unordered bulk write
+Parameters:
+  db_name - The database name
+  collection_name - The collection name
+  data - The snapshot
+  len - Its length
+  error - [out] The error, if any
+Return: true on success, false on a malformed snapshot or a failed write
+---------------------------------------------------------------------------------------------------------*/
+bool db_snapshot_import(const char* db_name, const char* collection_name, const uint8_t* data, size_t len,
+                        bson_error_t* error) {
+  if (!data || len < DB_SNAPSHOT_HEADER_SIZE + SHA256_HASH_SIZE) return false;
+
+  mongoc_client_t* client = mongoc_client_pool_pop(database_client_thread_pool);
+  if (!client) {
+    ERROR_PRINT("Failed to pop client from pool");
+    return false;
+  }
+  mongoc_collection_t* collection = mongoc_client_get_collection(client, db_name, collection_name);
+  db_bulk_t bulk;
+  db_bulk_result_t result;
+  bool ok = db_bulk_init(&bulk, collection, false, 0);
+
+  const uint8_t* end = data + len - SHA256_HASH_SIZE;
+  const uint8_t* p = data + DB_SNAPSHOT_HEADER_SIZE;
+  bson_t doc;
+  while (ok && p < end) {
+    p = snap_next(p, end, &doc);
+    if (!p) {
+      ERROR_PRINT("Malformed snapshot document");
+      ok = false;
+      break;
+    }
+    db_bulk_upsert(&bulk, &doc);
+  }
+
+  if (!db_bulk_finish(&bulk, &result) && ok) {
+    const db_bulk_error_t* e = result.error_entries ? &result.errors[0] : NULL;
+    ERROR_PRINT("Snapshot import into %s: %zu of %zu documents failed: %s", collection_name, result.error_count,
+                result.added, e ? e->message : "unknown error");
+    if (error && e) {
+      error->code = (uint32_t)e->code;
+      snprintf(error->message, sizeof(error->message), "%s", e->message);
+    }
+    ok = false;
+  }
+
+  if (collection) mongoc_collection_destroy(collection);
+  mongoc_client_pool_push(database_client_thread_pool, client);
+
+  // Written behind db_functions' back: read it back once
+  if (strcmp(db_name, DATABASE_NAME) == 0 && strcmp(collection_name, DB_COLLECTION_DELEGATES) == 0) {
+    delegates_registry_load();
+  }
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_encode
+Description: Messages are JSON text, so a snapshot travels as a string: the snapshot length (uint32 LE)
+  and the deflated snapshot, base64 encoded. Deflating first keeps the bytes aligned for the compressor;
+  base64 of the raw snapshot would gzip worse than the JSON it replaces.
+Parameters:
+  snap - A finished snapshot
+Return: A malloc'd NUL terminated string, or NULL on error
+---------------------------------------------------------------------------------------------------------*/
+char* db_snapshot_encode(const db_snapshot_t* snap) {
+  if (!snap || !snap->data || snap->len > DB_SNAPSHOT_MAX_SIZE) return NULL;
+
+  uLongf zlen = compressBound(snap->len);
+  uint8_t* z = malloc(4 + zlen);
+  if (!z) return NULL;
+  uint32_t raw = (uint32_t)snap->len;
+  z[0] = (uint8_t)raw;
+  z[1] = (uint8_t)(raw >> 8);
+  z[2] = (uint8_t)(raw >> 16);
+  z[3] = (uint8_t)(raw >> 24);
+  if (compress2(z + 4, &zlen, snap->data, snap->len, Z_BEST_COMPRESSION) != Z_OK) {
+    free(z);
+    return NULL;
+  }
+
+  size_t in = 4 + (size_t)zlen;
+  char* out = malloc(((in + 2) / 3) * 4 + 1);
+  if (out) EVP_EncodeBlock((unsigned char*)out, z, (int)in);
+  free(z);
+  return out;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: db_snapshot_decode
+Description: Reverses db_snapshot_encode; the result still has to pass db_snapshot_verify
+Parameters:
+  encoded - The string from db_snapshot_encode
+  len - [out] Length of the snapshot
+Return: The malloc'd snapshot, or NULL if the string is malformed or over DB_SNAPSHOT_MAX_SIZE
+---------------------------------------------------------------------------------------------------------*/
+uint8_t* db_snapshot_decode(const char* encoded, size_t* len) {
+  size_t in = encoded ? strlen(encoded) : 0;
+  if (in < 8 || in % 4 != 0 || in > INT32_MAX || !len) return NULL;
+  uint8_t* z = malloc((in / 4) * 3);
+  if (!z) return NULL;
+  int n = EVP_DecodeBlock(z, (const unsigned char*)encoded, (int)in);
+  // EVP_DecodeBlock counts the padding as output bytes
+  if (n >= 0 && encoded[in - 1] == '=') n--;
+  if (n >= 0 && encoded[in - 2] == '=') n--;
+
+  uint8_t* out = NULL;
+  if (n > 4) {
+    uint32_t raw = (uint32_t)z[0] | ((uint32_t)z[1] << 8) | ((uint32_t)z[2] << 16) | ((uint32_t)z[3] << 24);
+    uLongf out_len = raw;
+    out = (raw > 0 && raw <= DB_SNAPSHOT_MAX_SIZE) ? malloc(raw) : NULL;
+    if (out && (uncompress(out, &out_len, z + 4, (uLong)(n - 4)) != Z_OK || out_len != raw)) {
+      free(out);
+      out = NULL;
+    }
+    if (out) *len = raw;
+  }
+  free(z);
+  return out;
+}
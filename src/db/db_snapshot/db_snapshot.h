@@ -0,0 +1,48 @@
+#ifndef DB_SNAPSHOT_H_   /* Include guard */
+#define DB_SNAPSHOT_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <mongoc/mongoc.h>
+#include <bson/bson.h>
+#include <openssl/evp.h>
+#ifndef ZLIB_CONST
+#define ZLIB_CONST  // z_stream.next_in is const, whichever header includes zlib.h first
+#endif
+#include <zlib.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+#include "db_functions.h"
+
+#define DB_SNAPSHOT_MAGIC "XDS1"
+#define DB_SNAPSHOT_HEADER_SIZE 8          // magic + little endian document count
+#define DB_SNAPSHOT_MAX_SIZE (64 * 1024 * 1024)   // largest snapshot db_snapshot_decode inflates
+#define DB_SNAPSHOT_SYNC_FORMAT "bson_snapshot"   // sync_format value asking a peer for a snapshot
+
+// A snapshot being written: header, raw BSON documents back to back, SHA-256 of the documents
+typedef struct {
+  uint8_t* data;
+  size_t len;
+  size_t cap;
+  uint32_t count;
+  EVP_MD_CTX* ctx;
+} db_snapshot_t;
+
+bool db_snapshot_begin(db_snapshot_t* snap);
+bool db_snapshot_add(db_snapshot_t* snap, const bson_t* doc);
+bool db_snapshot_add_all(db_snapshot_t* snap, const bson_t* docs);
+bool db_snapshot_finish(db_snapshot_t* snap);
+void db_snapshot_free(db_snapshot_t* snap);
+bool db_snapshot_export(const char* db_name, const char* collection_name, db_snapshot_t* snap);
+bool db_snapshot_verify(const uint8_t* data, size_t len, uint32_t* count);
+bool db_snapshot_to_bson(const uint8_t* data, size_t len, bson_t* out);
+bool db_snapshot_import(const char* db_name, const char* collection_name, const uint8_t* data, size_t len,
+                        bson_error_t* error);
+char* db_snapshot_encode(const db_snapshot_t* snap);
+uint8_t* db_snapshot_decode(const char* encoded, size_t* len);
+
+#endif
@@ -1,7 +1,11 @@
 #include "db_sync.h"
 
-bool hash_delegates_collection(char *out_hash_hex) {
-  if (!out_hash_hex || !database_client_thread_pool) return XCASH_ERROR;
+bool hash_delegates_collection(char *out_hash_hex, char *out_md5_hex) {
+  if (!out_hash_hex || !out_md5_hex || !database_client_thread_pool) return XCASH_ERROR;
+
+  // Steady state: answered from the in-memory registry, which keeps the sum current on every write
+  if (delegates_registry_hash(out_hash_hex) && delegates_registry_hash_md5(out_md5_hex)) return XCASH_OK;
+  WARNING_PRINT("Delegates registry unavailable, hashing the delegates collection directly");
 
   mongoc_client_t *client = mongoc_client_pool_pop(database_client_thread_pool);
   if (!client) return XCASH_ERROR;
@@ -10,51 +14,34 @@ bool hash_delegates_collection(char *out_hash_hex) {
   mongoc_cursor_t *cursor = NULL;
   bson_t *query = NULL;
   bson_t *opts = NULL;
-  EVP_MD_CTX *ctx = NULL;
+  EVP_MD_CTX *md5_ctx = NULL;
   const bson_t *doc = NULL;
+  uint8_t digest[SHA256_HASH_SIZE] = {0};
+  unsigned char md5_bin[MD5_HASH_SIZE];
   bool result = XCASH_ERROR;
 
   // Step 1: Access collection
   collection = mongoc_client_get_collection(client, DATABASE_NAME, DB_COLLECTION_DELEGATES);
   if (!collection) goto cleanup;
 
-  // Step 2: Build query and sort options
+  // Step 2: Create cursor; the digest is a sum, but the MD5 hash needs _id order
   query = bson_new();
   opts = BCON_NEW("sort", "{", "_id", BCON_INT32(1), "}");
   if (!query || !opts) goto cleanup;
-
-  // Step 3: Create cursor
   cursor = mongoc_collection_find_with_opts(collection, query, opts, NULL);
   if (!cursor) goto cleanup;
 
-  // Step 4: Initialize hash
-  ctx = EVP_MD_CTX_new();
-  if (!ctx || EVP_DigestInit_ex(ctx, EVP_md5(), NULL) != 1) goto cleanup;
+  md5_ctx = EVP_MD_CTX_new();
+  if (!md5_ctx || EVP_DigestInit_ex(md5_ctx, EVP_md5(), NULL) != 1) goto cleanup;
 
-  // Step 5: Feed documents into hash
+  // Step 3: Add up the document digests and feed the MD5 hash
   while (mongoc_cursor_next(cursor, &doc)) {
-    bson_t filtered;
-    bson_init(&filtered);
-
-    // Copy everything except fields below
-    bson_iter_t iter;
-    if (bson_iter_init(&iter, doc)) {
-      while (bson_iter_next(&iter)) {
-        const char *key = bson_iter_key(&iter);
-        if (strcmp(key, "registration_timestamp") != 0 &&
-          strcmp(key, "total_vote_count") != 0 &&
-          strcmp(key, "online_status") != 0) {
-            bson_append_value(&filtered, key, -1, bson_iter_value(&iter));
-        }
-      }
+    uint8_t doc_digest[SHA256_HASH_SIZE];
+    if (!delegates_doc_digest(doc, doc_digest) || !delegates_doc_md5_update(md5_ctx, doc)) {
+      ERROR_PRINT("Failed to hash a delegates document.");
+      goto cleanup;
     }
-
-    char *json = bson_as_canonical_extended_json(&filtered, NULL);
-    if (json) {
-      EVP_DigestUpdate(ctx, json, strlen(json));
-      bson_free(json);
-    }
-    bson_destroy(&filtered);
+    delegates_digest_add(digest, doc_digest);
   }
 
   if (mongoc_cursor_error(cursor, NULL)) {
@@ -62,15 +49,14 @@ bool hash_delegates_collection(char *out_hash_hex) {
     goto cleanup;
   }
 
-  // Step 6: Finalize
-  unsigned char hash_bin[MD5_DIGEST_LENGTH];
-  if (EVP_DigestFinal_ex(ctx, hash_bin, NULL) != 1) goto cleanup;
-
-  bin_to_hex(hash_bin, MD5_DIGEST_LENGTH, out_hash_hex);
+  // Step 4: Finalize
+  if (EVP_DigestFinal_ex(md5_ctx, md5_bin, NULL) != 1) goto cleanup;
+  bin_to_hex(digest, SHA256_HASH_SIZE, out_hash_hex);
+  bin_to_hex(md5_bin, MD5_HASH_SIZE, out_md5_hex);
   result = XCASH_OK;
 
 cleanup:
-  if (ctx) EVP_MD_CTX_free(ctx);
+  if (md5_ctx) EVP_MD_CTX_free(md5_ctx);
   if (cursor) mongoc_cursor_destroy(cursor);
   if (opts) bson_destroy(opts);
   if (query) bson_destroy(query);
@@ -219,6 +205,20 @@ bool fill_delegates_from_db(void) {
 
   // cleanup the allocated memory
   free(delegates);
+
+  // Decode the delegates' VRF keys once for every proof verified until the next load
+  unsigned char vrf_keys[BLOCK_VERIFIERS_TOTAL_AMOUNT * crypto_vrf_PUBLICKEYBYTES];
+  size_t vrf_key_count = 0;
+  for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+    if (delegates_all[i].public_key[0] != '\0' &&
+        hex_to_byte_array(delegates_all[i].public_key, vrf_keys + vrf_key_count * crypto_vrf_PUBLICKEYBYTES,
+                          crypto_vrf_PUBLICKEYBYTES)) {
+      vrf_key_count++;
+    }
+  }
+  size_t cached = crypto_vrf_key_cache_set(vrf_keys, vrf_key_count);
+  DEBUG_PRINT("Cached %zu of %zu delegate VRF public keys", cached, vrf_key_count);
+
   return true;
 }
 
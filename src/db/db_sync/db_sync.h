@@ -11,8 +11,9 @@
 #include "net_multi.h"
 #include "xcash_net.h"
 #include "xcash_delegates.h"
+#include "crypto_vrf.h"
 
-bool hash_delegates_collection(char *out_hash_hex);
+bool hash_delegates_collection(char *out_hash_hex, char *out_md5_hex);
 bool fill_delegates_from_db(void);;
 int select_random_online_delegate(void);
 bool create_delegate_online_ip_list(char* out_data, size_t out_data_size);
@@ -0,0 +1,268 @@
+#include "delegates_merkle.h"
+
+/*
+ * Delta synchronization of the delegates collection.
+ *
+ * Delegates are spread over DELEGATES_MERKLE_LEAVES leaves by the SHA-256 of their public address.
+ * A leaf is the sum of the delegates_doc_digest of its documents (so the leaves add up to the
+ * delegates hash), FANOUT consecutive leaves are hashed into a node and the nodes into the root.
+ *
+ * An out of sync node sends its tree with the sync request: root and nodes in full and a prefix
+ * of each leaf, which keeps the request inside a signed message. The peer walks both trees from
+ * the root down and answers with the documents of the leaves that differ; the requester replaces
+ * the contents of exactly those leaves and checks its new root against the peer's. Traffic and
+ * writes follow the number of changed delegates instead of the size of the collection. A failed
+ * or inconsistent delta (including a leaf prefix collision) makes the next request ask for the
+ * whole collection, as before.
+ */
+static atomic_bool dmerkle_full_next = false;
+
+static bool dmerkle_hash(const uint8_t* data, size_t len, uint8_t out[SHA256_HASH_SIZE]) {
+  return EVP_Digest(data, len, out, NULL, EVP_sha256(), NULL) == 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_seal
+Description: Computes the nodes and the root from the leaves
+Parameters:
+  tree - The tree, with its leaves filled in
+Return: true on success, false on a digest failure
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_merkle_seal(delegates_merkle_t* tree) {
+  if (!tree) return false;
+  for (size_t n = 0; n < DELEGATES_MERKLE_FANOUT; n++) {
+    if (!dmerkle_hash(tree->leaves[n * DELEGATES_MERKLE_FANOUT], DELEGATES_MERKLE_FANOUT * SHA256_HASH_SIZE,
+                      tree->nodes[n])) {
+      return false;
+    }
+  }
+  return dmerkle_hash(tree->nodes[0], sizeof(tree->nodes), tree->root);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_build
+Description: Builds the tree of the local delegates collection from the delegates registry
+Parameters:
+  tree - [out] The tree
+Return: true on success, false if the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_merkle_build(delegates_merkle_t* tree) {
+  if (!tree) return false;
+  return delegates_registry_leaf_digests(tree->leaves, DELEGATES_MERKLE_LEAVES) && delegates_merkle_seal(tree);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_to_hex
+Description: Encodes a tree for a sync request: root and nodes in full, the first
+  DELEGATES_MERKLE_LEAF_PREFIX bytes of each leaf
+Parameters:
+  tree - The tree
+  root_hex - [out] SHA256_HASH_SIZE * 2 hex characters plus terminator
+  nodes_hex - [out] DELEGATES_MERKLE_NODES_HEX_LENGTH hex characters plus terminator
+  leaves_hex - [out] DELEGATES_MERKLE_LEAVES_HEX_LENGTH hex characters plus terminator
+---------------------------------------------------------------------------------------------------------*/
+void delegates_merkle_to_hex(const delegates_merkle_t* tree, char* root_hex, char* nodes_hex, char* leaves_hex) {
+  bin_to_hex(tree->root, SHA256_HASH_SIZE, root_hex);
+  bin_to_hex(tree->nodes[0], (int)sizeof(tree->nodes), nodes_hex);
+  for (size_t l = 0; l < DELEGATES_MERKLE_LEAVES; l++) {
+    bin_to_hex(tree->leaves[l], DELEGATES_MERKLE_LEAF_PREFIX, leaves_hex + (l * DELEGATES_MERKLE_LEAF_PREFIX * 2));
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_from_hex
+Description: Decodes a peer's tree from a sync request and checks its nodes against its root.
+  Only the first DELEGATES_MERKLE_LEAF_PREFIX bytes of each leaf are known, the rest is zero.
+Parameters:
+  root_hex, nodes_hex, leaves_hex - As written by delegates_merkle_to_hex
+  tree - [out] The tree
+Return: true if everything decodes and the nodes hash to the root, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_merkle_from_hex(const char* root_hex, const char* nodes_hex, const char* leaves_hex,
+                               delegates_merkle_t* tree) {
+  if (!root_hex || !nodes_hex || !leaves_hex || !tree) return false;
+  if (strlen(root_hex) != SHA256_HASH_SIZE * 2 || strlen(nodes_hex) != DELEGATES_MERKLE_NODES_HEX_LENGTH ||
+      strlen(leaves_hex) != DELEGATES_MERKLE_LEAVES_HEX_LENGTH) {
+    return false;
+  }
+
+  memset(tree, 0, sizeof(*tree));
+  if (!hex_to_byte_array(root_hex, tree->root, sizeof(tree->root)) ||
+      !hex_to_byte_array(nodes_hex, tree->nodes[0], sizeof(tree->nodes))) {
+    return false;
+  }
+  for (size_t l = 0; l < DELEGATES_MERKLE_LEAVES; l++) {
+    char part[(DELEGATES_MERKLE_LEAF_PREFIX * 2) + 1];
+    memcpy(part, leaves_hex + (l * DELEGATES_MERKLE_LEAF_PREFIX * 2), DELEGATES_MERKLE_LEAF_PREFIX * 2);
+    part[DELEGATES_MERKLE_LEAF_PREFIX * 2] = '\0';
+    if (!hex_to_byte_array(part, tree->leaves[l], DELEGATES_MERKLE_LEAF_PREFIX)) return false;
+  }
+
+  uint8_t root[SHA256_HASH_SIZE];
+  return dmerkle_hash(tree->nodes[0], sizeof(tree->nodes), root) && memcmp(root, tree->root, sizeof(root)) == 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_diff
+Description: Walks the local tree and a peer's from the root down and flags the leaves that differ.
+  Leaves are compared on their first DELEGATES_MERKLE_LEAF_PREFIX bytes, all a peer sends.
+Parameters:
+  local - The local tree
+  peer - The peer's tree, from delegates_merkle_from_hex
+  differ - [out] true for every leaf that differs
+Return: The number of differing leaves
+---------------------------------------------------------------------------------------------------------*/
+size_t delegates_merkle_diff(const delegates_merkle_t* local, const delegates_merkle_t* peer,
+                             bool differ[DELEGATES_MERKLE_LEAVES]) {
+  memset(differ, 0, DELEGATES_MERKLE_LEAVES * sizeof(bool));
+  if (memcmp(local->root, peer->root, SHA256_HASH_SIZE) == 0) return 0;
+
+  size_t count = 0;
+  for (size_t n = 0; n < DELEGATES_MERKLE_FANOUT; n++) {
+    if (memcmp(local->nodes[n], peer->nodes[n], SHA256_HASH_SIZE) == 0) continue;
+    for (size_t l = n * DELEGATES_MERKLE_FANOUT; l < (n + 1) * DELEGATES_MERKLE_FANOUT; l++) {
+      if (memcmp(local->leaves[l], peer->leaves[l], DELEGATES_MERKLE_LEAF_PREFIX) != 0) {
+        differ[l] = true;
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_mask_to_hex / delegates_merkle_mask_from_hex
+Description: Leaf flags as a bit string, leaf 0 in the low bit of the first byte
+---------------------------------------------------------------------------------------------------------*/
+void delegates_merkle_mask_to_hex(const bool mask[DELEGATES_MERKLE_LEAVES], char* out) {
+  uint8_t bits[DELEGATES_MERKLE_MASK_BYTES] = {0};
+  for (size_t l = 0; l < DELEGATES_MERKLE_LEAVES; l++) {
+    if (mask[l]) bits[l / 8] |= (uint8_t)(1u << (l % 8));
+  }
+  bin_to_hex(bits, DELEGATES_MERKLE_MASK_BYTES, out);
+}
+
+bool delegates_merkle_mask_from_hex(const char* hex, bool mask[DELEGATES_MERKLE_LEAVES]) {
+  uint8_t bits[DELEGATES_MERKLE_MASK_BYTES];
+  if (!hex || strlen(hex) != DELEGATES_MERKLE_MASK_HEX_LENGTH || !hex_to_byte_array(hex, bits, sizeof(bits))) {
+    return false;
+  }
+  for (size_t l = 0; l < DELEGATES_MERKLE_LEAVES; l++) mask[l] = (bits[l / 8] >> (l % 8)) & 1u;
+  return true;
+}
+
+// public_address of a delegates document, NULL when missing
+static const char* dmerkle_address(const bson_t* doc) {
+  bson_iter_t it;
+  if (bson_iter_init_find(&it, doc, "public_address") && BSON_ITER_HOLDS_UTF8(&it)) return bson_iter_utf8(&it, NULL);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_apply
+Description: Replaces the contents of the given leaves of the local delegates collection with the
+  documents a peer sent. Local delegates of those leaves that the peer does not have are deleted,
+  every document sent is upserted. Nothing is written if a document does not belong to one of
+  the leaves. Writes go through db_functions, which keeps the delegates registry current.
+Parameters:
+  replace - true for the leaves to replace
+  docs - The peer's documents ("0", "1", ... with _id)
+  upserted - [out] Documents written
+  removed - [out] Documents deleted
+Return: true on success, false on a malformed payload or a failed write
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_merkle_apply(const bool replace[DELEGATES_MERKLE_LEAVES], const bson_t* docs, size_t* upserted,
+                            size_t* removed) {
+  *upserted = 0;
+  *removed = 0;
+
+  // Validate the whole payload before touching the collection
+  bson_iter_t it;
+  size_t incoming = 0;
+  if (!bson_iter_init(&it, docs)) return false;
+  while (bson_iter_next(&it)) {
+    bson_t doc;
+    const uint8_t* data;
+    uint32_t len;
+    bson_iter_t id;
+    if (!BSON_ITER_HOLDS_DOCUMENT(&it)) return false;
+    bson_iter_document(&it, &len, &data);
+    if (!bson_init_static(&doc, data, len) || !bson_iter_init_find(&id, &doc, "_id")) {
+      ERROR_PRINT("DB sync: delta document without _id");
+      return false;
+    }
+    const char* address = dmerkle_address(&doc);
+    if (!replace[delegates_registry_leaf_of(address, DELEGATES_MERKLE_LEAVES)]) {
+      ERROR_PRINT("DB sync: delta document %s is outside the leaves being replaced", address ? address : "(none)");
+      return false;
+    }
+    incoming++;
+  }
+
+  bson_t local;
+  bson_init(&local);
+  if (!delegates_registry_export_leaves(replace, DELEGATES_MERKLE_LEAVES, &local)) {
+    bson_destroy(&local);
+    return false;
+  }
+
+  // Deletes first, so a delegate that moved to a new _id does not collide with its old document
+  bool ok = true;
+  bson_error_t error;
+  bson_iter_t lit;
+  if (bson_iter_init(&lit, &local)) {
+    while (ok && bson_iter_next(&lit)) {
+      bson_t ldoc;
+      const uint8_t* data;
+      uint32_t len;
+      bson_iter_document(&lit, &len, &data);
+      if (!bson_init_static(&ldoc, data, len)) continue;
+      const char* address = dmerkle_address(&ldoc);
+
+      bool kept = false;
+      bson_iter_init(&it, docs);
+      while (!kept && address && bson_iter_next(&it)) {
+        bson_t doc;
+        bson_iter_document(&it, &len, &data);
+        const char* a = bson_init_static(&doc, data, len) ? dmerkle_address(&doc) : NULL;
+        kept = a && strcmp(a, address) == 0;
+      }
+      if (kept) continue;
+
+      bson_iter_t id;
+      bson_t query = BSON_INITIALIZER;
+      if (bson_iter_init_find(&id, &ldoc, "_id")) bson_append_iter(&query, "_id", -1, &id);
+      ok = db_delete_doc(DATABASE_NAME, DB_COLLECTION_DELEGATES, &query, &error);
+      if (ok) (*removed)++;
+      bson_destroy(&query);
+    }
+  }
+  bson_destroy(&local);
+
+  bson_iter_init(&it, docs);
+  while (ok && bson_iter_next(&it)) {
+    bson_t doc;
+    const uint8_t* data;
+    uint32_t len;
+    bson_iter_document(&it, &len, &data);
+    ok = bson_init_static(&doc, data, len) && db_upsert_doc(DATABASE_NAME, DB_COLLECTION_DELEGATES, &doc, &error);
+    if (ok) (*upserted)++;
+  }
+
+  if (!ok) ERROR_PRINT("DB sync: delta apply stopped after %zu upserts and %zu deletes", *upserted, *removed);
+  DEBUG_PRINT("DB sync: delta carried %zu documents", incoming);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_merkle_request_full_sync / delegates_merkle_take_full_sync
+Description: After a delta that did not converge, the next sync request asks for the whole collection.
+  take returns the flag and clears it.
+---------------------------------------------------------------------------------------------------------*/
+void delegates_merkle_request_full_sync(void) {
+  atomic_store(&dmerkle_full_next, true);
+}
+
+bool delegates_merkle_take_full_sync(void) {
+  return atomic_exchange(&dmerkle_full_next, false);
+}
@@ -0,0 +1,48 @@
+#ifndef DELEGATES_MERKLE_H_   /* Include guard */
+#define DELEGATES_MERKLE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <mongoc/mongoc.h>
+#include <bson/bson.h>
+#include <openssl/evp.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+#include "string_functions.h"
+#include "db_functions.h"
+#include "delegates_registry.h"
+
+#define DELEGATES_MERKLE_LEAVES (DELEGATES_MERKLE_FANOUT * DELEGATES_MERKLE_FANOUT)
+#define DELEGATES_MERKLE_LEAF_PREFIX 8   // bytes of each leaf sent with a sync request (signed messages are small)
+#define DELEGATES_MERKLE_NODES_HEX_LENGTH (DELEGATES_MERKLE_FANOUT * SHA256_HASH_SIZE * 2)
+#define DELEGATES_MERKLE_LEAVES_HEX_LENGTH (DELEGATES_MERKLE_LEAVES * DELEGATES_MERKLE_LEAF_PREFIX * 2)
+#define DELEGATES_MERKLE_MASK_BYTES ((DELEGATES_MERKLE_LEAVES + 7) / 8)
+#define DELEGATES_MERKLE_MASK_HEX_LENGTH (DELEGATES_MERKLE_MASK_BYTES * 2)
+
+// Two level tree over the delegates collection, keyed by public_address
+typedef struct {
+  uint8_t leaves[DELEGATES_MERKLE_LEAVES][SHA256_HASH_SIZE];   // sum of the document digests in the leaf
+  uint8_t nodes[DELEGATES_MERKLE_FANOUT][SHA256_HASH_SIZE];    // SHA-256 of FANOUT consecutive leaves
+  uint8_t root[SHA256_HASH_SIZE];                              // SHA-256 of the nodes
+} delegates_merkle_t;
+
+bool delegates_merkle_build(delegates_merkle_t* tree);
+bool delegates_merkle_seal(delegates_merkle_t* tree);
+void delegates_merkle_to_hex(const delegates_merkle_t* tree, char* root_hex, char* nodes_hex, char* leaves_hex);
+bool delegates_merkle_from_hex(const char* root_hex, const char* nodes_hex, const char* leaves_hex,
+                               delegates_merkle_t* tree);
+size_t delegates_merkle_diff(const delegates_merkle_t* local, const delegates_merkle_t* peer,
+                             bool differ[DELEGATES_MERKLE_LEAVES]);
+void delegates_merkle_mask_to_hex(const bool mask[DELEGATES_MERKLE_LEAVES], char* out);
+bool delegates_merkle_mask_from_hex(const char* hex, bool mask[DELEGATES_MERKLE_LEAVES]);
+bool delegates_merkle_apply(const bool replace[DELEGATES_MERKLE_LEAVES], const bson_t* docs, size_t* upserted,
+                            size_t* removed);
+void delegates_merkle_request_full_sync(void);
+bool delegates_merkle_take_full_sync(void);
+
+#endif
@@ -0,0 +1,1185 @@
+#include "delegates_registry.h"
+
+/*
+ * Authoritative in-memory copy of the delegates collection.
+ *
+ * Every round used to read the whole collection twice (hash_delegates_collection and
+ * read_organize_delegates) and every signed message did one or two finds on it. The registry
+ * holds each document exactly as Mongo returns it, sorted by _id, with open-addressing hash
+ * indexes over public_address, delegate_name, IP_address and public_key, so those readers are
+ * answered without touching the database.
+ *
+ * Mongo stays the source of truth. The collection is read once, on first use, and the write
+ * helpers in db_functions call delegates_registry_refresh() with the filter of each write: the
+ * documents that matched the filter in memory and those that match it in the database are
+ * re-read, and ids that no longer exist are dropped. Re-reading instead of applying the update
+ * locally keeps the stored bytes identical to Mongo's, which the delegates hash depends on. The
+ * per-round online_status and total_vote_count bulks are the exception: a top level $set has a
+ * known result, so delegates_registry_apply_set applies it without a read.
+ * Seed nodes share a replica set, so writes made on another seed are followed with a change
+ * stream (delegates_registry_start_watch).
+ *
+ * The delegates hash compared between verifiers every round is the sum, mod 2^256, of the SHA-256
+ * of each document's canonical encoding (delegates_doc_digest). Addition does not depend on order,
+ * so the registry keeps the sum current by subtracting a document's old digest and adding its new
+ * one on every write; reading the hash is a copy. The sum is also stored in
+ * DB_COLLECTION_DELEGATES_DIGEST so it is kept with the data it describes. Until
+ * DELEGATES_HASH_V2_HEIGHT the former MD5 hash is what goes on the wire (delegates_registry_hash_md5).
+ *
+ * Readers take the rwlock shared; writers are serialized by dreg_write_lock while they talk to
+ * Mongo and only take the rwlock exclusively to swap documents in.
+ */
+typedef struct {
+  bson_t* doc;
+  bson_iter_t id;                              // _id of doc
+  const char* keys[DELEGATES_KEY_COUNT];       // point into doc, NULL when the field is missing
+  uint8_t digest[SHA256_HASH_SIZE];            // delegates_doc_digest of doc
+} dreg_entry_t;
+
+static const char* const dreg_key_fields[DELEGATES_KEY_COUNT] = {
+  "public_address", "delegate_name", "IP_address", "public_key"
+};
+
+static pthread_rwlock_t dreg_lock;
+static pthread_once_t dreg_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t dreg_write_lock = PTHREAD_MUTEX_INITIALIZER;
+static dreg_entry_t* dreg_entries = NULL;      // sorted by _id in Mongo's order
+static size_t dreg_count = 0;
+static size_t dreg_cap = 0;
+static int32_t* dreg_index[DELEGATES_KEY_COUNT];
+static size_t dreg_index_cap = 0;              // power of two, at least twice dreg_count
+static atomic_bool dreg_loaded = false;
+static uint8_t dreg_digest[SHA256_HASH_SIZE];       // sum of the entry digests, guarded by dreg_lock
+static uint8_t dreg_stored_digest[SHA256_HASH_SIZE];  // last sum written to Mongo, guarded by dreg_write_lock
+static bool dreg_stored_valid = false;
+
+static atomic_uint_fast64_t dreg_stat_lookups, dreg_stat_loads, dreg_stat_refreshes, dreg_stat_removals,
+    dreg_stat_events;
+
+static pthread_t dreg_watch_tid;
+static bool dreg_watch_started = false;
+static atomic_bool dreg_watch_stop = false;
+
+// Writers are rare; prefer them so a steady stream of readers cannot hold a refresh off indefinitely
+static void dreg_init(void) {
+  pthread_rwlockattr_t attr;
+  pthread_rwlockattr_init(&attr);
+  pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init(&dreg_lock, &attr);
+  pthread_rwlockattr_destroy(&attr);
+}
+
+static void dreg_rdlock(void) {
+  pthread_once(&dreg_once, dreg_init);
+  pthread_rwlock_rdlock(&dreg_lock);
+}
+
+static void dreg_wrlock(void) {
+  pthread_once(&dreg_once, dreg_init);
+  pthread_rwlock_wrlock(&dreg_lock);
+}
+
+// Sort rank of a BSON type in Mongo's comparison order
+static int dreg_type_rank(bson_type_t t) {
+  switch (t) {
+    case BSON_TYPE_MINKEY:     return 0;
+    case BSON_TYPE_UNDEFINED:
+    case BSON_TYPE_NULL:       return 1;
+    case BSON_TYPE_INT32:
+    case BSON_TYPE_INT64:
+    case BSON_TYPE_DOUBLE:
+    case BSON_TYPE_DECIMAL128: return 2;
+    case BSON_TYPE_SYMBOL:
+    case BSON_TYPE_UTF8:       return 3;
+    case BSON_TYPE_DOCUMENT:   return 4;
+    case BSON_TYPE_ARRAY:      return 5;
+    case BSON_TYPE_BINARY:     return 6;
+    case BSON_TYPE_OID:        return 7;
+    case BSON_TYPE_BOOL:       return 8;
+    case BSON_TYPE_DATE_TIME:  return 9;
+    case BSON_TYPE_TIMESTAMP:  return 10;
+    case BSON_TYPE_REGEX:      return 11;
+    case BSON_TYPE_MAXKEY:     return 13;
+    default:                   return 12;
+  }
+}
+
+// Compares two scalar values the way Mongo sorts them (strings bytewise, numbers by value)
+static int dreg_value_cmp(const bson_iter_t* a, const bson_iter_t* b) {
+  bson_type_t ta = bson_iter_type(a), tb = bson_iter_type(b);
+  int ra = dreg_type_rank(ta), rb = dreg_type_rank(tb);
+  if (ra != rb) return ra < rb ? -1 : 1;
+
+  switch (ra) {
+    case 2: {
+      if ((ta == BSON_TYPE_INT32 || ta == BSON_TYPE_INT64) && (tb == BSON_TYPE_INT32 || tb == BSON_TYPE_INT64)) {
+        int64_t x = bson_iter_as_int64(a), y = bson_iter_as_int64(b);
+        return x < y ? -1 : (x > y ? 1 : 0);
+      }
+      double x = bson_iter_as_double(a), y = bson_iter_as_double(b);
+      return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    case 3: {
+      uint32_t la = 0, lb = 0;
+      const char* sa = bson_iter_utf8(a, &la);
+      const char* sb = bson_iter_utf8(b, &lb);
+      int c = memcmp(sa, sb, la < lb ? la : lb);
+      if (c != 0) return c < 0 ? -1 : 1;
+      return la < lb ? -1 : (la > lb ? 1 : 0);
+    }
+    case 7: {
+      int c = memcmp(bson_iter_oid(a)->bytes, bson_iter_oid(b)->bytes, sizeof(bson_oid_t));
+      return c < 0 ? -1 : (c > 0 ? 1 : 0);
+    }
+    case 8:
+      return (int)bson_iter_bool(a) - (int)bson_iter_bool(b);
+    case 9: {
+      int64_t x = bson_iter_date_time(a), y = bson_iter_date_time(b);
+      return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    default:
+      return 0;
+  }
+}
+
+static int dreg_entry_cmp(const void* a, const void* b) {
+  return dreg_value_cmp(&((const dreg_entry_t*)a)->id, &((const dreg_entry_t*)b)->id);
+}
+
+static uint32_t dreg_hash_str(const char* s) {
+  uint32_t h = 2166136261u;
+  for (; *s; s++) {
+    h ^= (uint8_t)*s;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// Fields that change without the delegate set changing; left out of the delegates hash
+static bool dreg_digest_skips(const char* key) {
+  return strcmp(key, "registration_timestamp") == 0 || strcmp(key, "total_vote_count") == 0 ||
+         strcmp(key, "online_status") == 0;
+}
+
+static int dreg_iter_key_cmp(const void* a, const void* b) {
+  return strcmp(bson_iter_key((const bson_iter_t*)a), bson_iter_key((const bson_iter_t*)b));
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_doc_digest
+Description: SHA-256 of one delegates document in canonical form: the top level fields other than
+  registration_timestamp, total_vote_count and online_status, sorted by name and encoded as BSON.
+  The result does not depend on the field order Mongo happens to store.
+Parameters:
+  doc - The delegates document
+  out - [out] SHA256_HASH_SIZE bytes
+Return: true on success, false on a malformed document or digest failure
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_doc_digest(const bson_t* doc, uint8_t out[SHA256_HASH_SIZE]) {
+  bson_iter_t it;
+  if (!doc || !out || !bson_iter_init(&it, doc)) return false;
+
+  size_t n = 0;
+  while (bson_iter_next(&it)) n++;
+  bson_iter_t* fields = malloc((n ? n : 1) * sizeof(bson_iter_t));
+  if (!fields) return false;
+
+  size_t kept = 0;
+  bson_iter_init(&it, doc);
+  while (bson_iter_next(&it)) {
+    if (!dreg_digest_skips(bson_iter_key(&it))) fields[kept++] = it;
+  }
+  if (kept > 1) qsort(fields, kept, sizeof(bson_iter_t), dreg_iter_key_cmp);
+
+  bson_t canon;
+  bson_init(&canon);
+  bool ok = true;
+  for (size_t i = 0; i < kept && ok; i++) {
+    ok = bson_append_iter(&canon, bson_iter_key(&fields[i]), -1, &fields[i]);
+  }
+  ok = ok && EVP_Digest(bson_get_data(&canon), canon.len, out, NULL, EVP_sha256(), NULL) == 1;
+
+  bson_destroy(&canon);
+  free(fields);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_doc_md5_update
+Description: Feeds one delegates document into the pre DELEGATES_HASH_V2_HEIGHT delegates hash: MD5 over
+  the canonical extended JSON of every document in _id order, leaving out the same fields as
+  delegates_doc_digest, in the order Mongo stores them
+Parameters:
+  ctx - An MD5 context
+  doc - The delegates document
+Return: true on success, false on a malformed document or digest failure
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_doc_md5_update(EVP_MD_CTX* ctx, const bson_t* doc) {
+  bson_iter_t it;
+  if (!ctx || !doc || !bson_iter_init(&it, doc)) return false;
+
+  bson_t filtered;
+  bson_init(&filtered);
+  while (bson_iter_next(&it)) {
+    if (!dreg_digest_skips(bson_iter_key(&it))) bson_append_value(&filtered, bson_iter_key(&it), -1, bson_iter_value(&it));
+  }
+  char* json = bson_as_canonical_extended_json(&filtered, NULL);
+  bool ok = json && EVP_DigestUpdate(ctx, json, strlen(json)) == 1;
+  if (json) bson_free(json);
+  bson_destroy(&filtered);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_hash_v2_active
+Description: Whether the delegates hash at block_height is the SHA-256 sum (delegates_registry_hash) or
+  still the MD5 hash (delegates_registry_hash_md5). Below DELEGATES_HASH_V2_HEIGHT the MD5 hash is
+  sent so verifiers that only know it stay in sync, and either hash is accepted.
+Parameters:
+  block_height - The block height of the round, in decimal
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_hash_v2_active(const char* block_height) {
+  return block_height && block_height[0] != '\0' &&
+         strtoull(block_height, NULL, 10) >= (unsigned long long)DELEGATES_HASH_V2_HEIGHT;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_digest_add / delegates_digest_sub
+Description: Adds or subtracts one document digest to or from a collection digest. Both are read as
+  256 bit little endian integers and the arithmetic wraps mod 2^256, so documents can be added
+  and removed in any order.
+---------------------------------------------------------------------------------------------------------*/
+void delegates_digest_add(uint8_t sum[SHA256_HASH_SIZE], const uint8_t digest[SHA256_HASH_SIZE]) {
+  unsigned carry = 0;
+  for (size_t i = 0; i < SHA256_HASH_SIZE; i++) {
+    unsigned v = (unsigned)sum[i] + digest[i] + carry;
+    sum[i] = (uint8_t)v;
+    carry = v >> 8;
+  }
+}
+
+void delegates_digest_sub(uint8_t sum[SHA256_HASH_SIZE], const uint8_t digest[SHA256_HASH_SIZE]) {
+  int borrow = 0;
+  for (size_t i = 0; i < SHA256_HASH_SIZE; i++) {
+    int v = (int)sum[i] - digest[i] - borrow;
+    sum[i] = (uint8_t)v;
+    borrow = v < 0;
+  }
+}
+
+// Takes ownership of doc. Returns false when the document has no _id.
+static bool dreg_entry_init(dreg_entry_t* e, bson_t* doc) {
+  memset(e, 0, sizeof(*e));
+  if (!bson_iter_init_find(&e->id, doc, "_id")) {
+    bson_destroy(doc);
+    return false;
+  }
+  if (!delegates_doc_digest(doc, e->digest)) {
+    bson_destroy(doc);
+    return false;
+  }
+  e->doc = doc;
+  for (int k = 0; k < DELEGATES_KEY_COUNT; k++) {
+    bson_iter_t it;
+    if (bson_iter_init_find(&it, doc, dreg_key_fields[k]) && BSON_ITER_HOLDS_UTF8(&it)) {
+      e->keys[k] = bson_iter_utf8(&it, NULL);
+    }
+  }
+  return true;
+}
+
+// Rebuilds the key indexes after dreg_entries changed. Caller holds dreg_lock exclusively.
+static bool dreg_reindex_locked(void) {
+  size_t cap = 16;
+  while (cap < dreg_count * 2) cap <<= 1;
+
+  if (cap != dreg_index_cap) {
+    for (int k = 0; k < DELEGATES_KEY_COUNT; k++) {
+      int32_t* idx = realloc(dreg_index[k], cap * sizeof(int32_t));
+      if (!idx) return false;
+      dreg_index[k] = idx;
+    }
+    dreg_index_cap = cap;
+  }
+
+  for (int k = 0; k < DELEGATES_KEY_COUNT; k++) {
+    for (size_t s = 0; s < cap; s++) dreg_index[k][s] = -1;
+    for (size_t i = 0; i < dreg_count; i++) {
+      const char* v = dreg_entries[i].keys[k];
+      if (!v) continue;
+      size_t s = dreg_hash_str(v) & (cap - 1);
+      while (dreg_index[k][s] >= 0) s = (s + 1) & (cap - 1);
+      dreg_index[k][s] = (int32_t)i;
+    }
+  }
+  return true;
+}
+
+// Caller holds dreg_lock
+static const dreg_entry_t* dreg_find_locked(delegates_key_t key, const char* value) {
+  if ((int)key < 0 || (int)key >= DELEGATES_KEY_COUNT || !value || dreg_index_cap == 0) return NULL;
+  size_t s = dreg_hash_str(value) & (dreg_index_cap - 1);
+  for (int32_t i; (i = dreg_index[key][s]) >= 0; s = (s + 1) & (dreg_index_cap - 1)) {
+    if (strcmp(dreg_entries[i].keys[key], value) == 0) return &dreg_entries[i];
+  }
+  return NULL;
+}
+
+// Binary search by _id. Returns the index of the entry or, when absent, where it would go.
+static size_t dreg_search_locked(const bson_iter_t* id, bool* found) {
+  size_t lo = 0, hi = dreg_count;
+  *found = false;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int c = dreg_value_cmp(&dreg_entries[mid].id, id);
+    if (c == 0) {
+      *found = true;
+      return mid;
+    }
+    if (c < 0) lo = mid + 1; else hi = mid;
+  }
+  return lo;
+}
+
+// Inserts or replaces one document (copied). Caller holds dreg_lock exclusively.
+static bool dreg_upsert_locked(const bson_t* doc) {
+  bson_t* copy = bson_copy(doc);
+  if (!copy) return false;
+
+  dreg_entry_t e;
+  if (!dreg_entry_init(&e, copy)) return false;
+
+  bool found;
+  size_t pos = dreg_search_locked(&e.id, &found);
+  if (found) {
+    delegates_digest_sub(dreg_digest, dreg_entries[pos].digest);
+    delegates_digest_add(dreg_digest, e.digest);
+    bson_destroy(dreg_entries[pos].doc);
+    dreg_entries[pos] = e;
+    return true;
+  }
+
+  if (dreg_count == dreg_cap) {
+    size_t cap = dreg_cap ? dreg_cap * 2 : BLOCK_VERIFIERS_TOTAL_AMOUNT;
+    dreg_entry_t* n = realloc(dreg_entries, cap * sizeof(dreg_entry_t));
+    if (!n) {
+      bson_destroy(copy);
+      return false;
+    }
+    dreg_entries = n;
+    dreg_cap = cap;
+  }
+  memmove(&dreg_entries[pos + 1], &dreg_entries[pos], (dreg_count - pos) * sizeof(dreg_entry_t));
+  dreg_entries[pos] = e;
+  dreg_count++;
+  delegates_digest_add(dreg_digest, e.digest);
+  return true;
+}
+
+// Caller holds dreg_lock exclusively
+static bool dreg_remove_locked(const bson_iter_t* id) {
+  bool found;
+  size_t pos = dreg_search_locked(id, &found);
+  if (!found) return false;
+  delegates_digest_sub(dreg_digest, dreg_entries[pos].digest);
+  bson_destroy(dreg_entries[pos].doc);
+  memmove(&dreg_entries[pos], &dreg_entries[pos + 1], (dreg_count - pos - 1) * sizeof(dreg_entry_t));
+  dreg_count--;
+  return true;
+}
+
+// Caller holds dreg_lock exclusively
+static void dreg_free_entries_locked(void) {
+  for (size_t i = 0; i < dreg_count; i++) bson_destroy(dreg_entries[i].doc);
+  dreg_count = 0;
+  memset(dreg_digest, 0, sizeof(dreg_digest));
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dreg_doc_matches
+Description: Evaluates a write filter against a stored document
+Parameters:
+  doc - The stored delegates document
+  filter - A filter made only of top level equality conditions
+  match - [out] true when every condition holds
+Return: false when the filter uses anything but plain equality, so the caller cannot trust match
+---------------------------------------------------------------------------------------------------------*/
+static bool dreg_doc_matches(const bson_t* doc, const bson_t* filter, bool* match) {
+  bson_iter_t f;
+  *match = true;
+  if (!bson_iter_init(&f, filter)) return false;
+
+  while (bson_iter_next(&f)) {
+    const char* key = bson_iter_key(&f);
+    bson_type_t t = bson_iter_type(&f);
+    if (key[0] == '$' || strchr(key, '.') != NULL) return false;
+    if (t != BSON_TYPE_UTF8 && t != BSON_TYPE_BOOL && t != BSON_TYPE_INT32 && t != BSON_TYPE_INT64 &&
+        t != BSON_TYPE_DOUBLE && t != BSON_TYPE_OID) {
+      return false;
+    }
+
+    bson_iter_t d;
+    if (!bson_iter_init_find(&d, doc, key) || dreg_type_rank(bson_iter_type(&d)) != dreg_type_rank(t) ||
+        dreg_value_cmp(&d, &f) != 0) {
+      *match = false;
+    }
+  }
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dreg_store_digest_locked
+Description: Writes the collection digest to DB_COLLECTION_DELEGATES_DIGEST when it differs from the
+  last value written. Caller holds dreg_write_lock.
+Parameters:
+  verify - Read the stored value first and warn when it does not describe the collection
+           (a write reached Mongo without going through the registry)
+---------------------------------------------------------------------------------------------------------*/
+static void dreg_store_digest_locked(bool verify) {
+  if (!database_client_thread_pool) return;
+
+  uint8_t digest[SHA256_HASH_SIZE];
+  dreg_rdlock();
+  memcpy(digest, dreg_digest, sizeof(digest));
+  int64_t count = (int64_t)dreg_count;
+  pthread_rwlock_unlock(&dreg_lock);
+
+  if (!verify && dreg_stored_valid && memcmp(digest, dreg_stored_digest, sizeof(digest)) == 0) return;
+
+  mongoc_client_t* client = mongoc_client_pool_pop(database_client_thread_pool);
+  if (!client) return;
+  mongoc_collection_t* coll = mongoc_client_get_collection(client, DATABASE_NAME, DB_COLLECTION_DELEGATES_DIGEST);
+
+  char hex[(SHA256_HASH_SIZE * 2) + 1];
+  bin_to_hex(digest, SHA256_HASH_SIZE, hex);
+  bson_t* selector = BCON_NEW("_id", BCON_UTF8(DB_COLLECTION_DELEGATES));
+
+  if (verify && coll) {
+    dreg_stored_valid = false;
+    mongoc_cursor_t* cur = mongoc_collection_find_with_opts(coll, selector, NULL, NULL);
+    const bson_t* stored;
+    bson_iter_t it;
+    if (cur && mongoc_cursor_next(cur, &stored) && bson_iter_init_find(&it, stored, "digest") &&
+        BSON_ITER_HOLDS_UTF8(&it)) {
+      if (strcmp(bson_iter_utf8(&it, NULL), hex) == 0) {
+        memcpy(dreg_stored_digest, digest, sizeof(digest));
+        dreg_stored_valid = true;
+      } else {
+        WARNING_PRINT("delegates registry: stored digest %s does not match the collection (%s), rewriting",
+                      bson_iter_utf8(&it, NULL), hex);
+      }
+    }
+    if (cur) mongoc_cursor_destroy(cur);
+  }
+
+  bool current = dreg_stored_valid && memcmp(digest, dreg_stored_digest, sizeof(digest)) == 0;
+  if (coll && !current) {
+    bson_t* doc = BCON_NEW("_id", BCON_UTF8(DB_COLLECTION_DELEGATES), "digest", BCON_UTF8(hex),
+                           "count", BCON_INT64(count));
+    bson_t* opts = BCON_NEW("upsert", BCON_BOOL(true));
+    bson_error_t err;
+    if (mongoc_collection_replace_one(coll, selector, doc, opts, NULL, &err)) {
+      memcpy(dreg_stored_digest, digest, sizeof(digest));
+      dreg_stored_valid = true;
+    } else {
+      dreg_stored_valid = false;
+      WARNING_PRINT("delegates registry: failed to store the delegates digest: %s", err.message);
+    }
+    bson_destroy(opts);
+    bson_destroy(doc);
+  }
+
+  bson_destroy(selector);
+  if (coll) mongoc_collection_destroy(coll);
+  mongoc_client_pool_push(database_client_thread_pool, client);
+}
+
+// Reads the whole collection into a fresh table. Caller holds dreg_write_lock.
+static bool dreg_load_locked(void) {
+  if (!database_client_thread_pool) return false;
+  mongoc_client_t* client = mongoc_client_pool_pop(database_client_thread_pool);
+  if (!client) {
+    ERROR_PRINT("delegates registry: failed to pop client from pool");
+    return false;
+  }
+
+  mongoc_collection_t* coll = mongoc_client_get_collection(client, DATABASE_NAME, DB_COLLECTION_DELEGATES);
+  bson_t query = BSON_INITIALIZER;
+  bson_t* opts = BCON_NEW("sort", "{", "_id", BCON_INT32(1), "}");
+  mongoc_cursor_t* cur = coll ? mongoc_collection_find_with_opts(coll, &query, opts, NULL) : NULL;
+
+  dreg_entry_t* entries = NULL;
+  size_t count = 0, cap = 0;
+  bool ok = cur != NULL;
+  const bson_t* doc;
+  uint8_t digest[SHA256_HASH_SIZE] = {0};
+
+  while (ok && mongoc_cursor_next(cur, &doc)) {
+    if (count == cap) {
+      size_t ncap = cap ? cap * 2 : BLOCK_VERIFIERS_TOTAL_AMOUNT;
+      dreg_entry_t* n = realloc(entries, ncap * sizeof(dreg_entry_t));
+      if (!n) {
+        ok = false;
+        break;
+      }
+      entries = n;
+      cap = ncap;
+    }
+    bson_t* copy = bson_copy(doc);
+    if (copy && dreg_entry_init(&entries[count], copy)) {
+      delegates_digest_add(digest, entries[count].digest);
+      count++;
+    }
+  }
+
+  bson_error_t err;
+  if (cur && mongoc_cursor_error(cur, &err)) {
+    ERROR_PRINT("delegates registry: load failed: %s", err.message);
+    ok = false;
+  }
+
+  if (cur) mongoc_cursor_destroy(cur);
+  bson_destroy(opts);
+  bson_destroy(&query);
+  if (coll) mongoc_collection_destroy(coll);
+  mongoc_client_pool_push(database_client_thread_pool, client);
+
+  if (!ok) {
+    for (size_t i = 0; i < count; i++) bson_destroy(entries[i].doc);
+    free(entries);
+    return false;
+  }
+
+  // The server already sorted by _id; sorting again keeps the binary search valid for any collation
+  if (count > 1) qsort(entries, count, sizeof(dreg_entry_t), dreg_entry_cmp);
+
+  dreg_wrlock();
+  dreg_free_entries_locked();
+  free(dreg_entries);
+  dreg_entries = entries;
+  dreg_count = count;
+  dreg_cap = cap;
+  memcpy(dreg_digest, digest, sizeof(digest));
+  ok = dreg_reindex_locked();
+  pthread_rwlock_unlock(&dreg_lock);
+
+  atomic_store(&dreg_loaded, ok);
+  if (ok) {
+    atomic_fetch_add_explicit(&dreg_stat_loads, 1, memory_order_relaxed);
+    dreg_store_digest_locked(true);
+  }
+  DEBUG_PRINT("delegates registry: loaded %zu delegates", count);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_load
+Description: (Re)reads the whole delegates collection into memory
+Return: true on success, false if the collection could not be read (the previous copy is kept)
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_load(void) {
+  pthread_mutex_lock(&dreg_write_lock);
+  bool ok = dreg_load_locked();
+  pthread_mutex_unlock(&dreg_write_lock);
+  return ok;
+}
+
+// Loads the registry on first use
+static bool dreg_ensure_loaded(void) {
+  if (atomic_load(&dreg_loaded)) return true;
+  pthread_mutex_lock(&dreg_write_lock);
+  bool ok = atomic_load(&dreg_loaded) || dreg_load_locked();
+  pthread_mutex_unlock(&dreg_write_lock);
+  if (!ok) ERROR_PRINT("delegates registry: unable to load the delegates collection");
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_clear
+Description: Empties the registry after the delegates collection was dropped
+---------------------------------------------------------------------------------------------------------*/
+void delegates_registry_clear(void) {
+  pthread_mutex_lock(&dreg_write_lock);
+  dreg_wrlock();
+  dreg_free_entries_locked();
+  dreg_reindex_locked();
+  pthread_rwlock_unlock(&dreg_lock);
+  dreg_store_digest_locked(false);
+  pthread_mutex_unlock(&dreg_write_lock);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_refresh
+Description: Brings the registry in line with Mongo after a write to the delegates collection.
+  The documents that matched the write filter before the write, and those matching it now,
+  are read back; matched ids that are gone are dropped. A filter that cannot be evaluated
+  in memory falls back to a full reload. Nothing is done until the registry has been loaded.
+Parameters:
+  filter - The filter of the insert / update / delete that just ran
+---------------------------------------------------------------------------------------------------------*/
+void delegates_registry_refresh(const bson_t* filter) {
+  if (!filter || !atomic_load(&dreg_loaded) || !database_client_thread_pool) return;
+
+  pthread_mutex_lock(&dreg_write_lock);
+
+  // Ids this write may have touched, as the registry knows them
+  bson_t ids;
+  bson_init(&ids);
+  bool exact = true;
+  uint32_t id_count = 0;
+  dreg_rdlock();
+  for (size_t i = 0; i < dreg_count && exact; i++) {
+    bool match;
+    exact = dreg_doc_matches(dreg_entries[i].doc, filter, &match);
+    if (exact && match) {
+      char key[16];
+      snprintf(key, sizeof(key), "%u", id_count++);
+      bson_append_iter(&ids, key, -1, &dreg_entries[i].id);
+    }
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+
+  if (!exact) {
+    bson_destroy(&ids);
+    dreg_load_locked();
+    pthread_mutex_unlock(&dreg_write_lock);
+    return;
+  }
+
+  // { $or: [ filter, { _id: { $in: ids } } ] }
+  bson_t query, or_arr, or_filter, or_ids, id_doc, in_arr;
+  bson_init(&query);
+  BSON_APPEND_ARRAY_BEGIN(&query, "$or", &or_arr);
+  BSON_APPEND_DOCUMENT_BEGIN(&or_arr, "0", &or_filter);
+  bson_concat(&or_filter, filter);
+  bson_append_document_end(&or_arr, &or_filter);
+  BSON_APPEND_DOCUMENT_BEGIN(&or_arr, "1", &or_ids);
+  BSON_APPEND_DOCUMENT_BEGIN(&or_ids, "_id", &id_doc);
+  BSON_APPEND_ARRAY_BEGIN(&id_doc, "$in", &in_arr);
+  bson_concat(&in_arr, &ids);
+  bson_append_array_end(&id_doc, &in_arr);
+  bson_append_document_end(&or_ids, &id_doc);
+  bson_append_document_end(&or_arr, &or_ids);
+  bson_append_array_end(&query, &or_arr);
+
+  mongoc_client_t* client = mongoc_client_pool_pop(database_client_thread_pool);
+  mongoc_collection_t* coll =
+      client ? mongoc_client_get_collection(client, DATABASE_NAME, DB_COLLECTION_DELEGATES) : NULL;
+  mongoc_cursor_t* cur = coll ? mongoc_collection_find_with_opts(coll, &query, NULL, NULL) : NULL;
+
+  bson_t* docs[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+  size_t doc_count = 0;
+  bool ok = cur != NULL;
+  const bson_t* doc;
+  while (ok && mongoc_cursor_next(cur, &doc)) {
+    if (doc_count == BLOCK_VERIFIERS_TOTAL_AMOUNT) {
+      ok = false;
+      break;
+    }
+    docs[doc_count++] = bson_copy(doc);
+  }
+  bson_error_t err;
+  if (cur && mongoc_cursor_error(cur, &err)) {
+    WARNING_PRINT("delegates registry: refresh read failed: %s", err.message);
+    ok = false;
+  }
+  if (cur) mongoc_cursor_destroy(cur);
+  if (coll) mongoc_collection_destroy(coll);
+  if (client) mongoc_client_pool_push(database_client_thread_pool, client);
+
+  if (ok) {
+    dreg_wrlock();
+    for (size_t i = 0; i < doc_count; i++) {
+      if (docs[i] && dreg_upsert_locked(docs[i])) {
+        atomic_fetch_add_explicit(&dreg_stat_refreshes, 1, memory_order_relaxed);
+      }
+    }
+    bson_iter_t it;
+    if (bson_iter_init(&it, &ids)) {
+      while (bson_iter_next(&it)) {
+        bool still_there = false;
+        for (size_t i = 0; i < doc_count && !still_there; i++) {
+          bson_iter_t d;
+          still_there = docs[i] && bson_iter_init_find(&d, docs[i], "_id") && dreg_value_cmp(&d, &it) == 0;
+        }
+        if (!still_there && dreg_remove_locked(&it)) {
+          atomic_fetch_add_explicit(&dreg_stat_removals, 1, memory_order_relaxed);
+        }
+      }
+    }
+    ok = dreg_reindex_locked();
+    pthread_rwlock_unlock(&dreg_lock);
+  }
+
+  for (size_t i = 0; i < doc_count; i++) {
+    if (docs[i]) bson_destroy(docs[i]);
+  }
+  bson_destroy(&query);
+  bson_destroy(&ids);
+
+  // Could not tell what the write changed: fall back to reading everything
+  if (!ok && !dreg_load_locked()) {
+    atomic_store(&dreg_loaded, false);
+  }
+  if (ok) dreg_store_digest_locked(false);
+  pthread_mutex_unlock(&dreg_write_lock);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_apply_set
+Description: Applies a {$set: set} that was just written to one delegate, without reading it back.
+  Mongo replaces an existing top level field in place and appends a new one, so the document and
+  the delegates hash come out as a re-read would give them.
+Parameters:
+  key - Which field the write was filtered on
+  value - Its value
+  set - The $set fields; top level and not _id
+Return: true if the delegate was updated, false if it is not in the registry or set cannot be applied
+  locally (the caller then uses delegates_registry_refresh)
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_apply_set(delegates_key_t key, const char* value, const bson_t* set) {
+  bson_iter_t s, it, sv;
+  if (!value || !set || !atomic_load(&dreg_loaded) || !bson_iter_init(&s, set)) return false;
+  while (bson_iter_next(&s)) {
+    const char* field = bson_iter_key(&s);
+    if (field[0] == '$' || strchr(field, '.') != NULL || strcmp(field, "_id") == 0) return false;
+  }
+
+  pthread_mutex_lock(&dreg_write_lock);
+  dreg_wrlock();
+  const dreg_entry_t* e = dreg_find_locked(key, value);
+  bool ok = false;
+  if (e) {
+    bson_t* doc = bson_new();
+    bson_iter_init(&it, e->doc);
+    while (bson_iter_next(&it)) {
+      const char* field = bson_iter_key(&it);
+      bson_append_iter(doc, field, -1, bson_iter_init_find(&sv, set, field) ? &sv : &it);
+    }
+    bson_iter_init(&s, set);
+    while (bson_iter_next(&s)) {
+      if (!bson_iter_init_find(&sv, e->doc, bson_iter_key(&s))) bson_append_iter(doc, bson_iter_key(&s), -1, &s);
+    }
+    ok = dreg_upsert_locked(doc) && dreg_reindex_locked();
+    bson_destroy(doc);
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+
+  if (ok) {
+    dreg_store_digest_locked(false);
+  } else if (e && !dreg_load_locked()) {
+    atomic_store(&dreg_loaded, false);
+  }
+  pthread_mutex_unlock(&dreg_write_lock);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_has
+Description: Checks whether a delegate with the given key exists
+Parameters:
+  key - Which field value is compared with
+  value - The value to look for
+Return: true if found, false if not found or the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_has(delegates_key_t key, const char* value) {
+  if (!value || !dreg_ensure_loaded()) return false;
+  atomic_fetch_add_explicit(&dreg_stat_lookups, 1, memory_order_relaxed);
+  dreg_rdlock();
+  bool found = dreg_find_locked(key, value) != NULL;
+  pthread_rwlock_unlock(&dreg_lock);
+  return found;
+}
+
+// Positions it on field of the delegate found by key. Caller holds dreg_lock.
+static bool dreg_field_locked(delegates_key_t key, const char* value, const char* field, bson_iter_t* it) {
+  const dreg_entry_t* e = dreg_find_locked(key, value);
+  return e && bson_iter_init_find(it, e->doc, field);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_get_utf8
+Description: Reads a string field of one delegate
+Parameters:
+  key - Which field value is compared with
+  value - The value to look for
+  field - The field to read
+  out - [out] The field value, truncated to out_size - 1
+  out_size - Size of out
+Return: true if the delegate exists and the field is a string, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_get_utf8(delegates_key_t key, const char* value, const char* field, char* out,
+                                 size_t out_size) {
+  if (!value || !field || !out || out_size == 0 || !dreg_ensure_loaded()) return false;
+  atomic_fetch_add_explicit(&dreg_stat_lookups, 1, memory_order_relaxed);
+  bool ok = false;
+  bson_iter_t it;
+  dreg_rdlock();
+  if (dreg_field_locked(key, value, field, &it) && BSON_ITER_HOLDS_UTF8(&it)) {
+    snprintf(out, out_size, "%s", bson_iter_utf8(&it, NULL));
+    ok = true;
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_get_int64
+Description: Reads an int32 or int64 field of one delegate
+Return: true if the delegate exists and the field is an integer, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_get_int64(delegates_key_t key, const char* value, const char* field, int64_t* out) {
+  if (!value || !field || !out || !dreg_ensure_loaded()) return false;
+  atomic_fetch_add_explicit(&dreg_stat_lookups, 1, memory_order_relaxed);
+  bool ok = false;
+  bson_iter_t it;
+  dreg_rdlock();
+  if (dreg_field_locked(key, value, field, &it) && (BSON_ITER_HOLDS_INT32(&it) || BSON_ITER_HOLDS_INT64(&it))) {
+    *out = bson_iter_as_int64(&it);
+    ok = true;
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_get_double
+Description: Reads a double field of one delegate
+Return: true if the delegate exists and the field is a double, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_get_double(delegates_key_t key, const char* value, const char* field, double* out) {
+  if (!value || !field || !out || !dreg_ensure_loaded()) return false;
+  atomic_fetch_add_explicit(&dreg_stat_lookups, 1, memory_order_relaxed);
+  bool ok = false;
+  bson_iter_t it;
+  dreg_rdlock();
+  if (dreg_field_locked(key, value, field, &it) && BSON_ITER_HOLDS_DOUBLE(&it)) {
+    *out = bson_iter_double(&it);
+    ok = true;
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_count
+Return: The number of registered delegates, -1 if the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+int delegates_registry_count(void) {
+  if (!dreg_ensure_loaded()) return -1;
+  dreg_rdlock();
+  int count = (int)dreg_count;
+  pthread_rwlock_unlock(&dreg_lock);
+  return count;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_export
+Description: Copies every delegate into reply in the layout of db_find_all_doc ("0", "1", ... without _id)
+Parameters:
+  reply - [out] An initialized document
+Return: true on success, false if the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_export(bson_t* reply) {
+  if (!reply || !dreg_ensure_loaded()) return false;
+  atomic_fetch_add_explicit(&dreg_stat_lookups, 1, memory_order_relaxed);
+  dreg_rdlock();
+  for (size_t i = 0; i < dreg_count; i++) {
+    char key[16];
+    bson_t child;
+    snprintf(key, sizeof(key), "%zu", i);
+    BSON_APPEND_DOCUMENT_BEGIN(reply, key, &child);
+    bson_copy_to_excluding_noinit(dreg_entries[i].doc, &child, "_id", NULL);
+    bson_append_document_end(reply, &child);
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_leaf_of
+Description: The sync tree leaf a delegate belongs to, taken from the SHA-256 of its public address
+  so delegates spread evenly whatever their addresses look like
+Parameters:
+  public_address - The delegate's public_address (NULL or "" for documents without one)
+  leaf_count - Number of leaves
+Return: A leaf index below leaf_count
+---------------------------------------------------------------------------------------------------------*/
+size_t delegates_registry_leaf_of(const char* public_address, size_t leaf_count) {
+  uint8_t h[SHA256_HASH_SIZE];
+  const char* a = public_address ? public_address : "";
+  if (leaf_count == 0 || EVP_Digest(a, strlen(a), h, NULL, EVP_sha256(), NULL) != 1) return 0;
+  uint32_t v = ((uint32_t)h[0] << 24) | ((uint32_t)h[1] << 16) | ((uint32_t)h[2] << 8) | h[3];
+  return v % leaf_count;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_leaf_digests
+Description: Sums the document digests per sync tree leaf. The leaves add up to the delegates hash.
+Parameters:
+  leaves - [out] leaf_count digests
+  leaf_count - Number of leaves
+Return: true on success, false if the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_leaf_digests(uint8_t (*leaves)[SHA256_HASH_SIZE], size_t leaf_count) {
+  if (!leaves || leaf_count == 0 || !dreg_ensure_loaded()) return false;
+  memset(leaves, 0, leaf_count * SHA256_HASH_SIZE);
+  dreg_rdlock();
+  for (size_t i = 0; i < dreg_count; i++) {
+    size_t leaf = delegates_registry_leaf_of(dreg_entries[i].keys[DELEGATES_KEY_ADDRESS], leaf_count);
+    delegates_digest_add(leaves[leaf], dreg_entries[i].digest);
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_export_leaves
+Description: Copies the delegates of the selected sync tree leaves into reply in the layout of
+  db_export_collection_to_bson ("0", "1", ... with _id)
+Parameters:
+  leaves - leaf_count flags, true for the leaves to export
+  leaf_count - Number of leaves
+  reply - [out] An initialized document
+Return: true on success, false if the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_export_leaves(const bool* leaves, size_t leaf_count, bson_t* reply) {
+  if (!leaves || leaf_count == 0 || !reply || !dreg_ensure_loaded()) return false;
+  atomic_fetch_add_explicit(&dreg_stat_lookups, 1, memory_order_relaxed);
+  size_t n = 0;
+  dreg_rdlock();
+  for (size_t i = 0; i < dreg_count; i++) {
+    if (!leaves[delegates_registry_leaf_of(dreg_entries[i].keys[DELEGATES_KEY_ADDRESS], leaf_count)]) continue;
+    char key[16];
+    snprintf(key, sizeof(key), "%zu", n++);
+    bson_append_document(reply, key, -1, dreg_entries[i].doc);
+  }
+  pthread_rwlock_unlock(&dreg_lock);
+  return true;
+}
+
+// Recomputes every document digest and their sum. Caller holds dreg_lock.
+static bool dreg_verify_digest_locked(void) {
+  uint8_t sum[SHA256_HASH_SIZE] = {0};
+  size_t stale = 0;
+  for (size_t i = 0; i < dreg_count; i++) {
+    uint8_t d[SHA256_HASH_SIZE];
+    if (!delegates_doc_digest(dreg_entries[i].doc, d)) return false;
+    if (memcmp(d, dreg_entries[i].digest, sizeof(d)) != 0) stale++;
+    delegates_digest_add(sum, d);
+  }
+  if (stale) ERROR_PRINT("delegates registry: %zu cached document digests are stale", stale);
+  return stale == 0 && memcmp(sum, dreg_digest, sizeof(sum)) == 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_hash
+Description: The delegates hash: sum mod 2^256 of delegates_doc_digest over every delegate, kept
+  current on each write so this is a copy. At debug log level the sum is also recomputed from
+  the documents and a mismatch forces a reload.
+Parameters:
+  out_hash_hex - [out] SHA256_HASH_SIZE * 2 hex characters plus terminator
+Return: true on success, false if the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_hash(char* out_hash_hex) {
+  if (!out_hash_hex || !dreg_ensure_loaded()) return false;
+
+  uint8_t digest[SHA256_HASH_SIZE];
+  bool consistent = true;
+  dreg_rdlock();
+  memcpy(digest, dreg_digest, sizeof(digest));
+  if (log_level >= LOG_LEVEL_DEBUG) consistent = dreg_verify_digest_locked();
+  pthread_rwlock_unlock(&dreg_lock);
+
+  if (!consistent) {
+    ERROR_PRINT("delegates registry: incremental digest differs from a full recompute, reloading");
+    if (!delegates_registry_load()) return false;
+    dreg_rdlock();
+    memcpy(digest, dreg_digest, sizeof(digest));
+    pthread_rwlock_unlock(&dreg_lock);
+  }
+
+  bin_to_hex(digest, SHA256_HASH_SIZE, out_hash_hex);
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_hash_md5
+Description: The pre DELEGATES_HASH_V2_HEIGHT delegates hash (delegates_doc_md5_update over every delegate,
+  in the registry's _id order). Recomputed on each call; it is only needed once per round.
+Parameters:
+  out_hash_hex - [out] MD5_HASH_SIZE * 2 hex characters plus terminator
+Return: true on success, false if the registry could not be loaded
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_hash_md5(char* out_hash_hex) {
+  if (!out_hash_hex || !dreg_ensure_loaded()) return false;
+
+  unsigned char hash_bin[MD5_HASH_SIZE];
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  bool ok = ctx && EVP_DigestInit_ex(ctx, EVP_md5(), NULL) == 1;
+  dreg_rdlock();
+  for (size_t i = 0; ok && i < dreg_count; i++) ok = delegates_doc_md5_update(ctx, dreg_entries[i].doc);
+  pthread_rwlock_unlock(&dreg_lock);
+  ok = ok && EVP_DigestFinal_ex(ctx, hash_bin, NULL) == 1;
+  if (ctx) EVP_MD_CTX_free(ctx);
+
+  if (ok) bin_to_hex(hash_bin, MD5_HASH_SIZE, out_hash_hex);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dreg_apply_event
+Description: Applies one change stream event
+Return: false when the stream has to be reopened (invalidate, drop, rename)
+---------------------------------------------------------------------------------------------------------*/
+static bool dreg_apply_event(const bson_t* ev) {
+  bson_iter_t it;
+  if (!bson_iter_init_find(&it, ev, "operationType") || !BSON_ITER_HOLDS_UTF8(&it)) return true;
+  const char* op = bson_iter_utf8(&it, NULL);
+  atomic_fetch_add_explicit(&dreg_stat_events, 1, memory_order_relaxed);
+
+  bool is_delete = strcmp(op, "delete") == 0;
+  bool is_write = strcmp(op, "insert") == 0 || strcmp(op, "update") == 0 || strcmp(op, "replace") == 0;
+  if (!is_delete && !is_write) {
+    delegates_registry_load();
+    return false;
+  }
+
+  bson_t full;
+  bool have_full = false;
+  if (is_write && bson_iter_init_find(&it, ev, "fullDocument") && BSON_ITER_HOLDS_DOCUMENT(&it)) {
+    const uint8_t* data;
+    uint32_t len;
+    bson_iter_document(&it, &len, &data);
+    have_full = bson_init_static(&full, data, len);
+  }
+
+  bson_iter_t key, id;
+  bool have_id = bson_iter_init_find(&key, ev, "documentKey") && BSON_ITER_HOLDS_DOCUMENT(&key) &&
+                 bson_iter_recurse(&key, &id) && bson_iter_find(&id, "_id");
+
+  pthread_mutex_lock(&dreg_write_lock);
+  if (atomic_load(&dreg_loaded)) {
+    dreg_wrlock();
+    if (have_full) {
+      dreg_upsert_locked(&full);
+    } else if (have_id) {
+      // delete, or an update whose document was already deleted again
+      dreg_remove_locked(&id);
+    }
+    dreg_reindex_locked();
+    pthread_rwlock_unlock(&dreg_lock);
+    dreg_store_digest_locked(false);
+  }
+  pthread_mutex_unlock(&dreg_write_lock);
+  return true;
+}
+
+// Follows writes replicated from the other seeds
+static void* dreg_watch_main(void* arg) {
+  (void)arg;
+  while (!atomic_load(&dreg_watch_stop) && !atomic_load(&shutdown_requested)) {
+    mongoc_client_t* client = mongoc_client_pool_pop(database_client_thread_pool);
+    mongoc_collection_t* coll =
+        client ? mongoc_client_get_collection(client, DATABASE_NAME, DB_COLLECTION_DELEGATES) : NULL;
+    bson_t pipeline = BSON_INITIALIZER;
+    bson_t* opts = BCON_NEW("fullDocument", BCON_UTF8("updateLookup"),
+                            "maxAwaitTimeMS", BCON_INT64(DELEGATES_REGISTRY_WATCH_AWAIT_MS));
+    mongoc_change_stream_t* stream = coll ? mongoc_collection_watch(coll, &pipeline, opts) : NULL;
+
+    bson_error_t err;
+    if (!stream || mongoc_change_stream_error_document(stream, &err, NULL)) {
+      WARNING_PRINT("delegates registry: change stream unavailable: %s", stream ? err.message : "no client");
+    } else {
+      // Anything written before the stream opened is picked up by reading everything once
+      delegates_registry_load();
+      const bson_t* ev;
+      while (!atomic_load(&dreg_watch_stop) && !atomic_load(&shutdown_requested)) {
+        if (mongoc_change_stream_next(stream, &ev)) {
+          if (!dreg_apply_event(ev)) break;
+        } else if (mongoc_change_stream_error_document(stream, &err, NULL)) {
+          WARNING_PRINT("delegates registry: change stream error: %s", err.message);
+          break;
+        }
+      }
+    }
+
+    if (stream) mongoc_change_stream_destroy(stream);
+    bson_destroy(opts);
+    bson_destroy(&pipeline);
+    if (coll) mongoc_collection_destroy(coll);
+    if (client) mongoc_client_pool_push(database_client_thread_pool, client);
+
+    for (int i = 0; i < DELEGATES_REGISTRY_WATCH_RETRY_SEC && !atomic_load(&dreg_watch_stop) &&
+                    !atomic_load(&shutdown_requested); i++) {
+      sleep(1);
+    }
+  }
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_start_watch
+Description: Starts following the delegates collection with a change stream, for seed nodes whose
+  replica set members write to it directly
+Return: true if the watcher thread is running
+---------------------------------------------------------------------------------------------------------*/
+bool delegates_registry_start_watch(void) {
+  if (dreg_watch_started) return true;
+  atomic_store(&dreg_watch_stop, false);
+  if (pthread_create(&dreg_watch_tid, NULL, dreg_watch_main, NULL) != 0) {
+    ERROR_PRINT("delegates registry: failed to start the change stream thread");
+    return false;
+  }
+  dreg_watch_started = true;
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_stop_watch
+Description: Stops the change stream thread; returns within DELEGATES_REGISTRY_WATCH_AWAIT_MS
+---------------------------------------------------------------------------------------------------------*/
+void delegates_registry_stop_watch(void) {
+  if (!dreg_watch_started) return;
+  atomic_store(&dreg_watch_stop, true);
+  pthread_join(dreg_watch_tid, NULL);
+  dreg_watch_started = false;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: delegates_registry_get_stats
+Parameters:
+  out - [out] Counters since the last reset
+  reset - Zero the counters after reading
+---------------------------------------------------------------------------------------------------------*/
+void delegates_registry_get_stats(delegates_registry_stats_t* out, bool reset) {
+  if (!out) return;
+  if (reset) {
+    out->lookups = atomic_exchange(&dreg_stat_lookups, 0);
+    out->loads = atomic_exchange(&dreg_stat_loads, 0);
+    out->refreshes = atomic_exchange(&dreg_stat_refreshes, 0);
+    out->removals = atomic_exchange(&dreg_stat_removals, 0);
+    out->events = atomic_exchange(&dreg_stat_events, 0);
+  } else {
+    out->lookups = atomic_load(&dreg_stat_lookups);
+    out->loads = atomic_load(&dreg_stat_loads);
+    out->refreshes = atomic_load(&dreg_stat_refreshes);
+    out->removals = atomic_load(&dreg_stat_removals);
+    out->events = atomic_load(&dreg_stat_events);
+  }
+  dreg_rdlock();
+  out->delegates = dreg_count;
+  pthread_rwlock_unlock(&dreg_lock);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: log_delegates_registry_stats
+Description: Logs and resets the delegates registry counters
+---------------------------------------------------------------------------------------------------------*/
+void log_delegates_registry_stats(void) {
+  delegates_registry_stats_t st;
+  delegates_registry_get_stats(&st, true);
+  DEBUG_PRINT("Delegates registry: delegates=%zu lookups=%llu loads=%llu refreshes=%llu removals=%llu events=%llu",
+              st.delegates, (unsigned long long)st.lookups, (unsigned long long)st.loads,
+              (unsigned long long)st.refreshes, (unsigned long long)st.removals, (unsigned long long)st.events);
+}
@@ -0,0 +1,63 @@
+#ifndef DELEGATES_REGISTRY_H_   /* Include guard */
+#define DELEGATES_REGISTRY_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <mongoc/mongoc.h>
+#include <bson/bson.h>
+#include <openssl/evp.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+#include "string_functions.h"
+
+// Fields of a delegates document that lookups can be keyed by
+typedef enum {
+  DELEGATES_KEY_ADDRESS = 0,   // public_address
+  DELEGATES_KEY_NAME,          // delegate_name
+  DELEGATES_KEY_IP,            // IP_address
+  DELEGATES_KEY_PUBLIC_KEY,    // public_key
+  DELEGATES_KEY_COUNT
+} delegates_key_t;
+
+typedef struct {
+  uint64_t lookups;     // reads answered from memory
+  uint64_t loads;       // full reads of the delegates collection
+  uint64_t refreshes;   // documents re-read after a local write
+  uint64_t removals;    // documents dropped after a local write
+  uint64_t events;      // change stream events applied (seed nodes)
+  size_t delegates;
+} delegates_registry_stats_t;
+
+bool delegates_doc_digest(const bson_t* doc, uint8_t out[SHA256_HASH_SIZE]);
+bool delegates_doc_md5_update(EVP_MD_CTX* ctx, const bson_t* doc);
+bool delegates_hash_v2_active(const char* block_height);
+void delegates_digest_add(uint8_t sum[SHA256_HASH_SIZE], const uint8_t digest[SHA256_HASH_SIZE]);
+void delegates_digest_sub(uint8_t sum[SHA256_HASH_SIZE], const uint8_t digest[SHA256_HASH_SIZE]);
+bool delegates_registry_load(void);
+void delegates_registry_clear(void);
+void delegates_registry_refresh(const bson_t* filter);
+bool delegates_registry_apply_set(delegates_key_t key, const char* value, const bson_t* set);
+bool delegates_registry_has(delegates_key_t key, const char* value);
+bool delegates_registry_get_utf8(delegates_key_t key, const char* value, const char* field, char* out, size_t out_size);
+bool delegates_registry_get_int64(delegates_key_t key, const char* value, const char* field, int64_t* out);
+bool delegates_registry_get_double(delegates_key_t key, const char* value, const char* field, double* out);
+int delegates_registry_count(void);
+bool delegates_registry_export(bson_t* reply);
+bool delegates_registry_hash(char* out_hash_hex);
+bool delegates_registry_hash_md5(char* out_hash_hex);
+size_t delegates_registry_leaf_of(const char* public_address, size_t leaf_count);
+bool delegates_registry_leaf_digests(uint8_t (*leaves)[SHA256_HASH_SIZE], size_t leaf_count);
+bool delegates_registry_export_leaves(const bool* leaves, size_t leaf_count, bson_t* reply);
+bool delegates_registry_start_watch(void);
+void delegates_registry_stop_watch(void);
+void delegates_registry_get_stats(delegates_registry_stats_t* out, bool reset);
+void log_delegates_registry_stats(void);
+
+#endif
@@ -1,4 +1,5 @@
 #include "sha256EL.h"
+#include <pthread.h>
 #include <string.h>
 
 #define ROTRIGHT(a,b) (((a) >> (b)) | ((a) << (32-(b))))
@@ -20,6 +21,10 @@ static const uint32_t k[64] = {
   0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
 };
 
+static const uint32_t sha256EL_iv[8] = {
+  0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19
+};
+
 typedef struct {
   uint32_t state[8];
   uint64_t bitlen;
@@ -27,22 +32,24 @@ typedef struct {
   uint32_t datalen;
 } SHA256_EL_CTX;
 
-static void sha256EL_transform(SHA256_EL_CTX *ctx, const uint8_t data[]) {
+typedef void (*sha256EL_blocks_fn)(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+static void sha256EL_transform(uint32_t state[8], const uint8_t data[]) {
   uint32_t a,b,c,d,e,f,g,h,i,j,t1,t2,m[64];
 
   for (i = 0, j = 0; i < 16; ++i, j += 4)
-    m[i] = (data[j] << 24) | (data[j+1] << 16) | (data[j+2] << 8) | (data[j+3]);
+    m[i] = ((uint32_t)data[j] << 24) | ((uint32_t)data[j+1] << 16) | ((uint32_t)data[j+2] << 8) | (data[j+3]);
   for ( ; i < 64; ++i)
     m[i] = SIG1(m[i-2]) + m[i-7] + SIG0(m[i-15]) + m[i-16];
 
-  a = ctx->state[0];
-  b = ctx->state[1];
-  c = ctx->state[2];
-  d = ctx->state[3];
-  e = ctx->state[4];
-  f = ctx->state[5];
-  g = ctx->state[6];
-  h = ctx->state[7];
+  a = state[0];
+  b = state[1];
+  c = state[2];
+  d = state[3];
+  e = state[4];
+  f = state[5];
+  g = state[6];
+  h = state[7];
 
   for (i = 0; i < 64; ++i) {
     t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
@@ -57,39 +64,259 @@ static void sha256EL_transform(SHA256_EL_CTX *ctx, const uint8_t data[]) {
     a = t1 + t2;
   }
 
-  ctx->state[0] += a;
-  ctx->state[1] += b;
-  ctx->state[2] += c;
-  ctx->state[3] += d;
-  ctx->state[4] += e;
-  ctx->state[5] += f;
-  ctx->state[6] += g;
-  ctx->state[7] += h;
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+static void sha256EL_blocks_scalar(uint32_t state[8], const uint8_t *data, size_t blocks) {
+  for (; blocks > 0; blocks--, data += 64) {
+    sha256EL_transform(state, data);
+  }
+}
+
+#ifdef SHA_EL_X86
+#include <immintrin.h>
+
+/*
+ * SHA extensions: two rounds per sha256rnds2, state kept as ABEF/CDGH.
+ * Group j of the message schedule is msg2(msg1(W[j-4], W[j-3]) + W[j-1:j-2] >> 32, W[j-1]).
+ */
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256EL_blocks_shani(uint32_t state[8], const uint8_t *data, size_t blocks) {
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i state0, state1, tmp, msg, m[4];
+
+  tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+  state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);            /* CDAB */
+  state1 = _mm_shuffle_epi32(state1, 0x1B);      /* EFGH */
+  state0 = _mm_alignr_epi8(tmp, state1, 8);      /* ABEF */
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);   /* CDGH */
+
+  for (; blocks > 0; blocks--, data += 64) {
+    const __m128i abef_save = state0;
+    const __m128i cdgh_save = state1;
+
+    for (int j = 0; j < 16; j++) {
+      if (j < 4) {
+        m[j] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * j)), mask);
+      } else {
+        tmp = _mm_add_epi32(_mm_sha256msg1_epu32(m[j & 3], m[(j + 1) & 3]),
+                            _mm_alignr_epi8(m[(j + 3) & 3], m[(j + 2) & 3], 4));
+        m[j & 3] = _mm_sha256msg2_epu32(tmp, m[(j + 3) & 3]);
+      }
+      msg = _mm_add_epi32(m[j & 3], _mm_loadu_si128((const __m128i *)&k[4 * j]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+    }
+
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);         /* FEBA */
+  state1 = _mm_shuffle_epi32(state1, 0xB1);      /* DCHG */
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);   /* DCBA */
+  state1 = _mm_alignr_epi8(state1, tmp, 8);      /* HGFE */
+  _mm_storeu_si128((__m128i *)&state[0], state0);
+  _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+#define X8_ROTR(x,n) _mm256_or_si256(_mm256_srli_epi32((x),(n)), _mm256_slli_epi32((x),32-(n)))
+#define X8_EP0(x) _mm256_xor_si256(_mm256_xor_si256(X8_ROTR(x,2), X8_ROTR(x,13)), X8_ROTR(x,22))
+#define X8_EP1(x) _mm256_xor_si256(_mm256_xor_si256(X8_ROTR(x,6), X8_ROTR(x,11)), X8_ROTR(x,25))
+#define X8_SIG0(x) _mm256_xor_si256(_mm256_xor_si256(X8_ROTR(x,7), X8_ROTR(x,18)), _mm256_srli_epi32((x),3))
+#define X8_SIG1(x) _mm256_xor_si256(_mm256_xor_si256(X8_ROTR(x,17), X8_ROTR(x,19)), _mm256_srli_epi32((x),10))
+
+/*
+ * One compression of eight independent messages, lane i of every vector belonging to message i.
+ */
+__attribute__((target("avx2")))
+static void sha256EL_x8_avx2(__m256i s[8], const uint8_t *const blocks[8]) {
+  const __m256i bswap = _mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,
+                                         3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+  __m256i w[16];
+  __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+  for (int q = 0; q < 4; q++) {
+    // transpose 16-byte chunk q of every block: lanes 0-3 in the low halves, 4-7 in the high halves
+    __m256i r0, r1, r2, r3, t0, t1, t2, t3;
+    r0 = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)(blocks[4] + 16 * q)),
+                          _mm_loadu_si128((const __m128i *)(blocks[0] + 16 * q)));
+    r1 = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)(blocks[5] + 16 * q)),
+                          _mm_loadu_si128((const __m128i *)(blocks[1] + 16 * q)));
+    r2 = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)(blocks[6] + 16 * q)),
+                          _mm_loadu_si128((const __m128i *)(blocks[2] + 16 * q)));
+    r3 = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)(blocks[7] + 16 * q)),
+                          _mm_loadu_si128((const __m128i *)(blocks[3] + 16 * q)));
+    t0 = _mm256_unpacklo_epi32(r0, r1);
+    t1 = _mm256_unpackhi_epi32(r0, r1);
+    t2 = _mm256_unpacklo_epi32(r2, r3);
+    t3 = _mm256_unpackhi_epi32(r2, r3);
+    w[4 * q + 0] = _mm256_shuffle_epi8(_mm256_unpacklo_epi64(t0, t2), bswap);
+    w[4 * q + 1] = _mm256_shuffle_epi8(_mm256_unpackhi_epi64(t0, t2), bswap);
+    w[4 * q + 2] = _mm256_shuffle_epi8(_mm256_unpacklo_epi64(t1, t3), bswap);
+    w[4 * q + 3] = _mm256_shuffle_epi8(_mm256_unpackhi_epi64(t1, t3), bswap);
+  }
+
+  for (int i = 0; i < 64; i++) {
+    __m256i t1, t2;
+    if (i >= 16) {
+      w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(X8_SIG1(w[(i - 2) & 15]), w[(i - 7) & 15]),
+                                   _mm256_add_epi32(X8_SIG0(w[(i - 15) & 15]), w[i & 15]));
+    }
+    t1 = _mm256_add_epi32(_mm256_add_epi32(h, X8_EP1(e)),
+                          _mm256_add_epi32(_mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)),
+                                           _mm256_add_epi32(_mm256_set1_epi32((int)k[i]), w[i & 15])));
+    t2 = _mm256_add_epi32(X8_EP0(a), _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b))));
+    h = g;
+    g = f;
+    f = e;
+    e = _mm256_add_epi32(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm256_add_epi32(t1, t2);
+  }
+
+  s[0] = _mm256_add_epi32(s[0], a);
+  s[1] = _mm256_add_epi32(s[1], b);
+  s[2] = _mm256_add_epi32(s[2], c);
+  s[3] = _mm256_add_epi32(s[3], d);
+  s[4] = _mm256_add_epi32(s[4], e);
+  s[5] = _mm256_add_epi32(s[5], f);
+  s[6] = _mm256_add_epi32(s[6], g);
+  s[7] = _mm256_add_epi32(s[7], h);
+}
+#endif
+
+static void sha256EL_store(const uint32_t state[8], uint8_t *hash) {
+  for (size_t i = 0; i < 8; ++i) {
+    hash[4 * i]     = (uint8_t)(state[i] >> 24);
+    hash[4 * i + 1] = (uint8_t)(state[i] >> 16);
+    hash[4 * i + 2] = (uint8_t)(state[i] >> 8);
+    hash[4 * i + 3] = (uint8_t)(state[i]);
+  }
+}
+
+#ifdef SHA_EL_X86
+static void sha256EL_pad_tail(const uint8_t *data, size_t len, uint8_t tail[128], size_t *tail_blocks) {
+  size_t rem = len % 64;
+  uint64_t bitlen = (uint64_t)len * 8;
+
+  memset(tail, 0, 128);
+  if (rem > 0) memcpy(tail, data + (len - rem), rem);
+  tail[rem] = 0x80;
+  *tail_blocks = rem < 56 ? 1 : 2;
+  for (size_t i = 0; i < 8; i++) {
+    tail[*tail_blocks * 64 - 1 - i] = (uint8_t)(bitlen >> (8 * i));
+  }
+}
+
+/*
+ * Hashes up to eight messages at once. Lanes run for as many blocks as the longest message needs;
+ * a lane whose message is already finished is fed a dummy block and its state is restored.
+ */
+__attribute__((target("avx2")))
+static void sha256EL_multi_avx2_x8(const uint8_t *const *data, const size_t *lens, size_t n, uint8_t (*out)[SHA256_EL_HASH_SIZE]) {
+  static const uint8_t zero_block[64];
+  uint8_t tail[8][128];
+  size_t full[8] = {0}, total[8] = {0}, max_blocks = 0;
+  const uint8_t *blocks[8];
+  __m256i s[8], saved[8];
+  uint32_t lanes[8][8];
+
+  for (size_t i = 0; i < 8; i++) {
+    if (i < n) {
+      size_t tail_blocks;
+      sha256EL_pad_tail(data[i], lens[i], tail[i], &tail_blocks);
+      full[i] = lens[i] / 64;
+      total[i] = full[i] + tail_blocks;
+      if (total[i] > max_blocks) max_blocks = total[i];
+    }
+  }
+  for (size_t w = 0; w < 8; w++) {
+    s[w] = _mm256_set1_epi32((int)sha256EL_iv[w]);
+  }
+
+  for (size_t b = 0; b < max_blocks; b++) {
+    uint32_t active_bits[8];
+    for (size_t i = 0; i < 8; i++) {
+      active_bits[i] = b < total[i] ? 0xFFFFFFFFU : 0;
+      blocks[i] = b < full[i] ? data[i] + 64 * b : (b < total[i] ? tail[i] + 64 * (b - full[i]) : zero_block);
+    }
+    const __m256i active = _mm256_loadu_si256((const __m256i *)active_bits);
+    memcpy(saved, s, sizeof(saved));
+    sha256EL_x8_avx2(s, blocks);
+    for (size_t w = 0; w < 8; w++) {
+      s[w] = _mm256_blendv_epi8(saved[w], s[w], active);
+    }
+  }
+
+  for (size_t w = 0; w < 8; w++) {
+    uint32_t word[8];
+    _mm256_storeu_si256((__m256i *)word, s[w]);
+    for (size_t i = 0; i < 8; i++) lanes[i][w] = word[i];
+  }
+  for (size_t i = 0; i < n; i++) {
+    sha256EL_store(lanes[i], out[i]);
+  }
+}
+#endif
+
+static sha256EL_blocks_fn sha256EL_blocks = sha256EL_blocks_scalar;
+static sha_el_impl_t sha256EL_active = SHA_EL_IMPL_SCALAR;
+static sha_el_impl_t sha256EL_multi_active = SHA_EL_IMPL_SCALAR;
+static pthread_once_t sha256EL_once = PTHREAD_ONCE_INIT;
+
+static void sha256EL_select(void) {
+#ifdef SHA_EL_X86
+  if (sha_el_cpu_supports(SHA_EL_IMPL_SHANI)) {
+    sha256EL_blocks = sha256EL_blocks_shani;
+    sha256EL_active = SHA_EL_IMPL_SHANI;
+  }
+  // with SHA extensions a message at a time is already faster than eight AVX2 lanes
+  sha256EL_multi_active = sha256EL_active;
+  if (sha256EL_multi_active == SHA_EL_IMPL_SCALAR && sha_el_cpu_supports(SHA_EL_IMPL_AVX2)) {
+    sha256EL_multi_active = SHA_EL_IMPL_AVX2;
+  }
+#endif
 }
 
 static void sha256EL_init(SHA256_EL_CTX *ctx) {
+  pthread_once(&sha256EL_once, sha256EL_select);
   ctx->datalen = 0;
   ctx->bitlen = 0;
-  ctx->state[0] = 0x6a09e667;
-  ctx->state[1] = 0xbb67ae85;
-  ctx->state[2] = 0x3c6ef372;
-  ctx->state[3] = 0xa54ff53a;
-  ctx->state[4] = 0x510e527f;
-  ctx->state[5] = 0x9b05688c;
-  ctx->state[6] = 0x1f83d9ab;
-  ctx->state[7] = 0x5be0cd19;
+  memcpy(ctx->state, sha256EL_iv, sizeof(ctx->state));
 }
 
 static void sha256EL_update(SHA256_EL_CTX *ctx, const uint8_t *data, size_t len) {
-  for (size_t i = 0; i < len; ++i) {
-    ctx->data[ctx->datalen] = data[i];
-    ctx->datalen++;
-    if (ctx->datalen == 64) {
-      sha256EL_transform(ctx, ctx->data);
-      ctx->bitlen += 512;
-      ctx->datalen = 0;
-    }
+  if (ctx->datalen > 0) {
+    size_t take = 64 - ctx->datalen;
+    if (take > len) take = len;
+    memcpy(ctx->data + ctx->datalen, data, take);
+    ctx->datalen += (uint32_t)take;
+    data += take;
+    len -= take;
+    if (ctx->datalen < 64) return;
+    sha256EL_blocks(ctx->state, ctx->data, 1);
+    ctx->bitlen += 512;
+    ctx->datalen = 0;
   }
+  if (len >= 64) {
+    sha256EL_blocks(ctx->state, data, len / 64);
+    ctx->bitlen += (uint64_t)(len / 64) * 512;
+    data += len & ~(size_t)63;
+    len &= 63;
+  }
+  memcpy(ctx->data, data, len);
+  ctx->datalen = (uint32_t)len;
 }
 
 static void sha256EL_final(SHA256_EL_CTX *ctx, uint8_t *hash) {
@@ -102,7 +329,7 @@ static void sha256EL_final(SHA256_EL_CTX *ctx, uint8_t *hash) {
   } else {
     ctx->data[i++] = 0x80;
     while (i < 64) ctx->data[i++] = 0x00;
-    sha256EL_transform(ctx, ctx->data);
+    sha256EL_blocks(ctx->state, ctx->data, 1);
     memset(ctx->data, 0, 56);
   }
 
@@ -116,19 +343,10 @@ static void sha256EL_final(SHA256_EL_CTX *ctx, uint8_t *hash) {
   ctx->data[58] = ctx->bitlen >> 40;
   ctx->data[57] = ctx->bitlen >> 48;
   ctx->data[56] = ctx->bitlen >> 56;
-  sha256EL_transform(ctx, ctx->data);
+  sha256EL_blocks(ctx->state, ctx->data, 1);
 
   // Convert to big endian
-  for (i = 0; i < 4; ++i) {
-    hash[i]      = (ctx->state[0] >> (24 - i * 8)) & 0xff;
-    hash[i + 4]  = (ctx->state[1] >> (24 - i * 8)) & 0xff;
-    hash[i + 8]  = (ctx->state[2] >> (24 - i * 8)) & 0xff;
-    hash[i + 12] = (ctx->state[3] >> (24 - i * 8)) & 0xff;
-    hash[i + 16] = (ctx->state[4] >> (24 - i * 8)) & 0xff;
-    hash[i + 20] = (ctx->state[5] >> (24 - i * 8)) & 0xff;
-    hash[i + 24] = (ctx->state[6] >> (24 - i * 8)) & 0xff;
-    hash[i + 28] = (ctx->state[7] >> (24 - i * 8)) & 0xff;
-  }
+  sha256EL_store(ctx->state, hash);
 }
 
 void sha256EL(const uint8_t *data, size_t len, uint8_t *out_hash) {
@@ -136,4 +354,67 @@ void sha256EL(const uint8_t *data, size_t len, uint8_t *out_hash) {
   sha256EL_init(&ctx);
   sha256EL_update(&ctx, data, len);
   sha256EL_final(&ctx, out_hash);
-}
\ No newline at end of file
+}
+
+/*
+ * out[i] = SHA-256(data[i][0..lens[i]-1]) for every i < n; messages may have different lengths.
+ */
+void sha256EL_multi(const uint8_t *const *data, const size_t *lens, size_t n, uint8_t (*out)[SHA256_EL_HASH_SIZE]) {
+  pthread_once(&sha256EL_once, sha256EL_select);
+#ifdef SHA_EL_X86
+  if (sha256EL_multi_active == SHA_EL_IMPL_AVX2) {
+    for (size_t i = 0; i < n; i += 8) {
+      sha256EL_multi_avx2_x8(data + i, lens + i, n - i < 8 ? n - i : 8, out + i);
+    }
+    return;
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    sha256EL(data[i], lens[i], out[i]);
+  }
+}
+
+/*
+ * Forces one back end (SHA_EL_IMPL_AUTO restores the startup choice); for benchmarks and known-answer
+ * tests only, not safe while other threads hash. Returns 1 if the back end is available here.
+ */
+int sha256EL_set_impl(sha_el_impl_t impl) {
+  pthread_once(&sha256EL_once, sha256EL_select);
+  if (!sha_el_cpu_supports(impl)) return 0;
+  switch (impl) {
+    case SHA_EL_IMPL_AUTO:
+      sha256EL_blocks = sha256EL_blocks_scalar;
+      sha256EL_active = SHA_EL_IMPL_SCALAR;
+      sha256EL_multi_active = SHA_EL_IMPL_SCALAR;
+      sha256EL_select();
+      return 1;
+    case SHA_EL_IMPL_SCALAR:
+      sha256EL_blocks = sha256EL_blocks_scalar;
+      sha256EL_active = sha256EL_multi_active = SHA_EL_IMPL_SCALAR;
+      return 1;
+#ifdef SHA_EL_X86
+    case SHA_EL_IMPL_SHANI:
+      sha256EL_blocks = sha256EL_blocks_shani;
+      sha256EL_active = sha256EL_multi_active = SHA_EL_IMPL_SHANI;
+      return 1;
+    case SHA_EL_IMPL_AVX2:
+      // AVX2 only has a multi-buffer path; single messages stay on the scalar code
+      sha256EL_blocks = sha256EL_blocks_scalar;
+      sha256EL_active = SHA_EL_IMPL_SCALAR;
+      sha256EL_multi_active = SHA_EL_IMPL_AVX2;
+      return 1;
+#endif
+    default:
+      return 0;
+  }
+}
+
+sha_el_impl_t sha256EL_get_impl(void) {
+  pthread_once(&sha256EL_once, sha256EL_select);
+  return sha256EL_active;
+}
+
+sha_el_impl_t sha256EL_get_multi_impl(void) {
+  pthread_once(&sha256EL_once, sha256EL_select);
+  return sha256EL_multi_active;
+}
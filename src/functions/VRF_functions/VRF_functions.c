@@ -177,7 +177,10 @@ int VRF_data_verify(const char* BLOCK_VERIFIERS_PUBLIC_KEY, const char* BLOCK_VE
     beta_string_data[i / 2] = (unsigned char)strtol(hex_byte, NULL, 16);
   }
 
-  // Verify
-  return crypto_vrf_verify(beta_string_data, public_key_data, proof_data,
-    (const unsigned char*)DATA, (unsigned long long)strlen(DATA)) == 0 ? XCASH_OK : XCASH_ERROR;
-}
\ No newline at end of file
+  // Verify; a single-proof batch takes the vartime path and the cached delegate key
+  const unsigned char* msg = (const unsigned char*)DATA;
+  unsigned long long msg_len = (unsigned long long)strlen(DATA);
+  int result = -1;
+  crypto_vrf_verify_batch(beta_string_data, public_key_data, proof_data, &msg, &msg_len, 1, &result);
+  return result == 0 ? XCASH_OK : XCASH_ERROR;
+}
@@ -11,6 +11,8 @@
 #include "convert.h"
 #include "vrf.h"
 #include "crypto_vrf.h"
+#include "sha256EL.h"
+#include "sha512EL.h"
 
 int create_random_VRF_keys(unsigned char *public_key, unsigned char *secret_key);
 void generate_key(void);
@@ -68,11 +68,24 @@ _vrf_ietfdraft03_hash_to_curve_elligator2_25519(unsigned char H_string[32],
 						const unsigned char *alpha,
 						const unsigned long long alphalen)
 {
-    crypto_hash_sha512_state hs;
     unsigned char Y_string[32];
-    unsigned char r_string[64];
 
     _vrf_ietfdraft03_point_to_string(Y_string, Y_point);
+    _vrf_ietfdraft03_hash_to_curve_elligator2_25519_string(H_string, Y_string, alpha, alphalen);
+}
+
+/* Same as _vrf_ietfdraft03_hash_to_curve_elligator2_25519, for a public key
+ * that is already encoded (Y_string must be the canonical encoding of Y).
+ * Saves re-encoding the point, which costs a field inversion.
+ */
+void
+_vrf_ietfdraft03_hash_to_curve_elligator2_25519_string(unsigned char H_string[32],
+						       const unsigned char Y_string[32],
+						       const unsigned char *alpha,
+						       const unsigned long long alphalen)
+{
+    crypto_hash_sha512_state hs;
+    unsigned char r_string[64];
 
     crypto_hash_sha512_init(&hs);
     crypto_hash_sha512_update(&hs, &SUITE, 1);
@@ -42,6 +42,11 @@ void _vrf_ietfdraft03_hash_to_curve_elligator2_25519(unsigned char H_string[32],
 						     const unsigned char *alpha,
 						     const unsigned long long alphalen);
 
+void _vrf_ietfdraft03_hash_to_curve_elligator2_25519_string(unsigned char H_string[32],
+							    const unsigned char Y_string[32],
+							    const unsigned char *alpha,
+							    const unsigned long long alphalen);
+
 void _vrf_ietfdraft03_hash_points(unsigned char c[16], const ge25519_p3 *P1,
 				  const ge25519_p3 *P2, const ge25519_p3 *P3,
 				  const ge25519_p3 *P4);
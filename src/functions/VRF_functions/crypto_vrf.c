@@ -98,6 +98,20 @@ crypto_vrf_proof_to_hash(unsigned char *hash, const unsigned char *proof)
     return crypto_vrf_ietfdraft03_proof_to_hash(hash, proof);
 }
 
+size_t
+crypto_vrf_key_cache_set(const unsigned char *pks, size_t n)
+{
+    return crypto_vrf_ietfdraft03_key_cache_set(pks, n);
+}
+
+size_t
+crypto_vrf_verify_batch(unsigned char *outputs, const unsigned char *pks,
+			const unsigned char *proofs, const unsigned char * const *msgs,
+			const unsigned long long *msglens, size_t n, int *results)
+{
+    return crypto_vrf_ietfdraft03_verify_batch(outputs, pks, proofs, msgs, msglens, n, results);
+}
+
 void
 crypto_vrf_sk_to_pk(unsigned char *pk, const unsigned char *skpk)
 {
@@ -74,6 +74,12 @@ int crypto_vrf_verify(unsigned char *output,
 
 int crypto_vrf_proof_to_hash(unsigned char *hash, const unsigned char *proof);
 
+size_t crypto_vrf_key_cache_set(const unsigned char *pks, size_t n);
+
+size_t crypto_vrf_verify_batch(unsigned char *outputs, const unsigned char *pks,
+			       const unsigned char *proofs, const unsigned char * const *msgs,
+			       const unsigned long long *msglens, size_t n, int *results);
+
 void crypto_vrf_sk_to_pk(unsigned char *pk, const unsigned char *skpk);
 
 void crypto_vrf_sk_to_seed(unsigned char *seed, const unsigned char *skpk);
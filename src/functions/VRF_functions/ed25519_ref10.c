@@ -668,6 +668,29 @@ ge25519_tobytes(unsigned char *s, const ge25519_p2 *h)
     s[31] ^= fe25519_isnegative(x) << 7;
 }
 
+/*
+ Ai = A,3A,5A,7A,9A,11A,13A,15A, the table used by the vartime double scalar
+ multiplications below.
+ */
+
+void
+ge25519_cached_odd_multiples(ge25519_cached Ai[8], const ge25519_p3 *A)
+{
+    ge25519_p1p1 t;
+    ge25519_p3   u;
+    ge25519_p3   A2;
+    int          i;
+
+    ge25519_p3_to_cached(&Ai[0], A);
+    ge25519_p3_dbl(&t, A);
+    ge25519_p1p1_to_p3(&A2, &t);
+    for (i = 1; i < 8; i++) {
+        ge25519_add(&t, &A2, &Ai[i - 1]);
+        ge25519_p1p1_to_p3(&u, &t);
+        ge25519_p3_to_cached(&Ai[i], &u);
+    }
+}
+
 /*
  r = a * A + b * B
  where a = a[0]+256*a[1]+...+256^31 a[31].
@@ -680,6 +703,23 @@ ge25519_tobytes(unsigned char *s, const ge25519_p2 *h)
 void
 ge25519_double_scalarmult_vartime(ge25519_p2 *r, const unsigned char *a,
                                   const ge25519_p3 *A, const unsigned char *b)
+{
+    ge25519_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
+
+    ge25519_cached_odd_multiples(Ai, A);
+    ge25519_double_scalarmult_vartime_cached(r, a, Ai, b);
+}
+
+/*
+ Same as ge25519_double_scalarmult_vartime, with the odd multiples of A
+ (A,3A,...,15A, from ge25519_cached_odd_multiples) computed in advance, so a
+ key that is verified against repeatedly only pays for its table once.
+ */
+
+void
+ge25519_double_scalarmult_vartime_cached(ge25519_p2 *r, const unsigned char *a,
+                                         const ge25519_cached Ai[8],
+                                         const unsigned char *b)
 {
     static const ge25519_precomp Bi[8] = {
 #ifdef HAVE_TI_MODE
@@ -690,47 +730,73 @@ ge25519_double_scalarmult_vartime(ge25519_p2 *r, const unsigned char *a,
     };
     signed char    aslide[256];
     signed char    bslide[256];
-    ge25519_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
     ge25519_p1p1   t;
     ge25519_p3     u;
-    ge25519_p3     A2;
     int            i;
 
     slide_vartime(aslide, a);
     slide_vartime(bslide, b);
 
-    ge25519_p3_to_cached(&Ai[0], A);
+    ge25519_p2_0(r);
 
-    ge25519_p3_dbl(&t, A);
-    ge25519_p1p1_to_p3(&A2, &t);
+    for (i = 255; i >= 0; --i) {
+        if (aslide[i] || bslide[i]) {
+            break;
+        }
+    }
 
-    ge25519_add(&t, &A2, &Ai[0]);
-    ge25519_p1p1_to_p3(&u, &t);
-    ge25519_p3_to_cached(&Ai[1], &u);
+    for (; i >= 0; --i) {
+        ge25519_p2_dbl(&t, r);
 
-    ge25519_add(&t, &A2, &Ai[1]);
-    ge25519_p1p1_to_p3(&u, &t);
-    ge25519_p3_to_cached(&Ai[2], &u);
+        if (aslide[i] > 0) {
+            ge25519_p1p1_to_p3(&u, &t);
+            ge25519_add(&t, &u, &Ai[aslide[i] / 2]);
+        } else if (aslide[i] < 0) {
+            ge25519_p1p1_to_p3(&u, &t);
+            ge25519_sub(&t, &u, &Ai[(-aslide[i]) / 2]);
+        }
 
-    ge25519_add(&t, &A2, &Ai[2]);
-    ge25519_p1p1_to_p3(&u, &t);
-    ge25519_p3_to_cached(&Ai[3], &u);
+        if (bslide[i] > 0) {
+            ge25519_p1p1_to_p3(&u, &t);
+            ge25519_madd(&t, &u, &Bi[bslide[i] / 2]);
+        } else if (bslide[i] < 0) {
+            ge25519_p1p1_to_p3(&u, &t);
+            ge25519_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+        }
 
-    ge25519_add(&t, &A2, &Ai[3]);
-    ge25519_p1p1_to_p3(&u, &t);
-    ge25519_p3_to_cached(&Ai[4], &u);
+        ge25519_p1p1_to_p2(r, &t);
+    }
+}
 
-    ge25519_add(&t, &A2, &Ai[4]);
-    ge25519_p1p1_to_p3(&u, &t);
-    ge25519_p3_to_cached(&Ai[5], &u);
+/*
+ r = a * A + b * B
+ where a = a[0]+256*a[1]+...+256^31 a[31].
+ and b = b[0]+256*b[1]+...+256^31 b[31].
+ A and B are arbitrary points (B is not the base point).
 
-    ge25519_add(&t, &A2, &Ai[5]);
-    ge25519_p1p1_to_p3(&u, &t);
-    ge25519_p3_to_cached(&Ai[6], &u);
+ Preconditions:
+ a[31] <= 127, b[31] <= 127
 
-    ge25519_add(&t, &A2, &Ai[6]);
-    ge25519_p1p1_to_p3(&u, &t);
-    ge25519_p3_to_cached(&Ai[7], &u);
+ Only used for VRF proof verification, where every input is public.
+ */
+
+void
+ge25519_double_scalarmult_vartime_points(ge25519_p2 *r, const unsigned char *a,
+                                         const ge25519_p3 *A, const unsigned char *b,
+                                         const ge25519_p3 *B)
+{
+    signed char    aslide[256];
+    signed char    bslide[256];
+    ge25519_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
+    ge25519_cached Bi[8]; /* B,3B,5B,7B,9B,11B,13B,15B */
+    ge25519_p1p1   t;
+    ge25519_p3     u;
+    int            i;
+
+    slide_vartime(aslide, a);
+    slide_vartime(bslide, b);
+    ge25519_cached_odd_multiples(Ai, A);
+    ge25519_cached_odd_multiples(Bi, B);
 
     ge25519_p2_0(r);
 
@@ -753,10 +819,10 @@ ge25519_double_scalarmult_vartime(ge25519_p2 *r, const unsigned char *a,
 
         if (bslide[i] > 0) {
             ge25519_p1p1_to_p3(&u, &t);
-            ge25519_madd(&t, &u, &Bi[bslide[i] / 2]);
+            ge25519_add(&t, &u, &Bi[bslide[i] / 2]);
         } else if (bslide[i] < 0) {
             ge25519_p1p1_to_p3(&u, &t);
-            ge25519_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+            ge25519_sub(&t, &u, &Bi[(-bslide[i]) / 2]);
         }
 
         ge25519_p1p1_to_p2(r, &t);
@@ -32,7 +32,11 @@ SOFTWARE.
  Here the field is \Z/(2^255-19).
  */
 
+#ifdef HAVE_TI_MODE
+typedef uint64_t fe25519[5];
+#else
 typedef int32_t fe25519[10];
+#endif
 
 
 void fe25519_invert(fe25519 out, const fe25519 z);
@@ -40,7 +44,11 @@ void fe25519_frombytes(fe25519 h, const unsigned char *s);
 void fe25519_tobytes(unsigned char *s, const fe25519 h);
 
 
+#ifdef HAVE_TI_MODE
+# include "ed25519_ref10_fe_51.h"
+#else
 # include "ed25519_ref10_fe_25_5.h"
+#endif
 
 
 /*
@@ -110,10 +118,20 @@ void ge25519_sub(ge25519_p1p1 *r, const ge25519_p3 *p, const ge25519_cached *q);
 
 void ge25519_scalarmult_base(ge25519_p3 *h, const unsigned char *a);
 
+void ge25519_cached_odd_multiples(ge25519_cached Ai[8], const ge25519_p3 *A);
+
 void ge25519_double_scalarmult_vartime(ge25519_p2 *r, const unsigned char *a,
                                        const ge25519_p3 *A,
                                        const unsigned char *b);
 
+void ge25519_double_scalarmult_vartime_cached(ge25519_p2 *r, const unsigned char *a,
+                                              const ge25519_cached Ai[8],
+                                              const unsigned char *b);
+
+void ge25519_double_scalarmult_vartime_points(ge25519_p2 *r, const unsigned char *a,
+                                              const ge25519_p3 *A, const unsigned char *b,
+                                              const ge25519_p3 *B);
+
 void ge25519_scalarmult(ge25519_p3 *h, const unsigned char *a,
                         const ge25519_p3 *p);
 
@@ -0,0 +1,36 @@
+/*
+Copyright (c) 2018 Amir Hossein Alikhah Mishamandani
+Copyright (c) 2018 Algorand LLC
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* 37095705934669439343138083508754565189542113879843219016388785533085940283555 */
+static const fe25519 d = { 929955233495203, 466365720129213, 1662059464998953, 2033849074728123, 1442794654840575 };
+
+/* 2 * d =
+ * 16295367250680780974490674513165176452449235426866156013048779062215315747161
+ */
+static const fe25519 d2 = { 1859910466990425, 932731440258426, 1072319116312658, 1815898335770999, 633789495995903 };
+
+/* sqrt(-1) */
+static const fe25519 sqrtm1 = { 1718705420411056, 234908883556509, 2233514472574048, 2117202627021982, 765476049583133 };
+
+/* A = 486662 */
+static const fe25519 curve25519_A = { 486662, 0, 0, 0, 0 };
@@ -3,9 +3,14 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "sha_dispatch.h"
 
 #define SHA256_EL_HASH_SIZE 32
 
 void sha256EL(const uint8_t *data, size_t len, uint8_t *out_hash);
+void sha256EL_multi(const uint8_t *const *data, const size_t *lens, size_t n, uint8_t (*out)[SHA256_EL_HASH_SIZE]);
+int sha256EL_set_impl(sha_el_impl_t impl);
+sha_el_impl_t sha256EL_get_impl(void);
+sha_el_impl_t sha256EL_get_multi_impl(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -26,6 +26,7 @@ SOFTWARE.
 #include <stdlib.h>
 #include <string.h>
 
+#include <pthread.h>
 #include <sys/types.h>
 #include "sha512EL.h"
 #include "common.h"
@@ -153,6 +154,120 @@ SHA512_Transform(uint64_t *state, const uint8_t block[128], uint64_t W[80],
     }
 }
 
+#ifdef SHA_EL_X86
+#include <immintrin.h>
+
+#define X2_ROTR(x, n) _mm_or_si128(_mm_srli_epi64((x), (n)), _mm_slli_epi64((x), 64 - (n)))
+
+/*
+ The message schedule has no dependency between W[t] and W[t+1], so it is
+ computed two words at a time; the rounds are the scalar ones, built with
+ BMI2 so that the rotations become rorx.
+ */
+
+__attribute__((target("avx2,bmi2")))
+static void
+SHA512_Transform_avx2(uint64_t *state, const uint8_t block[128], uint64_t W[80],
+                      uint64_t S[8])
+{
+    int i;
+
+    be64dec_vect(W, block, 128);
+    for (i = 16; i < 80; i += 2) {
+        const __m128i w2  = _mm_loadu_si128((const __m128i *) &W[i - 2]);
+        const __m128i w15 = _mm_loadu_si128((const __m128i *) &W[i - 15]);
+        const __m128i sig1 = _mm_xor_si128(_mm_xor_si128(X2_ROTR(w2, 19), X2_ROTR(w2, 61)),
+                                           _mm_srli_epi64(w2, 6));
+        const __m128i sig0 = _mm_xor_si128(_mm_xor_si128(X2_ROTR(w15, 1), X2_ROTR(w15, 8)),
+                                           _mm_srli_epi64(w15, 7));
+        const __m128i w = _mm_add_epi64(_mm_add_epi64(sig1, _mm_loadu_si128((const __m128i *) &W[i - 7])),
+                                        _mm_add_epi64(sig0, _mm_loadu_si128((const __m128i *) &W[i - 16])));
+        _mm_storeu_si128((__m128i *) &W[i], w);
+    }
+    memcpy(S, state, 64);
+    for (i = 0; i < 80; i += 16) {
+        RNDr(S, W, 0, i);
+        RNDr(S, W, 1, i);
+        RNDr(S, W, 2, i);
+        RNDr(S, W, 3, i);
+        RNDr(S, W, 4, i);
+        RNDr(S, W, 5, i);
+        RNDr(S, W, 6, i);
+        RNDr(S, W, 7, i);
+        RNDr(S, W, 8, i);
+        RNDr(S, W, 9, i);
+        RNDr(S, W, 10, i);
+        RNDr(S, W, 11, i);
+        RNDr(S, W, 12, i);
+        RNDr(S, W, 13, i);
+        RNDr(S, W, 14, i);
+        RNDr(S, W, 15, i);
+    }
+    for (i = 0; i < 8; i++) {
+        state[i] += S[i];
+    }
+}
+#endif
+
+typedef void (*SHA512_Transform_fn)(uint64_t *state, const uint8_t block[128],
+                                    uint64_t W[80], uint64_t S[8]);
+
+static SHA512_Transform_fn SHA512_Transform_active = SHA512_Transform;
+static sha_el_impl_t       sha512EL_active = SHA_EL_IMPL_SCALAR;
+static pthread_once_t      sha512EL_once = PTHREAD_ONCE_INIT;
+
+static void
+sha512EL_select(void)
+{
+#ifdef SHA_EL_X86
+    if (sha_el_cpu_supports(SHA_EL_IMPL_AVX2)) {
+        SHA512_Transform_active = SHA512_Transform_avx2;
+        sha512EL_active = SHA_EL_IMPL_AVX2;
+    }
+#endif
+}
+
+/*
+ Forces one back end (SHA_EL_IMPL_AUTO restores the startup choice); for
+ benchmarks and known-answer tests only, not safe while other threads hash.
+ Returns 1 if the back end is available here.
+ */
+
+int
+sha512EL_set_impl(sha_el_impl_t impl)
+{
+    pthread_once(&sha512EL_once, sha512EL_select);
+    if (!sha_el_cpu_supports(impl)) {
+        return 0;
+    }
+    switch (impl) {
+    case SHA_EL_IMPL_AUTO:
+        SHA512_Transform_active = SHA512_Transform;
+        sha512EL_active = SHA_EL_IMPL_SCALAR;
+        sha512EL_select();
+        return 1;
+    case SHA_EL_IMPL_SCALAR:
+        SHA512_Transform_active = SHA512_Transform;
+        sha512EL_active = SHA_EL_IMPL_SCALAR;
+        return 1;
+#ifdef SHA_EL_X86
+    case SHA_EL_IMPL_AVX2:
+        SHA512_Transform_active = SHA512_Transform_avx2;
+        sha512EL_active = SHA_EL_IMPL_AVX2;
+        return 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+sha_el_impl_t
+sha512EL_get_impl(void)
+{
+    pthread_once(&sha512EL_once, sha512EL_select);
+    return sha512EL_active;
+}
+
 static const uint8_t PAD[128] = {
     0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -177,11 +292,11 @@ SHA512_Pad(crypto_hash_sha512_state *state, uint64_t tmp64[80 + 8])
         for (i = 0; i < 128 - r; i++) {
             state->buf[r + i] = PAD[i];
         }
-        SHA512_Transform(state->state, state->buf, &tmp64[0], &tmp64[80]);
+        SHA512_Transform_active(state->state, state->buf, &tmp64[0], &tmp64[80]);
         memset(&state->buf[0], 0, 112);
     }
     be64enc_vect(&state->buf[112], state->count, 16);
-    SHA512_Transform(state->state, state->buf, &tmp64[0], &tmp64[80]);
+    SHA512_Transform_active(state->state, state->buf, &tmp64[0], &tmp64[80]);
 }
 
 int
@@ -193,6 +308,7 @@ crypto_hash_sha512_init(crypto_hash_sha512_state *state)
         0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
     };
 
+    pthread_once(&sha512EL_once, sha512EL_select);
     state->count[0] = state->count[1] = (uint64_t) 0U;
     memcpy(state->state, sha512_initial_state, sizeof sha512_initial_state);
 
@@ -230,12 +346,12 @@ crypto_hash_sha512_update(crypto_hash_sha512_state *state,
     for (i = 0; i < 128 - r; i++) {
         state->buf[r + i] = in[i];
     }
-    SHA512_Transform(state->state, state->buf, &tmp64[0], &tmp64[80]);
+    SHA512_Transform_active(state->state, state->buf, &tmp64[0], &tmp64[80]);
     in += 128 - r;
     inlen -= 128 - r;
 
     while (inlen >= 128) {
-        SHA512_Transform(state->state, in, &tmp64[0], &tmp64[80]);
+        SHA512_Transform_active(state->state, in, &tmp64[0], &tmp64[80]);
         in += 128;
         inlen -= 128;
     }
@@ -27,6 +27,7 @@ SOFTWARE.
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include "sha_dispatch.h"
 
 
 typedef struct crypto_hash_sha512_state {
@@ -58,4 +59,10 @@ int crypto_hash_sha512_final(crypto_hash_sha512_state *state,
                              unsigned char *out);
 
 
+int sha512EL_set_impl(sha_el_impl_t impl);
+
+
+sha_el_impl_t sha512EL_get_impl(void);
+
+
 #endif
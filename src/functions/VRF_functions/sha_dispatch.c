@@ -0,0 +1,57 @@
+#include "sha_dispatch.h"
+
+#ifdef SHA_EL_X86
+#include <cpuid.h>
+
+#define SHA_EL_CPUID_SHA  (1U << 29)   /* leaf 7 ebx */
+#define SHA_EL_CPUID_AVX2 (1U << 5)    /* leaf 7 ebx */
+#define SHA_EL_CPUID_BMI2 (1U << 8)    /* leaf 7 ebx */
+#define SHA_EL_CPUID_SSE41 (1U << 19)  /* leaf 1 ecx */
+#define SHA_EL_CPUID_SSSE3 (1U << 9)   /* leaf 1 ecx */
+#define SHA_EL_CPUID_OSXSAVE (1U << 27) /* leaf 1 ecx */
+
+static uint64_t sha_el_xgetbv(void)
+{
+  uint32_t lo, hi;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+int sha_el_cpu_supports(sha_el_impl_t impl)
+{
+  unsigned int eax, ebx, ecx, edx;
+  unsigned int ecx1, ebx7;
+
+  if (impl == SHA_EL_IMPL_AUTO || impl == SHA_EL_IMPL_SCALAR) return 1;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+  ecx1 = ecx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+  ebx7 = ebx;
+
+  switch (impl) {
+    case SHA_EL_IMPL_SHANI:
+      return (ebx7 & SHA_EL_CPUID_SHA) && (ecx1 & SHA_EL_CPUID_SSE41) && (ecx1 & SHA_EL_CPUID_SSSE3);
+    case SHA_EL_IMPL_AVX2:
+      // the OS must also save the YMM registers across context switches
+      return (ebx7 & SHA_EL_CPUID_AVX2) && (ebx7 & SHA_EL_CPUID_BMI2) && (ecx1 & SHA_EL_CPUID_OSXSAVE) &&
+             (sha_el_xgetbv() & 0x6) == 0x6;
+    default:
+      return 0;
+  }
+}
+#else
+int sha_el_cpu_supports(sha_el_impl_t impl)
+{
+  return impl == SHA_EL_IMPL_AUTO || impl == SHA_EL_IMPL_SCALAR;
+}
+#endif
+
+const char *sha_el_impl_name(sha_el_impl_t impl)
+{
+  switch (impl) {
+    case SHA_EL_IMPL_SCALAR: return "scalar";
+    case SHA_EL_IMPL_SHANI:  return "sha-ni";
+    case SHA_EL_IMPL_AVX2:   return "avx2";
+    default:                 return "auto";
+  }
+}
@@ -0,0 +1,22 @@
+#ifndef SHA_DISPATCH_H
+#define SHA_DISPATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA_EL_X86 1
+#endif
+
+/* Compression-function back ends for sha256EL / sha512EL, picked once from CPUID */
+typedef enum {
+  SHA_EL_IMPL_AUTO = 0,   /* best supported, as chosen at startup */
+  SHA_EL_IMPL_SCALAR,     /* portable C */
+  SHA_EL_IMPL_SHANI,      /* Intel SHA extensions (SHA-256 only) */
+  SHA_EL_IMPL_AVX2        /* AVX2: 8-lane multi-buffer SHA-256, vector message schedule for SHA-512 */
+} sha_el_impl_t;
+
+int sha_el_cpu_supports(sha_el_impl_t impl);
+const char *sha_el_impl_name(sha_el_impl_t impl);
+
+#endif
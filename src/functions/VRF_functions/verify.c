@@ -25,6 +25,8 @@ SOFTWARE.
 
 
 #include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 #include "sha512EL.h"
 #include "crypto_verify_16.h"
@@ -110,6 +112,100 @@ crypto_vrf_ietfdraft03_is_valid_key(const unsigned char pk[crypto_vrf_ietfdraft0
     return (vrf_validate_key(&point, pk) == 0);
 }
 
+/* Decoded delegate VRF keys. Keys come from a small set that rarely changes, so
+ * each is validated, decompressed and expanded to the odd multiples table of
+ * the vartime path once per delegates load instead of once per proof.
+ */
+typedef struct {
+    unsigned char  pk[crypto_vrf_ietfdraft03_PUBLICKEYBYTES];
+    ge25519_p3     Y;
+    ge25519_cached Y_multiples[8]; /* Y,3Y,...,15Y */
+} vrf_key_entry;
+
+static vrf_key_entry    vrf_key_cache[crypto_vrf_ietfdraft03_KEYCACHEMAX];
+static size_t           vrf_key_cache_count = 0;
+static pthread_rwlock_t vrf_key_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Copy the cached entry for pk into *out. Returns 0 on a hit, -1 otherwise. */
+static int
+vrf_key_cache_find(vrf_key_entry *out, const unsigned char pk[32])
+{
+    int found = -1;
+    size_t i;
+
+    pthread_rwlock_rdlock(&vrf_key_cache_lock);
+    for (i = 0; i < vrf_key_cache_count; i++) {
+	if (memcmp(vrf_key_cache[i].pk, pk, crypto_vrf_ietfdraft03_PUBLICKEYBYTES) == 0) {
+	    *out = vrf_key_cache[i];
+	    found = 0;
+	    break;
+	}
+    }
+    pthread_rwlock_unlock(&vrf_key_cache_lock);
+    return found;
+}
+
+/* Validate and expand an untrusted public key. Returns 0 on success, -1 if
+ * the key fails vrf_validate_key. */
+static int
+vrf_key_entry_init(vrf_key_entry *out, const unsigned char pk[32])
+{
+    if (vrf_validate_key(&out->Y, pk) != 0) {
+	return -1;
+    }
+    memcpy(out->pk, pk, crypto_vrf_ietfdraft03_PUBLICKEYBYTES);
+    ge25519_cached_odd_multiples(out->Y_multiples, &out->Y);
+    return 0;
+}
+
+/* The cached entry for pk, or a freshly validated one if pk is not cached. */
+static int
+vrf_key_load(vrf_key_entry *out, const unsigned char pk[32])
+{
+    if (vrf_key_cache_find(out, pk) == 0) {
+	return 0;
+    }
+    return vrf_key_entry_init(out, pk);
+}
+
+/* Replace the key cache with the n keys at pks (32 bytes each), e.g. the
+ * delegates' VRF public keys after they are loaded. Invalid and duplicate
+ * keys are skipped, and at most crypto_vrf_ietfdraft03_KEYCACHEMAX are kept.
+ * Keys that are not cached still verify, they just pay for decoding again.
+ * Returns the number of keys cached.
+ */
+size_t
+crypto_vrf_ietfdraft03_key_cache_set(const unsigned char *pks, size_t n)
+{
+    vrf_key_entry *staged;
+    size_t count = 0;
+    size_t i, j;
+
+    staged = (vrf_key_entry *) calloc(crypto_vrf_ietfdraft03_KEYCACHEMAX, sizeof *staged);
+    if (staged == NULL) {
+	return 0;
+    }
+    for (i = 0; i < n && count < crypto_vrf_ietfdraft03_KEYCACHEMAX; i++) {
+	const unsigned char *pk = pks + i * crypto_vrf_ietfdraft03_PUBLICKEYBYTES;
+	for (j = 0; j < count; j++) {
+	    if (memcmp(staged[j].pk, pk, crypto_vrf_ietfdraft03_PUBLICKEYBYTES) == 0) {
+		break;
+	    }
+	}
+	if (j == count && vrf_key_entry_init(&staged[count], pk) == 0) {
+	    count++;
+	}
+    }
+
+    pthread_rwlock_wrlock(&vrf_key_cache_lock);
+    memcpy(vrf_key_cache, staged, count * sizeof *staged);
+    vrf_key_cache_count = count;
+    pthread_rwlock_unlock(&vrf_key_cache_lock);
+
+    free(staged);
+    return count;
+}
+
 /* Verify a proof per draft section 5.3. Return 0 on success, -1 on failure.
  * We assume Y_point has passed public key validation already.
  * Assuming verification succeeds, runtime does not depend on the message alpha
@@ -187,12 +283,115 @@ crypto_vrf_ietfdraft03_verify(unsigned char output[crypto_vrf_ietfdraft03_OUTPUT
 	      const unsigned char proof[crypto_vrf_ietfdraft03_PROOFBYTES],
 	      const unsigned char *msg, const unsigned long long msglen)
 {
-    ge25519_p3 Y;
-    if ((vrf_validate_key(&Y, pk) == 0) && (vrf_verify(&Y, proof, msg, msglen) == 0)) {
+    vrf_key_entry key;
+    if ((vrf_key_load(&key, pk) == 0) && (vrf_verify(&key.Y, proof, msg, msglen) == 0)) {
 	return crypto_vrf_ietfdraft03_proof_to_hash(output, proof);
     } else {
         return -1;
     }
 }
 
+/* Same check as vrf_verify, for public inputs only: U and V are each computed with
+ * one variable-time double-scalar multiplication instead of two constant-time
+ * scalar multiplications. Returns 0 if the proof verifies, -1 otherwise.
+ *
+ * Draft-03 proofs carry (Gamma, c, s) with c a hash of U and V, so U and V have to
+ * be rebuilt for every proof; they cannot be folded into a single random linear
+ * combination the way batch-compatible (Gamma, U, V, s) proofs can.
+ */
+static int
+vrf_verify_vartime(const vrf_key_entry *key, const unsigned char pi[80],
+		   const unsigned char *alpha, const unsigned long long alphalen)
+{
+    /* l - 1, so that (l - 1)*c + 0 = -c mod l */
+    static const unsigned char L_MINUS_ONE[32] = {
+	0xec, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+    };
+    static const unsigned char ZERO[32] = { 0 };
+    unsigned char h_string[32];
+    unsigned char c_scalar[32];
+    unsigned char neg_c_scalar[32];
+    unsigned char s_scalar[64];
+    unsigned char hash_input[2+32*4];
+    unsigned char cprime[64];
+
+    ge25519_p3 H_point;
+    ge25519_p3 Gamma_point;
+    ge25519_p2 U_point;
+    ge25519_p2 V_point;
+
+    if (_vrf_ietfdraft03_decode_proof(&Gamma_point, c_scalar, s_scalar, pi) != 0) {
+	return -1;
+    }
+    memset(c_scalar+16, 0, 16);
+    memset(s_scalar+32, 0, 32);
+    sc25519_reduce(s_scalar);
+    sc25519_muladd(neg_c_scalar, c_scalar, L_MINUS_ONE, ZERO);
+
+    /* a validated key is canonically encoded, so pk is the encoding of Y */
+    _vrf_ietfdraft03_hash_to_curve_elligator2_25519_string(h_string, key->pk, alpha, alphalen);
+    ge25519_frombytes(&H_point, h_string);
+
+    /* U = (-c)*Y + s*B */
+    ge25519_double_scalarmult_vartime_cached(&U_point, neg_c_scalar, key->Y_multiples, s_scalar);
+    /* V = (-c)*Gamma + s*H */
+    ge25519_double_scalarmult_vartime_points(&V_point, neg_c_scalar, &Gamma_point, s_scalar, &H_point);
+
+    /* c' = ECVRF_hash_points(H, Gamma, U, V), as _vrf_ietfdraft03_hash_points */
+    hash_input[0] = SUITE;
+    hash_input[1] = 0x02;
+    _vrf_ietfdraft03_point_to_string(hash_input+2+32*0, &H_point);
+    _vrf_ietfdraft03_point_to_string(hash_input+2+32*1, &Gamma_point);
+    ge25519_tobytes(hash_input+2+32*2, &U_point);
+    ge25519_tobytes(hash_input+2+32*3, &V_point);
+    crypto_hash_sha512(cprime, hash_input, sizeof hash_input);
+
+    return crypto_verify_16(c_scalar, cprime);
+}
+
+/* Verify a set of proofs, e.g. every VRF_DATA proof received in a round.
+ * Proof i is checked against pks[32*i] and msgs[i] (msglens[i] bytes); on
+ * success results[i] is 0 and its output hash is stored at outputs[64*i],
+ * otherwise results[i] is -1.
+ *
+ * Proofs are first checked with the variable-time path. A proof that fails it
+ * is checked again with crypto_vrf_ietfdraft03_verify, so every rejection is the
+ * reference verifier's verdict and a bad proof only costs its own check.
+ *
+ * Returns the number of proofs that verified.
+ */
+size_t
+crypto_vrf_ietfdraft03_verify_batch(unsigned char *outputs,
+				    const unsigned char *pks,
+				    const unsigned char *proofs,
+				    const unsigned char * const *msgs,
+				    const unsigned long long *msglens,
+				    size_t n, int *results)
+{
+    size_t valid = 0;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	const unsigned char *pk = pks + i * crypto_vrf_ietfdraft03_PUBLICKEYBYTES;
+	const unsigned char *proof = proofs + i * crypto_vrf_ietfdraft03_PROOFBYTES;
+	unsigned char *output = outputs + i * crypto_vrf_ietfdraft03_OUTPUTBYTES;
+	vrf_key_entry key;
+
+	if (vrf_key_load(&key, pk) == 0 &&
+	    vrf_verify_vartime(&key, proof, msgs[i], msglens[i]) == 0 &&
+	    crypto_vrf_ietfdraft03_proof_to_hash(output, proof) == 0) {
+	    results[i] = 0;
+	} else {
+	    results[i] = crypto_vrf_ietfdraft03_verify(output, pk, proof, msgs[i], msglens[i]) == 0 ? 0 : -1;
+	}
+	if (results[i] == 0) {
+	    valid++;
+	} else {
+	    memset(output, 0, crypto_vrf_ietfdraft03_OUTPUTBYTES);
+	}
+    }
+    return valid;
+}
+
 #pragma GCC diagnostic pop
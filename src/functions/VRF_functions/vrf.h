@@ -38,6 +38,8 @@ size_t crypto_vrf_ietfdraft03_proofbytes(void);
 #define crypto_vrf_ietfdraft03_OUTPUTBYTES 64U
 size_t crypto_vrf_ietfdraft03_outputbytes(void);
 
+#define crypto_vrf_ietfdraft03_KEYCACHEMAX 64U
+
 int crypto_vrf_ietfdraft03_prove(unsigned char *proof, 
 					const unsigned char *sk,
 					const unsigned char *m,
@@ -68,4 +70,13 @@ int crypto_vrf_ietfdraft03_verify(unsigned char *output,
 
 int crypto_vrf_ietfdraft03_proof_to_hash(unsigned char *hash,
 				         const unsigned char *proof);
+
+size_t crypto_vrf_ietfdraft03_key_cache_set(const unsigned char *pks, size_t n);
+
+size_t crypto_vrf_ietfdraft03_verify_batch(unsigned char *outputs,
+					   const unsigned char *pks,
+					   const unsigned char *proofs,
+					   const unsigned char * const *msgs,
+					   const unsigned long long *msglens,
+					   size_t n, int *results);
 #endif
\ No newline at end of file
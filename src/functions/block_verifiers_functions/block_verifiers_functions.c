@@ -350,7 +350,8 @@ bool generate_and_request_vrf_data_sync(char** message) {
     }
   }
 
-  // Compose outbound message (JSON)
+  // Compose outbound message (JSON); verifiers that only know the MD5 hash get it until the fork height
+  const char* wire_delegates_hash = delegates_hash_v2_active(current_block_height) ? delegates_hash : delegates_hash_md5;
   *message = create_message_param(
       XMSG_BLOCK_VERIFIERS_TO_BLOCK_VERIFIERS_VRF_DATA,
       "public_address", xcash_wallet_public_address,
@@ -358,7 +359,7 @@ bool generate_and_request_vrf_data_sync(char** message) {
       "vrf_proof", vrf_proof_hex,
       "vrf_beta", vrf_beta_hex,
       "block-height", current_block_height,
-      "delegates_hash", delegates_hash,
+      "delegates_hash", wire_delegates_hash,
       NULL);
 
   if (*message == NULL) {
@@ -561,6 +562,11 @@ Description:
   Sends a database sync request to another delegate node.
   This is typically used by a block verifier to request an updated copy of the delegates database
   from a peer node (e.g., during startup, resync, or recovery).
+  The request carries the root and leaves of the local delegates Merkle tree so the peer only
+  sends the delegates that differ. Without them (registry unavailable, or the previous delta
+  did not converge) the peer sends the whole collection.
+  sync_format asks for the documents as a binary BSON snapshot; peers that predate it ignore
+  the field and answer in JSON.
 
 Parameters:
   selected_index - Index of the delegate in the global delegates list. Used to resolve the target IP.
@@ -575,9 +581,23 @@ bool create_delegates_db_sync_request(int selected_index) {
     return false;
   }
 
+  delegates_merkle_t tree;
+  char root_hex[(SHA256_HASH_SIZE * 2) + 1] = {0};
+  char nodes_hex[DELEGATES_MERKLE_NODES_HEX_LENGTH + 1] = {0};
+  char leaves_hex[DELEGATES_MERKLE_LEAVES_HEX_LENGTH + 1] = {0};
+  bool delta = !delegates_merkle_take_full_sync() && delegates_merkle_build(&tree);
+  if (delta) {
+    delegates_merkle_to_hex(&tree, root_hex, nodes_hex, leaves_hex);
+  }
+
+  // Without a tree the list ends after sync_token and the peer sends the whole collection
   const char* params[] = {
       "public_address", xcash_wallet_public_address,
       "sync_token", sync_token,
+      "sync_format", DB_SNAPSHOT_SYNC_FORMAT,
+      delta ? "merkle_root" : NULL, root_hex,
+      "merkle_nodes", nodes_hex,
+      "merkle_leaves", leaves_hex,
       NULL};
 
   char* message = NULL;
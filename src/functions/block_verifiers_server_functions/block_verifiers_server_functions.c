@@ -1,23 +1,38 @@
 #include "block_verifiers_server_functions.h"
 
-void server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(const char* MESSAGE)
+// VRF_DATA proofs accepted by the handler, verified together by vrf_data_verify_pending
+typedef struct {
+  char public_address[XCASH_WALLET_LENGTH + 1];
+  char vrf_proof_hex[VRF_PROOF_LENGTH + 1];
+  char vrf_beta_hex[VRF_BETA_LENGTH + 1];
+  char block_height[BLOCK_HEIGHT_LENGTH + 1];
+  unsigned char pk_bin[crypto_vrf_PUBLICKEYBYTES];
+  unsigned char vrf_proof[crypto_vrf_PROOFBYTES];
+  unsigned char vrf_beta[crypto_vrf_OUTPUTBYTES];
+} vrf_pending_t;
+
+static pthread_mutex_t vrf_pending_lock = PTHREAD_MUTEX_INITIALIZER;
+static vrf_pending_t vrf_pending[VRF_DATA_BATCH_MAX];
+static size_t vrf_pending_count = 0;
+
+void server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(const xcash_msg_env_t* env)
 {
   char public_address[XCASH_WALLET_LENGTH + 1] = {0};
   char vrf_public_key_data[VRF_PUBLIC_KEY_LENGTH + 1] = {0};
   char vrf_proof_hex[VRF_PROOF_LENGTH + 1] = {0};  
   char vrf_beta_hex[VRF_BETA_LENGTH + 1] = {0};
   char block_height[BLOCK_HEIGHT_LENGTH + 1] = {0};
-  char parsed_delegates_hash[SHA256_HASH_SIZE + 1] = {0};
+  char parsed_delegates_hash[(SHA256_HASH_SIZE * 2) + 1] = {0};
 
-  DEBUG_PRINT("received %s, %s", __func__, MESSAGE);
+  DEBUG_PRINT("received %s, %s", __func__, env->data);
 
   // parse the message
-  if (parse_json_data(MESSAGE, "public_address", public_address, sizeof(public_address)) == XCASH_ERROR || 
-    parse_json_data(MESSAGE, "vrf_public_key", vrf_public_key_data, sizeof(vrf_public_key_data)) == XCASH_ERROR ||
-    parse_json_data(MESSAGE, "vrf_proof", vrf_proof_hex, sizeof(vrf_proof_hex)) == XCASH_ERROR ||
-    parse_json_data(MESSAGE, "vrf_beta", vrf_beta_hex, sizeof(vrf_beta_hex)) == XCASH_ERROR ||
-    parse_json_data(MESSAGE, "block-height", block_height, sizeof(block_height)) == XCASH_ERROR ||
-    parse_json_data(MESSAGE, "delegates_hash", parsed_delegates_hash, sizeof(parsed_delegates_hash)) == XCASH_ERROR)
+  if (parse_msg_env_field(env, "public_address", public_address, sizeof(public_address)) == XCASH_ERROR || 
+    parse_msg_env_field(env, "vrf_public_key", vrf_public_key_data, sizeof(vrf_public_key_data)) == XCASH_ERROR ||
+    parse_msg_env_field(env, "vrf_proof", vrf_proof_hex, sizeof(vrf_proof_hex)) == XCASH_ERROR ||
+    parse_msg_env_field(env, "vrf_beta", vrf_beta_hex, sizeof(vrf_beta_hex)) == XCASH_ERROR ||
+    parse_msg_env_field(env, "block-height", block_height, sizeof(block_height)) == XCASH_ERROR ||
+    parse_msg_env_field(env, "delegates_hash", parsed_delegates_hash, sizeof(parsed_delegates_hash)) == XCASH_ERROR)
   {
     ERROR_PRINT("Could not parse the block_verifiers_to_block_verifiers_vrf_data");
     return;
@@ -31,8 +46,18 @@ void server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(cons
   DEBUG_PRINT("Parsed remote public_address: %s, block_height: %s, delegates_hash: %s", public_address, block_height, 
     parsed_delegates_hash);
 
+  vrf_pending_t entry;
+  memset(&entry, 0, sizeof(entry));
+  if (!hex_to_byte_array(vrf_public_key_data, entry.pk_bin, sizeof(entry.pk_bin)) ||
+      !hex_to_byte_array(vrf_proof_hex, entry.vrf_proof, sizeof(entry.vrf_proof)) ||
+      !hex_to_byte_array(vrf_beta_hex, entry.vrf_beta, sizeof(entry.vrf_beta))) {
+    ERROR_PRINT("Failed to decode one or more fields in VRF message from %s", public_address);
+    return;
+  }
+
   pthread_mutex_lock(&delegates_all_lock);
   bool found = false;
+  bool queue = false;
 
   for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
 
@@ -47,8 +72,10 @@ void server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(cons
         break;
       }
 
-      // Compare delegate list hash
-      if (strcmp(parsed_delegates_hash, delegates_hash) != 0) {
+      // Compare delegate list hash; before the fork height a peer may still send the MD5 hash
+      bool hash_match = strcmp(parsed_delegates_hash, delegates_hash) == 0 ||
+                        (!delegates_hash_v2_active(block_height) && strcmp(parsed_delegates_hash, delegates_hash_md5) == 0);
+      if (!hash_match) {
         WARNING_PRINT("Delegates hash mismatch for %s: remote=%s, local=%s",
                     public_address, parsed_delegates_hash, delegates_hash);
         delegate_db_hash_mismatch = delegate_db_hash_mismatch + 1;
@@ -58,70 +85,148 @@ void server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(cons
         break;
       }
 
-      // All checks passed — mark online
-      strncpy(delegates_all[i].online_status, "true", sizeof(delegates_all[i].online_status));
-      delegates_all[i].online_status[sizeof(delegates_all[i].online_status) - 1] = '\0';
-      DEBUG_PRINT("Marked delegate %s as online (ck)", public_address);
-
-      unsigned char alpha_input_bin[72] = {0};
-      unsigned char pk_bin[crypto_vrf_PUBLICKEYBYTES] = {0};
-      unsigned char vrf_proof[crypto_vrf_PROOFBYTES] = {0};
-      unsigned char vrf_beta[crypto_vrf_OUTPUTBYTES] = {0};
-      unsigned char previous_block_hash_bin[BLOCK_HASH_LENGTH / 2] = {0};
-
-      if (!hex_to_byte_array(vrf_public_key_data, pk_bin, sizeof(pk_bin)) ||
-        !hex_to_byte_array(vrf_proof_hex, vrf_proof, sizeof(vrf_proof)) ||
-        !hex_to_byte_array(vrf_beta_hex, vrf_beta, sizeof(vrf_beta)) ||
-        !hex_to_byte_array(previous_block_hash, previous_block_hash_bin, sizeof(previous_block_hash_bin))) {
-          ERROR_PRINT("Failed to decode one or more fields in VRF message from %s", public_address);
-          break;
-      }
+      // All checks passed — queue the proof; the delegate is marked online once it verifies
+      queue = true;
+      break;
 
-      memcpy(alpha_input_bin, previous_block_hash_bin, 32);
+    }
+  }
+  pthread_mutex_unlock(&delegates_all_lock);
 
-      // Convert current_block_height (char*) to binary
-      uint64_t block_height_num = strtoull(current_block_height, NULL, 10);
-      uint64_t height_le = htole64(block_height_num);
-      memcpy(alpha_input_bin + 32, &height_le, sizeof(height_le));
+  if (!found && startup_complete) {
+    WARNING_PRINT("Delegate %s not found in delegates_all or delegates collection.", public_address);
+  }
+  if (!queue) {
+    return;
+  }
 
-      // Add vrf_block_producer
-      memcpy(alpha_input_bin + 40, pk_bin, 32);  // Write at offset 40
+  // The proof itself is checked with the rest of the round's proofs, outside delegates_all_lock
+  memcpy(entry.public_address, public_address, sizeof(entry.public_address));
+  memcpy(entry.vrf_proof_hex, vrf_proof_hex, sizeof(entry.vrf_proof_hex));
+  memcpy(entry.vrf_beta_hex, vrf_beta_hex, sizeof(entry.vrf_beta_hex));
+  memcpy(entry.block_height, block_height, sizeof(entry.block_height));
+
+  pthread_mutex_lock(&vrf_pending_lock);
+  bool duplicate = false;
+  for (size_t i = 0; i < vrf_pending_count; i++) {
+    if (strcmp(vrf_pending[i].public_address, entry.public_address) == 0 &&
+        strcmp(vrf_pending[i].vrf_proof_hex, entry.vrf_proof_hex) == 0) {
+      duplicate = true;
+      break;
+    }
+  }
+  if (!duplicate && vrf_pending_count < VRF_DATA_BATCH_MAX) {
+    vrf_pending[vrf_pending_count++] = entry;
+  } else if (!duplicate) {
+    WARNING_PRINT("VRF proof queue full, dropping proof from %s", public_address);
+  }
+  pthread_mutex_unlock(&vrf_pending_lock);
 
-      // Verify VRF proof
-      unsigned char computed_beta[crypto_vrf_OUTPUTBYTES];
-      if (crypto_vrf_verify(computed_beta, pk_bin, vrf_proof, alpha_input_bin, sizeof(alpha_input_bin)) != 0) {
-        ERROR_PRINT("VRF proof failed verification from %s", public_address);
-        break;
-      }
+  return;
+}
 
-      if (memcmp(computed_beta, vrf_beta, sizeof(vrf_beta)) != 0) {
-        WARNING_PRINT("VRF beta mismatch from %s", public_address);
-        break;
-      }
+/*---------------------------------------------------------------------------------------------------------
+Name: vrf_data_reset_pending
+Description: Drops VRF_DATA proofs queued but not yet verified; called at the start of each round
+---------------------------------------------------------------------------------------------------------*/
+void vrf_data_reset_pending(void)
+{
+  pthread_mutex_lock(&vrf_pending_lock);
+  vrf_pending_count = 0;
+  pthread_mutex_unlock(&vrf_pending_lock);
+}
 
-      memcpy(delegates_all[i].verifiers_vrf_proof_hex, vrf_proof_hex, VRF_PROOF_LENGTH + 1); 
-      memcpy(delegates_all[i].verifiers_vrf_beta_hex, vrf_beta_hex, VRF_BETA_LENGTH + 1);
+/*---------------------------------------------------------------------------------------------------------
+Name: vrf_data_verify_pending
+Description: Verifies the VRF_DATA proofs queued this round in one batch, stores the valid ones in
+             delegates_all and marks their delegates online. Verification runs without delegates_all_lock; the lock is only taken to store
+             the results. Called on the round thread before the Part 5 verifier list is built.
+Return: The number of proofs stored
+---------------------------------------------------------------------------------------------------------*/
+size_t vrf_data_verify_pending(void)
+{
+  static vrf_pending_t batch[VRF_DATA_BATCH_MAX];
+  static unsigned char alpha[VRF_DATA_BATCH_MAX][72];
+  static unsigned char pks[VRF_DATA_BATCH_MAX * crypto_vrf_PUBLICKEYBYTES];
+  static unsigned char proofs[VRF_DATA_BATCH_MAX * crypto_vrf_PROOFBYTES];
+  static unsigned char outputs[VRF_DATA_BATCH_MAX * crypto_vrf_OUTPUTBYTES];
+  const unsigned char* msgs[VRF_DATA_BATCH_MAX];
+  unsigned long long msg_lens[VRF_DATA_BATCH_MAX];
+  int results[VRF_DATA_BATCH_MAX];
+  unsigned char previous_block_hash_bin[BLOCK_HASH_LENGTH / 2] = {0};
+  size_t count = 0;
+  size_t stored = 0;
+
+  pthread_mutex_lock(&vrf_pending_lock);
+  for (size_t i = 0; i < vrf_pending_count; i++) {
+    // proofs for another height can not verify against this round's alpha
+    if (strcmp(vrf_pending[i].block_height, current_block_height) == 0) {
+      batch[count++] = vrf_pending[i];
+    }
+  }
+  vrf_pending_count = 0;
+  pthread_mutex_unlock(&vrf_pending_lock);
 
-      break;
+  if (count == 0) {
+    return 0;
+  }
 
-    }
+  if (!hex_to_byte_array(previous_block_hash, previous_block_hash_bin, sizeof(previous_block_hash_bin))) {
+    ERROR_PRINT("Failed to decode previous block hash for VRF proof verification");
+    return 0;
+  }
+  uint64_t height_le = htole64(strtoull(current_block_height, NULL, 10));
+
+  for (size_t i = 0; i < count; i++) {
+    // alpha = previous block hash || block height (LE) || vrf public key
+    memcpy(alpha[i], previous_block_hash_bin, 32);
+    memcpy(alpha[i] + 32, &height_le, sizeof(height_le));
+    memcpy(alpha[i] + 40, batch[i].pk_bin, 32);
+    memcpy(pks + i * crypto_vrf_PUBLICKEYBYTES, batch[i].pk_bin, crypto_vrf_PUBLICKEYBYTES);
+    memcpy(proofs + i * crypto_vrf_PROOFBYTES, batch[i].vrf_proof, crypto_vrf_PROOFBYTES);
+    msgs[i] = alpha[i];
+    msg_lens[i] = sizeof(alpha[i]);
   }
-  pthread_mutex_unlock(&delegates_all_lock);
 
-  if (!found && startup_complete) {
-    WARNING_PRINT("Delegate %s not found in delegates_all or delegates collection.", public_address);
+  size_t valid = crypto_vrf_verify_batch(outputs, pks, proofs, msgs, msg_lens, count, results);
+  DEBUG_PRINT("VRF batch: %zu of %zu proofs verified", valid, count);
+
+  pthread_mutex_lock(&delegates_all_lock);
+  for (size_t k = 0; k < count; k++) {
+    if (results[k] != 0) {
+      ERROR_PRINT("VRF proof failed verification from %s", batch[k].public_address);
+      continue;
+    }
+    if (memcmp(outputs + k * crypto_vrf_OUTPUTBYTES, batch[k].vrf_beta, crypto_vrf_OUTPUTBYTES) != 0) {
+      WARNING_PRINT("VRF beta mismatch from %s", batch[k].public_address);
+      continue;
+    }
+    for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+      if (strncmp(delegates_all[i].public_address, batch[k].public_address, XCASH_WALLET_LENGTH) == 0 &&
+          delegates_all[i].verifiers_vrf_proof_hex[0] == '\0' &&
+          delegates_all[i].verifiers_vrf_beta_hex[0] == '\0') {
+        memcpy(delegates_all[i].verifiers_vrf_proof_hex, batch[k].vrf_proof_hex, VRF_PROOF_LENGTH + 1);
+        memcpy(delegates_all[i].verifiers_vrf_beta_hex, batch[k].vrf_beta_hex, VRF_BETA_LENGTH + 1);
+        strncpy(delegates_all[i].online_status, "true", sizeof(delegates_all[i].online_status));
+        delegates_all[i].online_status[sizeof(delegates_all[i].online_status) - 1] = '\0';
+        DEBUG_PRINT("Marked delegate %s as online (ck)", batch[k].public_address);
+        stored++;
+        break;
+      }
+    }
   }
+  pthread_mutex_unlock(&delegates_all_lock);
 
-  return;
+  return stored;
 }
 
 /*---------------------------------------------------------------------------------------------------------
 Name: server_receive_data_socket_node_to_node_vote_majority
 Description: Runs the code when the server receives the NODES_TO_NODES_VOTE_MAJORITY_RESULTS message
 Parameters:
-  MESSAGE - The message
+  env - The parsed message
 ---------------------------------------------------------------------------------------------------------*/
-void server_receive_data_socket_node_to_node_vote_majority(const char* MESSAGE) {
+void server_receive_data_socket_node_to_node_vote_majority(const xcash_msg_env_t* env) {
   char public_address[XCASH_WALLET_LENGTH + 1] = {0};
   char public_address_producer[XCASH_WALLET_LENGTH + 1] = {0};
   char vrf_public_key_data[VRF_PUBLIC_KEY_LENGTH + 1] = {0};
@@ -130,16 +235,16 @@ void server_receive_data_socket_node_to_node_vote_majority(const char* MESSAGE)
   char block_height[BLOCK_HEIGHT_LENGTH + 1] = {0};
   char vote_signature[XCASH_SIGN_DATA_LENGTH + 1] = {0};
 
-  DEBUG_PRINT("received %s, %s", __func__, MESSAGE);
+  DEBUG_PRINT("received %s, %s", __func__, env->data);
 
   // parse the message
-  if (parse_json_data(MESSAGE, "public_address", public_address, sizeof(public_address)) == XCASH_ERROR ||
-      parse_json_data(MESSAGE, "proposed_producer", public_address_producer, sizeof(public_address_producer)) == XCASH_ERROR ||
-      parse_json_data(MESSAGE, "vrf_public_key", vrf_public_key_data, sizeof(vrf_public_key_data)) == XCASH_ERROR ||
-      parse_json_data(MESSAGE, "vrf_proof", vrf_proof_hex, sizeof(vrf_proof_hex)) == XCASH_ERROR ||
-      parse_json_data(MESSAGE, "vrf_beta", vrf_beta_hex, sizeof(vrf_beta_hex)) == XCASH_ERROR ||
-      parse_json_data(MESSAGE, "block_height", block_height, sizeof(block_height)) == XCASH_ERROR ||
-      parse_json_data(MESSAGE, "vote_signature", vote_signature, sizeof(vote_signature)) == XCASH_ERROR) {
+  if (parse_msg_env_field(env, "public_address", public_address, sizeof(public_address)) == XCASH_ERROR ||
+      parse_msg_env_field(env, "proposed_producer", public_address_producer, sizeof(public_address_producer)) == XCASH_ERROR ||
+      parse_msg_env_field(env, "vrf_public_key", vrf_public_key_data, sizeof(vrf_public_key_data)) == XCASH_ERROR ||
+      parse_msg_env_field(env, "vrf_proof", vrf_proof_hex, sizeof(vrf_proof_hex)) == XCASH_ERROR ||
+      parse_msg_env_field(env, "vrf_beta", vrf_beta_hex, sizeof(vrf_beta_hex)) == XCASH_ERROR ||
+      parse_msg_env_field(env, "block_height", block_height, sizeof(block_height)) == XCASH_ERROR ||
+      parse_msg_env_field(env, "vote_signature", vote_signature, sizeof(vote_signature)) == XCASH_ERROR) {
     ERROR_PRINT("Could not parse the block_verifiers_to_block_verifiers_vrf_data");
     return;
   }
@@ -149,70 +254,80 @@ void server_receive_data_socket_node_to_node_vote_majority(const char* MESSAGE)
     return;
   }
 
-  bool found_voter = false;
+  // 1) snapshot the verifier set; the signature check below runs without any lock held
+  char round_keys[BLOCK_VERIFIERS_AMOUNT][VRF_PUBLIC_KEY_LENGTH + 1];
+  int voter_index = -1;
+  bool already_voted = false;
   pthread_mutex_lock(&current_block_verifiers_lock);
+  const uint32_t generation = current_block_verifiers_generation;
   for (size_t i = 0; i < BLOCK_VERIFIERS_AMOUNT; i++) {
     if (strcmp(public_address, current_block_verifiers_list.block_verifiers_public_address[i]) == 0) {
-      found_voter = true;
-      if (!verify_vrf_vote_signature(block_height, vrf_beta_hex, vrf_public_key_data, public_address, vote_signature)) {
-        pthread_mutex_unlock(&current_block_verifiers_lock);
-        WARNING_PRINT("Unable to verify the signature for vote from delegate %s", public_address);
-        return;
-      }
-      if (current_block_verifiers_list.block_verifiers_voted[i] == 0) {
-        current_block_verifiers_list.block_verifiers_voted[i] = 1;
-        memcpy(current_block_verifiers_list.block_verifiers_vote_signature[i], vote_signature, XCASH_SIGN_DATA_LENGTH + 1);
-        memcpy(current_block_verifiers_list.block_verifiers_selected_public_address[i], public_address_producer, XCASH_WALLET_LENGTH + 1);
-        break;
-      } else {
-        pthread_mutex_unlock(&current_block_verifiers_lock);
-        WARNING_PRINT("Verifier %s, has already voted and can not vote again", public_address);
-        return;
-      }
+      voter_index = (int)i;
+      already_voted = current_block_verifiers_list.block_verifiers_voted[i] != 0;
+      break;
     }
   }
+  memcpy(round_keys, current_block_verifiers_list.block_verifiers_public_key, sizeof(round_keys));
   pthread_mutex_unlock(&current_block_verifiers_lock);
 
-  if (!found_voter) {
+  if (voter_index < 0) {
     WARNING_PRINT("Verifier %s not found in current_block_verifiers_list", public_address);
     return;
   }
+  if (already_voted) {
+    WARNING_PRINT("Verifier %s, has already voted and can not vote again", public_address);
+    return;
+  }
 
-  if (strcmp(block_height, current_block_height) != 0) {
-    ERROR_PRINT("Mismatch in block height for verifier %s", public_address);
+  // 2) verify against the snapshot
+  bool signature_ok = verify_vrf_vote_signature(block_height, vrf_beta_hex, vrf_public_key_data, public_address, vote_signature,
+                                                (const char (*)[VRF_PUBLIC_KEY_LENGTH + 1])round_keys, BLOCK_VERIFIERS_AMOUNT);
+  if (!signature_ok) {
+    WARNING_PRINT("Unable to verify the signature for vote from delegate %s", public_address);
     return;
   }
 
+  // 3) commit the vote and the tally in one short critical section
+  const bool height_ok = strcmp(block_height, current_block_height) == 0;
+  const char* mismatch = NULL;
   pthread_mutex_lock(&current_block_verifiers_lock);
-  for (size_t i = 0; i < BLOCK_VERIFIERS_AMOUNT; i++) {
+  if (generation != current_block_verifiers_generation ||
+      strcmp(public_address, current_block_verifiers_list.block_verifiers_public_address[voter_index]) != 0) {
+    pthread_mutex_unlock(&current_block_verifiers_lock);
+    WARNING_PRINT("Verifier list changed while checking the vote from %s, vote dropped", public_address);
+    return;
+  }
+  if (current_block_verifiers_list.block_verifiers_voted[voter_index] != 0) {
+    pthread_mutex_unlock(&current_block_verifiers_lock);
+    WARNING_PRINT("Verifier %s, has already voted and can not vote again", public_address);
+    return;
+  }
+  current_block_verifiers_list.block_verifiers_voted[voter_index] = 1;
+  memcpy(current_block_verifiers_list.block_verifiers_vote_signature[voter_index], vote_signature, XCASH_SIGN_DATA_LENGTH + 1);
+  memcpy(current_block_verifiers_list.block_verifiers_selected_public_address[voter_index], public_address_producer, XCASH_WALLET_LENGTH + 1);
+
+  for (size_t i = 0; height_ok && i < BLOCK_VERIFIERS_AMOUNT; i++) {
     if (strcmp(public_address_producer, current_block_verifiers_list.block_verifiers_public_address[i]) != 0) {
       continue;
     }
-
     if (strcmp(vrf_public_key_data, current_block_verifiers_list.block_verifiers_public_key[i]) != 0) {
-      pthread_mutex_unlock(&current_block_verifiers_lock);
-      ERROR_PRINT("Mismatch in vrf_public_key for verifier %s", public_address_producer);
-      return;
-    }
-
-    if (strcmp(vrf_proof_hex, current_block_verifiers_list.block_verifiers_vrf_proof_hex[i]) != 0) {
-      pthread_mutex_unlock(&current_block_verifiers_lock);
-      ERROR_PRINT("Mismatch in vrf_proof for verifier %s", public_address_producer);
-      return;
-    }
-
-    if (strcmp(vrf_beta_hex, current_block_verifiers_list.block_verifiers_vrf_beta_hex[i]) != 0) {
-      pthread_mutex_unlock(&current_block_verifiers_lock);
-      ERROR_PRINT("Mismatch in vrf_beta for verifier %s", public_address_producer);
-      return;
+      mismatch = "vrf_public_key";
+    } else if (strcmp(vrf_proof_hex, current_block_verifiers_list.block_verifiers_vrf_proof_hex[i]) != 0) {
+      mismatch = "vrf_proof";
+    } else if (strcmp(vrf_beta_hex, current_block_verifiers_list.block_verifiers_vrf_beta_hex[i]) != 0) {
+      mismatch = "vrf_beta";
+    } else {
+      current_block_verifiers_list.block_verifiers_vote_total[i] += 1;
     }
-
-    current_block_verifiers_list.block_verifiers_vote_total[i] += 1;
-    pthread_mutex_unlock(&current_block_verifiers_lock);
-    return;
+    break;
   }
-
   pthread_mutex_unlock(&current_block_verifiers_lock);
+
+  if (!height_ok) {
+    ERROR_PRINT("Mismatch in block height for verifier %s", public_address);
+  } else if (mismatch) {
+    ERROR_PRINT("Mismatch in %s for verifier %s", mismatch, public_address_producer);
+  }
   return;
 }
 
@@ -238,6 +353,8 @@ static int bytes32_cmp(const void *va, const void *vb) {
  * @param vrf_beta_hex         Hex-encoded 32-byte VRF beta (64 hex characters)
  * @param vrf_pubkey_hex       Hex-encoded 32-byte VRF public key (64 hex characters)
  * @param vote_signature_hex   Hex-encoded 64-byte signature (128 hex characters)
+ * @param round_keys           Snapshot of the round's VRF public keys (hex), taken by the caller
+ * @param round_key_count      Number of entries in round_keys
  *
  * @return true if the signature is valid and matches the inputs; false otherwise
 ---------------------------------------------------------------------------------------------------------*/
@@ -245,20 +362,18 @@ bool verify_vrf_vote_signature(const char *block_height,
                           const char *vrf_beta_hex,
                           const char *vrf_pubkey_hex,
                           const char *public_wallet_address,
-                          const char *vote_signature)
+                          const char *vote_signature,
+                          const char (*round_keys)[VRF_PUBLIC_KEY_LENGTH + 1],
+                          size_t round_key_count)
 {
-  const char *HTTP_HEADERS[] = {"Content-Type: application/json", "Accept: application/json"};
-  const size_t HTTP_HEADERS_LENGTH = sizeof(HTTP_HEADERS) / sizeof(HTTP_HEADERS[0]);
   uint8_t vrf_beta_bin[crypto_vrf_OUTPUTBYTES] = {0};
   uint8_t vrf_pubkey_bin[crypto_vrf_PUBLICKEYBYTES] = {0};
   uint8_t hash[SHA256_EL_HASH_SIZE];
   char hash_hex[(SHA256_EL_HASH_SIZE * 2) + 1] = {0};
   uint8_t hash_input[160];
   size_t offset = 0;
-  char request[MEDIUM_BUFFER_SIZE * 2] = {0};
-  char response[MEDIUM_BUFFER_SIZE] = {0};
 
-  if (!block_height || !vrf_beta_hex || !vrf_pubkey_hex || !vote_signature)
+  if (!block_height || !vrf_beta_hex || !vrf_pubkey_hex || !vote_signature || !round_keys)
     return false;
 
   if (strlen(vrf_beta_hex) != crypto_vrf_OUTPUTBYTES * 2 ||
@@ -278,9 +393,9 @@ bool verify_vrf_vote_signature(const char *block_height,
   memset(pks, 0, sizeof pks);
   size_t n = 0;
 
-  for (size_t i = 0; i < BLOCK_VERIFIERS_AMOUNT; ++i) {
-    const char* hex = current_block_verifiers_list.block_verifiers_public_key[i];
-    if (!hex || hex[0] == '\0') continue;
+  for (size_t i = 0; i < round_key_count && i < BLOCK_VERIFIERS_AMOUNT; ++i) {
+    const char* hex = round_keys[i];
+    if (hex[0] == '\0') continue;
 
     size_t len = strnlen(hex, (size_t)VRF_PUBLIC_KEY_LENGTH + 1);  // VRF_PUBLIC_KEY_LENGTH == 64
     if (len != (size_t)VRF_PUBLIC_KEY_LENGTH) {
@@ -339,35 +454,14 @@ bool verify_vrf_vote_signature(const char *block_height,
   for (size_t i = 0; i < SHA256_EL_HASH_SIZE; i++)
     snprintf(hash_hex + i * 2, 3, "%02x", hash[i]);
 
-  snprintf(request, sizeof(request),
-           "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"method\":\"verify\",\"params\":{"
-           "\"data\":\"%s\","
-           "\"address\":\"%s\","
-           "\"signature\":\"%s\"}}",
-           hash_hex, public_wallet_address, vote_signature);
-
-  if (send_http_request(response, sizeof(response), XCASH_WALLET_IP, "/json_rpc", XCASH_WALLET_PORT,
-                        "POST", HTTP_HEADERS, HTTP_HEADERS_LENGTH,
-                        request, HTTP_TIMEOUT_SETTINGS) <= 0) {
-    ERROR_PRINT("verify_vrf_vote_signature: HTTP request failed");
-    return false;
-  }
-
-  // Parse response
-  char result[8] = {0};
-  if (parse_json_data(response, "result.good", result, sizeof(result)) == 1 && strcmp(result, "true") == 0) {
-    return true;
-  } else {
-    return false;
-  }
-
+  return wallet_verify_signature(hash_hex, public_wallet_address, vote_signature) == XCASH_OK;
 }
 
 // Verifies a vote signature against data bound to:
 //   block_height (ASCII) || vrf_beta (32 bytes) || vrf_pubkey (32 bytes) || sha256(concat(all round VRF pubkeys))
-// Assumes helpers/constants exist: hex_to_byte_array, sha256EL, send_http_request, parse_json_data,
+// Assumes helpers/constants exist: hex_to_byte_array, sha256EL, wallet_verify_signature,
 //   crypto_vrf_OUTPUTBYTES, crypto_vrf_PUBLICKEYBYTES, SHA256_EL_HASH_SIZE (== 32), VRF_PUBLIC_KEY_LENGTH (== 64),
-//   BLOCK_VERIFIERS_AMOUNT, XCASH_WALLET_IP, XCASH_WALLET_PORT, HTTP_TIMEOUT_SETTINGS, MEDIUM_BUFFER_SIZE, etc.
+//   BLOCK_VERIFIERS_AMOUNT, etc.
 // Uses current_block_verifiers_list.* already populated.
 
 bool verify_vrf_vote_signature_bound(const char* block_height,
@@ -445,38 +539,12 @@ bool verify_vrf_vote_signature_bound(const char* block_height,
   uint8_t hash[SHA256_EL_HASH_SIZE];
   sha256EL(hash_input, offset, hash);
 
-  // Hex-encode the digest for wallet RPC
+  // Hex-encode the digest, which is the signed text
   char hash_hex[(SHA256_EL_HASH_SIZE * 2) + 1] = {0};
   for (size_t i = 0; i < SHA256_EL_HASH_SIZE; ++i)
     snprintf(hash_hex + (i * 2), 3, "%02x", hash[i]);
 
-  // --- Call wallet verify
-  const char* HTTP_HEADERS[] = {"Content-Type: application/json", "Accept: application/json"};
-  const size_t HTTP_HEADERS_LENGTH = sizeof(HTTP_HEADERS) / sizeof(HTTP_HEADERS[0]);
-
-  char request[MEDIUM_BUFFER_SIZE * 2] = {0};
-  char response[MEDIUM_BUFFER_SIZE] = {0};
-
-  snprintf(request, sizeof(request),
-           "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"method\":\"verify\",\"params\":{"
-           "\"data\":\"%s\",\"address\":\"%s\",\"signature\":\"%s\"}}",
-           hash_hex, public_wallet_address, vote_signature);
-
-  if (send_http_request(response, sizeof(response),
-                        XCASH_WALLET_IP, "/json_rpc", XCASH_WALLET_PORT,
-                        "POST", HTTP_HEADERS, HTTP_HEADERS_LENGTH,
-                        request, HTTP_TIMEOUT_SETTINGS) <= 0) {
-    ERROR_PRINT("verify_vrf_vote_signature_bound: HTTP request failed");
-    return false;
-  }
-
-  char result[8] = {0};
-  if (parse_json_data(response, "result.good", result, sizeof(result)) == 1 &&
-      strcmp(result, "true") == 0) {
-    return true;
-  }
-
-  return false;
+  return wallet_verify_signature(hash_hex, public_wallet_address, vote_signature) == XCASH_OK;
 }
 
 /*---------------------------------------------------------------------------------------------------------
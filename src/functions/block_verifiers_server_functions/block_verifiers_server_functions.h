@@ -11,11 +11,15 @@
 #include "sha256EL.h"
 #include "network_daemon_functions.h"
 #include "db_functions.h"
+#include "network_security_functions.h"
+#include "crypto_vrf.h"
 
-void server_receive_data_socket_node_to_node_vote_majority(const char* MESSAGE);
-void server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(const char* MESSAGE);
+void server_receive_data_socket_node_to_node_vote_majority(const xcash_msg_env_t* env);
+void server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(const xcash_msg_env_t* env);
+void vrf_data_reset_pending(void);
+size_t vrf_data_verify_pending(void);
 bool verify_vrf_vote_signature(const char *block_height, const char *vrf_beta_hex, const char *vrf_pubkey_hex, const char *public_wallet_address,
-  const char *vote_signature);
+  const char *vote_signature, const char (*round_keys)[VRF_PUBLIC_KEY_LENGTH + 1], size_t round_key_count);
 void server_receive_data_socket_seed_to_block_verifiers_maintenance(const char* MESSAGE);
 
 #endif
\ No newline at end of file
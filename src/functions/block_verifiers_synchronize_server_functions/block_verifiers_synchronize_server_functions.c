@@ -27,12 +27,17 @@ Description:
   When a peer node sends a XMSG_NODES_TO_NODES_DATABASE_SYNC_REQ message, this function is triggered.
   It responds by exporting the local delegates collection, converting it to canonical extended JSON,
   and sending it back in a structured message using the existing message format.
+  When the request carries the requester's delegates Merkle tree, only the delegates of the leaves
+  that differ are sent, with the leaf mask (merkle_replace) and the local root (merkle_root).
+  When the request asks for sync_format "bson_snapshot", the documents are copied from the cursor
+  into a binary snapshot (see db_snapshot) and sent deflated and base64 encoded as "snapshot" instead of JSON.
 
 Parameters:
   client - Pointer to the server_client_t structure representing the requesting peer connection.
 
 Behavior:
-  - Exports the delegates collection from the local database (including "_id" fields).
+  - Exports the delegates collection from the local database (including "_id" fields), or only the
+    differing leaves for a delta request.
   - Converts the data to a JSON string.
   - Packages it into a key-value parameter message.
   - Sends the message back to the requesting client over the socket.
@@ -44,6 +49,7 @@ void server_receive_data_socket_node_to_node_db_sync_req(server_client_t *client
   bson_t reply;
   bson_error_t error;
   char *json_string = NULL;          // from bson_as_canonical_extended_json
+  char *snapshot_str = NULL;         // from db_snapshot_encode
   cJSON *message = NULL;             // outer message object
   cJSON *json_data = NULL;           // nested "json" (delegates dump)
   char *message_str = NULL;          // serialized full message (used for hashing)
@@ -51,8 +57,15 @@ void server_receive_data_socket_node_to_node_db_sync_req(server_client_t *client
   EVP_MD_CTX* ctx = NULL;
 
   char incoming_token[SYNC_TOKEN_LEN + 1] = {0};
-
-  // 1) Parse incoming MESSAGE, extract sync_token
+  char peer_root[(SHA256_HASH_SIZE * 2) + 1] = {0};
+  char peer_nodes[DELEGATES_MERKLE_NODES_HEX_LENGTH + 1] = {0};
+  char peer_leaves[DELEGATES_MERKLE_LEAVES_HEX_LENGTH + 1] = {0};
+  bool delta = false;
+  bool snapshot = false;
+  bool differ[DELEGATES_MERKLE_LEAVES];
+  delegates_merkle_t local_tree;
+
+  // 1) Parse incoming MESSAGE, extract sync_token and the optional Merkle tree
   cJSON *root = cJSON_Parse(MESSAGE);
   if (!root) {
     ERROR_PRINT("cJSON parse failed");
@@ -65,6 +78,20 @@ void server_receive_data_socket_node_to_node_db_sync_req(server_client_t *client
       strncpy(incoming_token, token_item->valuestring, SYNC_TOKEN_LEN);
       incoming_token[SYNC_TOKEN_LEN] = '\0';
     }
+    cJSON *format_item = cJSON_GetObjectItemCaseSensitive(root, "sync_format");
+    snapshot = cJSON_IsString(format_item) && strcmp(format_item->valuestring, DB_SNAPSHOT_SYNC_FORMAT) == 0;
+    // Older nodes send no tree; lengths are checked by delegates_merkle_from_hex
+    struct { const char *name; char *out; size_t size; } tree_fields[] = {
+      {"merkle_root", peer_root, sizeof(peer_root)},
+      {"merkle_nodes", peer_nodes, sizeof(peer_nodes)},
+      {"merkle_leaves", peer_leaves, sizeof(peer_leaves)},
+    };
+    for (size_t i = 0; i < sizeof(tree_fields) / sizeof(tree_fields[0]); i++) {
+      cJSON *item = cJSON_GetObjectItemCaseSensitive(root, tree_fields[i].name);
+      if (item && cJSON_IsString(item) && item->valuestring) {
+        snprintf(tree_fields[i].out, tree_fields[i].size, "%s", item->valuestring);
+      }
+    }
   }
   cJSON_Delete(root);
   root = NULL;
@@ -74,16 +101,45 @@ void server_receive_data_socket_node_to_node_db_sync_req(server_client_t *client
     goto cleanup;
   }
 
-  // 2) Export collection -> BSON -> canonical extended JSON (string)
-  if (!db_export_collection_to_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, &reply, &error)) {
-    ERROR_PRINT("Failed to export collection: %s", error.message);
-    goto cleanup;
+  // 2) Export the differing leaves, or the whole collection -> snapshot, or BSON -> canonical extended JSON (string)
+  if (peer_root[0] != '\0') {
+    delegates_merkle_t peer_tree;
+    if (delegates_merkle_from_hex(peer_root, peer_nodes, peer_leaves, &peer_tree) &&
+        delegates_merkle_build(&local_tree)) {
+      size_t leaves = delegates_merkle_diff(&local_tree, &peer_tree, differ);
+      bson_init(&reply);
+      delta = delegates_registry_export_leaves(differ, DELEGATES_MERKLE_LEAVES, &reply);
+      if (delta) {
+        DEBUG_PRINT("DB sync: %zu of %d leaves differ from %s", leaves, DELEGATES_MERKLE_LEAVES, client->client_ip);
+      } else {
+        bson_destroy(&reply);
+      }
+    } else {
+      WARNING_PRINT("DB sync: unusable Merkle tree from %s, sending the whole collection", client->client_ip);
+    }
   }
-  json_string = bson_as_canonical_extended_json(&reply, NULL);
-  bson_destroy(&reply);
-  if (!json_string) {
-    ERROR_PRINT("Failed to convert BSON to JSON");
-    goto cleanup;
+  if (snapshot) {
+    db_snapshot_t snap;
+    bool built = delta ? db_snapshot_begin(&snap) && db_snapshot_add_all(&snap, &reply) && db_snapshot_finish(&snap)
+                       : db_snapshot_export(DATABASE_NAME, DB_COLLECTION_DELEGATES, &snap);
+    if (delta) bson_destroy(&reply);
+    if (built) snapshot_str = db_snapshot_encode(&snap);
+    db_snapshot_free(&snap);
+    if (!snapshot_str) {
+      ERROR_PRINT("Failed to build delegates snapshot");
+      goto cleanup;
+    }
+  } else {
+    if (!delta && !db_export_collection_to_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, &reply, &error)) {
+      ERROR_PRINT("Failed to export collection: %s", error.message);
+      goto cleanup;
+    }
+    json_string = bson_as_canonical_extended_json(&reply, NULL);
+    bson_destroy(&reply);
+    if (!json_string) {
+      ERROR_PRINT("Failed to convert BSON to JSON");
+      goto cleanup;
+    }
   }
 
   // 3) Build the outgoing JSON object (keep it in memory until the very end)
@@ -95,14 +151,32 @@ void server_receive_data_socket_node_to_node_db_sync_req(server_client_t *client
   cJSON_AddStringToObject(message, "message_settings", "NODES_TO_NODES_DATABASE_SYNC_DATA");
   cJSON_AddStringToObject(message, "public_address", xcash_wallet_public_address);
 
-  // Parse the exported collection JSON into an object
-  json_data = cJSON_Parse(json_string);
+  // Parse the exported collection JSON into an object, or carry the snapshot as a single string
+  if (snapshot) {
+    json_data = cJSON_CreateObject();
+    if (json_data && !cJSON_AddStringToObject(json_data, "snapshot", snapshot_str)) {
+      cJSON_Delete(json_data);
+      json_data = NULL;
+    }
+    free(snapshot_str);
+    snapshot_str = NULL;
+  } else {
+    json_data = cJSON_Parse(json_string);
+  }
   if (!json_data) {
     ERROR_PRINT("Failed to parse inner JSON data");
     goto cleanup;
   }
-  // Attach sync_token and nest it under "json"
+  // Attach sync_token (and the leaves being replaced) and nest it under "json"
   cJSON_AddStringToObject(json_data, "sync_token", incoming_token);
+  if (delta) {
+    char root_hex[(SHA256_HASH_SIZE * 2) + 1];
+    char mask_hex[DELEGATES_MERKLE_MASK_HEX_LENGTH + 1];
+    bin_to_hex(local_tree.root, SHA256_HASH_SIZE, root_hex);
+    delegates_merkle_mask_to_hex(differ, mask_hex);
+    cJSON_AddStringToObject(json_data, "merkle_root", root_hex);
+    cJSON_AddStringToObject(json_data, "merkle_replace", mask_hex);
+  }
   cJSON_AddItemToObject(message, "json", json_data);
   json_data = NULL; // now owned by message
 
@@ -208,6 +282,7 @@ void server_receive_data_socket_node_to_node_db_sync_req(server_client_t *client
 cleanup:
   if (ctx) EVP_MD_CTX_free(ctx);
   if (json_string) bson_free(json_string);
+  if (snapshot_str) free(snapshot_str);
   if (message) cJSON_Delete(message);
   if (message_str) free(message_str);
   if (final_str) free(final_str);
@@ -226,6 +301,14 @@ cleanup:
  * The "json" field in the incoming message should be a valid JSON object (not a stringified JSON)
  * representing multiple delegate documents keyed by index ("0", "1", etc).
  *
+ * A delta reply also carries "merkle_replace" (the Merkle leaves it covers) and "merkle_root"; only
+ * those leaves are replaced, and if the local root does not match the peer's afterwards the next
+ * sync request asks for the whole collection.
+ *
+ * A peer that understood sync_format sends "json": { "snapshot": "<encoded>", ... } instead of the
+ * numbered documents; the snapshot is verified and written with one bulk write, without going
+ * through JSON.
+ *
  * Example message format:
  * {
  *   "message_settings": "NODES_TO_NODES_DATABASE_SYNC_DATA",
@@ -403,36 +486,113 @@ void server_receive_data_socket_node_to_node_db_sync_data(const char *MESSAGE) {
     if (tok_node) cJSON_Delete(tok_node); // ok if absent
   }
 
-  // --- quick sanity: at least one document under 'json' ---
-  int doc_count = 0;
-  for (cJSON *it = json_field->child; it; it = it->next) {
-    if (it->string && cJSON_IsObject(it)) ++doc_count;
+  // --- delta reply: only the leaves in merkle_replace are replaced ---
+  bool delta = false;
+  bool replace[DELEGATES_MERKLE_LEAVES];
+  char peer_root[(SHA256_HASH_SIZE * 2) + 1] = {0};
+  {
+    cJSON *mask_item = cJSON_GetObjectItemCaseSensitive(json_field, "merkle_replace");
+    cJSON *root_item = cJSON_GetObjectItemCaseSensitive(json_field, "merkle_root");
+    if (mask_item || root_item) {
+      if (!cJSON_IsString(mask_item) || !cJSON_IsString(root_item) ||
+          !delegates_merkle_mask_from_hex(mask_item->valuestring, replace) ||
+          strlen(root_item->valuestring) != SHA256_HASH_SIZE * 2) {
+        ERROR_PRINT("DB sync: malformed merkle_replace / merkle_root");
+        cJSON_Delete(root); root = NULL;
+        return;
+      }
+      memcpy(peer_root, root_item->valuestring, SHA256_HASH_SIZE * 2);
+      cJSON_DeleteItemFromObjectCaseSensitive(json_field, "merkle_replace");
+      cJSON_DeleteItemFromObjectCaseSensitive(json_field, "merkle_root");
+      delta = true;
+    }
   }
-  if (doc_count == 0) {
-    ERROR_PRINT("DB sync payload empty: no documents under 'json'");
+
+  bson_error_t error;
+  bson_t *doc = NULL;
+  uint8_t *snapshot = NULL;
+  size_t snapshot_len = 0;
+
+  cJSON *snapshot_item = cJSON_GetObjectItemCaseSensitive(json_field, "snapshot");
+  if (snapshot_item) {
+    // --- binary snapshot: check bounds, count and SHA-256 before touching the database ---
+    uint32_t doc_count = 0;
+    if (cJSON_IsString(snapshot_item)) {
+      snapshot = db_snapshot_decode(snapshot_item->valuestring, &snapshot_len);
+    }
     cJSON_Delete(root); root = NULL;
-    return;
-  }
-  INFO_PRINT("DB sync payload object contains %d documents", doc_count);
+    if (!snapshot || !db_snapshot_verify(snapshot, snapshot_len, &doc_count)) {
+      ERROR_PRINT("DB sync: malformed delegates snapshot");
+      free(snapshot);
+      return;
+    }
+    if (doc_count == 0 && !delta) {
+      ERROR_PRINT("DB sync payload empty: no documents in snapshot");
+      free(snapshot);
+      return;
+    }
+    INFO_PRINT("DB sync snapshot contains %u documents (%zu bytes)", doc_count, snapshot_len);
+
+    if (delta) {
+      doc = bson_new();
+      bool copied = db_snapshot_to_bson(snapshot, snapshot_len, doc);
+      free(snapshot); snapshot = NULL;
+      if (!copied) {
+        ERROR_PRINT("DB sync: failed to read delegates snapshot");
+        bson_destroy(doc);
+        return;
+      }
+    }
+  } else {
+    // --- quick sanity: at least one document under 'json' ---
+    int doc_count = 0;
+    for (cJSON *it = json_field->child; it; it = it->next) {
+      if (it->string && cJSON_IsObject(it)) ++doc_count;
+    }
+    if (doc_count == 0 && !delta) {
+      ERROR_PRINT("DB sync payload empty: no documents under 'json'");
+      cJSON_Delete(root); root = NULL;
+      return;
+    }
+    INFO_PRINT("DB sync payload object contains %d documents", doc_count);
 
-  // --- serialize 'json' object and convert to BSON ---
-  char *json_compact = cJSON_PrintUnformatted(json_field);
-  cJSON_Delete(root); root = NULL;
-  if (!json_compact) {
-    ERROR_PRINT("Failed to serialize 'json' object");
-    return;
-  }
+    // --- serialize 'json' object and convert to BSON ---
+    char *json_compact = cJSON_PrintUnformatted(json_field);
+    cJSON_Delete(root); root = NULL;
+    if (!json_compact) {
+      ERROR_PRINT("Failed to serialize 'json' object");
+      return;
+    }
 
-  bson_error_t error;
-  bson_t *doc = bson_new_from_json((const uint8_t *)json_compact, -1, &error);
-  free(json_compact);
-  if (!doc) {
-    ERROR_PRINT("Failed to parse BSON from JSON: %s", error.message);
-    return;
+    doc = bson_new_from_json((const uint8_t *)json_compact, -1, &error);
+    free(json_compact);
+    if (!doc) {
+      ERROR_PRINT("Failed to parse BSON from JSON: %s", error.message);
+      return;
+    }
+    if (doc->len == 0) {
+      ERROR_PRINT("Constructed BSON has zero length");
+      bson_destroy(doc);
+      return;
+    }
   }
-  if (doc->len == 0) {
-    ERROR_PRINT("Constructed BSON has zero length");
+
+  if (delta) {
+    size_t upserted = 0, removed = 0;
+    pthread_mutex_lock(&delegates_all_lock);
+    bool applied = delegates_merkle_apply(replace, doc, &upserted, &removed);
+    pthread_mutex_unlock(&delegates_all_lock);
     bson_destroy(doc);
+
+    delegates_merkle_t tree;
+    char root_hex[(SHA256_HASH_SIZE * 2) + 1] = {0};
+    if (delegates_merkle_build(&tree)) bin_to_hex(tree.root, SHA256_HASH_SIZE, root_hex);
+    if (!applied || strcmp(root_hex, peer_root) != 0) {
+      WARNING_PRINT("DB sync: delta did not converge, the next sync will copy the whole collection");
+      delegates_merkle_request_full_sync();
+    }
+    create_sync_token();
+    INFO_PRINT("Updated delegates database from sync delta: %zu written, %zu removed", upserted, removed);
     return;
   }
 
@@ -442,26 +602,32 @@ void server_receive_data_socket_node_to_node_db_sync_data(const char *MESSAGE) {
   if (!db_drop(DATABASE_NAME, DB_COLLECTION_DELEGATES, &error)) {
     ERROR_PRINT("Failed to clear old delegates table before sync: %s", error.message);
     pthread_mutex_unlock(&delegates_all_lock);
-    bson_destroy(doc);
+    if (doc) bson_destroy(doc);
+    free(snapshot);
     return;
   }
 
-  if (!db_upsert_multi_docs(DATABASE_NAME, DB_COLLECTION_DELEGATES, doc, &error)) {
+  bool written = snapshot ? db_snapshot_import(DATABASE_NAME, DB_COLLECTION_DELEGATES, snapshot, snapshot_len, &error)
+                          : db_upsert_multi_docs(DATABASE_NAME, DB_COLLECTION_DELEGATES, doc, &error);
+  if (!written) {
     ERROR_PRINT("Failed to upsert delegates sync data: %s", error.message);
     pthread_mutex_unlock(&delegates_all_lock);
-    bson_destroy(doc);
+    if (doc) bson_destroy(doc);
+    free(snapshot);
     return;
   }
 
   if (!add_indexes_delegates()) {
     ERROR_PRINT("Failed to create index on delegates");
     pthread_mutex_unlock(&delegates_all_lock);
-    bson_destroy(doc);
+    if (doc) bson_destroy(doc);
+    free(snapshot);
     return;
   }
 
   pthread_mutex_unlock(&delegates_all_lock);
-  bson_destroy(doc);
+  if (doc) bson_destroy(doc);
+  free(snapshot);
   create_sync_token();
 
   INFO_PRINT("Successfully updated delegates database from sync message");
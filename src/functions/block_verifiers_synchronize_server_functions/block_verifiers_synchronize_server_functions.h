@@ -12,6 +12,8 @@
 #include "structures.h"
 #include "db_functions.h"
 #include "db_sync.h"
+#include "delegates_merkle.h"
+#include "db_snapshot.h"
 #include "xcash_message.h"
 #include "db_sync.h"
 
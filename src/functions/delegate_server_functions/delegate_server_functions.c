@@ -766,7 +766,6 @@ void server_receive_data_socket_node_to_block_verifiers_add_reserve_proof(server
   char dbvoted_for[XCASH_WALLET_LENGTH + 1] = {0};
   char dbreserve_proof[BUFFER_SIZE_RESERVE_PROOF + 1] = {0};
   char json_filter[256] = {0};
-  char type_filter[256] = {0};
   uint64_t vote_amount_atomic = 0;
   int64_t dbtotal_vote = 0;
 
@@ -891,11 +890,10 @@ void server_receive_data_socket_node_to_block_verifiers_add_reserve_proof(server
       }
     }
 
-    snprintf(json_filter, sizeof(json_filter), "{\"delegate_name\":\"%.*s\"}",
-     (int)name_len, delegate_name_or_address);
+    char name_buf[MAXIMUM_BUFFER_SIZE_DELEGATES_NAME + 1] = {0};
+    snprintf(name_buf, sizeof(name_buf), "%.*s", (int)name_len, delegate_name_or_address);
     char addr_buf[XCASH_WALLET_LENGTH + 1] = {0};
-    if (read_document_field_from_collection(DATABASE_NAME, DB_COLLECTION_DELEGATES, json_filter,
-                                            "public_address", addr_buf, sizeof(addr_buf)) != XCASH_OK ||
+    if (!delegates_registry_get_utf8(DELEGATES_KEY_NAME, name_buf, "public_address", addr_buf, sizeof(addr_buf)) ||
         strnlen(addr_buf, sizeof(addr_buf)) != XCASH_WALLET_LENGTH ||
         strncmp(addr_buf, XCASH_WALLET_PREFIX, sizeof(XCASH_WALLET_PREFIX) - 1) != 0) {
       cJSON_Delete(root);
@@ -912,9 +910,7 @@ void server_receive_data_socket_node_to_block_verifiers_add_reserve_proof(server
   }
 
   char data[VVSMALL_BUFFER_SIZE] = {0};
-  snprintf(data, sizeof(data), "{\"public_address\":\"%s\"}", voter_public_address);
-  int num_delegates = count_documents_in_collection(DATABASE_NAME, DB_COLLECTION_DELEGATES, data);
-  if (num_delegates > 0) {
+  if (delegates_registry_has(DELEGATES_KEY_ADDRESS, voter_public_address)) {
     cJSON_Delete(root);
     SERVER_ERROR("0|A delegate wallet is not allowed to vote");
   }
@@ -929,10 +925,8 @@ void server_receive_data_socket_node_to_block_verifiers_add_reserve_proof(server
   }
 
   char type_buf[10] = {0};
-  snprintf(type_filter, sizeof(type_filter), "{\"public_address\":\"%s\"}", voted_for_public_address);
-
-  if (read_document_field_from_collection(DATABASE_NAME, DB_COLLECTION_DELEGATES, type_filter,
-                                          "delegate_type", type_buf, sizeof(type_buf)) != XCASH_OK) {
+  if (!delegates_registry_get_utf8(DELEGATES_KEY_ADDRESS, voted_for_public_address, "delegate_type",
+                                   type_buf, sizeof(type_buf))) {
     cJSON_Delete(root);
     SERVER_ERROR("0|The delegate voted for is invalid");
   }
@@ -0,0 +1,735 @@
+#include "reserve_proof_pipeline.h"
+
+/*
+ * Reserve proof scan as a producer/consumer pipeline.
+ *
+ * The calling thread walks the reserve_proofs cursor, does the cheap field checks, assigns each
+ * proof its delegate slot and pushes it into a bounded ring of RESERVE_PROOF_QUEUE_DEPTH jobs,
+ * blocking while the ring is full so memory stays flat however large the collection is.
+ * RESERVE_PROOF_VERIFIERS threads pop jobs and run check_reserve_proofs(); each keeps its own
+ * keep-alive wallet connection (send_http_request holds one curl handle per thread), so that
+ * many wallet calls are in flight at once instead of one.
+ *
+ * Per-delegate totals are atomic adds into slots fixed by the producer, and every verifier
+ * records its results in a private array, so no lock is held around a result. The arrays are
+ * merged and put back into cursor order after the verifiers are joined.
+ *
+ * The reserve_proofs_ledger collection remembers, per voter, the key SHA-256(voter, proof,
+ * total_vote) of the last proof the wallet accepted and the chain height it was accepted at.
+ * A proof whose key is in the ledger is counted as valid without a wallet call unless it falls
+ * in this scan's rolling slice (one of RESERVE_PROOF_RECHECK_SLICES) or was last proven more
+ * than RESERVE_PROOF_MAX_AGE_BLOCKS ago, so outputs spent since are still caught and pruned.
+ */
+typedef struct {
+  uint64_t seq;
+  char voter[XCASH_WALLET_LENGTH + 1];
+  uint32_t delegate;
+  uint64_t amount;
+  uint8_t key[SHA256_HASH_SIZE];
+  char* proof;
+} rp_job_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+  rp_job_t slots[RESERVE_PROOF_QUEUE_DEPTH];
+  size_t head;
+  size_t count;
+  bool closed;
+} rp_queue_t;
+
+typedef struct {
+  pthread_t thread;
+  rp_queue_t* queue;
+  _Atomic int64_t* totals;
+  reserve_proof_result_t* results;
+  size_t count;
+  size_t cap;
+  bool oom;
+} rp_worker_t;
+
+static atomic_bool rp_running = false;
+static atomic_uint_fast64_t rp_queued = 0;
+static atomic_uint_fast64_t rp_verified = 0;
+static atomic_uint_fast64_t rp_valid = 0;
+static atomic_uint_fast64_t rp_invalid = 0;
+static atomic_uint_fast64_t rp_skipped = 0;
+static atomic_uint_fast64_t rp_trusted = 0;
+static atomic_uint rp_ledger_runs = 0;
+static atomic_int_fast64_t rp_started_ns = 0;
+static atomic_int_fast64_t rp_finished_ns = 0;
+
+static int64_t rp_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void rp_queue_push(rp_queue_t* q, const rp_job_t* job)
+{
+  pthread_mutex_lock(&q->lock);
+  while (q->count == RESERVE_PROOF_QUEUE_DEPTH) {
+    pthread_cond_wait(&q->not_full, &q->lock);
+  }
+  q->slots[(q->head + q->count) % RESERVE_PROOF_QUEUE_DEPTH] = *job;
+  q->count++;
+  pthread_cond_signal(&q->not_empty);
+  pthread_mutex_unlock(&q->lock);
+}
+
+static bool rp_queue_pop(rp_queue_t* q, rp_job_t* job)
+{
+  pthread_mutex_lock(&q->lock);
+  while (q->count == 0 && !q->closed) {
+    pthread_cond_wait(&q->not_empty, &q->lock);
+  }
+  if (q->count == 0) {
+    pthread_mutex_unlock(&q->lock);
+    return false;
+  }
+  *job = q->slots[q->head];
+  q->head = (q->head + 1) % RESERVE_PROOF_QUEUE_DEPTH;
+  q->count--;
+  pthread_cond_signal(&q->not_full);
+  pthread_mutex_unlock(&q->lock);
+  return true;
+}
+
+static void rp_queue_close(rp_queue_t* q)
+{
+  pthread_mutex_lock(&q->lock);
+  q->closed = true;
+  pthread_cond_broadcast(&q->not_empty);
+  pthread_mutex_unlock(&q->lock);
+}
+
+static bool rp_worker_record(rp_worker_t* w, const rp_job_t* job, bool valid, bool cached)
+{
+  if (w->count == w->cap) {
+    size_t new_cap = w->cap ? w->cap * 2 : 256;
+    reserve_proof_result_t* p = realloc(w->results, new_cap * sizeof(*p));
+    if (!p) return false;
+    w->results = p;
+    w->cap = new_cap;
+  }
+  reserve_proof_result_t* r = &w->results[w->count++];
+  r->seq = job->seq;
+  memcpy(r->voter, job->voter, sizeof(r->voter));
+  r->delegate = job->delegate;
+  r->amount = job->amount;
+  memcpy(r->key, job->key, sizeof(r->key));
+  r->valid = valid;
+  r->cached = cached;
+  return true;
+}
+
+static void* rp_worker_main(void* arg)
+{
+  rp_worker_t* w = (rp_worker_t*)arg;
+  rp_job_t job;
+
+  while (rp_queue_pop(w->queue, &job)) {
+    // On shutdown the queue is drained without calling the wallet
+    if (atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
+      free(job.proof);
+      continue;
+    }
+
+    bool valid = check_reserve_proofs(job.amount, job.voter, job.proof) == XCASH_OK;
+    free(job.proof);
+
+    if (valid) {
+      atomic_fetch_add_explicit(&w->totals[job.delegate], (int64_t)job.amount, memory_order_relaxed);
+      atomic_fetch_add_explicit(&rp_valid, 1, memory_order_relaxed);
+    } else {
+      atomic_fetch_add_explicit(&rp_invalid, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&rp_verified, 1, memory_order_relaxed);
+
+    if (!w->oom && !rp_worker_record(w, &job, valid, false)) {
+      w->oom = true;
+    }
+  }
+  return NULL;
+}
+
+static int rp_result_cmp(const void* a, const void* b)
+{
+  uint64_t x = ((const reserve_proof_result_t*)a)->seq;
+  uint64_t y = ((const reserve_proof_result_t*)b)->seq;
+  return (x > y) - (x < y);
+}
+
+// Slot of a delegate in the scan, created on first use; -1 when the table is full or the address is malformed
+static int rp_delegate_index(reserve_proof_scan_t* scan, const char* delegate)
+{
+  for (size_t i = 0; i < scan->delegate_count; ++i) {
+    if (strcmp(scan->delegates[i], delegate) == 0) return (int)i;
+  }
+  size_t n = strnlen(delegate, XCASH_WALLET_LENGTH + 1);
+  if (n == 0 || n > XCASH_WALLET_LENGTH) {
+    ERROR_PRINT("bad delegate address length=%zu, skipping", n);
+    return -1;
+  }
+  if (scan->delegate_count >= BLOCK_VERIFIERS_TOTAL_AMOUNT) {
+    ERROR_PRINT("vote_sums full; dropping contribution for %.12s…", delegate);
+    return -1;
+  }
+  memcpy(scan->delegates[scan->delegate_count], delegate, n);
+  scan->delegates[scan->delegate_count][n] = '\0';
+  return (int)scan->delegate_count++;
+}
+
+// Reads one reserve_proofs document into a job (proof points into doc); false if it must be skipped
+static bool rp_parse_doc(const bson_t* doc, reserve_proof_scan_t* scan, rp_job_t* job, const char** proof_out)
+{
+  bson_iter_t it;
+  const char* voter = NULL;     // _id (voter public address)
+  const char* delegate = NULL;  // public_address_voted_for
+  const char* proof = NULL;     // reserve_proof
+  int64_t claimed_total = 0;
+
+  if (bson_iter_init_find(&it, doc, "_id") && BSON_ITER_HOLDS_UTF8(&it))
+    voter = bson_iter_utf8(&it, NULL);
+
+  if (bson_iter_init_find(&it, doc, "public_address_voted_for") && BSON_ITER_HOLDS_UTF8(&it))
+    delegate = bson_iter_utf8(&it, NULL);
+
+  if (bson_iter_init_find(&it, doc, "reserve_proof") && BSON_ITER_HOLDS_UTF8(&it))
+    proof = bson_iter_utf8(&it, NULL);
+
+  // total_vote must be integer and positive
+  if (bson_iter_init_find(&it, doc, "total_vote")) {
+    if (BSON_ITER_HOLDS_INT64(&it))
+      claimed_total = bson_iter_int64(&it);
+    else if (BSON_ITER_HOLDS_INT32(&it))
+      claimed_total = (int64_t)bson_iter_int32(&it);
+    else {
+      ERROR_PRINT("reserve_proofs: total_vote has unexpected type=%d for id=%.12s…",
+                  (int)bson_iter_type(&it), voter ? voter : "(unknown)");
+      return false;
+    }
+  } else {
+    ERROR_PRINT("reserve_proofs: missing total_vote for id=%.12s…",
+                voter ? voter : "(unknown)");
+    return false;
+  }
+
+  if (claimed_total <= 0) {
+    ERROR_PRINT("reserve_proofs: non-positive total_vote=%lld for id=%.12s… — skipping",
+                (long long)claimed_total, voter ? voter : "(unknown)");
+    return false;
+  }
+
+  if (!voter || !delegate || !proof) {
+    ERROR_PRINT("reserve_proofs: missing required field(s), skipping one doc");
+    return false;
+  }
+
+  size_t voter_len = strnlen(voter, XCASH_WALLET_LENGTH + 1);
+  if (voter_len == 0 || voter_len > XCASH_WALLET_LENGTH) {
+    ERROR_PRINT("reserve_proofs: bad voter address length=%zu, skipping", voter_len);
+    return false;
+  }
+
+  int idx = rp_delegate_index(scan, delegate);
+  if (idx < 0) {
+    return false;
+  }
+
+  *proof_out = proof;
+  memcpy(job->voter, voter, voter_len);
+  job->voter[voter_len] = '\0';
+  job->delegate = (uint32_t)idx;
+  job->amount = (uint64_t)claimed_total;
+  return true;
+}
+
+typedef enum {
+  RP_LEDGER_FRESH = 0,    // not in the ledger: new, changed or never proven
+  RP_LEDGER_RECHECK = 1,  // in the ledger but due for a wallet call
+  RP_LEDGER_TRUSTED = 2   // in the ledger and recent enough to count without a wallet call
+} rp_ledger_state_t;
+
+static bool rp_ledger_key(const char* voter, const char* proof, uint64_t amount, uint8_t key[SHA256_HASH_SIZE])
+{
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  if (!ctx) return false;
+
+  // NUL separators and the fixed-width amount keep (voter, proof, amount) splits unambiguous
+  uint8_t amount_le[8];
+  for (int b = 0; b < 8; ++b) amount_le[b] = (uint8_t)((amount >> (8 * b)) & 0xFF);
+
+  unsigned int out_len = 0;
+  bool ok = EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+            EVP_DigestUpdate(ctx, voter, strlen(voter) + 1) == 1 &&
+            EVP_DigestUpdate(ctx, proof, strlen(proof) + 1) == 1 &&
+            EVP_DigestUpdate(ctx, amount_le, sizeof amount_le) == 1 &&
+            EVP_DigestFinal_ex(ctx, key, &out_len) == 1 &&
+            out_len == SHA256_HASH_SIZE;
+  EVP_MD_CTX_free(ctx);
+  return ok;
+}
+
+static size_t rp_ledger_slot(const reserve_proof_ledger_t* l, const uint8_t key[SHA256_HASH_SIZE])
+{
+  size_t h = (size_t)key[0] | ((size_t)key[1] << 8) | ((size_t)key[2] << 16) | ((size_t)key[3] << 24);
+  size_t mask = l->cap - 1;
+  for (size_t i = h & mask;; i = (i + 1) & mask) {
+    if (!l->slots[i].used || memcmp(l->slots[i].key, key, SHA256_HASH_SIZE) == 0) return i;
+  }
+}
+
+static bool rp_ledger_insert(reserve_proof_ledger_t* l, const uint8_t key[SHA256_HASH_SIZE], uint64_t height)
+{
+  if ((l->count + 1) * 2 > l->cap) {
+    size_t new_cap = l->cap ? l->cap * 2 : 1024;
+    reserve_proof_ledger_entry_t* old = l->slots;
+    size_t old_cap = l->cap;
+    l->slots = calloc(new_cap, sizeof(*l->slots));
+    if (!l->slots) {
+      l->slots = old;
+      return false;
+    }
+    l->cap = new_cap;
+    for (size_t i = 0; i < old_cap; ++i) {
+      if (old[i].used) l->slots[rp_ledger_slot(l, old[i].key)] = old[i];
+    }
+    free(old);
+  }
+  reserve_proof_ledger_entry_t* e = &l->slots[rp_ledger_slot(l, key)];
+  if (!e->used) l->count++;
+  memcpy(e->key, key, SHA256_HASH_SIZE);
+  e->height = height;
+  e->used = true;
+  return true;
+}
+
+static rp_ledger_state_t rp_ledger_state(const reserve_proof_ledger_t* l, const uint8_t key[SHA256_HASH_SIZE])
+{
+  if (!l || l->count == 0) return RP_LEDGER_FRESH;
+  const reserve_proof_ledger_entry_t* e = &l->slots[rp_ledger_slot(l, key)];
+  if (!e->used) return RP_LEDGER_FRESH;
+
+  // A height above the chain's means the node resynced or reorganised; prove it again
+  if (e->height > l->height || l->height - e->height >= RESERVE_PROOF_MAX_AGE_BLOCKS) return RP_LEDGER_RECHECK;
+  if (key[SHA256_HASH_SIZE - 1] % RESERVE_PROOF_RECHECK_SLICES == l->slice) return RP_LEDGER_RECHECK;
+  return RP_LEDGER_TRUSTED;
+}
+
+static void rp_log_progress(const char* label)
+{
+  reserve_proof_progress_t p;
+  reserve_proof_get_progress(&p);
+  INFO_PRINT("reserve_proofs %s: queued=%llu verified=%llu valid=%llu invalid=%llu skipped=%llu trusted=%llu "
+             "in_flight=%llu elapsed=%.1fs rate=%.1f proofs/s",
+             label, (unsigned long long)p.queued, (unsigned long long)p.verified, (unsigned long long)p.valid,
+             (unsigned long long)p.invalid, (unsigned long long)p.skipped, (unsigned long long)p.trusted,
+             (unsigned long long)p.in_flight, p.elapsed_sec, p.proofs_per_sec);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: reserve_proof_scan
+Description: Validates every proof returned by a reserve_proofs cursor with RESERVE_PROOF_VERIFIERS
+  concurrent wallet calls and aggregates the valid claimed totals per delegate. Proofs the ledger
+  still vouches for are counted as valid without a wallet call.
+Parameters:
+  cur - Cursor over reserve_proofs projecting _id, public_address_voted_for, total_vote and reserve_proof
+  ledger - Ledger loaded by reserve_proof_ledger_load, or NULL to send every proof to the wallet
+  scan - Receives the per-delegate totals, the per-proof results and the counters; release it with
+         reserve_proof_scan_free()
+Return: true if the whole cursor was verified, false after a setup failure, a cursor error or a
+  shutdown request (scan then holds what was verified so far)
+---------------------------------------------------------------------------------------------------------*/
+bool reserve_proof_scan(mongoc_cursor_t* cur, const reserve_proof_ledger_t* ledger, reserve_proof_scan_t* scan)
+{
+  if (!cur || !scan) return false;
+  memset(scan, 0, sizeof(*scan));
+
+  rp_queue_t* queue = calloc(1, sizeof(*queue));
+  // workers[RESERVE_PROOF_VERIFIERS] is not a thread; it holds the results taken from the ledger
+  rp_worker_t* workers = calloc(RESERVE_PROOF_VERIFIERS + 1, sizeof(*workers));
+  _Atomic int64_t* totals = calloc(BLOCK_VERIFIERS_TOTAL_AMOUNT, sizeof(*totals));
+  if (!queue || !workers || !totals) {
+    ERROR_PRINT("reserve_proofs: OOM setting up the verifier pool");
+    free(queue);
+    free(workers);
+    free(totals);
+    return false;
+  }
+  pthread_mutex_init(&queue->lock, NULL);
+  pthread_cond_init(&queue->not_empty, NULL);
+  pthread_cond_init(&queue->not_full, NULL);
+
+  atomic_store(&rp_queued, 0);
+  atomic_store(&rp_verified, 0);
+  atomic_store(&rp_valid, 0);
+  atomic_store(&rp_invalid, 0);
+  atomic_store(&rp_skipped, 0);
+  atomic_store(&rp_trusted, 0);
+  atomic_store(&rp_finished_ns, 0);
+  int64_t started = rp_now_ns();
+  atomic_store(&rp_started_ns, started);
+  atomic_store(&rp_running, true);
+
+  size_t started_workers = 0;
+  for (size_t i = 0; i < RESERVE_PROOF_VERIFIERS; ++i) {
+    workers[i].queue = queue;
+    workers[i].totals = totals;
+    if (pthread_create(&workers[i].thread, NULL, rp_worker_main, &workers[i]) != 0) {
+      WARNING_PRINT("reserve_proofs: could only start %zu of %d verifiers", started_workers, RESERVE_PROOF_VERIFIERS);
+      break;
+    }
+    started_workers++;
+  }
+
+  bool complete = started_workers > 0;
+  if (!complete) {
+    ERROR_PRINT("reserve_proofs: no verifier thread could be started");
+  }
+
+  const bson_t* doc = NULL;
+  int64_t next_progress = started + (int64_t)RESERVE_PROOF_PROGRESS_SEC * 1000000000LL;
+  while (complete && mongoc_cursor_next(cur, &doc)) {
+    if (atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
+      complete = false;
+      break;
+    }
+    scan->seen++;
+
+    rp_job_t job;
+    const char* proof = NULL;
+    memset(&job, 0, sizeof(job));
+    job.seq = scan->seen;
+    if (!rp_parse_doc(doc, scan, &job, &proof) || !rp_ledger_key(job.voter, proof, job.amount, job.key)) {
+      scan->skipped++;
+      atomic_fetch_add_explicit(&rp_skipped, 1, memory_order_relaxed);
+      continue;
+    }
+
+    rp_ledger_state_t state = rp_ledger_state(ledger, job.key);
+    if (state == RP_LEDGER_TRUSTED) {
+      rp_worker_t* own = &workers[RESERVE_PROOF_VERIFIERS];
+      if (!own->oom && !rp_worker_record(own, &job, true, true)) {
+        own->oom = true;
+      }
+      atomic_fetch_add_explicit(&totals[job.delegate], (int64_t)job.amount, memory_order_relaxed);
+      atomic_fetch_add_explicit(&rp_valid, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&rp_trusted, 1, memory_order_relaxed);
+      scan->trusted++;
+      continue;
+    }
+    if (state == RP_LEDGER_RECHECK) {
+      scan->rechecked++;
+    } else {
+      scan->fresh++;
+    }
+
+    job.proof = strdup(proof);
+    if (!job.proof) {
+      ERROR_PRINT("reserve_proofs: OOM copying proof for id=%.12s…", job.voter);
+      scan->skipped++;
+      atomic_fetch_add_explicit(&rp_skipped, 1, memory_order_relaxed);
+      continue;
+    }
+
+    atomic_fetch_add_explicit(&rp_queued, 1, memory_order_relaxed);
+    rp_queue_push(queue, &job);
+
+    int64_t now = rp_now_ns();
+    if (now >= next_progress) {
+      rp_log_progress("scan progress");
+      next_progress = now + (int64_t)RESERVE_PROOF_PROGRESS_SEC * 1000000000LL;
+    }
+  }
+
+  bson_error_t cerr;
+  if (mongoc_cursor_error(cur, &cerr)) {
+    ERROR_PRINT("reserve_proofs cursor error: %s", cerr.message);
+    complete = false;
+  }
+
+  rp_queue_close(queue);
+  for (size_t i = 0; i < started_workers; ++i) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  if (atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
+    complete = false;
+  }
+
+  // The ledger results sit after the started verifiers so one loop merges both
+  if (started_workers < RESERVE_PROOF_VERIFIERS) {
+    workers[started_workers] = workers[RESERVE_PROOF_VERIFIERS];
+  }
+  size_t merged_workers = started_workers + 1;
+
+  size_t total_results = 0;
+  for (size_t i = 0; i < merged_workers; ++i) {
+    if (workers[i].oom) {
+      ERROR_PRINT("reserve_proofs: OOM recording results; some verified proofs are missing from the payout outputs");
+      complete = false;
+    }
+    total_results += workers[i].count;
+  }
+
+  if (total_results > 0) {
+    scan->results = malloc(total_results * sizeof(*scan->results));
+    if (!scan->results) {
+      ERROR_PRINT("reserve_proofs: OOM merging %zu results", total_results);
+      complete = false;
+    }
+  }
+  for (size_t i = 0; i < merged_workers; ++i) {
+    if (scan->results && workers[i].count > 0) {
+      memcpy(&scan->results[scan->result_count], workers[i].results, workers[i].count * sizeof(*scan->results));
+      scan->result_count += workers[i].count;
+    }
+    free(workers[i].results);
+  }
+  if (scan->result_count > 1) {
+    qsort(scan->results, scan->result_count, sizeof(*scan->results), rp_result_cmp);
+  }
+
+  for (size_t i = 0; i < scan->delegate_count; ++i) {
+    scan->totals[i] = atomic_load(&totals[i]);
+  }
+  scan->valid = (size_t)atomic_load(&rp_valid);
+  scan->invalid = (size_t)atomic_load(&rp_invalid);
+  scan->complete = complete;
+
+  int64_t finished = rp_now_ns();
+  scan->elapsed_sec = (double)(finished - started) / 1e9;
+  atomic_store(&rp_finished_ns, finished);
+  atomic_store(&rp_running, false);
+  rp_log_progress("scan finished");
+
+  pthread_cond_destroy(&queue->not_full);
+  pthread_cond_destroy(&queue->not_empty);
+  pthread_mutex_destroy(&queue->lock);
+  free(queue);
+  free(workers);
+  free(totals);
+  return complete;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: reserve_proof_scan_free
+Description: Releases the results held by a scan
+Parameters:
+  scan - The scan filled by reserve_proof_scan
+---------------------------------------------------------------------------------------------------------*/
+void reserve_proof_scan_free(reserve_proof_scan_t* scan)
+{
+  if (!scan) return;
+  free(scan->results);
+  scan->results = NULL;
+  scan->result_count = 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: reserve_proof_get_progress
+Description: Copies the counters of the running (or last) reserve proof scan; safe from any thread
+Parameters:
+  out - Receives the counters
+---------------------------------------------------------------------------------------------------------*/
+void reserve_proof_get_progress(reserve_proof_progress_t* out)
+{
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+
+  out->running = atomic_load(&rp_running);
+  out->queued = atomic_load(&rp_queued);
+  out->verified = atomic_load(&rp_verified);
+  out->valid = atomic_load(&rp_valid);
+  out->invalid = atomic_load(&rp_invalid);
+  out->skipped = atomic_load(&rp_skipped);
+  out->trusted = atomic_load(&rp_trusted);
+  out->in_flight = out->queued > out->verified ? out->queued - out->verified : 0;
+
+  int64_t started = atomic_load(&rp_started_ns);
+  int64_t finished = atomic_load(&rp_finished_ns);
+  if (started == 0) return;
+  int64_t end = (out->running || finished == 0) ? rp_now_ns() : finished;
+  out->elapsed_sec = (double)(end - started) / 1e9;
+  if (out->elapsed_sec > 0.0) {
+    out->proofs_per_sec = (double)out->verified / out->elapsed_sec;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: reserve_proof_ledger_load
+Description: Reads the reserve_proofs ledger into memory for one scan and picks the scan's re-check slice
+Parameters:
+  coll - The reserve_proofs_ledger collection
+  height - Current chain height
+  ledger - Receives the ledger; release it with reserve_proof_ledger_free()
+Return: true if the ledger can be used, false if the height is unknown or the collection could not be
+  read (the scan then sends every proof to the wallet)
+---------------------------------------------------------------------------------------------------------*/
+bool reserve_proof_ledger_load(mongoc_collection_t* coll, uint64_t height, reserve_proof_ledger_t* ledger)
+{
+  if (!coll || !ledger) return false;
+  memset(ledger, 0, sizeof(*ledger));
+  if (height == 0) return false;
+
+  ledger->height = height;
+  ledger->slice = atomic_fetch_add(&rp_ledger_runs, 1) % RESERVE_PROOF_RECHECK_SLICES;
+
+  bson_t* query = bson_new();
+  bson_t* opts = BCON_NEW("projection", "{", "key", BCON_INT32(1), "height", BCON_INT32(1), "}");
+  mongoc_cursor_t* cur = (query && opts) ? mongoc_collection_find_with_opts(coll, query, opts, NULL) : NULL;
+  if (!cur) {
+    ERROR_PRINT("reserve_proofs ledger: find failed");
+    if (opts) bson_destroy(opts);
+    if (query) bson_destroy(query);
+    return false;
+  }
+
+  const bson_t* doc = NULL;
+  size_t dropped = 0;
+  bool ok = true;
+  while (mongoc_cursor_next(cur, &doc)) {
+    bson_iter_t it;
+    const char* key_hex = NULL;
+    int64_t entry_height = -1;
+    if (bson_iter_init_find(&it, doc, "key") && BSON_ITER_HOLDS_UTF8(&it))
+      key_hex = bson_iter_utf8(&it, NULL);
+    if (bson_iter_init_find(&it, doc, "height") && (BSON_ITER_HOLDS_INT64(&it) || BSON_ITER_HOLDS_INT32(&it)))
+      entry_height = bson_iter_as_int64(&it);
+
+    uint8_t key[SHA256_HASH_SIZE];
+    if (!key_hex || entry_height < 0 || !is_hex_len(key_hex, SHA256_HASH_SIZE * 2) ||
+        !hex_to_byte_array(key_hex, key, sizeof key)) {
+      ++dropped;
+      continue;
+    }
+    if (!rp_ledger_insert(ledger, key, (uint64_t)entry_height)) {
+      ERROR_PRINT("reserve_proofs ledger: OOM loading entries");
+      ok = false;
+      break;
+    }
+  }
+
+  bson_error_t err;
+  if (ok && mongoc_cursor_error(cur, &err)) {
+    ERROR_PRINT("reserve_proofs ledger: cursor error: %s", err.message);
+    ok = false;
+  }
+  mongoc_cursor_destroy(cur);
+  bson_destroy(opts);
+  bson_destroy(query);
+
+  if (!ok) {
+    reserve_proof_ledger_free(ledger);
+    return false;
+  }
+  if (dropped > 0) {
+    WARNING_PRINT("reserve_proofs ledger: ignored %zu malformed entries", dropped);
+  }
+  DEBUG_PRINT("reserve_proofs ledger: loaded %zu entries at height %llu, re-check slice %u/%d",
+              ledger->count, (unsigned long long)height, ledger->slice, RESERVE_PROOF_RECHECK_SLICES);
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: reserve_proof_ledger_commit
+Description: Records the proofs the wallet accepted during a scan at the scan's height, forgets the
+  rejected ones and drops entries of voters that no longer have a proof
+Parameters:
+  coll - The reserve_proofs_ledger collection
+  ledger - The ledger the scan ran with
+  scan - The finished scan
+---------------------------------------------------------------------------------------------------------*/
+void reserve_proof_ledger_commit(mongoc_collection_t* coll, const reserve_proof_ledger_t* ledger,
+                                 const reserve_proof_scan_t* scan)
+{
+  if (!coll || !ledger || !scan || ledger->height == 0) return;
+
+  bson_t* upsert_opts = BCON_NEW("upsert", BCON_BOOL(true));
+  if (!upsert_opts) {
+    ERROR_PRINT("reserve_proofs ledger: OOM building options");
+    return;
+  }
+
+  size_t stored = 0, forgotten = 0, failed = 0;
+  for (size_t r = 0; r < scan->result_count; ++r) {
+    const reserve_proof_result_t* res = &scan->results[r];
+    if (res->cached) continue;
+
+    bson_t filter;
+    bson_init(&filter);
+    BSON_APPEND_UTF8(&filter, "_id", res->voter);
+    bson_error_t err;
+
+    if (res->valid) {
+      char key_hex[SHA256_HASH_SIZE * 2 + 1];
+      bytes_to_hex(res->key, sizeof res->key, key_hex, sizeof key_hex);
+
+      bson_t set, update;
+      bson_init(&set);
+      BSON_APPEND_UTF8(&set, "key", key_hex);
+      BSON_APPEND_INT64(&set, "height", (int64_t)ledger->height);
+      bson_init(&update);
+      BSON_APPEND_DOCUMENT(&update, "$set", &set);
+      if (mongoc_collection_update_one(coll, &filter, &update, upsert_opts, NULL, &err)) {
+        ++stored;
+      } else {
+        ++failed;
+        DEBUG_PRINT("reserve_proofs ledger: store failed id=%.12s… : %s", res->voter, err.message);
+      }
+      bson_destroy(&update);
+      bson_destroy(&set);
+    } else {
+      if (mongoc_collection_delete_one(coll, &filter, NULL, NULL, &err)) {
+        ++forgotten;
+      } else {
+        ++failed;
+        DEBUG_PRINT("reserve_proofs ledger: delete failed id=%.12s… : %s", res->voter, err.message);
+      }
+    }
+    bson_destroy(&filter);
+  }
+  bson_destroy(upsert_opts);
+
+  // Every live entry is re-proven within RESERVE_PROOF_MAX_AGE_BLOCKS, so anything twice as old
+  // belongs to a voter whose proof is gone
+  int64_t pruned = 0;
+  if (ledger->height > 2ULL * RESERVE_PROOF_MAX_AGE_BLOCKS) {
+    int64_t cutoff = (int64_t)(ledger->height - 2ULL * RESERVE_PROOF_MAX_AGE_BLOCKS);
+    bson_t* filter = BCON_NEW("height", "{", "$lt", BCON_INT64(cutoff), "}");
+    if (filter) {
+      bson_t reply;
+      bson_error_t err;
+      if (mongoc_collection_delete_many(coll, filter, NULL, &reply, &err)) {
+        bson_iter_t it;
+        if (bson_iter_init_find(&it, &reply, "deletedCount") && BSON_ITER_HOLDS_INT(&it)) {
+          pruned = bson_iter_as_int64(&it);
+        }
+      } else {
+        ERROR_PRINT("reserve_proofs ledger: prune failed: %s", err.message);
+      }
+      bson_destroy(&reply);
+      bson_destroy(filter);
+    }
+  }
+
+  INFO_PRINT("reserve_proofs ledger: stored=%zu forgotten=%zu pruned=%lld failed=%zu",
+             stored, forgotten, (long long)pruned, failed);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: reserve_proof_ledger_free
+Description: Releases an in-memory ledger
+Parameters:
+  ledger - The ledger filled by reserve_proof_ledger_load
+---------------------------------------------------------------------------------------------------------*/
+void reserve_proof_ledger_free(reserve_proof_ledger_t* ledger)
+{
+  if (!ledger) return;
+  free(ledger->slots);
+  ledger->slots = NULL;
+  ledger->cap = 0;
+  ledger->count = 0;
+}
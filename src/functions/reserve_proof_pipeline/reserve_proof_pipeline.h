@@ -0,0 +1,84 @@
+#ifndef RESERVE_PROOF_PIPELINE_H_   /* Include guard */
+#define RESERVE_PROOF_PIPELINE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include <mongoc/mongoc.h>
+#include <bson/bson.h>
+#include <openssl/evp.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+#include "network_wallet_functions.h"
+#include "string_functions.h"
+
+typedef struct {
+  uint64_t seq;                              // position of the document in the cursor
+  char voter[XCASH_WALLET_LENGTH + 1];       // _id of the reserve_proofs document
+  uint32_t delegate;                         // index into reserve_proof_scan_t.delegates
+  uint64_t amount;                           // claimed total_vote
+  uint8_t key[SHA256_HASH_SIZE];             // ledger key of (voter, proof, amount)
+  bool valid;                                // wallet accepted the proof for amount
+  bool cached;                               // taken from the ledger without a wallet call
+} reserve_proof_result_t;
+
+typedef struct {
+  uint8_t key[SHA256_HASH_SIZE];
+  uint64_t height;                           // chain height the proof was last proven unspent at
+  bool used;
+} reserve_proof_ledger_entry_t;
+
+// In-memory copy of the reserve_proofs ledger for one scan
+typedef struct {
+  reserve_proof_ledger_entry_t* slots;       // open addressing, capacity is a power of two
+  size_t cap;
+  size_t count;
+  uint64_t height;                           // chain height of this scan
+  uint32_t slice;                            // share of unchanged proofs re-checked by this scan
+} reserve_proof_ledger_t;
+
+typedef struct {
+  char delegates[BLOCK_VERIFIERS_TOTAL_AMOUNT][XCASH_WALLET_LENGTH + 1];
+  int64_t totals[BLOCK_VERIFIERS_TOTAL_AMOUNT];  // sum of the valid claimed totals per delegate
+  size_t delegate_count;
+  reserve_proof_result_t* results;               // every verified proof, in cursor order
+  size_t result_count;
+  size_t seen;
+  size_t valid;
+  size_t invalid;
+  size_t skipped;                                // documents rejected before reaching the wallet
+  size_t trusted;                                // unchanged proofs taken from the ledger
+  size_t rechecked;                              // unchanged proofs sent to the wallet (slice or age)
+  size_t fresh;                                  // new or changed proofs
+  double elapsed_sec;
+  bool complete;                                 // false after a cursor error or a shutdown request
+} reserve_proof_scan_t;
+
+typedef struct {
+  bool running;
+  uint64_t queued;       // proofs handed to the verifiers
+  uint64_t verified;     // wallet answers received, valid or not
+  uint64_t valid;
+  uint64_t invalid;
+  uint64_t skipped;
+  uint64_t trusted;      // answered from the ledger
+  uint64_t in_flight;    // queued but not yet answered
+  double elapsed_sec;
+  double proofs_per_sec;
+} reserve_proof_progress_t;
+
+bool reserve_proof_ledger_load(mongoc_collection_t* coll, uint64_t height, reserve_proof_ledger_t* ledger);
+void reserve_proof_ledger_commit(mongoc_collection_t* coll, const reserve_proof_ledger_t* ledger,
+                                 const reserve_proof_scan_t* scan);
+void reserve_proof_ledger_free(reserve_proof_ledger_t* ledger);
+bool reserve_proof_scan(mongoc_cursor_t* cur, const reserve_proof_ledger_t* ledger, reserve_proof_scan_t* scan);
+void reserve_proof_scan_free(reserve_proof_scan_t* scan);
+void reserve_proof_get_progress(reserve_proof_progress_t* out);
+
+#endif
@@ -54,21 +54,18 @@ Description: Limits or removes connections based on public addresses.
 Parameters:
   LIMIT_ACTION - LIMIT_CHECK (1) to enforce limit and add address if below threshold,
                  LIMIT_REMOVE (0) to remove the address from the limit list.
-  MESSAGE - JSON string containing the "public_address" field.
+  env - The parsed message containing the "public_address" field.
 
 Return:
   1 if the operation was successful (limit passed or address removed),
   0 if the limit is exceeded, input is invalid, or an error occurred.
 ---------------------------------------------------------------------------------------------------------*/
-int server_limit_public_addresses(limit_action_t action, const char* MESSAGE) {
-  if (!MESSAGE || *MESSAGE == '\0') return 0;
+int server_limit_public_addresses(limit_action_t action, const xcash_msg_env_t* env) {
+  if (!env || env->public_address[0] == '\0') return 0;
 
-  char public_address[XCASH_WALLET_LENGTH + 1] = {0};
+  const char* public_address = env->public_address;
   char data[VVSMALL_BUFFER_SIZE] = {0};
 
-  if (parse_json_data(MESSAGE, "public_address", public_address, sizeof(public_address)) != 1)
-    return 0;
-
   if (strlen(public_address) != XCASH_WALLET_LENGTH ||
       strncmp(public_address, XCASH_WALLET_PREFIX, strlen(XCASH_WALLET_PREFIX)) != 0)
     return 0;
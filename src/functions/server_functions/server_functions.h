@@ -12,7 +12,7 @@
 #include "network_security_functions.h"
 
 int server_limit_IP_addresses(limit_action_t action, const char* IP_ADDRESS);
-int server_limit_public_addresses(limit_action_t action, const char* MESSAGE);
+int server_limit_public_addresses(limit_action_t action, const xcash_msg_env_t* env);
 bool get_self_sha256(char out_hex[SHA256_DIGEST_SIZE + 1]);
 
 #endif
\ No newline at end of file
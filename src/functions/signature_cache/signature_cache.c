@@ -0,0 +1,246 @@
+#include "signature_cache.h"
+
+/*
+ * Memo of signatures that already verified.
+ *
+ * Seeds re-verify votes replicated between them, peers resend after timeouts and clients
+ * retry action messages, so the same (data, address, signature) triple is checked many
+ * times. Only positive results are stored: a forged signature always pays for the full
+ * check and cannot push good entries out any faster than a valid one.
+ *
+ * Keys are SHA-256(data length || data || address || signature); the table is split
+ * into SIGNATURE_CACHE_SHARDS independently locked shards of fixed size, and a key may only
+ * live in one set of SIGNATURE_CACHE_WAYS slots, so a lookup is a handful of memcmps and the
+ * memory use is fixed. Entries whose signed data carries v_previous_block_hash are bound to
+ * the round they were stored in and stop matching once signature_cache_new_round() runs;
+ * every entry also expires after SIGNATURE_CACHE_TTL_SEC.
+ */
+#define SIG_CACHE_SETS (SIGNATURE_CACHE_SHARD_ENTRIES / SIGNATURE_CACHE_WAYS)
+
+typedef struct {
+  uint8_t key[SHA256_HASH_SIZE];
+  bool used;
+  bool round_bound;
+  uint32_t epoch;
+  long expires_sec;
+  uint64_t stamp;             /* insertion order within the shard, oldest is replaced first */
+} sig_cache_entry_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  sig_cache_entry_t entries[SIGNATURE_CACHE_SHARD_ENTRIES];
+  uint64_t next_stamp;
+  signature_cache_stats_t stats;
+} sig_cache_shard_t;
+
+static sig_cache_shard_t sig_cache_shards[SIGNATURE_CACHE_SHARDS];
+static pthread_once_t sig_cache_once = PTHREAD_ONCE_INIT;
+static atomic_uint sig_cache_epoch = 1;
+
+static void sig_cache_init(void)
+{
+  for (size_t s = 0; s < SIGNATURE_CACHE_SHARDS; s++) {
+    pthread_mutex_init(&sig_cache_shards[s].lock, NULL);
+  }
+}
+
+static long sig_cache_now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long)ts.tv_sec;
+}
+
+static sig_cache_shard_t* sig_cache_shard(const sig_cache_key_t* key)
+{
+  pthread_once(&sig_cache_once, sig_cache_init);
+  return &sig_cache_shards[key->bytes[0] % SIGNATURE_CACHE_SHARDS];
+}
+
+static sig_cache_entry_t* sig_cache_set(sig_cache_shard_t* shard, const sig_cache_key_t* key)
+{
+  uint32_t h = (uint32_t)key->bytes[1] | ((uint32_t)key->bytes[2] << 8) |
+               ((uint32_t)key->bytes[3] << 16) | ((uint32_t)key->bytes[4] << 24);
+  return &shard->entries[(h % SIG_CACHE_SETS) * SIGNATURE_CACHE_WAYS];
+}
+
+static bool sig_cache_live(const sig_cache_entry_t* e, long now, uint32_t epoch)
+{
+  return e->used && now < e->expires_sec && (!e->round_bound || e->epoch == epoch);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: signature_cache_key
+Description: Derives the cache key of a signature check
+Parameters:
+  data - The exact signed bytes
+  data_len - Length of data
+  public_address - The claimed signer
+  signature - The signature text
+  key - Receives the key
+Return: true if the key was derived, false if it could not be (the caller skips the cache)
+---------------------------------------------------------------------------------------------------------*/
+bool signature_cache_key(const char* data, size_t data_len, const char* public_address, const char* signature,
+                         sig_cache_key_t* key)
+{
+  if (!data || !public_address || !signature || !key) return false;
+
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  if (!ctx) return false;
+
+  // length prefix and NUL separator keep (data, address, signature) splits unambiguous
+  uint8_t prefix[8];
+  for (int b = 0; b < 8; ++b) prefix[b] = (uint8_t)(((uint64_t)data_len >> (8 * b)) & 0xFF);
+
+  unsigned int out_len = 0;
+  bool ok = EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+            EVP_DigestUpdate(ctx, prefix, sizeof prefix) == 1 &&
+            EVP_DigestUpdate(ctx, data, data_len) == 1 &&
+            EVP_DigestUpdate(ctx, public_address, strlen(public_address) + 1) == 1 &&
+            EVP_DigestUpdate(ctx, signature, strlen(signature)) == 1 &&
+            EVP_DigestFinal_ex(ctx, key->bytes, &out_len) == 1 &&
+            out_len == SHA256_HASH_SIZE;
+  EVP_MD_CTX_free(ctx);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: signature_cache_lookup
+Description: Checks whether a signature with this key was verified and is still valid to reuse
+Parameters:
+  key - Key from signature_cache_key
+Return: true on a hit, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool signature_cache_lookup(const sig_cache_key_t* key)
+{
+  if (!key) return false;
+
+  sig_cache_shard_t* shard = sig_cache_shard(key);
+  long now = sig_cache_now_sec();
+  uint32_t epoch = atomic_load(&sig_cache_epoch);
+  bool hit = false;
+
+  pthread_mutex_lock(&shard->lock);
+  sig_cache_entry_t* set = sig_cache_set(shard, key);
+  for (size_t i = 0; i < SIGNATURE_CACHE_WAYS; i++) {
+    sig_cache_entry_t* e = &set[i];
+    if (!e->used || memcmp(e->key, key->bytes, sizeof(e->key)) != 0) continue;
+    if (sig_cache_live(e, now, epoch)) {
+      hit = true;
+    } else {
+      e->used = false;
+      shard->stats.expired++;
+    }
+    break;
+  }
+  if (hit) {
+    shard->stats.hits++;
+  } else {
+    shard->stats.misses++;
+  }
+  pthread_mutex_unlock(&shard->lock);
+  return hit;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: signature_cache_insert
+Description: Stores a positive verification result
+Parameters:
+  key - Key from signature_cache_key
+  round_bound - true if the signed data is tied to the current round (carries v_previous_block_hash)
+---------------------------------------------------------------------------------------------------------*/
+void signature_cache_insert(const sig_cache_key_t* key, bool round_bound)
+{
+  if (!key) return;
+
+  sig_cache_shard_t* shard = sig_cache_shard(key);
+  long now = sig_cache_now_sec();
+  uint32_t epoch = atomic_load(&sig_cache_epoch);
+
+  pthread_mutex_lock(&shard->lock);
+  sig_cache_entry_t* set = sig_cache_set(shard, key);
+  sig_cache_entry_t* match = NULL;
+  sig_cache_entry_t* free_slot = NULL;
+  sig_cache_entry_t* oldest = NULL;
+  for (size_t i = 0; i < SIGNATURE_CACHE_WAYS; i++) {
+    sig_cache_entry_t* e = &set[i];
+    if (e->used && memcmp(e->key, key->bytes, sizeof(e->key)) == 0) {
+      match = e;
+      break;
+    }
+    if (!sig_cache_live(e, now, epoch)) {
+      if (!free_slot) free_slot = e;
+    } else if (!oldest || e->stamp < oldest->stamp) {
+      oldest = e;
+    }
+  }
+  sig_cache_entry_t* slot = match ? match : (free_slot ? free_slot : oldest);
+  if (!match && !free_slot) {
+    shard->stats.evictions++;
+  }
+
+  memcpy(slot->key, key->bytes, sizeof(slot->key));
+  slot->used = true;
+  slot->round_bound = round_bound;
+  slot->epoch = epoch;
+  slot->expires_sec = now + SIGNATURE_CACHE_TTL_SEC;
+  slot->stamp = shard->next_stamp++;
+  shard->stats.inserts++;
+  pthread_mutex_unlock(&shard->lock);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: signature_cache_new_round
+Description: Expires every round-bound entry; called once at the start of each round
+---------------------------------------------------------------------------------------------------------*/
+void signature_cache_new_round(void)
+{
+  atomic_fetch_add(&sig_cache_epoch, 1);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: signature_cache_get_stats
+Description: Copies the cache counters summed over all shards, optionally resetting them
+Parameters:
+  out - Receives the counters
+  reset - true to zero the counters after copying
+---------------------------------------------------------------------------------------------------------*/
+void signature_cache_get_stats(signature_cache_stats_t* out, bool reset)
+{
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+
+  long now = sig_cache_now_sec();
+  uint32_t epoch = atomic_load(&sig_cache_epoch);
+
+  pthread_once(&sig_cache_once, sig_cache_init);
+  for (size_t s = 0; s < SIGNATURE_CACHE_SHARDS; s++) {
+    sig_cache_shard_t* shard = &sig_cache_shards[s];
+    pthread_mutex_lock(&shard->lock);
+    out->hits += shard->stats.hits;
+    out->misses += shard->stats.misses;
+    out->expired += shard->stats.expired;
+    out->inserts += shard->stats.inserts;
+    out->evictions += shard->stats.evictions;
+    for (size_t i = 0; i < SIGNATURE_CACHE_SHARD_ENTRIES; i++) {
+      if (sig_cache_live(&shard->entries[i], now, epoch)) out->entries++;
+    }
+    if (reset) memset(&shard->stats, 0, sizeof(shard->stats));
+    pthread_mutex_unlock(&shard->lock);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: log_signature_cache_stats
+Description: Logs and resets the verified-signature cache counters with the hit ratio
+---------------------------------------------------------------------------------------------------------*/
+void log_signature_cache_stats(void)
+{
+  signature_cache_stats_t st;
+  signature_cache_get_stats(&st, true);
+  uint64_t lookups = st.hits + st.misses;
+  double ratio = lookups ? (100.0 * (double)st.hits / (double)lookups) : 0.0;
+  DEBUG_PRINT("Signature cache: hits=%llu misses=%llu hit_ratio=%.1f%% expired=%llu inserts=%llu evictions=%llu entries=%zu",
+              (unsigned long long)st.hits, (unsigned long long)st.misses, ratio, (unsigned long long)st.expired,
+              (unsigned long long)st.inserts, (unsigned long long)st.evictions, st.entries);
+}
@@ -0,0 +1,38 @@
+#ifndef SIGNATURE_CACHE_H_   /* Include guard */
+#define SIGNATURE_CACHE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include <openssl/evp.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+
+typedef struct {
+  uint8_t bytes[SHA256_HASH_SIZE];
+} sig_cache_key_t;
+
+typedef struct {
+  uint64_t hits;        // answered from a live entry
+  uint64_t misses;      // no live entry, full verification ran
+  uint64_t expired;     // entries dropped on lookup after a TTL or round change
+  uint64_t inserts;     // positive results stored
+  uint64_t evictions;   // live entries replaced because their set was full
+  size_t entries;
+} signature_cache_stats_t;
+
+bool signature_cache_key(const char* data, size_t data_len, const char* public_address, const char* signature,
+                         sig_cache_key_t* key);
+bool signature_cache_lookup(const sig_cache_key_t* key);
+void signature_cache_insert(const sig_cache_key_t* key, bool round_bound);
+void signature_cache_new_round(void);
+void signature_cache_get_stats(signature_cache_stats_t* out, bool reset);
+void log_signature_cache_stats(void);
+
+#endif
@@ -0,0 +1,422 @@
+#include "signature_functions.h"
+
+/*
+ * Wallet signature verification.
+ *
+ * XCK wallets sign with CryptoNote Schnorr signatures over their spend (or view) key:
+ * "SigV2" + base58(c || r), checked as c == H(hash || pub || c*pub + r*G) with
+ * H = Keccak-256 reduced mod l. SigV2 hashes the message with a domain key, both
+ * public keys and the key mode; SigV1 hashes the message alone. Addresses and
+ * signatures use the CryptoNote block base58 encoding (8 bytes <-> 11 chars).
+ */
+
+// ---- Keccak-256 (original padding, as used by CryptoNote) ----
+
+#define KECCAK_ROUNDS 24
+#define KECCAK_RATE_256 136
+
+static const uint64_t keccakf_rndc[KECCAK_ROUNDS] = {
+  0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+  0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+  0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+  0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+  0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+  0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+static const int keccakf_rotc[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+static const int keccakf_piln[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+static void keccakf(uint64_t st[25]) {
+  uint64_t t, bc[5];
+  for (int round = 0; round < KECCAK_ROUNDS; round++) {
+    for (int i = 0; i < 5; i++) bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+    for (int i = 0; i < 5; i++) {
+      t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
+      for (int j = 0; j < 25; j += 5) st[j + i] ^= t;
+    }
+    t = st[1];
+    for (int i = 0; i < 24; i++) {
+      int j = keccakf_piln[i];
+      bc[0] = st[j];
+      st[j] = ROTL64(t, keccakf_rotc[i]);
+      t = bc[0];
+    }
+    for (int j = 0; j < 25; j += 5) {
+      for (int i = 0; i < 5; i++) bc[i] = st[j + i];
+      for (int i = 0; i < 5; i++) st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+    }
+    st[0] ^= keccakf_rndc[round];
+  }
+}
+
+typedef struct {
+  uint64_t st[25];
+  uint8_t buf[KECCAK_RATE_256];
+  size_t used;
+} keccak_ctx_t;
+
+static void keccak_absorb_block(keccak_ctx_t* ctx, const uint8_t* block) {
+  for (size_t i = 0; i < KECCAK_RATE_256 / 8; i++) {
+    uint64_t w = 0;
+    for (int b = 7; b >= 0; b--) w = (w << 8) | block[i * 8 + (size_t)b];
+    ctx->st[i] ^= w;
+  }
+  keccakf(ctx->st);
+}
+
+static void keccak_init(keccak_ctx_t* ctx) {
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+static void keccak_update(keccak_ctx_t* ctx, const uint8_t* data, size_t len) {
+  if (ctx->used > 0) {
+    size_t take = KECCAK_RATE_256 - ctx->used;
+    if (take > len) take = len;
+    memcpy(ctx->buf + ctx->used, data, take);
+    ctx->used += take;
+    data += take;
+    len -= take;
+    if (ctx->used < KECCAK_RATE_256) return;
+    keccak_absorb_block(ctx, ctx->buf);
+    ctx->used = 0;
+  }
+  for (; len >= KECCAK_RATE_256; data += KECCAK_RATE_256, len -= KECCAK_RATE_256) {
+    keccak_absorb_block(ctx, data);
+  }
+  memcpy(ctx->buf, data, len);
+  ctx->used = len;
+}
+
+static void keccak_final(keccak_ctx_t* ctx, uint8_t out32[32]) {
+  memset(ctx->buf + ctx->used, 0, KECCAK_RATE_256 - ctx->used);
+  ctx->buf[ctx->used] = 0x01;
+  ctx->buf[KECCAK_RATE_256 - 1] |= 0x80;
+  keccak_absorb_block(ctx, ctx->buf);
+  for (size_t i = 0; i < 32; i++) out32[i] = (uint8_t)(ctx->st[i / 8] >> (8 * (i % 8)));
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: keccak_256
+Description: CryptoNote's fast hash (Keccak-256 with the original 0x01 padding, not SHA3-256)
+Parameters:
+  data - The data to hash
+  len - The length of data
+  out32 - Receives the 32 byte digest
+---------------------------------------------------------------------------------------------------------*/
+void keccak_256(const uint8_t* data, size_t len, uint8_t out32[32]) {
+  keccak_ctx_t ctx;
+  keccak_init(&ctx);
+  keccak_update(&ctx, data, len);
+  keccak_final(&ctx, out32);
+}
+
+// ---- CryptoNote base58 ----
+
+#define B58_FULL_BLOCK_SIZE 8
+#define B58_FULL_ENCODED_BLOCK_SIZE 11
+
+static const char b58_alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+static const int b58_encoded_block_sizes[] = {0, 2, 3, 5, 6, 7, 9, 10, 11};
+
+static int b58_digit(char c) {
+  const char* p = (c != '\0') ? strchr(b58_alphabet, c) : NULL;
+  return p ? (int)(p - b58_alphabet) : -1;
+}
+
+static bool b58_decode_block(const char* block, size_t size, uint8_t* out, size_t out_size) {
+  unsigned __int128 num = 0;
+  for (size_t i = 0; i < size; i++) {
+    int d = b58_digit(block[i]);
+    if (d < 0) return false;
+    num = num * 58 + (unsigned)d;
+  }
+  if (num >> (8 * out_size)) return false;  // overflow for the decoded size
+  for (size_t i = out_size; i-- > 0;) {
+    out[i] = (uint8_t)num;
+    num >>= 8;
+  }
+  return true;
+}
+
+/* Decodes CryptoNote base58 text; returns the decoded length or 0 on error */
+static size_t b58_decode(const char* in, size_t in_len, uint8_t* out, size_t out_max) {
+  const size_t full_blocks = in_len / B58_FULL_ENCODED_BLOCK_SIZE;
+  const size_t last_enc = in_len % B58_FULL_ENCODED_BLOCK_SIZE;
+  size_t last_dec = 0;
+  if (last_enc > 0) {
+    while (last_dec <= B58_FULL_BLOCK_SIZE && (size_t)b58_encoded_block_sizes[last_dec] != last_enc) last_dec++;
+    if (last_dec > B58_FULL_BLOCK_SIZE) return 0;
+  }
+  const size_t total = full_blocks * B58_FULL_BLOCK_SIZE + last_dec;
+  if (total == 0 || total > out_max) return 0;
+
+  for (size_t i = 0; i < full_blocks; i++) {
+    if (!b58_decode_block(in + i * B58_FULL_ENCODED_BLOCK_SIZE, B58_FULL_ENCODED_BLOCK_SIZE,
+                          out + i * B58_FULL_BLOCK_SIZE, B58_FULL_BLOCK_SIZE)) {
+      return 0;
+    }
+  }
+  if (last_enc > 0 &&
+      !b58_decode_block(in + full_blocks * B58_FULL_ENCODED_BLOCK_SIZE, last_enc,
+                        out + full_blocks * B58_FULL_BLOCK_SIZE, last_dec)) {
+    return 0;
+  }
+  return total;
+}
+
+static void b58_encode(const uint8_t* in, size_t in_len, char* out) {
+  for (size_t off = 0; off < in_len; off += B58_FULL_BLOCK_SIZE) {
+    size_t n = in_len - off < B58_FULL_BLOCK_SIZE ? in_len - off : B58_FULL_BLOCK_SIZE;
+    size_t enc = (size_t)b58_encoded_block_sizes[n];
+    uint64_t num = 0;
+    for (size_t i = 0; i < n; i++) num = (num << 8) | in[off + i];
+    for (size_t i = enc; i-- > 0;) {
+      out[i] = b58_alphabet[num % 58];
+      num /= 58;
+    }
+    out += enc;
+  }
+  *out = '\0';
+}
+
+// ---- Addresses ----
+
+#define ADDRESS_CHECKSUM_SIZE 4
+#define ADDRESS_MAX_BYTES 80
+
+/*---------------------------------------------------------------------------------------------------------
+Name: xcash_address_decode
+Description: Decodes a standard XCK address into its public spend and view keys, checking the checksum
+Parameters:
+  public_address - The XCK address
+  spend_pub - Receives the public spend key
+  view_pub - Receives the public view key
+Return: true if the address is a well formed standard address, false otherwise
+---------------------------------------------------------------------------------------------------------*/
+bool xcash_address_decode(const char* public_address, uint8_t spend_pub[XCASH_KEY_LENGTH], uint8_t view_pub[XCASH_KEY_LENGTH]) {
+  if (!public_address || strlen(public_address) != XCASH_WALLET_LENGTH ||
+      strncmp(public_address, XCASH_WALLET_PREFIX, sizeof(XCASH_WALLET_PREFIX) - 1) != 0) {
+    return false;
+  }
+
+  uint8_t raw[ADDRESS_MAX_BYTES];
+  size_t len = b58_decode(public_address, XCASH_WALLET_LENGTH, raw, sizeof(raw));
+  if (len <= ADDRESS_CHECKSUM_SIZE) return false;
+
+  uint8_t hash[32];
+  keccak_256(raw, len - ADDRESS_CHECKSUM_SIZE, hash);
+  if (memcmp(hash, raw + len - ADDRESS_CHECKSUM_SIZE, ADDRESS_CHECKSUM_SIZE) != 0) return false;
+
+  // varint network tag, then exactly the two keys (integrated and sub addresses are not delegates)
+  size_t tag_len = 0;
+  while (tag_len < len && (raw[tag_len] & 0x80)) tag_len++;
+  tag_len++;
+  if (tag_len + 2 * XCASH_KEY_LENGTH + ADDRESS_CHECKSUM_SIZE != len) return false;
+
+  memcpy(spend_pub, raw + tag_len, XCASH_KEY_LENGTH);
+  memcpy(view_pub, raw + tag_len + XCASH_KEY_LENGTH, XCASH_KEY_LENGTH);
+  return true;
+}
+
+// ---- Signatures ----
+
+static const uint8_t ge25519_identity_bytes[32] = {1};
+
+static void hash_to_scalar(const uint8_t* data, size_t len, uint8_t out32[32]) {
+  uint8_t wide[64] = {0};
+  keccak_256(data, len, wide);
+  sc25519_reduce(wide);
+  memcpy(out32, wide, 32);
+}
+
+static bool sc25519_is_zero(const uint8_t s[32]) {
+  uint8_t acc = 0;
+  for (int i = 0; i < 32; i++) acc |= s[i];
+  return acc == 0;
+}
+
+/* SigV2 message hash: H(domain || spend_pub || view_pub || mode || varint(len) || data) */
+static void message_hash_v2(const char* data, size_t data_len, const uint8_t spend_pub[32], const uint8_t view_pub[32],
+                            uint8_t mode, uint8_t out32[32]) {
+  keccak_ctx_t ctx;
+  uint8_t varint[10];
+  size_t vlen = 0;
+  for (size_t v = data_len; ; v >>= 7) {
+    varint[vlen++] = (uint8_t)((v & 0x7f) | (v > 0x7f ? 0x80 : 0));
+    if (v <= 0x7f) break;
+  }
+
+  keccak_init(&ctx);
+  keccak_update(&ctx, (const uint8_t*)XCASH_MESSAGE_SIGNING_DOMAIN, sizeof(XCASH_MESSAGE_SIGNING_DOMAIN));
+  keccak_update(&ctx, spend_pub, XCASH_KEY_LENGTH);
+  keccak_update(&ctx, view_pub, XCASH_KEY_LENGTH);
+  keccak_update(&ctx, &mode, 1);
+  keccak_update(&ctx, varint, vlen);
+  keccak_update(&ctx, (const uint8_t*)data, data_len);
+  keccak_final(&ctx, out32);
+}
+
+/*
+ * The wallet's ge_frombytes_vartime: rejects y >= p and x = 0 with the sign bit set, which libsodium's
+ * decoder accepts. Nothing stricter than the wallet is applied here, so both verifiers accept the same keys.
+ */
+static int wallet_ge_frombytes(ge25519_p3* h, const uint8_t s[32]) {
+  if (!ge25519_is_canonical(s)) return -1;
+  if (ge25519_frombytes(h, s) != 0) return -1;
+  if ((s[31] & 0x80) && fe25519_iszero(h->X)) return -1;
+  return 0;
+}
+
+/* CryptoNote check_signature: c == H(hash || pub || c*pub + r*G) */
+static bool check_signature(const uint8_t hash[32], const uint8_t pub[32], const uint8_t sig[SIGNATURE_BIN_LEN]) {
+  const uint8_t* c = sig;
+  const uint8_t* r = sig + 32;
+  ge25519_p3 A;
+  ge25519_p2 R;
+  uint8_t buf[96];
+  uint8_t c2[32];
+
+  if (wallet_ge_frombytes(&A, pub) != 0) return false;
+  if (!sc25519_is_canonical(c) || !sc25519_is_canonical(r) || sc25519_is_zero(c)) return false;
+
+  ge25519_double_scalarmult_vartime(&R, c, &A, r);
+  memcpy(buf, hash, 32);
+  memcpy(buf + 32, pub, 32);
+  ge25519_tobytes(buf + 64, &R);
+  if (memcmp(buf + 64, ge25519_identity_bytes, 32) == 0) return false;
+
+  hash_to_scalar(buf, sizeof(buf), c2);
+  return memcmp(c2, c, 32) == 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: xcash_verify_signature
+Description: Verifies an XCK wallet signature of data in process, as the wallet's verify RPC does:
+             SigV2 against the spend key and then the view key, SigV1 against the spend key
+Parameters:
+  data - The exact signed bytes
+  data_len - The length of data
+  public_address - The XCK address of the claimed signer
+  signature - The signature text ("SigV2..." or "SigV1...")
+Return: XCASH_OK if the signature is valid, XCASH_ERROR otherwise
+---------------------------------------------------------------------------------------------------------*/
+int xcash_verify_signature(const char* data, size_t data_len, const char* public_address, const char* signature) {
+  uint8_t spend_pub[XCASH_KEY_LENGTH];
+  uint8_t view_pub[XCASH_KEY_LENGTH];
+  uint8_t sig[SIGNATURE_BIN_LEN + 8];
+  uint8_t hash[32];
+  const size_t prefix_len = sizeof(XCASH_SIGN_DATA_PREFIX) - 1;
+
+  if (!data || !public_address || !signature) return XCASH_ERROR;
+
+  bool v2 = strncmp(signature, XCASH_SIGN_DATA_PREFIX, prefix_len) == 0;
+  if (!v2 && strncmp(signature, XCASH_SIGN_DATA_PREFIX_V1, prefix_len) != 0) return XCASH_ERROR;
+  if (b58_decode(signature + prefix_len, strlen(signature + prefix_len), sig, sizeof(sig)) != SIGNATURE_BIN_LEN) {
+    return XCASH_ERROR;
+  }
+  if (!xcash_address_decode(public_address, spend_pub, view_pub)) {
+    DEBUG_PRINT("Signature check: invalid address %.12s...", public_address);
+    return XCASH_ERROR;
+  }
+
+  if (v2) {
+    message_hash_v2(data, data_len, spend_pub, view_pub, 0, hash);
+  } else {
+    keccak_256((const uint8_t*)data, data_len, hash);
+  }
+  if (check_signature(hash, spend_pub, sig)) return XCASH_OK;
+
+  if (v2) {
+    message_hash_v2(data, data_len, spend_pub, view_pub, 1, hash);
+    if (check_signature(hash, view_pub, sig)) return XCASH_OK;
+  }
+  return XCASH_ERROR;
+}
+
+// ---- Known answers ----
+
+/*
+ * Produced by tests/signature_vectors.py, an independent Python model of the wallet signer (Keccak, ed25519,
+ * base58 and the "MoneroMessageSignature" SigV2 hash are all reimplemented there, not taken from this file).
+ */
+static const char SIG_KAT_SEED_ADDRESS[] =
+  "XCK1gUSXCuV4KANQz78YYFQuxeGzPwUtzToqnNGXwjFgjULzWQiYbdC9iJRPiLDqn1ijo9HpfXsDzSRjgKZAwK7x2fTAQZBLXF";
+static const char SIG_KAT_SEED_SPEND[] = "c3b33f175013ced32e01e009c88ef78fcdd04a0043a045aead2c3d3babfdeb96";
+static const char SIG_KAT_SEED_VIEW[] = "bcd88f9f8334160a3bf9bf4a22f988c9c401c25b699803d6655524041b2be1ea";
+static const char SIG_KAT_ADDRESS[] =
+  "XCK1MmS6rEGQBoEUGWWxKj72tMUMF7vLsUjakjko8WYKbckhxpsnYDTLti5saHjNWgEhc1JvFMiGx1Wrxn8rfbh19RES7b5nVN";
+static const char SIG_KAT_MESSAGE[] =
+  "{\"message_settings\":\"NODES_TO_NODES_VOTE_MAJORITY_RESULTS\",\"v_current_round_part\":\"2\"}";
+static const char SIG_KAT_V2_SPEND[] =
+  "SigV2K1XKW3n2FkCQYzKu1NM9hYTFXd3aJ9K4U8CCUNj7Y9xyA5DGiN5uhRVFVWG3ZKRBLMMeMCgKVkCSQZ8kr9yxDN25";
+static const char SIG_KAT_V2_VIEW[] =
+  "SigV25Z5LvNkfwCS5nhZ51y9BAfFm4eTu6tTXMQasf7yKT1Fi9xJPJK1pyo3K6jJSzqY7hiLYHRtNLFHgH6nfycQwKdHA";
+static const char SIG_KAT_V1[] =
+  "SigV1TrTCUxfWZYvA9xf7awt6w9GdDCVGkSbB5bPjrNx9mkBr2zDZMNN1AQiaahNLiNEYa3U2yXuyU8J8peb2MAAq3ku3";
+
+static bool sig_kat_equal(const uint8_t key[XCASH_KEY_LENGTH], const char* hex) {
+  char buf[2 * XCASH_KEY_LENGTH + 1];
+  for (size_t i = 0; i < XCASH_KEY_LENGTH; i++) snprintf(buf + 2 * i, sizeof(buf) - 2 * i, "%02x", key[i]);
+  return strcmp(buf, hex) == 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: signature_known_answer_test
+Description: Checks address decoding and SigV1/SigV2 verification (spend and view key modes) against fixed
+             answers, and that the key encodings the wallet's decoder refuses are refused here too
+Return: 1 if every answer matches, 0 otherwise
+---------------------------------------------------------------------------------------------------------*/
+int signature_known_answer_test(void) {
+  uint8_t spend_pub[XCASH_KEY_LENGTH];
+  uint8_t view_pub[XCASH_KEY_LENGTH];
+  uint8_t sig[SIGNATURE_BIN_LEN + 8];
+  uint8_t hash[32];
+  char message[sizeof(SIG_KAT_MESSAGE)];
+  const size_t message_len = sizeof(SIG_KAT_MESSAGE) - 1;
+  const size_t prefix_len = sizeof(XCASH_SIGN_DATA_PREFIX) - 1;
+
+  if (!xcash_address_decode(SIG_KAT_SEED_ADDRESS, spend_pub, view_pub) ||
+      !sig_kat_equal(spend_pub, SIG_KAT_SEED_SPEND) || !sig_kat_equal(view_pub, SIG_KAT_SEED_VIEW)) {
+    return 0;
+  }
+
+  if (xcash_verify_signature(SIG_KAT_MESSAGE, message_len, SIG_KAT_ADDRESS, SIG_KAT_V2_SPEND) != XCASH_OK ||
+      xcash_verify_signature(SIG_KAT_MESSAGE, message_len, SIG_KAT_ADDRESS, SIG_KAT_V2_VIEW) != XCASH_OK ||
+      xcash_verify_signature(SIG_KAT_MESSAGE, message_len, SIG_KAT_ADDRESS, SIG_KAT_V1) != XCASH_OK) {
+    return 0;
+  }
+
+  // wrong message, wrong signer, and a SigV2 signature relabelled as SigV1 must all fail
+  memcpy(message, SIG_KAT_MESSAGE, sizeof(message));
+  message[message_len - 2] ^= 1;
+  if (xcash_verify_signature(message, message_len, SIG_KAT_ADDRESS, SIG_KAT_V2_SPEND) == XCASH_OK ||
+      xcash_verify_signature(SIG_KAT_MESSAGE, message_len, SIG_KAT_SEED_ADDRESS, SIG_KAT_V2_SPEND) == XCASH_OK) {
+    return 0;
+  }
+  char relabelled[sizeof(SIG_KAT_V2_SPEND)];
+  memcpy(relabelled, SIG_KAT_V2_SPEND, sizeof(relabelled));
+  memcpy(relabelled, XCASH_SIGN_DATA_PREFIX_V1, prefix_len);
+  if (xcash_verify_signature(SIG_KAT_MESSAGE, message_len, SIG_KAT_ADDRESS, relabelled) == XCASH_OK) return 0;
+
+  // the wallet's decoder refuses y >= p and x = 0 with the sign bit set; any other valid point is a key
+  static const uint8_t y_not_reduced[32] = {
+    0xee, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+  };
+  static const uint8_t negative_zero_x[32] = {0x01, [31] = 0x80};
+  ge25519_p3 A;
+  if (wallet_ge_frombytes(&A, y_not_reduced) == 0 || wallet_ge_frombytes(&A, negative_zero_x) == 0 ||
+      wallet_ge_frombytes(&A, ge25519_identity_bytes) != 0 || wallet_ge_frombytes(&A, spend_pub) != 0) {
+    return 0;
+  }
+
+  // and the signature bytes themselves round-trip through base58
+  keccak_256((const uint8_t*)SIG_KAT_MESSAGE, message_len, hash);
+  if (b58_decode(SIG_KAT_V1 + prefix_len, strlen(SIG_KAT_V1 + prefix_len), sig, sizeof(sig)) != SIGNATURE_BIN_LEN ||
+      !xcash_address_decode(SIG_KAT_ADDRESS, spend_pub, view_pub) || !check_signature(hash, spend_pub, sig)) {
+    return 0;
+  }
+  char encoded[XCASH_SIGN_DATA_LENGTH];
+  b58_encode(sig, SIGNATURE_BIN_LEN, encoded);
+  return strcmp(encoded, SIG_KAT_V1 + prefix_len) == 0 ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+#ifndef SIGNATURE_FUNCTIONS_H_   /* Include guard */
+#define SIGNATURE_FUNCTIONS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+#include "ed25519_ref10.h"
+#include "string_functions.h"
+
+void keccak_256(const uint8_t* data, size_t len, uint8_t out32[32]);
+bool xcash_address_decode(const char* public_address, uint8_t spend_pub[XCASH_KEY_LENGTH], uint8_t view_pub[XCASH_KEY_LENGTH]);
+int xcash_verify_signature(const char* data, size_t data_len, const char* public_address, const char* signature);
+int signature_known_answer_test(void);
+
+#endif
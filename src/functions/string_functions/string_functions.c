@@ -194,37 +194,31 @@ static int json_result_path_digits(const char* json, const char* path, char* out
 }
 
 /*---------------------------------------------------------------------------------------------------------
-Name: parse_json_data
-Description: Parses JSON data safely using cJSON, supporting both root-level and "result" fields.
+Name: parse_json_obj_data
+Description: Extracts a field from an already parsed cJSON tree, supporting both root-level and "result"
+             fields and dotted paths with array indexes (e.g. "result.addresses[0].address").
 Parameters:
-  - data: The JSON-formatted string.
-  - field_name: The field to extract (can be at root level or inside "result").
+  - json: The parsed document.
+  - data: The JSON text the tree was parsed from; used to keep large integers digit exact. May be NULL.
+  - field_name: The field to extract.
   - result: Output buffer to store extracted value.
   - result_size: The size of the output buffer.
 Return:
   - XCASH_OK (1) if successful.
   - XCASH_ERROR (0) if an error occurred.
 ---------------------------------------------------------------------------------------------------------*/
-int parse_json_data(const char *data, const char *field_name, char *result, size_t result_size) {
-    if (!data || !field_name || !result) {
+int parse_json_obj_data(const cJSON *json, const char *data, const char *field_name, char *result, size_t result_size) {
+    if (!json || !field_name || !result || result_size == 0) {
         ERROR_PRINT("Invalid parameters");
         return XCASH_ERROR;
     }
 
-    // Parse JSON
-    cJSON *json = cJSON_Parse(data);
-    if (!json) {
-        const char *error_ptr = cJSON_GetErrorPtr();
-        ERROR_PRINT("JSON parsing error near: %s", error_ptr ? error_ptr : "unknown location");
-        return XCASH_ERROR;
-    }
-
     // Handle nested JSON paths with array support (e.g., "result.addresses[0].address")
     char path_copy[256];
     strncpy(path_copy, field_name, sizeof(path_copy) - 1);
     path_copy[sizeof(path_copy) - 1] = '\0';
 
-    cJSON *current_obj = json;
+    const cJSON *current_obj = json;
     char *saveptr = NULL;
     char *token = strtok_r(path_copy, ".", &saveptr);
     while (token != NULL) {
@@ -235,7 +229,6 @@ int parse_json_data(const char *data, const char *field_name, char *result, size
         current_obj = cJSON_GetObjectItemCaseSensitive(current_obj, token);
         if (!current_obj || !cJSON_IsArray(current_obj)) {
           ERROR_PRINT("Field '%s' not found or is not an array", token);
-          cJSON_Delete(json);
           return XCASH_ERROR;
         }
 
@@ -243,14 +236,12 @@ int parse_json_data(const char *data, const char *field_name, char *result, size
         current_obj = cJSON_GetArrayItem(current_obj, index);
         if (!current_obj) {
           ERROR_PRINT("Index %d out of range for field '%s'", index, token);
-          cJSON_Delete(json);
           return XCASH_ERROR;
         }
       } else {
         current_obj = cJSON_GetObjectItemCaseSensitive(current_obj, token);
         if (!current_obj) {
           ERROR_PRINT("Field '%s' not found in JSON", field_name);
-          cJSON_Delete(json);
           return XCASH_ERROR;
         }
       }
@@ -263,20 +254,408 @@ int parse_json_data(const char *data, const char *field_name, char *result, size
         result[result_size - 1] = '\0';
     } else if (cJSON_IsNumber(current_obj)) {
       const char* path_in_result = (strncmp(field_name, "result.", 7) == 0) ? field_name + 7 : field_name;
-      if (!json_result_path_digits(data, path_in_result, result, result_size)) {
+      if (!data || !json_result_path_digits(data, path_in_result, result, result_size)) {
         snprintf(result, result_size, "%.0f", current_obj->valuedouble);
       }
     } else if (cJSON_IsBool(current_obj)) {
         snprintf(result, result_size, "%s", cJSON_IsTrue(current_obj) ? "true" : "false");
     } else {
         ERROR_PRINT("Field '%s' has unsupported data type", field_name);
-        cJSON_Delete(json);
         return XCASH_ERROR;
     }
 
-    cJSON_Delete(json);
     return XCASH_OK;
 }
+
+/*---------------------------------------------------------------------------------------------------------
+Name: parse_json_data
+Description: Parses JSON data safely using cJSON, supporting both root-level and "result" fields.
+             Callers that need several fields from one document should parse it once and use
+             parse_json_obj_data instead.
+Parameters:
+  - data: The JSON-formatted string.
+  - field_name: The field to extract (can be at root level or inside "result").
+  - result: Output buffer to store extracted value.
+  - result_size: The size of the output buffer.
+Return:
+  - XCASH_OK (1) if successful.
+  - XCASH_ERROR (0) if an error occurred.
+---------------------------------------------------------------------------------------------------------*/
+int parse_json_data(const char *data, const char *field_name, char *result, size_t result_size) {
+    if (!data || !field_name || !result) {
+        ERROR_PRINT("Invalid parameters");
+        return XCASH_ERROR;
+    }
+
+    // Parse JSON
+    cJSON *json = cJSON_Parse(data);
+    if (!json) {
+        const char *error_ptr = cJSON_GetErrorPtr();
+        ERROR_PRINT("JSON parsing error near: %s", error_ptr ? error_ptr : "unknown location");
+        return XCASH_ERROR;
+    }
+
+    int rc = parse_json_obj_data(json, data, field_name, result, result_size);
+    cJSON_Delete(json);
+    return rc;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: parse_msg_env_field
+Description: Extracts a field from an inbound message envelope without parsing the message again
+Parameters:
+  - env: The envelope built by handle_srv_message.
+  - field_name: The field to extract.
+  - result: Output buffer to store extracted value.
+  - result_size: The size of the output buffer.
+Return:
+  - XCASH_OK (1) if successful.
+  - XCASH_ERROR (0) if an error occurred.
+---------------------------------------------------------------------------------------------------------*/
+int parse_msg_env_field(const xcash_msg_env_t *env, const char *field_name, char *result, size_t result_size) {
+    if (!env || !env->root) {
+        ERROR_PRINT("Invalid parameters");
+        return XCASH_ERROR;
+    }
+    return parse_json_obj_data(env->root, env->data, field_name, result, result_size);
+}
+
+/*
+ * One-pass JSON field scanner.
+ *
+ * Walks the document once without allocating, keeping the path of the value under the
+ * cursor (object keys and array indexes) on a small stack. Subtrees that no requested path
+ * runs through are skipped without being decoded. Strings are unescaped and booleans
+ * written as "true"/"false", as parse_json_data() does. Every number an RPC caller reads
+ * (heights, amounts, offsets, timestamps) is a non-negative integer, so a number is copied
+ * digit for digit like json_result_path_digits() does, array elements included; fractions,
+ * exponents and negatives are rejected rather than rounded. null, objects and arrays are
+ * not values.
+ */
+typedef struct {
+  const char* key;            /* object key as it appears in the buffer, NULL for array slots */
+  size_t key_len;
+  size_t index;
+} json_scan_seg_t;
+
+typedef struct {
+  const char* p;
+  json_scan_seg_t path[JSON_SCAN_MAX_DEPTH];
+  int depth;
+  json_field_t* fields;
+  size_t count;
+  size_t remaining;
+} json_scan_t;
+
+/* 0: no match, 1: the field lies below the current path, 2: the field is the current path */
+static int json_scan_match(const json_scan_t* s, const char* fpath) {
+  const char* q = fpath;
+  for (int i = 0; i < s->depth; i++) {
+    const json_scan_seg_t* seg = &s->path[i];
+    if (seg->key) {
+      if (i > 0) {
+        if (*q != '.') return 0;
+        q++;
+      }
+      size_t n = strcspn(q, ".[");
+      if (n != seg->key_len || memcmp(q, seg->key, n) != 0) return 0;
+      q += n;
+    } else {
+      if (*q != '[') return 0;
+      char* end = NULL;
+      unsigned long idx = strtoul(q + 1, &end, 10);
+      if (!end || *end != ']' || idx != seg->index) return 0;
+      q = end + 1;
+    }
+  }
+  return (*q == '\0') ? 2 : 1;
+}
+
+static void json_scan_ws(json_scan_t* s) {
+  while (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r') s->p++;
+}
+
+/* Skips a string starting at the opening quote */
+static bool json_scan_skip_string(json_scan_t* s) {
+  const char* p = s->p + 1;
+  for (;;) {
+    if (*p == '\0') return false;
+    if (*p == '\\') {
+      if (p[1] == '\0') return false;
+      p += 2;
+      continue;
+    }
+    if (*p == '"') break;
+    p++;
+  }
+  s->p = p + 1;
+  return true;
+}
+
+static size_t json_utf8_put(char* out, size_t w, size_t cap, unsigned long cp) {
+  unsigned char b[4];
+  size_t n;
+  if (cp < 0x80) { b[0] = (unsigned char)cp; n = 1; }
+  else if (cp < 0x800) { b[0] = (unsigned char)(0xC0 | (cp >> 6)); b[1] = (unsigned char)(0x80 | (cp & 0x3F)); n = 2; }
+  else if (cp < 0x10000) {
+    b[0] = (unsigned char)(0xE0 | (cp >> 12)); b[1] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+    b[2] = (unsigned char)(0x80 | (cp & 0x3F)); n = 3;
+  } else {
+    b[0] = (unsigned char)(0xF0 | (cp >> 18)); b[1] = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+    b[2] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F)); b[3] = (unsigned char)(0x80 | (cp & 0x3F)); n = 4;
+  }
+  for (size_t i = 0; i < n && w < cap; i++) out[w++] = (char)b[i];
+  return w;
+}
+
+static bool json_hex4(const char* p, unsigned long* out) {
+  unsigned long v = 0;
+  for (int i = 0; i < 4; i++) {
+    int c = (unsigned char)p[i];
+    v <<= 4;
+    if (c >= '0' && c <= '9') v |= (unsigned long)(c - '0');
+    else if (c >= 'a' && c <= 'f') v |= (unsigned long)(c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F') v |= (unsigned long)(c - 'A' + 10);
+    else return false;
+  }
+  *out = v;
+  return true;
+}
+
+/* Decodes the string under the cursor into out (truncated like strncpy) */
+static bool json_scan_read_string(json_scan_t* s, char* out, size_t out_size) {
+  const size_t cap = out_size - 1;
+  size_t w = 0;
+  const char* p = s->p + 1;
+  while (*p != '"') {
+    if (*p == '\0') return false;
+    if (*p != '\\') {
+      if (w < cap) out[w++] = *p;
+      p++;
+      continue;
+    }
+    char c = p[1];
+    p += 2;
+    switch (c) {
+      case '"': case '\\': case '/': if (w < cap) out[w++] = c; break;
+      case 'b': if (w < cap) out[w++] = '\b'; break;
+      case 'f': if (w < cap) out[w++] = '\f'; break;
+      case 'n': if (w < cap) out[w++] = '\n'; break;
+      case 'r': if (w < cap) out[w++] = '\r'; break;
+      case 't': if (w < cap) out[w++] = '\t'; break;
+      case 'u': {
+        unsigned long cp;
+        if (!json_hex4(p, &cp)) return false;
+        p += 4;
+        if (cp >= 0xD800 && cp <= 0xDBFF && p[0] == '\\' && p[1] == 'u') {
+          unsigned long lo;
+          if (json_hex4(p + 2, &lo) && lo >= 0xDC00 && lo <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            p += 6;
+          }
+        }
+        w = json_utf8_put(out, w, cap, cp);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  out[w] = '\0';
+  s->p = p + 1;
+  return true;
+}
+
+/* Reads a boolean or a non-negative integer under the cursor into out, integers digit for digit */
+static bool json_scan_read_scalar(json_scan_t* s, const json_field_t* f, char* out, size_t out_size) {
+  const char* start = s->p;
+  const char* p = start;
+  while (*p && strchr(",}] \t\r\n", *p) == NULL) p++;
+  size_t len = (size_t)(p - start);
+  s->p = p;
+
+  if (len == 4 && memcmp(start, "true", 4) == 0) { snprintf(out, out_size, "true"); return true; }
+  if (len == 5 && memcmp(start, "false", 5) == 0) { snprintf(out, out_size, "false"); return true; }
+  if (len == 4 && memcmp(start, "null", 4) == 0) return false;
+
+  size_t digits = 0;
+  while (digits < len && start[digits] >= '0' && start[digits] <= '9') digits++;
+  if (digits == 0 || digits != len) {
+    ERROR_PRINT("Field '%s' is not a non-negative integer: %.*s", f->path, (int)(len < 32 ? len : 32), start);
+    return false;
+  }
+  if (digits >= out_size) {
+    ERROR_PRINT("Field '%s' does not fit in %zu bytes", f->path, out_size);
+    return false;
+  }
+  memcpy(out, start, digits);
+  out[digits] = '\0';
+  return true;
+}
+
+static bool json_scan_value(json_scan_t* s);
+
+/* Object or array under the cursor; the caller already pushed nothing for its members */
+static bool json_scan_container(json_scan_t* s) {
+  const char open = *s->p;
+  const char close = (open == '{') ? '}' : ']';
+  s->p++;
+  json_scan_ws(s);
+  if (*s->p == close) {
+    s->p++;
+    return true;
+  }
+  if (s->depth >= JSON_SCAN_MAX_DEPTH) return false;
+
+  for (size_t index = 0;; index++) {
+    json_scan_seg_t* seg = &s->path[s->depth];
+    if (open == '{') {
+      if (*s->p != '"') return false;
+      const char* key = s->p + 1;
+      if (!json_scan_skip_string(s)) return false;
+      seg->key = key;
+      seg->key_len = (size_t)(s->p - 1 - key);
+      json_scan_ws(s);
+      if (*s->p != ':') return false;
+      s->p++;
+    } else {
+      seg->key = NULL;
+      seg->index = index;
+    }
+    s->depth++;
+    bool ok = json_scan_value(s);
+    s->depth--;
+    if (!ok) return false;
+    if (s->remaining == 0) return true;  /* everything found; the rest is not read */
+
+    json_scan_ws(s);
+    if (*s->p == ',') {
+      s->p++;
+      json_scan_ws(s);
+      continue;
+    }
+    if (*s->p == close) {
+      s->p++;
+      return true;
+    }
+    return false;
+  }
+}
+
+/* Skips a value that no requested path runs through */
+static bool json_scan_skip(json_scan_t* s) {
+  if (*s->p == '"') return json_scan_skip_string(s);
+  if (*s->p != '{' && *s->p != '[') {
+    const char* start = s->p;
+    while (*s->p && strchr(",}] \t\r\n", *s->p) == NULL) s->p++;
+    return s->p != start;
+  }
+
+  int depth = 0;
+  do {
+    char c = *s->p;
+    if (c == '\0') return false;
+    if (c == '"') {
+      if (!json_scan_skip_string(s)) return false;
+      continue;
+    }
+    if (c == '{' || c == '[') depth++;
+    else if (c == '}' || c == ']') depth--;
+    s->p++;
+  } while (depth > 0);
+  return true;
+}
+
+static bool json_scan_value(json_scan_t* s) {
+  json_scan_ws(s);
+
+  bool wanted = false;
+  for (size_t i = 0; i < s->count; i++) {
+    json_field_t* f = &s->fields[i];
+    if (f->found) continue;
+    int m = json_scan_match(s, f->path);
+    if (m == 1) {
+      wanted = true;
+    } else if (m == 2 && *s->p != '{' && *s->p != '[') {
+      const char* at = s->p;
+      bool ok = (*s->p == '"') ? json_scan_read_string(s, f->out, f->out_size)
+                               : json_scan_read_scalar(s, f, f->out, f->out_size);
+      if (ok) {
+        f->found = true;
+        s->remaining--;
+      }
+      /* the same value may be requested twice */
+      for (size_t j = i + 1; ok && j < s->count; j++) {
+        json_field_t* g = &s->fields[j];
+        if (!g->found && strcmp(g->path, f->path) == 0 && g->out_size > 0) {
+          snprintf(g->out, g->out_size, "%s", f->out);
+          g->found = true;
+          s->remaining--;
+        }
+      }
+      if (s->p == at && !ok) return false;
+      return true;
+    }
+  }
+
+  if (wanted && (*s->p == '{' || *s->p == '[')) return json_scan_container(s);
+  return json_scan_skip(s);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: parse_json_fields
+Description: Extracts several dotted paths (e.g. "result.height", "result.addresses[0].address") from a JSON
+             document in one pass, without building a tree or allocating. Strings and booleans follow the
+             rules of parse_json_data; numbers must be non-negative integers and are copied digit for
+             digit, so large values stay exact. The first occurrence of a duplicated key wins.
+Parameters:
+  - data: The JSON-formatted string.
+  - fields: The requested paths and their output buffers; found is set for every extracted field.
+  - count: The number of fields.
+Return:
+  - XCASH_OK (1) if every field was found.
+  - XCASH_ERROR (0) if a field is missing or the document is malformed.
+---------------------------------------------------------------------------------------------------------*/
+int parse_json_fields(const char* data, json_field_t* fields, size_t count) {
+  if (!data || !fields) {
+    ERROR_PRINT("Invalid parameters");
+    return XCASH_ERROR;
+  }
+
+  json_scan_t s;
+  memset(&s, 0, sizeof(s));
+  s.p = data;
+  s.fields = fields;
+  s.count = count;
+  for (size_t i = 0; i < count; i++) {
+    fields[i].found = false;
+    if (!fields[i].path || !fields[i].out || fields[i].out_size == 0) {
+      ERROR_PRINT("Invalid parameters");
+      return XCASH_ERROR;
+    }
+    fields[i].out[0] = '\0';
+  }
+  s.remaining = count;
+
+  json_scan_ws(&s);
+  if (*s.p != '{' && *s.p != '[') {
+    ERROR_PRINT("JSON parsing error near: %.32s", s.p);
+    return XCASH_ERROR;
+  }
+  if (!json_scan_container(&s)) {
+    ERROR_PRINT("JSON parsing error near: %.32s", *s.p ? s.p : "end of data");
+    return XCASH_ERROR;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (!fields[i].found) {
+      ERROR_PRINT("Field '%s' not found in JSON", fields[i].path);
+      return XCASH_ERROR;
+    }
+  }
+  return XCASH_OK;
+}
+
 /*---------------------------------------------------------------------------------------------------------
 Name: string_replace
 Description: String replace
@@ -541,6 +920,47 @@ bool compress_gzip_with_prefix(const unsigned char* input, size_t input_len,
     return XCASH_OK;
 }
 
+/*---------------------------------------------------------------------------------------------------------
+Name: compress_gzip_framed
+Description: Compresses like compress_gzip_with_prefix() and wraps the result in a DPoPS frame:
+  NET_FRAME_MAGIC, a 4-byte big-endian body length, then the 0x01-prefixed body. The server uses the
+  length to reassemble messages that arrive split across reads. Servers from before framing only accept
+  the 0x01 body, so senders use this only when framed_messages (--framed-messages) is set.
+Parameters:
+  input, input_len   - data to send
+  output, output_len - malloc'd frame, caller frees
+Return: XCASH_OK on success, XCASH_ERROR on failure
+---------------------------------------------------------------------------------------------------------*/
+bool compress_gzip_framed(const unsigned char* input, size_t input_len,
+                          unsigned char** output, size_t* output_len) {
+    if (!input || !output || !output_len) return XCASH_ERROR;
+
+    uLongf bound = compressBound(input_len);
+    *output = malloc(NET_FRAME_HEADER_SIZE + 1 + bound);
+    if (!*output) return XCASH_ERROR;
+
+    unsigned char* body = *output + NET_FRAME_HEADER_SIZE;
+    body[0] = 0x01;  // Prefix to signal gzip
+
+    int result = compress2(body + 1, &bound, input, input_len, Z_BEST_COMPRESSION);
+    if (result != Z_OK || bound + 1 > NET_MAX_FRAME_SIZE) {
+        free(*output);
+        *output = NULL;
+        *output_len = 0;
+        return XCASH_ERROR;
+    }
+
+    uint32_t body_len = (uint32_t)(bound + 1);
+    (*output)[0] = NET_FRAME_MAGIC;
+    (*output)[1] = (unsigned char)(body_len >> 24);
+    (*output)[2] = (unsigned char)(body_len >> 16);
+    (*output)[3] = (unsigned char)(body_len >> 8);
+    (*output)[4] = (unsigned char)(body_len);
+
+    *output_len = NET_FRAME_HEADER_SIZE + body_len;
+    return XCASH_OK;
+}
+
 bool decompress_gzip_with_prefix(const unsigned char* input, size_t input_len,
                                 unsigned char** output, size_t* output_len) {
     if (!input || !output || !output_len || input_len < 2) return XCASH_ERROR;
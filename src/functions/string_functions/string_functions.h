@@ -12,6 +12,9 @@
 #include <openssl/evp.h>
 #include <openssl/md5.h> 
 #include <unistd.h>
+#ifndef ZLIB_CONST
+#define ZLIB_CONST  // z_stream.next_in is const, whichever header includes zlib.h first
+#endif
 #include <zlib.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -19,10 +22,20 @@
 #include "globals.h"
 #include "macro_functions.h"
 
+typedef struct {
+  const char* path;           /* dotted path, e.g. "result.block_header.hash" */
+  char* out;
+  size_t out_size;
+  bool found;
+} json_field_t;
+
 bool is_hex_len(const char *s, size_t expected_len);
 bool hex_to_byte_array(const char *hex_string, unsigned char *byte_array, size_t byte_array_size);
 void bytes_to_hex(const unsigned char* bytes, size_t byte_len, char* hex_out, size_t hex_out_len);
 int parse_json_data(const char* DATA, const char* FIELD_NAME, char *result, const size_t RESULT_TOTAL_LENGTH);
+int parse_json_obj_data(const cJSON* json, const char* data, const char* field_name, char *result, size_t result_size);
+int parse_msg_env_field(const xcash_msg_env_t* env, const char* field_name, char *result, size_t result_size);
+int parse_json_fields(const char* data, json_field_t* fields, size_t count);
 void string_replace(char *data, const size_t DATA_TOTAL_LENGTH, const char* STR1, const char* STR2);
 int random_string(char *result, const size_t LENGTH);
 size_t string_count(const char* DATA, const char* STRING);
@@ -30,6 +43,7 @@ void bin_to_hex(const unsigned char *bin_data, int data_size, char *buf);
 void md5_hex(const char * src, char * dest);
 void string_replace_limit(char *data, const size_t DATA_TOTAL_LENGTH, const char* STR1, const char* STR2, const int COUNT);
 bool compress_gzip_with_prefix(const unsigned char* input, size_t input_len, unsigned char** output, size_t* output_len);
+bool compress_gzip_framed(const unsigned char* input, size_t input_len, unsigned char** output, size_t* output_len);
 bool decompress_gzip_with_prefix(const unsigned char* input, size_t input_len, unsigned char** output, size_t* output_len);
 int get_random_bytes(unsigned char *buf, size_t len);
 bool base64_decode(const char* input, uint8_t* output, size_t max_output, size_t* decoded_len);
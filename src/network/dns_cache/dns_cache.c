@@ -0,0 +1,454 @@
+#include "dns_cache.h"
+
+/*
+ * Resolver cache shared by every outbound and verification path.
+ *
+ * Entries are keyed by (hostname, address family) and hold the sorted address list that
+ * getaddrinfo() returned, or the resolver error for a negative entry. A fresh entry is
+ * answered under the lock without touching the resolver. Once an entry in use passes
+ * DNS_CACHE_REFRESH_PCT of its TTL it is queued for the background refresher, so busy
+ * names are renewed before they expire and never resolve on the round thread. A refresh
+ * that fails with a temporary error keeps the previous addresses.
+ *
+ * Only definitive answers (no such name, no address of that family) are cached as negative
+ * entries. A temporary failure (EAI_AGAIN, a resolver that could not be reached, ...) with
+ * nothing known to fall back on is returned to the caller and not cached, so the next
+ * lookup of that name asks the resolver again instead of failing for DNS_CACHE_NEG_TTL_SEC.
+ *
+ * Numeric IPv4/IPv6 literals are converted in place and never enter the cache.
+ *
+ * dns_cache_lookup answers from the cache only and reports a miss instead of resolving, for
+ * callers such as the outbound I/O thread that hand misses to a thread of their own.
+ */
+typedef struct {
+  char host[IP_LENGTH + 1];
+  int family;
+  int error;                  /* 0, or the EAI_* code of a negative entry */
+  size_t count;
+  struct sockaddr_storage addrs[DNS_CACHE_MAX_ADDRS];
+  socklen_t addr_lens[DNS_CACHE_MAX_ADDRS];
+  long expires_ms;
+  long refresh_at_ms;
+  long last_used_ms;
+  bool refresh_queued;
+} dns_entry_t;
+
+typedef struct {
+  int error;
+  size_t count;
+  struct sockaddr_storage addrs[DNS_CACHE_MAX_ADDRS];
+  socklen_t addr_lens[DNS_CACHE_MAX_ADDRS];
+} dns_answer_t;
+
+typedef struct {
+  struct addrinfo ai;
+  struct sockaddr_storage addr;
+} dns_result_node_t;
+
+static dns_entry_t dns_entries[DNS_CACHE_MAX_ENTRIES];
+static size_t dns_entries_used = 0;
+static dns_cache_stats_t dns_stats;
+static pthread_mutex_t dns_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dns_refresh_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t dns_refresher_once = PTHREAD_ONCE_INIT;
+
+static long dns_now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long)(ts.tv_sec * 1000L + ts.tv_nsec / 1000000L);
+}
+
+/* Resolves without the cache; fills ans with at most DNS_CACHE_MAX_ADDRS stream addresses */
+static void dns_resolve(const char* host, int family, dns_answer_t* ans)
+{
+  memset(ans, 0, sizeof(*ans));
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = family;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_ADDRCONFIG;
+
+  struct addrinfo* res = NULL;
+  int rc = getaddrinfo(host, NULL, &hints, &res);
+  if (rc != 0 || !res) {
+    ans->error = rc != 0 ? rc : EAI_NONAME;
+    return;
+  }
+
+  for (const struct addrinfo* p = res; p && ans->count < DNS_CACHE_MAX_ADDRS; p = p->ai_next) {
+    if (!p->ai_addr || p->ai_addrlen > sizeof(struct sockaddr_storage)) continue;
+    memcpy(&ans->addrs[ans->count], p->ai_addr, p->ai_addrlen);
+    ans->addr_lens[ans->count] = p->ai_addrlen;
+    ans->count++;
+  }
+  freeaddrinfo(res);
+  if (ans->count == 0) ans->error = EAI_NONAME;
+}
+
+/* Answers that stay true until the name's records change; anything else may succeed on the next try */
+static bool dns_error_definitive(int error)
+{
+  switch (error) {
+    case EAI_NONAME:
+    case EAI_FAMILY:
+    case EAI_SERVICE:
+#ifdef EAI_NODATA
+    case EAI_NODATA:
+#endif
+#ifdef EAI_ADDRFAMILY
+    case EAI_ADDRFAMILY:
+#endif
+      return true;
+    default:
+      return false;
+  }
+}
+
+/* Caller holds dns_lock */
+static bool dns_has_addresses(const dns_entry_t* e)
+{
+  return e && e->error == 0 && e->count > 0;
+}
+
+/* Caller holds dns_lock */
+static dns_entry_t* dns_find(const char* host, int family)
+{
+  for (size_t i = 0; i < dns_entries_used; i++) {
+    if (dns_entries[i].family == family && strcmp(dns_entries[i].host, host) == 0) return &dns_entries[i];
+  }
+  return NULL;
+}
+
+/* Caller holds dns_lock; a full table reuses the least recently used entry */
+static dns_entry_t* dns_slot(const char* host, int family)
+{
+  dns_entry_t* e = dns_find(host, family);
+  if (e) return e;
+
+  if (dns_entries_used < DNS_CACHE_MAX_ENTRIES) {
+    e = &dns_entries[dns_entries_used++];
+  } else {
+    for (size_t i = 0; i < dns_entries_used; i++) {
+      if (!e || dns_entries[i].last_used_ms < e->last_used_ms) e = &dns_entries[i];
+    }
+  }
+  memset(e, 0, sizeof(*e));
+  snprintf(e->host, sizeof(e->host), "%s", host);
+  e->family = family;
+  return e;
+}
+
+/* Caller holds dns_lock. A temporary failure never replaces or creates an entry */
+static void dns_store(dns_entry_t* e, const dns_answer_t* ans, long now)
+{
+  if (ans->error != 0 && !dns_error_definitive(ans->error)) {
+    if (dns_has_addresses(e)) {
+      /* keep serving the last known addresses and try again later */
+      e->refresh_at_ms = now + DNS_CACHE_NEG_TTL_SEC * 1000L;
+      e->expires_ms = e->refresh_at_ms;
+    }
+    return;
+  }
+
+  e->error = ans->error;
+  e->count = ans->count;
+  memcpy(e->addrs, ans->addrs, sizeof(e->addrs));
+  memcpy(e->addr_lens, ans->addr_lens, sizeof(e->addr_lens));
+
+  const long ttl_ms = (ans->error == 0 ? DNS_CACHE_TTL_SEC : DNS_CACHE_NEG_TTL_SEC) * 1000L;
+  e->expires_ms = now + ttl_ms;
+  e->refresh_at_ms = (ans->error == 0) ? now + ttl_ms * DNS_CACHE_REFRESH_PCT / 100 : e->expires_ms;
+}
+
+static void* dns_refresher(void* arg)
+{
+  (void)arg;
+  char host[IP_LENGTH + 1];
+
+  pthread_mutex_lock(&dns_lock);
+  for (;;) {
+    dns_entry_t* due = NULL;
+    for (size_t i = 0; i < dns_entries_used; i++) {
+      if (dns_entries[i].refresh_queued) {
+        due = &dns_entries[i];
+        break;
+      }
+    }
+    if (!due) {
+      pthread_cond_wait(&dns_refresh_cond, &dns_lock);
+      continue;
+    }
+
+    snprintf(host, sizeof(host), "%s", due->host);
+    const int family = due->family;
+    due->refresh_queued = false;
+    pthread_mutex_unlock(&dns_lock);
+
+    dns_answer_t ans;
+    dns_resolve(host, family, &ans);
+
+    pthread_mutex_lock(&dns_lock);
+    dns_stats.refreshes++;
+    if (ans.error != 0) {
+      dns_stats.failures++;
+      DEBUG_PRINT("DNS refresh failed for %s: %s", host, gai_strerror(ans.error));
+    }
+    /* the slot may have been reused for another name while unlocked */
+    dns_entry_t* e = dns_find(host, family);
+    if (e) dns_store(e, &ans, dns_now_ms());
+  }
+  return NULL;
+}
+
+static void dns_start_refresher(void)
+{
+  pthread_t th;
+  if (pthread_create(&th, NULL, dns_refresher, NULL) != 0) {
+    ERROR_PRINT("Could not start the DNS refresh thread: %s", strerror(errno));
+    return;
+  }
+  pthread_detach(th);
+}
+
+/* Builds a getaddrinfo-style list; every node is one allocation released by dns_cache_freeaddrinfo */
+static int dns_build_result(const struct sockaddr_storage* addrs, const socklen_t* lens, size_t count,
+                            int port, int socktype, struct addrinfo** res)
+{
+  struct addrinfo* head = NULL;
+  struct addrinfo** tail = &head;
+
+  for (size_t i = 0; i < count; i++) {
+    dns_result_node_t* n = (dns_result_node_t*)calloc(1, sizeof(*n));
+    if (!n) {
+      dns_cache_freeaddrinfo(head);
+      return EAI_MEMORY;
+    }
+    memcpy(&n->addr, &addrs[i], lens[i]);
+    if (n->addr.ss_family == AF_INET) {
+      ((struct sockaddr_in*)&n->addr)->sin_port = htons((uint16_t)port);
+    } else if (n->addr.ss_family == AF_INET6) {
+      ((struct sockaddr_in6*)&n->addr)->sin6_port = htons((uint16_t)port);
+    }
+    n->ai.ai_family = n->addr.ss_family;
+    n->ai.ai_socktype = socktype;
+    n->ai.ai_protocol = (socktype == SOCK_STREAM) ? IPPROTO_TCP : 0;
+    n->ai.ai_addrlen = lens[i];
+    n->ai.ai_addr = (struct sockaddr*)&n->addr;
+    *tail = &n->ai;
+    tail = &n->ai.ai_next;
+  }
+  *res = head;
+  return 0;
+}
+
+/* Numeric literals skip the cache; returns true if node was one */
+static bool dns_literal(const char* node, int family, struct sockaddr_storage* ss, socklen_t* len)
+{
+  memset(ss, 0, sizeof(*ss));
+  if (family != AF_INET6 && inet_pton(AF_INET, node, &((struct sockaddr_in*)ss)->sin_addr) == 1) {
+    ss->ss_family = AF_INET;
+    *len = sizeof(struct sockaddr_in);
+    return true;
+  }
+  if (family != AF_INET && inet_pton(AF_INET6, node, &((struct sockaddr_in6*)ss)->sin6_addr) == 1) {
+    ss->ss_family = AF_INET6;
+    *len = sizeof(struct sockaddr_in6);
+    return true;
+  }
+  return false;
+}
+
+/* Parses a numeric service; returns false if it is not a port */
+static bool dns_parse_port(const char* service, int* port)
+{
+  *port = 0;
+  if (!service) return true;
+  char* end = NULL;
+  long p = strtol(service, &end, 10);
+  if (!end || *end != '\0' || p < 0 || p > 65535) return false;
+  *port = (int)p;
+  return true;
+}
+
+/* Copies a fresh entry into ans and queues it for refresh when due; returns false on a miss */
+static bool dns_cached_answer(const char* node, int family, long now, dns_answer_t* ans)
+{
+  pthread_mutex_lock(&dns_lock);
+  dns_entry_t* e = dns_find(node, family);
+  if (!e || now >= e->expires_ms) {
+    pthread_mutex_unlock(&dns_lock);
+    return false;
+  }
+  e->last_used_ms = now;
+  if (e->error == 0) {
+    dns_stats.hits++;
+    if (now >= e->refresh_at_ms && !e->refresh_queued) {
+      e->refresh_queued = true;
+      pthread_cond_signal(&dns_refresh_cond);
+    }
+  } else {
+    dns_stats.negative_hits++;
+  }
+  ans->error = e->error;
+  ans->count = e->count;
+  memcpy(ans->addrs, e->addrs, sizeof(ans->addrs));
+  memcpy(ans->addr_lens, e->addr_lens, sizeof(ans->addr_lens));
+  pthread_mutex_unlock(&dns_lock);
+  return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dns_cache_getaddrinfo
+Description: Cached replacement for getaddrinfo() for stream sockets. Only hints->ai_family is used for
+             the lookup (AF_UNSPEC, AF_INET or AF_INET6); the service must be a numeric port or NULL.
+             A miss resolves on the calling thread and fills the cache for everyone else.
+Parameters:
+  node - Hostname or numeric IP
+  service - Numeric port string, or NULL for port 0
+  hints - Optional, family and socktype are honoured
+  res - The resulting address list, free it with dns_cache_freeaddrinfo
+Return: 0 on success, otherwise an EAI_* code usable with gai_strerror()
+---------------------------------------------------------------------------------------------------------*/
+int dns_cache_getaddrinfo(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+  if (!res) return EAI_FAIL;
+  *res = NULL;
+  if (!node || node[0] == '\0') return EAI_NONAME;
+
+  const int family = hints ? hints->ai_family : AF_UNSPEC;
+  const int socktype = (hints && hints->ai_socktype) ? hints->ai_socktype : SOCK_STREAM;
+  int port = 0;
+  if (!dns_parse_port(service, &port)) return EAI_SERVICE;
+
+  struct sockaddr_storage lit;
+  socklen_t lit_len = 0;
+  if (dns_literal(node, family, &lit, &lit_len)) {
+    return dns_build_result(&lit, &lit_len, 1, port, socktype, res);
+  }
+  if (strlen(node) > IP_LENGTH) return EAI_NONAME;
+
+  pthread_once(&dns_refresher_once, dns_start_refresher);
+
+  dns_answer_t ans;
+  const long now = dns_now_ms();
+
+  if (!dns_cached_answer(node, family, now, &ans)) {
+    pthread_mutex_lock(&dns_lock);
+    dns_stats.misses++;
+    pthread_mutex_unlock(&dns_lock);
+
+    dns_resolve(node, family, &ans);
+
+    pthread_mutex_lock(&dns_lock);
+    if (ans.error != 0) dns_stats.failures++;
+    dns_entry_t* e = dns_find(node, family);
+    if (ans.error != 0 && !dns_error_definitive(ans.error) && !dns_has_addresses(e)) {
+      /* temporary failure and nothing to fall back on: report it, the next lookup tries again */
+      pthread_mutex_unlock(&dns_lock);
+      return ans.error;
+    }
+    if (!e) e = dns_slot(node, family);
+    dns_store(e, &ans, dns_now_ms());
+    e->last_used_ms = now;
+    /* dns_store may have kept older addresses on a temporary failure */
+    ans.error = e->error;
+    ans.count = e->count;
+    memcpy(ans.addrs, e->addrs, sizeof(ans.addrs));
+    memcpy(ans.addr_lens, e->addr_lens, sizeof(ans.addr_lens));
+    pthread_mutex_unlock(&dns_lock);
+  }
+
+  if (ans.error != 0) return ans.error;
+  return dns_build_result(ans.addrs, ans.addr_lens, ans.count, port, socktype, res);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dns_cache_lookup
+Description: Like dns_cache_getaddrinfo, but never calls the resolver: numeric IPs and fresh entries are
+             answered at once, anything else is reported as a miss. For event loops that must not block;
+             resolve a miss elsewhere with dns_cache_getaddrinfo and look the name up again.
+Parameters:
+  node - Hostname or numeric IP
+  service - Numeric port string, or NULL for port 0
+  hints - Optional, family and socktype are honoured
+  res - The resulting address list, free it with dns_cache_freeaddrinfo
+Return: 0 on success, DNS_CACHE_MISS if the name is not cached, otherwise the cached EAI_* code
+---------------------------------------------------------------------------------------------------------*/
+int dns_cache_lookup(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+  if (!res) return EAI_FAIL;
+  *res = NULL;
+  if (!node || node[0] == '\0') return EAI_NONAME;
+
+  const int family = hints ? hints->ai_family : AF_UNSPEC;
+  const int socktype = (hints && hints->ai_socktype) ? hints->ai_socktype : SOCK_STREAM;
+  int port = 0;
+  if (!dns_parse_port(service, &port)) return EAI_SERVICE;
+
+  struct sockaddr_storage lit;
+  socklen_t lit_len = 0;
+  if (dns_literal(node, family, &lit, &lit_len)) {
+    return dns_build_result(&lit, &lit_len, 1, port, socktype, res);
+  }
+  if (strlen(node) > IP_LENGTH) return EAI_NONAME;
+
+  pthread_once(&dns_refresher_once, dns_start_refresher);
+
+  dns_answer_t ans;
+  if (!dns_cached_answer(node, family, dns_now_ms(), &ans)) return DNS_CACHE_MISS;
+  if (ans.error != 0) return ans.error;
+  return dns_build_result(ans.addrs, ans.addr_lens, ans.count, port, socktype, res);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dns_cache_freeaddrinfo
+Description: Frees a list returned by dns_cache_getaddrinfo
+Parameters:
+  res - The address list, may be NULL
+---------------------------------------------------------------------------------------------------------*/
+void dns_cache_freeaddrinfo(struct addrinfo* res)
+{
+  while (res) {
+    struct addrinfo* next = res->ai_next;
+    free(res);  /* first member of dns_result_node_t */
+    res = next;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dns_cache_get_stats
+Description: Copies the resolver cache counters
+Parameters:
+  out - The counters
+  reset - Clear the counters after copying them
+---------------------------------------------------------------------------------------------------------*/
+void dns_cache_get_stats(dns_cache_stats_t* out, bool reset)
+{
+  if (!out) return;
+  pthread_mutex_lock(&dns_lock);
+  *out = dns_stats;
+  out->entries = dns_entries_used;
+  if (reset) memset(&dns_stats, 0, sizeof(dns_stats));
+  pthread_mutex_unlock(&dns_lock);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: log_dns_cache_stats
+Description: Logs and resets the resolver cache counters; failures are logged as a warning
+---------------------------------------------------------------------------------------------------------*/
+void log_dns_cache_stats(void)
+{
+  dns_cache_stats_t st;
+  dns_cache_get_stats(&st, true);
+  if (st.failures > 0) {
+    WARNING_PRINT("DNS cache: hits=%llu negative_hits=%llu misses=%llu refreshes=%llu failures=%llu entries=%zu",
+                  (unsigned long long)st.hits, (unsigned long long)st.negative_hits, (unsigned long long)st.misses,
+                  (unsigned long long)st.refreshes, (unsigned long long)st.failures, st.entries);
+  } else {
+    DEBUG_PRINT("DNS cache: hits=%llu negative_hits=%llu misses=%llu refreshes=%llu failures=%llu entries=%zu",
+                (unsigned long long)st.hits, (unsigned long long)st.negative_hits, (unsigned long long)st.misses,
+                (unsigned long long)st.refreshes, (unsigned long long)st.failures, st.entries);
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef DNS_CACHE_H_
+#define DNS_CACHE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "config.h"
+#include "globals.h"
+#include "macro_functions.h"
+
+#define DNS_CACHE_MISS 1            // dns_cache_lookup: not cached; EAI_* codes are all non-zero and negative
+
+typedef struct {
+  uint64_t hits;            // answered from a fresh entry
+  uint64_t negative_hits;   // answered from a cached resolver failure
+  uint64_t misses;          // resolved on the caller's thread
+  uint64_t refreshes;       // resolved by the background refresher
+  uint64_t failures;        // resolver errors (miss or refresh)
+  size_t entries;
+} dns_cache_stats_t;
+
+int dns_cache_getaddrinfo(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res);
+int dns_cache_lookup(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res);
+void dns_cache_freeaddrinfo(struct addrinfo* res);
+void dns_cache_get_stats(dns_cache_stats_t* out, bool reset);
+void log_dns_cache_stats(void);
+
+#endif
@@ -1,37 +1,5 @@
 #include "net_multi.h"
 
-static void sleep_ms(int ms)
-{
-  struct timespec ts;
-  ts.tv_sec = ms / 1000;
-  ts.tv_nsec = (long)(ms % 1000) * 1000000L;
-  nanosleep(&ts, NULL);
-}
-
-/* --- write whole buffer with per-attempt timeout (select + send) --- */
-static int send_all_with_timeout(int fd, const uint8_t* buf, size_t len, int ms_timeout) {
-    size_t off = 0;
-    while (off < len) {
-        struct timeval tv;
-        tv.tv_sec  = ms_timeout / 1000;
-        tv.tv_usec = (ms_timeout % 1000) * 1000;
-
-        fd_set wfds; FD_ZERO(&wfds); FD_SET(fd, &wfds);
-        int r = select(fd + 1, NULL, &wfds, NULL, &tv);
-        if (r < 0) { if (errno == EINTR) continue; return -1; }
-        if (r == 0 || !FD_ISSET(fd, &wfds)) return -1; /* timeout */
-
-        ssize_t n = send(fd, buf + off, len - off, MSG_NOSIGNAL);
-        if (n < 0) {
-            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
-            return -1;
-        }
-        if (n == 0) return -1; /* peer closed */
-        off += (size_t)n;
-    }
-    return 0;
-}
-
 static long monotonic_ms_now(void)
 {
   struct timespec ts;
@@ -55,327 +23,1111 @@ static void addr_to_ipstr(const struct addrinfo* ai, char* out, size_t out_sz)
   }
 }
 
-static int set_nonblocking(int fd, int* out_old_flags)
+/*
+ * Persistent outbound connections.
+ *
+ * One idle socket is kept per (host, port). A sender takes the socket out of the table
+ * (so it is never shared), and gives it back after a successful send. Only DPoPS peers
+ * are pooled, and only with --framed-messages: their server reassembles length-prefixed
+ * frames, so several messages can travel over one connection. Legacy bodies carry no
+ * length, so until framing is on (and for the payouts service) every send gets its own
+ * connection.
+ */
+typedef struct {
+  char host[IP_LENGTH + 1];
+  int port;
+  int fd;                 /* -1 while checked out or not connected */
+  long last_used_ms;
+} pooled_conn_t;
+
+/* The server closes idle DPoPS peers after NET_SERVER_PEER_IDLE_SEC; the pool has to give a socket up first */
+#if NET_POOL_IDLE_MS >= NET_SERVER_PEER_IDLE_SEC * 1000
+#error "NET_POOL_IDLE_MS must stay below NET_SERVER_PEER_IDLE_SEC"
+#endif
+
+static pooled_conn_t conn_pool[NET_POOL_MAX_ENTRIES];
+static size_t conn_pool_used = 0;
+static pthread_mutex_t conn_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool conn_pool_eligible(int port)
 {
-  int of = fcntl(fd, F_GETFL, 0);
-  if (of == -1) of = 0;
-  if (out_old_flags) *out_old_flags = of;
-  return fcntl(fd, F_SETFL, of | O_NONBLOCK);
+  return port == XCASH_DPOPS_PORT && framed_messages;
 }
 
-static void restore_blocking(int fd, int old_flags)
+/* Caller holds conn_pool_lock */
+static pooled_conn_t* conn_pool_find(const char* host, int port)
 {
-  (void)fcntl(fd, F_SETFL, old_flags);
+  for (size_t i = 0; i < conn_pool_used; i++) {
+    if (conn_pool[i].port == port && strcmp(conn_pool[i].host, host) == 0) return &conn_pool[i];
+  }
+  return NULL;
+}
+
+/* Caller holds conn_pool_lock */
+static void conn_pool_evict_idle(long now)
+{
+  for (size_t i = 0; i < conn_pool_used; i++) {
+    if (conn_pool[i].fd >= 0 && now - conn_pool[i].last_used_ms >= NET_POOL_IDLE_MS) {
+      close(conn_pool[i].fd);
+      conn_pool[i].fd = -1;
+    }
+  }
 }
 
 /*
- * Attempt connect with a monotonic deadline (timeout_ms).
- * Returns 0 on success, -1 on failure and sets *out_err to the failure reason
- * (ETIMEDOUT, ECONNREFUSED, etc.).
+ * A pooled socket is healthy if the peer has not closed or reset it and it has no pending
+ * error. send() on a socket the peer already closed still succeeds and the message is
+ * lost, so the FIN or RST has to be looked for with recv(MSG_PEEK) before reuse. Stray
+ * reply bytes in front of it are drained and dropped.
  */
-static int connect_with_deadline(int sock,
-                                 const struct sockaddr* sa,
-                                 socklen_t slen,
-                                 int timeout_ms,
-                                 int* out_err)
+static bool conn_pool_healthy(int fd)
+{
+  char sink[VSMALL_BUFFER_SIZE];
+  for (;;) {
+    ssize_t n = recv(fd, sink, sizeof(sink), MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0) {
+      if (recv(fd, sink, (size_t)n, MSG_DONTWAIT) < 0 && errno != EINTR) return false;
+      continue;
+    }
+    if (n == 0) return false;  /* FIN */
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+    return false;              /* reset or another error */
+  }
+
+  int soerr = 0;
+  socklen_t sl = sizeof(soerr);
+  return getsockopt(fd, SOL_SOCKET, SO_ERROR, &soerr, &sl) == 0 && soerr == 0;
+}
+
+/* Returns a healthy pooled socket for host:port, or -1 if the caller must connect */
+static int conn_pool_checkout(const char* host, int port)
 {
-  if (out_err) *out_err = 0;
+  if (!conn_pool_eligible(port)) return -1;
+
+  const long now = monotonic_ms_now();
+  int fd = -1;
+  long last_used = 0;
+
+  pthread_mutex_lock(&conn_pool_lock);
+  pooled_conn_t* e = conn_pool_find(host, port);
+  if (e && e->fd >= 0) {
+    fd = e->fd;
+    last_used = e->last_used_ms;
+    e->fd = -1;
+  }
+  pthread_mutex_unlock(&conn_pool_lock);
 
-  int old_flags = 0;
-  if (set_nonblocking(sock, &old_flags) != 0) {
-    if (out_err) *out_err = errno;
+  if (fd < 0) return -1;
+  if (now - last_used >= NET_POOL_IDLE_MS || !conn_pool_healthy(fd)) {
+    DEBUG_PRINT("Pooled connection to %s:%d is stale, reconnecting", host, port);
+    close(fd);
     return -1;
   }
+  return fd;
+}
+
+/* Returns a socket to the pool after a successful send; closes it if there is no room */
+static void conn_pool_checkin(const char* host, int port, int fd)
+{
+  if (fd < 0) return;
+  if (!conn_pool_eligible(port) || strlen(host) > IP_LENGTH) {
+    close(fd);
+    return;
+  }
+
+  const long now = monotonic_ms_now();
 
-  int rc = connect(sock, sa, slen);
-  if (rc == 0) {
-    restore_blocking(sock, old_flags);
-    return 0;
+  pthread_mutex_lock(&conn_pool_lock);
+  conn_pool_evict_idle(now);
+
+  pooled_conn_t* e = conn_pool_find(host, port);
+  if (!e && conn_pool_used < NET_POOL_MAX_ENTRIES) {
+    e = &conn_pool[conn_pool_used++];
+    snprintf(e->host, sizeof(e->host), "%s", host);
+    e->port = port;
+    e->fd = -1;
+  }
+  if (!e) {
+    /* table full: reuse the least recently used slot */
+    for (size_t i = 0; i < conn_pool_used; i++) {
+      if (!e || conn_pool[i].last_used_ms < e->last_used_ms) e = &conn_pool[i];
+    }
+    if (e->fd >= 0) close(e->fd);
+    snprintf(e->host, sizeof(e->host), "%s", host);
+    e->port = port;
+    e->fd = -1;
   }
 
-  if (errno == EISCONN) {
-    restore_blocking(sock, old_flags);
-    return 0;
+  if (e->fd >= 0) {
+    /* a concurrent sender already returned one */
+    close(fd);
+  } else {
+    e->fd = fd;
   }
+  e->last_used_ms = now;
+  pthread_mutex_unlock(&conn_pool_lock);
+}
 
-  if (errno != EINPROGRESS && errno != EALREADY) {
-    if (out_err) *out_err = errno;
-    return -1;
+/* Closes every pooled connection (shutdown) */
+void cleanup_connection_pool(void)
+{
+  pthread_mutex_lock(&conn_pool_lock);
+  for (size_t i = 0; i < conn_pool_used; i++) {
+    if (conn_pool[i].fd >= 0) close(conn_pool[i].fd);
+    conn_pool[i].fd = -1;
   }
+  conn_pool_used = 0;
+  pthread_mutex_unlock(&conn_pool_lock);
+}
 
-  const long deadline = monotonic_ms_now() + (long)timeout_ms;
+/*
+ * Outbound I/O thread.
+ *
+ * All broadcasts share one long-lived thread that drives every outbound connect and send
+ * through a single epoll set. A broadcast is a batch of per-host operations; each operation
+ * is a small state machine (wait -> connect -> send -> done) with a monotonic timer for the
+ * DPoPS pacing slot, the connect-retry jitter and the connect/send deadlines.
+ *
+ * Host names are resolved when an operation first needs to connect, never on the caller's
+ * thread: a name the DNS cache holds connects at once, a miss parks the operation while one
+ * of NET_MULTI_RESOLVE_THREADS resolves it, and the answer comes back through the wake
+ * eventfd. One slow or unknown name no longer holds up the connects to every other host.
+ *
+ * The batch is reference counted: the caller may stop waiting once enough hosts have
+ * accepted the message (multi_request_wait) while stragglers keep running here, and
+ * later read their final status with multi_request_results().
+ */
+struct multi_request_s {
+  response_t** responses;     /* owned by the request; callers get copies */
+  size_t total;
+  size_t pending;             /* operations not finished yet */
+  size_t ok;                  /* operations finished with STATUS_OK */
+  uint8_t* z;
+  size_t zlen;
+  int port;
+  long round;                 /* BLOCK_TIME_SEC window the broadcast started in */
+  int refs;                   /* caller + unfinished operations; guarded by mu */
+  pthread_mutex_t mu;
+  pthread_cond_t cv;          /* signalled on every finished operation (CLOCK_MONOTONIC) */
+};
+
+typedef enum {
+  OP_WAIT,                    /* waiting for start_at (pacing slot or retry jitter) */
+  OP_RESOLVING,               /* host name handed to a resolver thread */
+  OP_CONNECTING,
+  OP_SENDING,
+  OP_DONE
+} mr_op_state_t;
+
+typedef struct mr_op_s {
+  multi_request_t* batch;     /* NULL for circuit breaker probes */
+  response_t* r;              /* owned by the op for probes */
+  int port;
+  bool probe;                 /* connect-only check of a host whose breaker is open */
+  struct addrinfo* res;       /* NULL until the host name is resolved */
+  struct addrinfo* ai;        /* address being tried */
+  int dns_err;                /* resolver result, set with res by a resolver thread */
+  bool dns_failed;
+  int attempt;                /* connect attempts on ai */
+  int fd;
+  bool pooled;                /* fd came from the connection pool */
+  bool pool_tried;
+  int last_err;
+  char last_ip[INET6_ADDRSTRLEN];
+  mr_op_state_t state;
+  long start_at_ms;
+  long deadline_ms;
+  long connect_start_ms;
+  size_t sent;
+  struct addrinfo probe_ai;   /* probes connect to the last address seen for the host */
+  struct sockaddr_storage probe_addr;
+  struct mr_op_s* next;
+  struct mr_op_s* resolve_next;  /* resolver queue or answered list, guarded by mr_resolve_lock */
+} mr_op_t;
 
-  for (;;) {
-    long now = monotonic_ms_now();
-    long remaining = deadline - now;
-    if (remaining <= 0) {
-      if (out_err) *out_err = ETIMEDOUT;
-      return -1;
+/*
+ * Per-host scoreboard, owned by the I/O thread.
+ *
+ * Connect RTTs feed a smoothed RTT and deviation (RFC 6298 style) from which the connect
+ * timeout and retry jitter are derived, so a host on the same continent is given up on
+ * long before CONNECT_TIMEOUT_SEC. A host that has a failed send in NET_BREAKER_FAIL_ROUNDS
+ * rounds in a row has its breaker opened: broadcasts skip it at once, and a connect-only
+ * probe every NET_BREAKER_PROBE_MS closes the breaker again when the host comes back. A
+ * round (one BLOCK_TIME_SEC window) fans several broadcasts out to the same host, so only
+ * its first failed send counts; one bad round cannot open the breaker.
+ */
+typedef struct {
+  char host[IP_LENGTH + 1];
+  int port;
+  double srtt_ms;             /* 0 until the first sample */
+  double rttvar_ms;
+  int fail_streak;            /* consecutive rounds with a failed send */
+  long fail_round;            /* round of the last counted failure */
+  time_t last_success;
+  long last_seen_ms;
+  bool open;                  /* circuit breaker tripped */
+  bool probing;
+  long next_probe_ms;
+  struct sockaddr_storage addr;  /* last address tried, used by probes */
+  socklen_t addrlen;
+} peer_score_t;
+
+static peer_score_t peer_scores[NET_SCORE_MAX_ENTRIES];
+static size_t peer_scores_used = 0;
+
+static peer_score_t* peer_score_get(const char* host, int port, bool create)
+{
+  peer_score_t* oldest = NULL;
+  for (size_t i = 0; i < peer_scores_used; i++) {
+    if (peer_scores[i].port == port && strcmp(peer_scores[i].host, host) == 0) return &peer_scores[i];
+    if (!peer_scores[i].probing && (!oldest || peer_scores[i].last_seen_ms < oldest->last_seen_ms)) {
+      oldest = &peer_scores[i];
     }
+  }
+  if (!create || strlen(host) > IP_LENGTH) return NULL;
+
+  peer_score_t* e = (peer_scores_used < NET_SCORE_MAX_ENTRIES) ? &peer_scores[peer_scores_used++] : oldest;
+  if (!e) return NULL;
+  memset(e, 0, sizeof(*e));
+  snprintf(e->host, sizeof(e->host), "%s", host);
+  e->port = port;
+  e->last_seen_ms = monotonic_ms_now();
+  return e;
+}
 
-    struct timeval tv;
-    tv.tv_sec  = (time_t)(remaining / 1000L);
-    tv.tv_usec = (suseconds_t)((remaining % 1000L) * 1000L);
+static void peer_score_rtt(peer_score_t* e, long sample_ms)
+{
+  if (!e) return;
+  double s = (double)(sample_ms > 0 ? sample_ms : 1);
+  if (e->srtt_ms <= 0.0) {
+    e->srtt_ms = s;
+    e->rttvar_ms = s / 2.0;
+  } else {
+    double dev = e->srtt_ms > s ? e->srtt_ms - s : s - e->srtt_ms;
+    e->rttvar_ms = 0.75 * e->rttvar_ms + 0.25 * dev;
+    e->srtt_ms = 0.875 * e->srtt_ms + 0.125 * s;
+  }
+}
 
-    fd_set wf;
-    FD_ZERO(&wf);
-    FD_SET(sock, &wf);
+/* srtt + 4 * rttvar, at least NET_CONNECT_TIMEOUT_MIN_MS; CONNECT_TIMEOUT_SEC until a sample exists */
+static long peer_connect_timeout_ms(const peer_score_t* e)
+{
+  const long max_ms = CONNECT_TIMEOUT_SEC * 1000L;
+  if (!e || e->srtt_ms <= 0.0) return max_ms;
+  long t = (long)(e->srtt_ms + 4.0 * e->rttvar_ms);
+  if (t < NET_CONNECT_TIMEOUT_MIN_MS) t = NET_CONNECT_TIMEOUT_MIN_MS;
+  return t > max_ms ? max_ms : t;
+}
 
-    int sel = select(sock + 1, NULL, &wf, NULL, &tv);
-    if (sel < 0 && errno == EINTR) continue;
+/* one smoothed RTT, bounded by CONNECT_RETRY_JITTER_MS */
+static long peer_retry_jitter_ms(const peer_score_t* e)
+{
+  if (!e || e->srtt_ms <= 0.0) return CONNECT_RETRY_JITTER_MS;
+  long j = (long)e->srtt_ms;
+  if (j < 10) j = 10;
+  return j > CONNECT_RETRY_JITTER_MS ? CONNECT_RETRY_JITTER_MS : j;
+}
 
-    if (sel < 0) {
-      if (out_err) *out_err = errno;
-      return -1;
-    }
+static void peer_score_result(const char* host, int port, bool ok, long now, long round)
+{
+  peer_score_t* e = peer_score_get(host, port, true);
+  if (!e) return;
+  e->last_seen_ms = now;
+
+  if (ok) {
+    if (e->open) INFO_PRINT("Host %s:%d is reachable again, resuming sends", host, port);
+    e->fail_streak = 0;
+    e->open = false;
+    e->last_success = time(NULL);
+    return;
+  }
 
-    if (sel == 0 || !FD_ISSET(sock, &wf)) {
-      if (out_err) *out_err = ETIMEDOUT;
-      return -1;
-    }
+  if (e->fail_streak > 0 && e->fail_round == round) return;  /* this round already counted */
+  e->fail_streak++;
+  e->fail_round = round;
+  if (!e->open && e->fail_streak >= NET_BREAKER_FAIL_ROUNDS) {
+    WARNING_PRINT("Host %s:%d failed sends in %d rounds in a row, skipping it until a probe succeeds",
+                  host, port, e->fail_streak);
+    e->open = true;
+    e->next_probe_ms = now + NET_BREAKER_PROBE_MS;
+  }
+}
 
-    int soerr = 0;
-    socklen_t sl = sizeof(soerr);
-    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &soerr, &sl) != 0) {
-      if (out_err) *out_err = errno;
-      return -1;
+static int mr_epoll_fd = -1;
+static int mr_wake_fd = -1;
+static pthread_once_t mr_once = PTHREAD_ONCE_INIT;
+static bool mr_ready = false;
+static pthread_mutex_t mr_submit_lock = PTHREAD_MUTEX_INITIALIZER;
+static mr_op_t* mr_submitted = NULL;   /* handed over by callers, guarded by mr_submit_lock */
+static mr_op_t* mr_active = NULL;      /* owned by the I/O thread */
+static pthread_mutex_t mr_resolve_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mr_resolve_cond = PTHREAD_COND_INITIALIZER;
+static mr_op_t* mr_resolve_head = NULL;  /* names waiting for a resolver thread, guarded by mr_resolve_lock */
+static mr_op_t* mr_resolve_tail = NULL;
+static mr_op_t* mr_resolved = NULL;      /* answered, waiting for the I/O thread, guarded by mr_resolve_lock */
+static size_t mr_resolver_count = 0;
+
+static void mr_batch_release(multi_request_t* b)
+{
+  pthread_mutex_lock(&b->mu);
+  int left = --b->refs;
+  pthread_mutex_unlock(&b->mu);
+  if (left > 0) return;
+
+  pthread_mutex_destroy(&b->mu);
+  pthread_cond_destroy(&b->cv);
+  cleanup_responses(b->responses);
+  free(b->z);
+  free(b);
+}
+
+static const char* mr_status_str(response_status_t st)
+{
+  return st == STATUS_OK ? "OK" : st == STATUS_TIMEOUT ? "TIMEOUT" : "ERROR";
+}
+
+/* Ends a probe: an established connection closes the breaker and is kept for reuse */
+static void mr_probe_finish(mr_op_t* op, bool ok, long now)
+{
+  peer_score_t* e = peer_score_get(op->r->host, op->port, false);
+  if (op->fd >= 0) {
+    epoll_ctl(mr_epoll_fd, EPOLL_CTL_DEL, op->fd, NULL);
+    if (ok && conn_pool_eligible(op->port)) {
+      conn_pool_checkin(op->r->host, op->port, op->fd);
+    } else {
+      close(op->fd);
     }
+    op->fd = -1;
+  }
+  if (e) {
+    e->probing = false;
+    e->next_probe_ms = now + NET_BREAKER_PROBE_MS;
+  }
+  DEBUG_PRINT("Probe %s:%d | %s", op->r->host, op->port, ok ? "OK" : "FAILED");
+  if (ok) peer_score_result(op->r->host, op->port, true, now, 0);
 
-    if (soerr != 0) {
-      if (out_err) *out_err = soerr;
-      return -1;
+  free(op->r->host);
+  free(op->r);
+  op->r = NULL;
+  op->state = OP_DONE;
+}
+
+static void mr_op_finish(mr_op_t* op, response_status_t status)
+{
+  if (op->probe) {
+    mr_probe_finish(op, status == STATUS_OK, monotonic_ms_now());
+    return;
+  }
+
+  /* a name that does not resolve says nothing about the host's connectivity */
+  if (!op->dns_failed) {
+    peer_score_result(op->r->host, op->port, status == STATUS_OK, monotonic_ms_now(), op->batch->round);
+  }
+
+  if (op->fd >= 0) {
+    epoll_ctl(mr_epoll_fd, EPOLL_CTL_DEL, op->fd, NULL);
+    if (status == STATUS_OK && conn_pool_eligible(op->port)) {
+      conn_pool_checkin(op->r->host, op->port, op->fd);
+    } else {
+      close(op->fd);
     }
+    op->fd = -1;
+  }
+  if (op->res) dns_cache_freeaddrinfo(op->res);
+  op->res = NULL;
+  op->ai = NULL;
 
-    restore_blocking(sock, old_flags);
-    return 0;
+  if (status == STATUS_TIMEOUT || (status == STATUS_ERROR && op->last_err != 0)) {
+    WARNING_PRINT("Connect failed to %s:%d ip=%s final_err=%d (%s)",
+                  op->r->host, op->port, op->last_ip[0] ? op->last_ip : "?",
+                  op->last_err, strerror(op->last_err));
   }
+
+  multi_request_t* b = op->batch;
+  pthread_mutex_lock(&b->mu);
+  op->r->status = status;
+  op->r->req_time_end = time(NULL);
+  DEBUG_PRINT("Host:%s | %s%s | %lds", op->r->host, mr_status_str(status), op->pooled ? " (pooled)" : "",
+              (long)(op->r->req_time_end - op->r->req_time_start));
+  if (status == STATUS_OK) b->ok++;
+  b->pending--;
+  pthread_cond_broadcast(&b->cv);
+  pthread_mutex_unlock(&b->mu);
+
+  op->state = OP_DONE;
+  mr_batch_release(b);
 }
 
-static response_t* send_to_one_host(const char* host, int port,
-                                    const uint8_t* z, size_t zlen)
+static void mr_op_watch(mr_op_t* op)
 {
-  response_t* r = (response_t*)calloc(1, sizeof(*r));
-  if (!r) return NULL;
-
-  r->host = strdup(host);
-  r->status = STATUS_PENDING;
-  r->req_time_start = time(NULL);
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLOUT;
+  ev.data.ptr = op;
+  if (epoll_ctl(mr_epoll_fd, EPOLL_CTL_ADD, op->fd, &ev) != 0) {
+    op->last_err = errno;
+    mr_op_finish(op, STATUS_ERROR);
+  }
+}
 
-  char port_str[6];
-  snprintf(port_str, sizeof(port_str), "%d", port);
+/* Connect to op->ai failed with err: retry, move to the next address or give up */
+static void mr_op_connect_failed(mr_op_t* op, int err, long now)
+{
+  if (op->fd >= 0) {
+    epoll_ctl(mr_epoll_fd, EPOLL_CTL_DEL, op->fd, NULL);
+    close(op->fd);
+    op->fd = -1;
+  }
+  op->last_err = err;
 
-  struct addrinfo hints;
-  memset(&hints, 0, sizeof(hints));
-  hints.ai_family   = AF_UNSPEC;     /* allow v4/v6 */
-  hints.ai_socktype = SOCK_STREAM;
-  hints.ai_flags    = AI_NUMERICSERV | AI_ADDRCONFIG;
+  DEBUG_PRINT("connect failed host=%s port=%d ip=%s err=%d (%s)",
+              op->r->host, op->port, op->last_ip[0] ? op->last_ip : "?", err, strerror(err));
 
-  struct addrinfo* res = NULL;
-  int gai = getaddrinfo(host, port_str, &hints, &res);
-  if (gai != 0 || !res) {
-    r->status = STATUS_ERROR;
-    ERROR_PRINT("DNS resolution failed for %s: %s", host, gai_strerror(gai));
-    r->req_time_end = time(NULL);
-    return r;
+  if (op->probe) {
+    mr_probe_finish(op, false, now);
+    return;
   }
 
-  int sock = -1;
-  int last_err = 0;
-  char last_ip[INET6_ADDRSTRLEN] = {0};
+  op->state = OP_WAIT;
+  op->attempt++;
+  /* Retry only on transient-ish cases; the jitter helps avoid stampedes */
+  if (op->attempt < CONNECT_RETRY_COUNT &&
+      (err == ETIMEDOUT || err == EHOSTUNREACH || err == ENETUNREACH)) {
+    op->start_at_ms = now + peer_retry_jitter_ms(peer_score_get(op->r->host, op->port, false));
+    return;
+  }
 
-  for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
-    char ipstr[INET6_ADDRSTRLEN] = {0};
-    addr_to_ipstr(ai, ipstr, sizeof(ipstr));
+  op->attempt = 0;
+  op->ai = op->ai ? op->ai->ai_next : NULL;
+  op->start_at_ms = now;
+  if (!op->ai) mr_op_finish(op, op->last_err == ETIMEDOUT ? STATUS_TIMEOUT : STATUS_ERROR);
+}
 
-    /* We only support stream sockets; skip others defensively */
-    if (ai->ai_socktype != SOCK_STREAM) continue;
+/* A send on a pooled socket failed or stalled: the peer dropped it, so send once more on a fresh connection */
+static void mr_op_pool_fallback(mr_op_t* op, int err, long now)
+{
+  DEBUG_PRINT("Send on pooled connection to %s failed: %s, reconnecting", op->r->host, strerror(err));
+  epoll_ctl(mr_epoll_fd, EPOLL_CTL_DEL, op->fd, NULL);
+  close(op->fd);
+  op->fd = -1;
+  op->pooled = false;
+  op->sent = 0;
+  op->state = OP_WAIT;
+  op->start_at_ms = now;
+}
 
-    /* Attempt connect (with one retry on timeout-ish errors) */
-    for (int attempt = 0; attempt < CONNECT_RETRY_COUNT; attempt++) {
-      sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
-      if (sock < 0) {
-        last_err = errno;
-        continue;
-      }
+/* Writes as much of the payload as the socket takes */
+static void mr_op_send(mr_op_t* op, long now)
+{
+  const multi_request_t* b = op->batch;
+  while (op->sent < b->zlen) {
+    ssize_t n = send(op->fd, b->z + op->sent, b->zlen - op->sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      op->sent += (size_t)n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
 
-      /* harmless tuning */
-      int one = 1;
-      (void)setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
-      (void)setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    int err = (n == 0) ? EPIPE : errno;
+    if (op->pooled) {
+      mr_op_pool_fallback(op, err, now);
+      return;
+    }
+    ERROR_PRINT("Send failed to %s: %s", op->r->host, strerror(err));
+    mr_op_finish(op, STATUS_ERROR);
+    return;
+  }
+  mr_op_finish(op, STATUS_OK);
+}
 
-      DEBUG_PRINT("connect attempt host=%s port=%d ip=%s try=%d/%d",
-        host, port, ipstr[0] ? ipstr : "?", attempt + 1, CONNECT_RETRY_COUNT);
+static void mr_resolve_hints(struct addrinfo* hints)
+{
+  memset(hints, 0, sizeof(*hints));
+  hints->ai_family   = AF_UNSPEC;     /* allow v4/v6 */
+  hints->ai_socktype = SOCK_STREAM;
+  hints->ai_flags    = AI_NUMERICSERV | AI_ADDRCONFIG;
+}
 
-      int ce = 0;
-      int timeout_ms = CONNECT_TIMEOUT_SEC * 1000;
-      if (connect_with_deadline(sock, ai->ai_addr, ai->ai_addrlen, timeout_ms, &ce) == 0) {
-        last_err = 0;
-        snprintf(last_ip, sizeof(last_ip), "%s", ipstr);
-        goto connected;
-      }
+static void mr_op_dns_failed(mr_op_t* op, int err)
+{
+  ERROR_PRINT("DNS resolution failed for %s: %s", op->r->host, gai_strerror(err));
+  op->dns_failed = true;
+  mr_op_finish(op, STATUS_ERROR);
+}
 
-      last_err = ce;
-      snprintf(last_ip, sizeof(last_ip), "%s", ipstr);
+/* Resolves a name the cache missed, then hands the operation back to the I/O thread */
+static void* mr_resolver_thread(void* arg)
+{
+  (void)arg;
+  for (;;) {
+    pthread_mutex_lock(&mr_resolve_lock);
+    while (!mr_resolve_head) pthread_cond_wait(&mr_resolve_cond, &mr_resolve_lock);
+    mr_op_t* op = mr_resolve_head;
+    mr_resolve_head = op->resolve_next;
+    if (!mr_resolve_head) mr_resolve_tail = NULL;
+    op->resolve_next = NULL;
+    pthread_mutex_unlock(&mr_resolve_lock);
+
+    /* the I/O thread leaves a resolving operation alone, so only this thread touches it */
+    char port_str[6];
+    snprintf(port_str, sizeof(port_str), "%d", op->port);
+    struct addrinfo hints;
+    mr_resolve_hints(&hints);
+    struct addrinfo* res = NULL;
+    int gai = dns_cache_getaddrinfo(op->r->host, port_str, &hints, &res);
+
+    pthread_mutex_lock(&mr_resolve_lock);
+    op->res = res;
+    op->dns_err = (gai == 0 && !res) ? EAI_NONAME : gai;
+    op->resolve_next = mr_resolved;
+    mr_resolved = op;
+    pthread_mutex_unlock(&mr_resolve_lock);
+
+    uint64_t one = 1;
+    if (write(mr_wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+      WARNING_PRINT("Could not wake the outbound I/O thread: %s", strerror(errno));
+    }
+  }
+  return NULL;
+}
 
-      DEBUG_PRINT("connect failed host=%s port=%d ip=%s err=%d (%s)",
-                  host, port, ipstr[0] ? ipstr : "?", ce, strerror(ce));
+/* Fills op->res from the DNS cache; returns false if the operation is now resolving or finished */
+static bool mr_op_resolve(mr_op_t* op)
+{
+  char port_str[6];
+  snprintf(port_str, sizeof(port_str), "%d", op->port);
+  struct addrinfo hints;
+  mr_resolve_hints(&hints);
+  struct addrinfo* res = NULL;
 
-      close(sock);
-      sock = -1;
+  int gai = dns_cache_lookup(op->r->host, port_str, &hints, &res);
+  if (gai == DNS_CACHE_MISS && mr_resolver_count == 0) {
+    gai = dns_cache_getaddrinfo(op->r->host, port_str, &hints, &res);  /* no resolver threads to wait for */
+  }
+  if (gai == DNS_CACHE_MISS) {
+    op->state = OP_RESOLVING;
+    pthread_mutex_lock(&mr_resolve_lock);
+    if (mr_resolve_tail) mr_resolve_tail->resolve_next = op;
+    else mr_resolve_head = op;
+    mr_resolve_tail = op;
+    pthread_cond_signal(&mr_resolve_cond);
+    pthread_mutex_unlock(&mr_resolve_lock);
+    return false;
+  }
+  if (gai != 0 || !res) {
+    mr_op_dns_failed(op, gai != 0 ? gai : EAI_NONAME);
+    return false;
+  }
+  op->res = res;
+  op->ai = res;
+  return true;
+}
 
-      /* Retry only on transient-ish cases */
-      if (attempt + 1 < CONNECT_RETRY_COUNT &&
-          (ce == ETIMEDOUT || ce == EHOSTUNREACH || ce == ENETUNREACH)) {
-        /* small jitter helps avoid stampedes */
-        sleep_ms(CONNECT_RETRY_JITTER_MS);
-        continue;
-      }
+/* Starts the operation: pooled socket first, otherwise a non-blocking connect to op->ai */
+static void mr_op_start(mr_op_t* op, long now)
+{
+  const int port = op->port;
+
+  if (!op->probe && !op->pool_tried) {
+    const peer_score_t* e = peer_score_get(op->r->host, port, false);
+    if (e && e->open) {
+      DEBUG_PRINT("Host:%s | skipped, breaker open after %d failed rounds", op->r->host, e->fail_streak);
+      mr_op_finish(op, STATUS_ERROR);
+      return;
+    }
+  }
 
-      break;
+  if (!op->probe && !op->pool_tried) {
+    op->pool_tried = true;
+    int fd = conn_pool_checkout(op->r->host, port);
+    if (fd >= 0) {
+      op->fd = fd;
+      op->pooled = true;
+      op->state = OP_SENDING;
+      op->deadline_ms = now + SEND_TIMEOUT_MS;
+      (void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+      mr_op_watch(op);
+      if (op->state == OP_SENDING) mr_op_send(op, now);
+      return;
     }
   }
 
-connected:
-  freeaddrinfo(res);
+  /* No pooled socket: the name is needed now */
+  if (!op->probe && !op->res && !mr_op_resolve(op)) return;
 
-  if (sock < 0) {
-    /* classify a little better */
-    if (last_err == ETIMEDOUT) r->status = STATUS_TIMEOUT;
-    else r->status = STATUS_ERROR;
+  /* We only support stream sockets; skip others defensively */
+  while (op->ai && op->ai->ai_socktype != SOCK_STREAM) op->ai = op->ai->ai_next;
+  if (!op->ai) {
+    mr_op_finish(op, op->last_err == ETIMEDOUT ? STATUS_TIMEOUT : STATUS_ERROR);
+    return;
+  }
 
-    WARNING_PRINT("Connect failed to %s:%d ip=%s final_err=%d (%s)",
-                  host, port, last_ip[0] ? last_ip : "?", last_err, strerror(last_err));
+  addr_to_ipstr(op->ai, op->last_ip, sizeof(op->last_ip));
+  peer_score_t* score = peer_score_get(op->r->host, port, true);
+  if (score && !op->probe && op->ai->ai_addrlen <= sizeof(score->addr)) {
+    memcpy(&score->addr, op->ai->ai_addr, op->ai->ai_addrlen);
+    score->addrlen = op->ai->ai_addrlen;
+  }
+  DEBUG_PRINT("connect attempt host=%s port=%d ip=%s try=%d/%d",
+              op->r->host, port, op->last_ip[0] ? op->last_ip : "?", op->attempt + 1, CONNECT_RETRY_COUNT);
 
-    r->req_time_end = time(NULL);
-    return r;
+  op->fd = socket(op->ai->ai_family, op->ai->ai_socktype, op->ai->ai_protocol);
+  if (op->fd < 0) {
+    mr_op_connect_failed(op, errno, now);
+    return;
+  }
+  (void)fcntl(op->fd, F_SETFL, fcntl(op->fd, F_GETFL, 0) | O_NONBLOCK);
+
+  /* harmless tuning */
+  int one = 1;
+  (void)setsockopt(op->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  (void)setsockopt(op->fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+
+  op->sent = 0;
+  op->connect_start_ms = now;
+  if (connect(op->fd, op->ai->ai_addr, op->ai->ai_addrlen) == 0) {
+    peer_score_rtt(score, 0);
+    if (op->probe) {
+      mr_probe_finish(op, true, now);
+      return;
+    }
+    op->state = OP_SENDING;
+    op->deadline_ms = now + SEND_TIMEOUT_MS;
+  } else if (errno == EINPROGRESS) {
+    op->state = OP_CONNECTING;
+    op->deadline_ms = now + (op->probe ? CONNECT_TIMEOUT_SEC * 1000L : peer_connect_timeout_ms(score));
+  } else {
+    mr_op_connect_failed(op, errno, now);
+    return;
   }
 
-  /* align SO_SNDTIMEO with helper timeout */
-  struct timeval sto;
-  sto.tv_sec  = SEND_TIMEOUT_MS / 1000;
-  sto.tv_usec = (SEND_TIMEOUT_MS % 1000) * 1000;
-  if (setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &sto, sizeof(sto)) < 0) {
-    WARNING_PRINT("setsockopt(SO_SNDTIMEO) failed: %s", strerror(errno));
+  mr_op_watch(op);
+  if (op->state == OP_SENDING) mr_op_send(op, now);
+}
+
+/* A resolver thread answered: connect, or fail the operation if the name did not resolve */
+static void mr_op_resolved(mr_op_t* op, long now)
+{
+  if (op->dns_err != 0) {
+    mr_op_dns_failed(op, op->dns_err);
+    return;
   }
+  op->ai = op->res;
+  op->state = OP_WAIT;
+  mr_op_start(op, now);
+}
 
-  if (send_all_with_timeout(sock, z, zlen, SEND_TIMEOUT_MS) != 0) {
-    r->status = STATUS_ERROR;
-    ERROR_PRINT("Send failed to %s: %s", host, strerror(errno));
-  } else {
-    r->status = STATUS_OK;
+static void mr_op_ready(mr_op_t* op, uint32_t events, long now)
+{
+  if (op->state == OP_CONNECTING) {
+    int soerr = 0;
+    socklen_t sl = sizeof(soerr);
+    if (getsockopt(op->fd, SOL_SOCKET, SO_ERROR, &soerr, &sl) != 0) soerr = errno;
+    if (soerr == 0 && (events & (EPOLLERR | EPOLLHUP))) soerr = ECONNREFUSED;
+    if (soerr != 0) {
+      mr_op_connect_failed(op, soerr, now);
+      return;
+    }
+    op->last_err = 0;
+    peer_score_rtt(peer_score_get(op->r->host, op->port, true), now - op->connect_start_ms);
+    if (op->probe) {
+      mr_probe_finish(op, true, now);
+      return;
+    }
+    op->state = OP_SENDING;
+    op->deadline_ms = now + SEND_TIMEOUT_MS;
+  } else if (op->pooled && (events & (EPOLLERR | EPOLLHUP))) {
+    int soerr = 0;
+    socklen_t sl = sizeof(soerr);
+    if (getsockopt(op->fd, SOL_SOCKET, SO_ERROR, &soerr, &sl) != 0 || soerr == 0) soerr = ECONNRESET;
+    mr_op_pool_fallback(op, soerr, now);
+    return;
+  }
+  if (op->state == OP_SENDING) mr_op_send(op, now);
+}
+
+static void mr_op_timer(mr_op_t* op, long now)
+{
+  switch (op->state) {
+    case OP_WAIT:
+      if (now >= op->start_at_ms) mr_op_start(op, now);
+      break;
+    case OP_RESOLVING:
+      break;
+    case OP_CONNECTING:
+      if (now >= op->deadline_ms) mr_op_connect_failed(op, ETIMEDOUT, now);
+      break;
+    case OP_SENDING:
+      if (now >= op->deadline_ms && op->pooled) {
+        mr_op_pool_fallback(op, ETIMEDOUT, now);
+      } else if (now >= op->deadline_ms) {
+        ERROR_PRINT("Send failed to %s: %s", op->r->host, strerror(ETIMEDOUT));
+        mr_op_finish(op, STATUS_ERROR);
+      }
+      break;
+    case OP_DONE:
+      break;
   }
+}
 
-  r->req_time_end = time(NULL);
-  DEBUG_PRINT("Host:%s | %s | %lds",
-              host,
-              r->status == STATUS_OK ? "OK" :
-              r->status == STATUS_TIMEOUT ? "TIMEOUT" : "ERROR",
-              (long)(r->req_time_end - r->req_time_start));
+/* Milliseconds until the earliest timer of an active operation, capped at one second */
+static int mr_next_timeout(long now)
+{
+  long next = now + 1000;
+  for (const mr_op_t* op = mr_active; op; op = op->next) {
+    if (op->state == OP_RESOLVING) continue;  /* woken by its resolver thread */
+    long at = (op->state == OP_WAIT) ? op->start_at_ms : op->deadline_ms;
+    if (at < next) next = at;
+  }
+  for (size_t i = 0; i < peer_scores_used; i++) {
+    const peer_score_t* e = &peer_scores[i];
+    if (e->open && !e->probing && e->addrlen > 0 && e->next_probe_ms < next) next = e->next_probe_ms;
+  }
+  return next <= now ? 0 : (int)(next - now);
+}
 
-  close(sock);
+static response_t* mr_new_response(const char* host)
+{
+  response_t* r = (response_t*)calloc(1, sizeof(*r));
+  if (!r) return NULL;
+  r->host = strdup(host);
+  if (!r->host) {
+    free(r);
+    return NULL;
+  }
+  r->status = STATUS_PENDING;
+  r->req_time_start = time(NULL);
   return r;
 }
 
-/* ---- simple worker pool ---- */
-typedef struct {
-    const char**    hosts;
-    size_t          total;
-    int             port;
-    const uint8_t*  z;
-    size_t          zlen;
-    response_t**    responses;
-    size_t          next_idx;
-    pthread_mutex_t mu;
-    size_t launch_seq;
-} work_ctx_t;
-
-static void* worker_fn(void* arg) {
-  work_ctx_t* ctx = (work_ctx_t*)arg;
+/* Queues a connect-only probe for every open breaker whose probe time has come */
+static void mr_start_probes(long now)
+{
+  for (size_t i = 0; i < peer_scores_used; i++) {
+    peer_score_t* e = &peer_scores[i];
+    if (!e->open || e->probing || e->addrlen == 0 || now < e->next_probe_ms) continue;
+
+    mr_op_t* op = (mr_op_t*)calloc(1, sizeof(*op));
+    response_t* r = op ? mr_new_response(e->host) : NULL;
+    if (!r) {
+      free(op);
+      e->next_probe_ms = now + NET_BREAKER_PROBE_MS;
+      continue;
+    }
+
+    memcpy(&op->probe_addr, &e->addr, e->addrlen);
+    op->probe_ai.ai_family = op->probe_addr.ss_family;
+    op->probe_ai.ai_socktype = SOCK_STREAM;
+    op->probe_ai.ai_protocol = IPPROTO_TCP;
+    op->probe_ai.ai_addr = (struct sockaddr*)&op->probe_addr;
+    op->probe_ai.ai_addrlen = e->addrlen;
+    op->r = r;
+    op->port = e->port;
+    op->probe = true;
+    op->ai = &op->probe_ai;
+    op->fd = -1;
+    op->state = OP_WAIT;
+    op->start_at_ms = now;
+
+    e->probing = true;
+    op->next = mr_active;
+    mr_active = op;
+  }
+}
+
+static void* mr_io_thread(void* arg)
+{
+  (void)arg;
+  struct epoll_event events[NET_MULTI_MAX_EVENTS];
 
   for (;;) {
-    size_t i, seq = 0;
-    pthread_mutex_lock(&ctx->mu);
-    i = ctx->next_idx++;
-    if (i < ctx->total) {
-        seq = ctx->launch_seq++;
+    int n = epoll_wait(mr_epoll_fd, events, NET_MULTI_MAX_EVENTS, mr_next_timeout(monotonic_ms_now()));
+    if (n < 0 && errno != EINTR) {
+      ERROR_PRINT("epoll_wait failed in outbound I/O thread: %s", strerror(errno));
+      sleep(1);
+      continue;
     }
-    pthread_mutex_unlock(&ctx->mu);
 
-    if (i >= ctx->total) {
-        break;
+    long now = monotonic_ms_now();
+    for (int i = 0; i < n; i++) {
+      if (events[i].data.ptr == NULL) {
+        uint64_t v;
+        while (read(mr_wake_fd, &v, sizeof(v)) > 0) {}
+        continue;
+      }
+      mr_op_ready((mr_op_t*)events[i].data.ptr, events[i].events, now);
     }
 
-    // Stagger only for DPoPS traffic (optional but recommended)
-    if (ctx->port == XCASH_DPOPS_PORT) {
-      // deterministic spread: 12..32ms
-      int delay_ms = 12 + (int)(seq % 6) * 4;  // 12,16,20,24,28,32 repeat
-      sleep_ms(delay_ms);
+    /* connect the operations whose names the resolver threads answered */
+    pthread_mutex_lock(&mr_resolve_lock);
+    mr_op_t* resolved = mr_resolved;
+    mr_resolved = NULL;
+    pthread_mutex_unlock(&mr_resolve_lock);
+    while (resolved) {
+      mr_op_t* op = resolved;
+      resolved = op->resolve_next;
+      op->resolve_next = NULL;
+      mr_op_resolved(op, now);
     }
 
-    const char* host = ctx->hosts[i];
-
-    ctx->responses[i] = send_to_one_host(host, ctx->port, ctx->z, ctx->zlen);
-    if (!ctx->responses[i]) {
-      response_t* r = (response_t*)calloc(1, sizeof(*r));
-      if (r) { r->host = strdup(host); r->status = STATUS_ERROR; }
-      ctx->responses[i] = r;
+    /* adopt newly submitted operations, in submission order */
+    pthread_mutex_lock(&mr_submit_lock);
+    mr_op_t* incoming = mr_submitted;
+    mr_submitted = NULL;
+    pthread_mutex_unlock(&mr_submit_lock);
+    mr_op_t** tail = &mr_active;
+    while (*tail) tail = &(*tail)->next;
+    *tail = incoming;
+
+    now = monotonic_ms_now();
+    mr_start_probes(now);
+    for (mr_op_t** pp = &mr_active; *pp;) {
+      mr_op_t* op = *pp;
+      mr_op_timer(op, now);
+      if (op->state == OP_DONE) {
+        *pp = op->next;
+        free(op);
+      } else {
+        pp = &op->next;
+      }
     }
   }
-
   return NULL;
 }
 
-/* ---- public entry: parallel fan-out ---- */
-response_t** send_multi_request(const char** hosts, int port, const char* message) {
+static void mr_init(void)
+{
+  mr_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (mr_epoll_fd < 0) {
+    ERROR_PRINT("epoll_create1 failed for outbound I/O: %s", strerror(errno));
+    return;
+  }
+  mr_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (mr_wake_fd < 0) {
+    ERROR_PRINT("eventfd failed for outbound I/O: %s", strerror(errno));
+    close(mr_epoll_fd);
+    mr_epoll_fd = -1;
+    return;
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  pthread_t th;
+  if (epoll_ctl(mr_epoll_fd, EPOLL_CTL_ADD, mr_wake_fd, &ev) != 0 ||
+      pthread_create(&th, NULL, mr_io_thread, NULL) != 0) {
+    ERROR_PRINT("Could not start the outbound I/O thread: %s", strerror(errno));
+    close(mr_wake_fd);
+    close(mr_epoll_fd);
+    mr_wake_fd = mr_epoll_fd = -1;
+    return;
+  }
+  pthread_detach(th);
+
+  for (size_t i = 0; i < NET_MULTI_RESOLVE_THREADS; i++) {
+    if (pthread_create(&th, NULL, mr_resolver_thread, NULL) != 0) {
+      ERROR_PRINT("Could not start an outbound resolver thread: %s", strerror(errno));
+      break;
+    }
+    pthread_detach(th);
+    mr_resolver_count++;
+  }
+  mr_ready = true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: send_multi_request_start
+Description: Compresses the message once and queues a send to every host on the outbound I/O thread.
+             Returns without waiting; use multi_request_wait() and multi_request_results().
+Parameters:
+  hosts - NULL terminated host list (copied)
+  port - destination port
+  message - message to send
+Return: The request handle (release with multi_request_release), or NULL on error
+---------------------------------------------------------------------------------------------------------*/
+multi_request_t* send_multi_request_start(const char** hosts, int port, const char* message) {
     /* count */
     size_t total_hosts = 0;
     while (hosts[total_hosts]) total_hosts++;
 
-    response_t** responses = (response_t**)calloc(total_hosts + 1, sizeof(*responses));
-    if (!responses) { perror("calloc responses"); return NULL; }
-    if (total_hosts == 0) return responses; /* nothing to do */
+    pthread_once(&mr_once, mr_init);
+    if (!mr_ready) return NULL;
 
-    /* compress once */
-    uint8_t* z = NULL; size_t zlen = 0;
-    {
+    multi_request_t* b = (multi_request_t*)calloc(1, sizeof(*b));
+    if (!b) return NULL;
+
+    b->responses = (response_t**)calloc(total_hosts + 1, sizeof(*b->responses));
+    if (!b->responses) { perror("calloc responses"); free(b); return NULL; }
+
+    /* compress once; DPoPS peers get a length-prefixed frame once --framed-messages is on, everything
+       else (and every peer until then) the bare gzip body older servers expect */
+    if (total_hosts > 0) {
         size_t mlen = strlen(message) + 1;
-        if (!compress_gzip_with_prefix((const unsigned char*)message, mlen, &z, &zlen)) {
+        bool ok = (port == XCASH_DPOPS_PORT && framed_messages)
+                      ? compress_gzip_framed((const unsigned char*)message, mlen, &b->z, &b->zlen)
+                      : compress_gzip_with_prefix((const unsigned char*)message, mlen, &b->z, &b->zlen);
+        if (!ok) {
             ERROR_PRINT("gzip failed");
-            responses[total_hosts] = NULL;
-            return responses; /* caller can still cleanup */
+            free(b->responses);
+            free(b);
+            return NULL;
         }
     }
 
-    work_ctx_t ctx;
-    ctx.hosts     = hosts;
-    ctx.total     = total_hosts;
-    ctx.port      = port;
-    ctx.z         = z;
-    ctx.zlen      = zlen;
-    ctx.responses = responses;
-    ctx.next_idx  = 0;
-    ctx.launch_seq = 0;
-    pthread_mutex_init(&ctx.mu, NULL);
-
-    size_t nworkers = NET_MULTI_WORKERS;
-    if (nworkers > total_hosts) nworkers = total_hosts ? total_hosts : 1;
-
-    pthread_t* th = (pthread_t*)malloc(nworkers * sizeof(*th));
-    if (!th) {
-        pthread_mutex_destroy(&ctx.mu);
-        free(z);
-        return responses;
+    b->port = port;
+    b->round = (long)(time(NULL) / BLOCK_TIME_SEC);
+    b->refs = 1;
+    pthread_mutex_init(&b->mu, NULL);
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&b->cv, &ca);
+    pthread_condattr_destroy(&ca);
+
+    /* build the operations; DPoPS sends are paced in bursts instead of all starting at once. Names are
+       resolved on the I/O thread, so nothing here waits for DNS */
+    const long t0 = monotonic_ms_now();
+    mr_op_t* head = NULL;
+    mr_op_t** tail = &head;
+    size_t launch_seq = 0;
+
+    for (size_t i = 0; i < total_hosts; i++) {
+        response_t* r = mr_new_response(hosts[i]);
+        b->responses[i] = r;
+        if (!r) break;  /* out of memory: the NULL ends the list early */
+        b->total++;
+
+        mr_op_t* op = (mr_op_t*)calloc(1, sizeof(*op));
+        if (!op) {
+            r->status = STATUS_ERROR;
+            r->req_time_end = time(NULL);
+            continue;
+        }
+        op->batch = b;
+        op->port = port;
+        op->r = r;
+        op->fd = -1;
+        op->state = OP_WAIT;
+        op->start_at_ms = t0;
+        if (port == XCASH_DPOPS_PORT) {
+            op->start_at_ms += (long)(launch_seq / NET_MULTI_PACE_BURST) * NET_MULTI_PACE_MS;
+        }
+        launch_seq++;
+
+        b->pending++;
+        b->refs++;
+        *tail = op;
+        tail = &op->next;
+    }
+
+    if (head) {
+        pthread_mutex_lock(&mr_submit_lock);
+        mr_op_t** st = &mr_submitted;
+        while (*st) st = &(*st)->next;
+        *st = head;
+        pthread_mutex_unlock(&mr_submit_lock);
+
+        uint64_t one = 1;
+        if (write(mr_wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            WARNING_PRINT("Could not wake the outbound I/O thread: %s", strerror(errno));
+        }
+    }
+
+    return b;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: multi_request_wait
+Description: Waits until min_ok hosts accepted the message, every host finished, or timeout_ms passed.
+             Hosts still in flight keep going on the I/O thread.
+Parameters:
+  req - request handle
+  min_ok - number of successful sends that is enough; 0 waits for every host
+  timeout_ms - maximum wait in milliseconds; negative waits without a limit
+Return: The number of hosts that accepted the message so far
+---------------------------------------------------------------------------------------------------------*/
+size_t multi_request_wait(multi_request_t* req, size_t min_ok, long timeout_ms) {
+    if (!req) return 0;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeout_ms >= 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&req->mu);
+    while (req->pending > 0 && (min_ok == 0 || req->ok < min_ok)) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&req->cv, &req->mu);
+        } else if (pthread_cond_timedwait(&req->cv, &req->mu, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    size_t ok = req->ok;
+    if (req->pending > 0) {
+        DEBUG_PRINT("Broadcast returned with %zu/%zu hosts OK, %zu still in flight", ok, req->total, req->pending);
+    }
+    pthread_mutex_unlock(&req->mu);
+    return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: multi_request_results
+Description: Copies the current per-host results. Hosts still in flight are reported as STATUS_PENDING.
+Parameters:
+  req - request handle
+Return: A NULL terminated response list to free with cleanup_responses, or NULL on error
+---------------------------------------------------------------------------------------------------------*/
+response_t** multi_request_results(multi_request_t* req) {
+    if (!req) return NULL;
+
+    response_t** out = (response_t**)calloc(req->total + 1, sizeof(*out));
+    if (!out) return NULL;
+
+    pthread_mutex_lock(&req->mu);
+    for (size_t i = 0; i < req->total; i++) {
+        const response_t* src = req->responses[i];
+        response_t* r = (response_t*)calloc(1, sizeof(*r));
+        if (!r) break;
+        *r = *src;
+        r->data = NULL;
+        r->host = strdup(src->host);
+        if (!r->host) {
+            free(r);
+            break;
+        }
+        out[i] = r;
     }
+    pthread_mutex_unlock(&req->mu);
+    return out;
+}
 
-    for (size_t t = 0; t < nworkers; ++t) pthread_create(&th[t], NULL, worker_fn, &ctx);
-    for (size_t t = 0; t < nworkers; ++t) pthread_join(th[t], NULL);
+/* Drops the caller's reference; hosts still in flight finish on their own */
+void multi_request_release(multi_request_t* req) {
+    if (req) mr_batch_release(req);
+}
 
-    free(th);
-    pthread_mutex_destroy(&ctx.mu);
-    free(z);
-    z = NULL;
+/* ---- public entry: parallel fan-out, waits for every host ---- */
+response_t** send_multi_request(const char** hosts, int port, const char* message) {
+    multi_request_t* req = send_multi_request_start(hosts, port, message);
+    if (!req) {
+        /* empty list: the caller can still cleanup */
+        response_t** responses = (response_t**)calloc(1, sizeof(*responses));
+        if (!responses) perror("calloc responses");
+        return responses;
+    }
 
-    responses[total_hosts] = NULL;
+    multi_request_wait(req, 0, -1);
+    response_t** responses = multi_request_results(req);
+    multi_request_release(req);
     return responses;
 }
 
@@ -13,10 +13,17 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include "config.h"
 #include "globals.h"
 #include "macro_functions.h" 
 #include "string_functions.h"
+#include "dns_cache.h"
 
 typedef enum {
     STATUS_ERROR,
@@ -35,16 +42,15 @@ typedef struct {
   void* client; // optional, will be NULL
 } response_t;
 
-
-typedef struct {
-    const char** hosts;
-    int port;
-    const char* message;
-    response_t** results;  // output
-  } multi_request_args_t;
+typedef struct multi_request_s multi_request_t;  /* in-flight broadcast */
 
 
 response_t **send_multi_request(const char **hosts, int port, const char *message);
+multi_request_t *send_multi_request_start(const char **hosts, int port, const char *message);
+size_t multi_request_wait(multi_request_t *req, size_t min_ok, long timeout_ms);
+response_t **multi_request_results(multi_request_t *req);
+void multi_request_release(multi_request_t *req);
 void cleanup_responses(response_t **responses);
+void cleanup_connection_pool(void);
 
 #endif
\ No newline at end of file
@@ -1,7 +1,765 @@
 #include "net_server.h"
 
+/*---------------------------------------------------------------------------------------------------------
+The server is a single edge-triggered epoll reactor (server_thread) plus fixed worker pools.
+
+  - The reactor accepts and drains readable sockets into the connection's read buffer. Once a complete
+    frame is buffered, only its first NET_SERVER_PEEK_BYTES are inflated to read the message type, and
+    the still compressed frame is queued as a job. Sockets are registered EPOLLONESHOT, so while a job
+    owns a connection the reactor never touches it (or its read buffer, which the job points into); the
+    worker re-arms it when done.
+  - There is one bounded queue per dispatch class. Consensus messages (VRF data, vote majority, block
+    verification) have their own workers and are also taken first by every other worker, so a flood of
+    wallet votes cannot push them past the round cut-offs.
+  - Each class has a byte budget and each peer IP a cap on jobs, with slots only consensus messages may
+    use. A message over a limit is dropped and counted before anything is allocated for it; the
+    connection stays open, so a flood of public messages cannot cut a verifier off.
+  - Workers decompress the message and run handle_srv_message(). Replies go out through send_data() on
+    the same (non-blocking) socket.
+  - Connections armed in epoll sit on an idle list and are closed after RECEIVE_TIMEOUT_SEC of silence,
+    or NET_SERVER_PEER_IDLE_SEC for DPoPS peers that keep pooled connections open.
+
+Inbound framing: DPoPS peers send NET_FRAME_MAGIC + 4-byte big-endian length + body, so a message
+split across TCP segments is reassembled before it is decompressed. Anything else (wallet tools,
+older senders) is treated the legacy way: whatever a read drains is one message.
+---------------------------------------------------------------------------------------------------------*/
+
+typedef struct server_conn_s {
+  server_client_t client;            // passed to handle_srv_message(), keep first
+  unsigned char* rbuf;               // bytes drained from the socket, rbuf[rstart..rlen) not yet dispatched
+  size_t rstart;
+  size_t rlen;
+  size_t rcap;
+  bool peer_closed;                  // EOF or reset seen while reading
+  bool framed;                       // sent framed data: a DPoPS peer that may keep the connection open
+  uint32_t peer_addr;                // IPv4 address (network order), key for the per-peer job cap
+  uint64_t last_active_ms;
+  struct server_conn_s* prev;        // idle list links, only valid while armed
+  struct server_conn_s* next;
+} server_conn_t;
+
+typedef struct {
+  server_conn_t* conn;
+  const unsigned char* data;         // compressed frame body inside conn->rbuf, stable while the job owns conn
+  size_t length;
+  dispatch_class_t dclass;
+  uint64_t enqueued_ms;
+} dispatch_job_t;
+
+typedef struct {
+  dispatch_job_t jobs[NET_SERVER_QUEUE_MAX];
+  size_t head;
+  size_t len;
+  size_t bytes;                      // held by waiting and running jobs, bounded by NET_SERVER_QUEUE_MAX_BYTES
+  dispatch_queue_stats_t stats;
+} dispatch_queue_t;
+
+// Waiting and running jobs per peer IP. Open addressing; a slot with jobs == 0 is empty. At most one
+// job runs per connection, so there are never more peers with jobs than MAX_CONNECTIONS.
+#define PEER_JOB_SLOTS (MAX_CONNECTIONS * 2)
+typedef struct {
+  uint32_t addr;
+  uint32_t jobs;
+} peer_jobs_t;
+
+static const char* const dispatch_class_names[DISPATCH_CLASS_COUNT] = {"consensus", "sync", "public"};
+static const size_t dispatch_class_workers[DISPATCH_CLASS_COUNT] = {
+    NET_SERVER_CONSENSUS_WORKERS, NET_SERVER_SYNC_WORKERS, NET_SERVER_PUBLIC_WORKERS};
+
 int server_fd = -1;
-sem_t client_slots;
+static int epoll_fd = -1;
+static int wake_fd = -1;
+
+typedef struct {
+  pthread_t thread;
+  dispatch_class_t dclass;           // serves this class and every higher-priority one
+} dispatch_worker_t;
+
+static dispatch_worker_t workers[NET_SERVER_CONSENSUS_WORKERS + NET_SERVER_SYNC_WORKERS + NET_SERVER_PUBLIC_WORKERS];
+static size_t worker_count = 0;
+
+static dispatch_queue_t dispatch_queues[DISPATCH_CLASS_COUNT];
+static peer_jobs_t peer_jobs[PEER_JOB_SLOTS];     // guarded by dispatch_lock
+static bool workers_stop = false;
+static pthread_mutex_t dispatch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dispatch_cond = PTHREAD_COND_INITIALIZER;
+
+static z_stream peek_stream;         // reactor only
+static bool peek_stream_ready = false;
+
+static server_conn_t* armed_head = NULL;
+static pthread_mutex_t armed_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int live_connections = ATOMIC_VAR_INIT(0);
+static atomic_bool listener_paused = ATOMIC_VAR_INIT(false);  // set while the listener is disarmed at the cap
+
+static uint64_t server_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+static int set_socket_nonblocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0) return -1;
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Caller holds armed_lock
+static void armed_insert(server_conn_t* conn) {
+  conn->prev = NULL;
+  conn->next = armed_head;
+  if (armed_head) armed_head->prev = conn;
+  armed_head = conn;
+}
+
+// Caller holds armed_lock
+static void armed_remove(server_conn_t* conn) {
+  if (conn->prev) conn->prev->next = conn->next;
+  else if (armed_head == conn) armed_head = conn->next;
+  if (conn->next) conn->next->prev = conn->prev;
+  conn->prev = conn->next = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: listener_arm
+Description: Enables or disables accept events on the listener. At MAX_CONNECTIONS the reactor disarms it
+  and leaves new clients in the listen backlog; the first close below the cap re-arms it, and since the
+  listener is edge-triggered EPOLL_CTL_MOD re-reports anything already waiting. Safe from any thread.
+Parameters:
+  on - true to re-arm, false to disarm
+Return: None
+---------------------------------------------------------------------------------------------------------*/
+static void listener_arm(bool on) {
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = on ? (EPOLLIN | EPOLLET) : EPOLLET;
+  ev.data.ptr = NULL;
+  if (epoll_fd >= 0 && server_fd >= 0 && epoll_ctl(epoll_fd, EPOLL_CTL_MOD, server_fd, &ev) != 0 &&
+      atomic_load(&server_running)) {
+    perror("epoll_ctl listener");
+  }
+}
+
+// Re-arms the listener if it was paused and the connection count has dropped below the cap
+static void listener_resume_if_below_cap(void) {
+  if (atomic_load(&listener_paused) && atomic_load(&live_connections) < MAX_CONNECTIONS &&
+      atomic_exchange(&listener_paused, false)) {
+    listener_arm(true);
+  }
+}
+
+static void conn_close(server_conn_t* conn) {
+  if (!conn) return;
+  if (conn->client.socket_fd >= 0) {
+    close(conn->client.socket_fd);  // also drops it from the epoll set
+    conn->client.socket_fd = -1;
+  }
+  free(conn->rbuf);
+  free(conn);
+  atomic_fetch_sub(&live_connections, 1);
+  listener_resume_if_below_cap();
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: conn_arm
+Description: Puts a connection back under reactor ownership: idle list first, then re-enables the
+  one-shot read event. If data arrived while a worker held it, epoll reports it immediately.
+Parameters:
+  conn - connection to arm
+  add  - true for a freshly accepted socket (EPOLL_CTL_ADD), false to re-arm (EPOLL_CTL_MOD)
+Return: true on success, false if the connection was closed
+---------------------------------------------------------------------------------------------------------*/
+static bool conn_arm(server_conn_t* conn, bool add) {
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+  ev.data.ptr = conn;
+
+  pthread_mutex_lock(&armed_lock);
+  conn->last_active_ms = server_now_ms();
+  armed_insert(conn);
+  pthread_mutex_unlock(&armed_lock);
+
+  if (epoll_ctl(epoll_fd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, conn->client.socket_fd, &ev) != 0) {
+    WARNING_PRINT("epoll_ctl failed for %s: %s", conn->client.client_ip, strerror(errno));
+    pthread_mutex_lock(&armed_lock);
+    armed_remove(conn);
+    pthread_mutex_unlock(&armed_lock);
+    conn_close(conn);
+    return false;
+  }
+  return true;
+}
+
+typedef enum {
+  FRAME_NONE,       // nothing buffered
+  FRAME_PARTIAL,    // framed message still arriving
+  FRAME_COMPLETE,   // *body / *body_len / *consumed are set
+  FRAME_INVALID     // bad or oversized length, drop the connection
+} frame_status_t;
+
+/*---------------------------------------------------------------------------------------------------------
+Name: conn_next_frame
+Description: Looks for the next complete message at rbuf[rstart]. Framed data is complete once the whole
+  announced body is buffered; legacy (unframed) data is complete as soon as anything is buffered.
+Parameters:
+  conn     - connection
+  body     - [out] start of the message body
+  body_len - [out] body length
+  consumed - [out] bytes to advance rstart by
+Return: frame_status_t
+---------------------------------------------------------------------------------------------------------*/
+static frame_status_t conn_next_frame(const server_conn_t* conn, const unsigned char** body, size_t* body_len,
+                                      size_t* consumed) {
+  const size_t avail = conn->rlen - conn->rstart;
+  if (avail == 0) return FRAME_NONE;
+
+  const unsigned char* p = conn->rbuf + conn->rstart;
+  if (p[0] != NET_FRAME_MAGIC) {
+    *body = p;
+    *body_len = avail;
+    *consumed = avail;
+    return FRAME_COMPLETE;
+  }
+
+  if (avail < NET_FRAME_HEADER_SIZE) return FRAME_PARTIAL;
+
+  const size_t len = ((size_t)p[1] << 24) | ((size_t)p[2] << 16) | ((size_t)p[3] << 8) | (size_t)p[4];
+  if (len == 0 || len > NET_MAX_FRAME_SIZE) return FRAME_INVALID;
+  if (avail - NET_FRAME_HEADER_SIZE < len) return FRAME_PARTIAL;
+
+  *body = p + NET_FRAME_HEADER_SIZE;
+  *body_len = len;
+  *consumed = NET_FRAME_HEADER_SIZE + len;
+  return FRAME_COMPLETE;
+}
+
+static frame_status_t conn_frame_status(const server_conn_t* conn) {
+  const unsigned char* body;
+  size_t body_len, consumed;
+  return conn_next_frame(conn, &body, &body_len, &consumed);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: conn_read
+Description: Drains a non-blocking socket until EAGAIN (required with EPOLLET), appending to the
+  connection read buffer. The buffer grows on demand: up to the announced frame size for framed data,
+  up to BUFFER_SIZE for legacy data. It always keeps one spare byte for a terminating NUL.
+  If the buffer is full but already holds a complete frame, reading stops early; the rest is picked
+  up when the worker re-arms the socket.
+Parameters:
+  conn - connection owned by the reactor
+Return: 1 on success (peer_closed is set on EOF/reset), 0 if the connection must be dropped
+---------------------------------------------------------------------------------------------------------*/
+static int conn_read(server_conn_t* conn) {
+  for (;;) {
+    if (conn->rcap - conn->rlen < 2) {
+      const bool framed = conn->rlen > conn->rstart && conn->rbuf[conn->rstart] == NET_FRAME_MAGIC;
+      const size_t limit = framed ? (size_t)NET_FRAME_HEADER_SIZE + NET_MAX_FRAME_SIZE + 1 : (size_t)BUFFER_SIZE;
+      if (conn->rcap - conn->rstart >= limit) {
+        if (framed && conn_frame_status(conn) == FRAME_COMPLETE) break;
+        WARNING_PRINT("Dropping %s: message exceeds %zu bytes", conn->client.client_ip, limit);
+        return 0;
+      }
+      size_t ncap = conn->rcap ? conn->rcap * 2 : VSMALL_BUFFER_SIZE * 4;
+      if (ncap - conn->rstart > limit) ncap = conn->rstart + limit;
+      unsigned char* nbuf = realloc(conn->rbuf, ncap);
+      if (!nbuf) {
+        ERROR_PRINT("Out of memory growing read buffer for %s", conn->client.client_ip);
+        return 0;
+      }
+      conn->rbuf = nbuf;
+      conn->rcap = ncap;
+    }
+
+    ssize_t n = recv(conn->client.socket_fd, conn->rbuf + conn->rlen, conn->rcap - conn->rlen - 1, 0);
+    if (n > 0) {
+      conn->rlen += (size_t)n;
+      continue;
+    }
+    if (n == 0) {
+      conn->peer_closed = true;
+      break;
+    }
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+    if (errno == ECONNRESET) {
+      conn->peer_closed = true;
+      break;
+    }
+    return 0;
+  }
+
+  if (conn->rbuf) conn->rbuf[conn->rlen] = '\0';
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dispatch_class_for
+Description: Maps a message type to its dispatch queue.
+Parameters:
+  msg_type - message type
+Return: dispatch_class_t
+---------------------------------------------------------------------------------------------------------*/
+static dispatch_class_t dispatch_class_for(xcash_msg_t msg_type) {
+  switch (msg_type) {
+    case XMSG_BLOCK_VERIFIERS_TO_BLOCK_VERIFIERS_VRF_DATA:
+    case XMSG_NODES_TO_NODES_VOTE_MAJORITY_RESULTS:
+    case XMSG_XCASHD_TO_DPOPS_VERIFY:
+    case XMSG_DPOPS_TO_XCASHD_VERIFY:
+      return DISPATCH_CONSENSUS;
+
+    case XMSG_NODE_TO_NETWORK_DATA_NODES_GET_CURRENT_BLOCK_VERIFIERS_LIST:
+    case XMSG_NODES_TO_NODES_DATABASE_SYNC_REQ:
+    case XMSG_NODES_TO_NODES_DATABASE_SYNC_DATA:
+    case XMSG_SEED_TO_NODES_UPDATE_VOTE_COUNT:
+    case XMSG_SEED_TO_NODES_PAYOUT:
+    case XMSG_NODES_TO_NODES_PAYOUT_INFO:
+    case XMSG_SEED_TO_NODES_MAINTENANCE:
+      return DISPATCH_SYNC;
+
+    default:
+      return DISPATCH_PUBLIC;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: peek_message_type
+Description: Reads message_settings from a decompressed message without a full JSON parse. Anything
+  that does not look right lands in the public queue and is rejected by handle_srv_message().
+Parameters:
+  data   - decompressed message
+  length - message length
+Return: message type or XMSG_NONE
+---------------------------------------------------------------------------------------------------------*/
+static xcash_msg_t peek_message_type(const unsigned char* data, size_t length) {
+  static const char key[] = "\"message_settings\"";
+  const size_t key_len = sizeof(key) - 1;
+  const char* end = (const char*)data + length;
+  const char* p = NULL;
+  for (const char* c = (const char*)data; (size_t)(end - c) >= key_len; c++) {
+    if (*c == '"' && memcmp(c, key, key_len) == 0) {
+      p = c + key_len;
+      break;
+    }
+  }
+  if (!p) return XMSG_NONE;
+
+  while (p < end && (*p == ' ' || *p == ':' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+  if (p >= end || *p != '"') return XMSG_NONE;
+  p++;
+
+  char value[128];
+  size_t n = 0;
+  while (p < end && *p != '"' && n < sizeof(value) - 1) value[n++] = *p++;
+  value[n] = '\0';
+  return get_message_type(value);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: peek_frame_type
+Description: Reads the message type of a still compressed frame body. Only the first NET_SERVER_PEEK_BYTES
+  of the message are inflated (message_settings is the first field every sender writes), so the reactor
+  does a bounded amount of work whatever the frame size. Runs on the reactor thread only.
+Parameters:
+  body     - frame body, 0x01 + zlib data or plain JSON
+  body_len - body length
+Return: message type or XMSG_NONE
+---------------------------------------------------------------------------------------------------------*/
+static xcash_msg_t peek_frame_type(const unsigned char* body, size_t body_len) {
+  if (body_len == 0) return XMSG_NONE;
+  if (body[0] != 0x01) return peek_message_type(body, body_len < NET_SERVER_PEEK_BYTES ? body_len : NET_SERVER_PEEK_BYTES);
+
+  if (!peek_stream_ready) {
+    memset(&peek_stream, 0, sizeof(peek_stream));
+    if (inflateInit(&peek_stream) != Z_OK) return XMSG_NONE;
+    peek_stream_ready = true;
+  } else if (inflateReset(&peek_stream) != Z_OK) {
+    return XMSG_NONE;
+  }
+
+  unsigned char prefix[NET_SERVER_PEEK_BYTES];
+  peek_stream.next_in = body + 1;
+  peek_stream.avail_in = (uInt)(body_len - 1);
+  peek_stream.next_out = prefix;
+  peek_stream.avail_out = sizeof(prefix);
+  int rc = inflate(&peek_stream, Z_SYNC_FLUSH);
+  if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) return XMSG_NONE;
+  return peek_message_type(prefix, sizeof(prefix) - peek_stream.avail_out);
+}
+
+static size_t peer_jobs_home(uint32_t addr) {
+  return (size_t)((addr * 2654435761u) % PEER_JOB_SLOTS);
+}
+
+// Caller holds dispatch_lock. Returns the peer's slot, or the empty slot it would take if create is set
+static peer_jobs_t* peer_jobs_find(uint32_t addr, bool create) {
+  size_t i = peer_jobs_home(addr);
+  for (size_t probes = 0; probes < PEER_JOB_SLOTS; probes++, i = (i + 1) % PEER_JOB_SLOTS) {
+    if (peer_jobs[i].jobs == 0) {
+      if (!create) return NULL;
+      peer_jobs[i].addr = addr;
+      return &peer_jobs[i];
+    }
+    if (peer_jobs[i].addr == addr) return &peer_jobs[i];
+  }
+  return NULL;
+}
+
+// Caller holds dispatch_lock. Drops one job from the peer's count, emptying the slot at zero
+static void peer_jobs_release(uint32_t addr) {
+  peer_jobs_t* e = peer_jobs_find(addr, false);
+  if (!e || --e->jobs > 0) return;
+
+  // Backward-shift deletion keeps every later entry of the probe run reachable
+  size_t i = (size_t)(e - peer_jobs);
+  for (size_t j = (i + 1) % PEER_JOB_SLOTS; peer_jobs[j].jobs != 0; j = (j + 1) % PEER_JOB_SLOTS) {
+    size_t home = peer_jobs_home(peer_jobs[j].addr);
+    bool reachable = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+    if (reachable) continue;
+    peer_jobs[i] = peer_jobs[j];
+    peer_jobs[j].jobs = 0;
+    i = j;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dispatch_push
+Description: Queues a job if its class has room (NET_SERVER_QUEUE_MAX jobs, NET_SERVER_QUEUE_MAX_BYTES)
+  and its peer is under NET_SERVER_PEER_MAX_JOBS. Non-consensus messages stop
+  NET_SERVER_PEER_CONSENSUS_RESERVE jobs short of that cap, so a peer flooding public messages can still
+  get its consensus messages in.
+Parameters:
+  job - job to queue, job->dclass set
+Return: true if queued, false if it was dropped (and counted)
+---------------------------------------------------------------------------------------------------------*/
+static bool dispatch_push(const dispatch_job_t* job) {
+  const size_t peer_limit = job->dclass == DISPATCH_CONSENSUS
+                                ? NET_SERVER_PEER_MAX_JOBS
+                                : NET_SERVER_PEER_MAX_JOBS - NET_SERVER_PEER_CONSENSUS_RESERVE;
+
+  pthread_mutex_lock(&dispatch_lock);
+  dispatch_queue_t* q = &dispatch_queues[job->dclass];
+  peer_jobs_t* peer = peer_jobs_find(job->conn->peer_addr, true);
+  if (q->len == NET_SERVER_QUEUE_MAX || q->bytes + job->length > NET_SERVER_QUEUE_MAX_BYTES || !peer ||
+      peer->jobs >= peer_limit) {
+    q->stats.dropped++;
+    pthread_mutex_unlock(&dispatch_lock);
+    return false;
+  }
+  peer->jobs++;
+  q->bytes += job->length;
+  q->jobs[(q->head + q->len) % NET_SERVER_QUEUE_MAX] = *job;
+  q->len++;
+  q->stats.enqueued++;
+  if (q->len > q->stats.max_depth) q->stats.max_depth = q->len;
+  // Workers of several classes may be eligible for this job
+  pthread_cond_broadcast(&dispatch_cond);
+  pthread_mutex_unlock(&dispatch_lock);
+  return true;
+}
+
+// A worker finished the job: its bytes and peer slot count against the budgets until now
+static void dispatch_done(const dispatch_job_t* job) {
+  pthread_mutex_lock(&dispatch_lock);
+  dispatch_queues[job->dclass].bytes -= job->length;
+  peer_jobs_release(job->conn->peer_addr);
+  pthread_mutex_unlock(&dispatch_lock);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: dispatch_pop
+Description: Blocks until a job is available for a worker of the given class. Queues are scanned in
+  strict priority order, from consensus down to the worker's own class.
+Parameters:
+  dclass - class of the calling worker
+  job    - [out] job taken
+Return: true if a job was taken, false on shutdown
+---------------------------------------------------------------------------------------------------------*/
+static bool dispatch_pop(dispatch_class_t dclass, dispatch_job_t* job) {
+  pthread_mutex_lock(&dispatch_lock);
+  for (;;) {
+    for (int c = 0; c <= (int)dclass; c++) {
+      dispatch_queue_t* q = &dispatch_queues[c];
+      if (q->len == 0) continue;
+
+      *job = q->jobs[q->head];
+      q->head = (q->head + 1) % NET_SERVER_QUEUE_MAX;
+      q->len--;
+
+      uint64_t waited = server_now_ms() - job->enqueued_ms;
+      q->stats.processed++;
+      q->stats.wait_ms_total += waited;
+      if (waited > q->stats.wait_ms_max) q->stats.wait_ms_max = waited;
+      pthread_mutex_unlock(&dispatch_lock);
+      return true;
+    }
+    if (workers_stop) break;
+    pthread_cond_wait(&dispatch_cond, &dispatch_lock);
+  }
+  pthread_mutex_unlock(&dispatch_lock);
+  return false;
+}
+
+typedef enum {
+  SUBMIT_QUEUED,    // a job now owns the connection
+  SUBMIT_IDLE,      // nothing complete buffered, caller re-arms or closes
+  SUBMIT_CLOSE      // drop the connection
+} submit_result_t;
+
+/*---------------------------------------------------------------------------------------------------------
+Name: conn_submit
+Description: Takes the next complete frame from the connection buffer, classifies it from its first bytes
+  and queues it, still compressed. Frames that dispatch_push() refuses are dropped and the next one is
+  tried; the connection stays open. When nothing complete is left, any partial frame is compacted to the
+  front of the buffer. Called by the reactor after a read and by a worker after it finished the previous
+  job of the same connection.
+Parameters:
+  conn - connection owned by the caller
+Return: submit_result_t
+---------------------------------------------------------------------------------------------------------*/
+static submit_result_t conn_submit(server_conn_t* conn) {
+  const unsigned char* body;
+  size_t body_len, consumed;
+  frame_status_t st;
+
+  while ((st = conn_next_frame(conn, &body, &body_len, &consumed)) == FRAME_COMPLETE) {
+    const bool framed = conn->rbuf[conn->rstart] == NET_FRAME_MAGIC;
+    conn->rstart += consumed;
+    if (framed) conn->framed = true;
+
+    if (!framed && (strncmp((const char*)body, "GET ", 4) == 0 || strncmp((const char*)body, "POST", 4) == 0 ||
+                    strncmp((const char*)body, "HEAD", 4) == 0)) {
+      WARNING_PRINT("Rejected HTTP request from %s", conn->client.client_ip);
+      return SUBMIT_CLOSE;
+    }
+
+    dispatch_job_t job;
+    job.conn = conn;
+    job.data = body;
+    job.length = body_len;
+    job.dclass = dispatch_class_for(peek_frame_type(body, body_len));
+    job.enqueued_ms = server_now_ms();
+    if (!dispatch_push(&job)) {
+      WARNING_PRINT("Server %s queue or %s's job limit full, dropping a message", dispatch_class_names[job.dclass],
+                    conn->client.client_ip);
+      continue;
+    }
+    return SUBMIT_QUEUED;
+  }
+
+  if (st == FRAME_INVALID) {
+    WARNING_PRINT("Invalid frame header from %s", conn->client.client_ip);
+    return SUBMIT_CLOSE;
+  }
+
+  if (conn->rstart == conn->rlen) {
+    conn->rstart = conn->rlen = 0;
+    if (conn->rcap > NET_SERVER_RBUF_KEEP) {
+      free(conn->rbuf);
+      conn->rbuf = NULL;
+      conn->rcap = 0;
+    }
+  } else if (conn->rstart > 0) {
+    memmove(conn->rbuf, conn->rbuf + conn->rstart, conn->rlen - conn->rstart);
+    conn->rlen -= conn->rstart;
+    conn->rstart = 0;
+    conn->rbuf[conn->rlen] = '\0';
+  }
+  return SUBMIT_IDLE;
+}
+
+// Decides what happens to a connection whose buffer holds no complete frame
+static void conn_release(server_conn_t* conn) {
+  if (conn->peer_closed) {
+    if (conn->rlen > conn->rstart) {
+      WARNING_PRINT("Connection from %s closed mid-frame (%zu bytes buffered)", conn->client.client_ip,
+                    conn->rlen - conn->rstart);
+    }
+    conn_close(conn);
+    return;
+  }
+  conn_arm(conn, false);
+}
+
+static void* server_worker_loop(void* arg) {
+  const dispatch_worker_t* self = (const dispatch_worker_t*)arg;
+
+  dispatch_job_t job;
+  while (dispatch_pop(self->dclass, &job)) {
+    server_conn_t* conn = job.conn;
+
+    unsigned char* data = NULL;
+    size_t length = 0;
+    if (decompress_gzip_with_prefix(job.data, job.length, &data, &length)) {
+      DEBUG_PRINT("[TCP] Message from %s: %.*s\n", conn->client.client_ip, (int)length, data);
+      handle_srv_message((const char*)data, length, &conn->client);
+      free(data);
+    } else {
+      WARNING_PRINT("Failed to decompress message from %s", conn->client.client_ip);
+    }
+    dispatch_done(&job);
+
+    switch (conn_submit(conn)) {
+      case SUBMIT_QUEUED:
+        break;
+      case SUBMIT_CLOSE:
+        conn_close(conn);
+        break;
+      case SUBMIT_IDLE:
+      default:
+        conn_release(conn);
+        break;
+    }
+  }
+  return NULL;
+}
+
+static void server_accept_ready(void) {
+  for (;;) {
+    // At the cap, stop accepting rather than accept and drop: clients wait in the backlog until a close
+    if (atomic_load(&live_connections) >= MAX_CONNECTIONS) {
+      // disarm before publishing the pause, so a close can never re-arm ahead of the disarm
+      if (!atomic_load(&listener_paused)) {
+        listener_arm(false);
+        atomic_store(&listener_paused, true);
+        WARNING_PRINT("Connection limit (%d) reached, pausing accept", MAX_CONNECTIONS);
+      }
+      // a close between the check and the pause saw nothing to resume
+      if (atomic_load(&live_connections) < MAX_CONNECTIONS && atomic_exchange(&listener_paused, false)) {
+        listener_arm(true);
+        continue;
+      }
+      return;
+    }
+
+    struct sockaddr_in client_addr;
+    socklen_t client_len = sizeof(client_addr);
+    int fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK && atomic_load(&server_running)) {
+        perror("accept");
+      }
+      return;
+    }
+
+    if (set_socket_nonblocking(fd) != 0) {
+      perror("fcntl");
+      close(fd);
+      continue;
+    }
+
+    server_conn_t* conn = calloc(1, sizeof(server_conn_t));
+    if (!conn) {
+      perror("calloc");
+      close(fd);
+      continue;
+    }
+    conn->client.socket_fd = fd;
+    conn->peer_addr = client_addr.sin_addr.s_addr;
+    if (inet_ntop(AF_INET, &client_addr.sin_addr, conn->client.client_ip, sizeof(conn->client.client_ip)) == NULL) {
+      strncpy(conn->client.client_ip, "unknown", sizeof(conn->client.client_ip));
+      conn->client.client_ip[sizeof(conn->client.client_ip) - 1] = '\0';  // Ensure null-termination
+    }
+
+    atomic_fetch_add(&live_connections, 1);
+    conn_arm(conn, true);
+  }
+}
+
+static void server_conn_ready(server_conn_t* conn) {
+  pthread_mutex_lock(&armed_lock);
+  armed_remove(conn);
+  pthread_mutex_unlock(&armed_lock);
+
+  if (!conn_read(conn)) {
+    conn_close(conn);
+    return;
+  }
+
+  switch (conn_submit(conn)) {
+    case SUBMIT_QUEUED:
+      return;
+    case SUBMIT_CLOSE:
+      conn_close(conn);
+      return;
+    case SUBMIT_IDLE:
+    default:
+      conn_release(conn);
+      return;
+  }
+}
+
+static void server_sweep_idle(void) {
+  const uint64_t now = server_now_ms();
+  const uint64_t limit = (uint64_t)RECEIVE_TIMEOUT_SEC * 1000ull;
+  const uint64_t peer_limit = (uint64_t)NET_SERVER_PEER_IDLE_SEC * 1000ull;
+
+  pthread_mutex_lock(&armed_lock);
+  server_conn_t* conn = armed_head;
+  while (conn) {
+    server_conn_t* next = conn->next;
+    if (now - conn->last_active_ms >= (conn->framed ? peer_limit : limit)) {
+      armed_remove(conn);
+      conn_close(conn);
+    }
+    conn = next;
+  }
+  pthread_mutex_unlock(&armed_lock);
+}
+
+static void server_stop_workers(void) {
+  pthread_mutex_lock(&dispatch_lock);
+  workers_stop = true;
+  pthread_cond_broadcast(&dispatch_cond);
+  pthread_mutex_unlock(&dispatch_lock);
+
+  for (size_t i = 0; i < worker_count; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  worker_count = 0;
+}
+
+// Only called once the reactor and all workers have exited
+static void server_close_all(void) {
+  for (int c = 0; c < DISPATCH_CLASS_COUNT; c++) {
+    dispatch_queue_t* q = &dispatch_queues[c];
+    while (q->len > 0) {
+      dispatch_job_t* job = &q->jobs[q->head];
+      conn_close(job->conn);
+      q->head = (q->head + 1) % NET_SERVER_QUEUE_MAX;
+      q->len--;
+    }
+    q->head = 0;
+    q->bytes = 0;
+  }
+  memset(peer_jobs, 0, sizeof(peer_jobs));
+
+  if (peek_stream_ready) {
+    inflateEnd(&peek_stream);
+    peek_stream_ready = false;
+  }
+
+  while (armed_head) {
+    server_conn_t* conn = armed_head;
+    armed_remove(conn);
+    conn_close(conn);
+  }
+
+  if (server_fd >= 0) {
+    close(server_fd);
+    server_fd = -1;
+  }
+  if (epoll_fd >= 0) {
+    close(epoll_fd);
+    epoll_fd = -1;
+  }
+  if (wake_fd >= 0) {
+    close(wake_fd);
+    wake_fd = -1;
+  }
+}
 
 // Start the TCP server
 int start_tcp_server(int port) {
@@ -36,102 +794,93 @@ int start_tcp_server(int port) {
     return 0;
   }
 
-  sem_init(&client_slots, 0, MAX_ACTIVE_CLIENTS);
-
-  if (pthread_create(&server_thread, NULL, server_thread_loop, NULL) != 0) {
-    perror("pthread_create");
+  if (set_socket_nonblocking(server_fd) != 0) {
+    perror("fcntl");
     close(server_fd);
     return 0;
   }
 
-  printf("Server listening on port %d\n", port);
-  return 1;
-}
-
-void* server_thread_loop(void* arg) {
-  (void)arg;
-
-  while (atomic_load(&server_running)) {
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-
-    server_client_t* client = malloc(sizeof(server_client_t));
-    if (!client) {
-      perror("malloc");
-      continue;
-    }
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd < 0 || wake_fd < 0) {
+    perror("epoll_create1/eventfd");
+    if (epoll_fd >= 0) close(epoll_fd);
+    if (wake_fd >= 0) close(wake_fd);
+    close(server_fd);
+    return 0;
+  }
 
-    client->socket_fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
-    if (client->socket_fd < 0) {
-      free(client);
+  // data.ptr == NULL marks the listener, &wake_fd marks the shutdown eventfd
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLET;
+  ev.data.ptr = NULL;
+  atomic_store(&listener_paused, false);
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_fd, &ev);
+  ev.events = EPOLLIN;
+  ev.data.ptr = &wake_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
 
-      if (!atomic_load(&server_running)) {
-        break;
+  workers_stop = false;
+  worker_count = 0;
+  for (int c = 0; c < DISPATCH_CLASS_COUNT; c++) {
+    for (size_t i = 0; i < dispatch_class_workers[c]; i++) {
+      dispatch_worker_t* w = &workers[worker_count];
+      w->dclass = (dispatch_class_t)c;
+      if (pthread_create(&w->thread, NULL, server_worker_loop, w) != 0) {
+        perror("pthread_create");
+        server_stop_workers();
+        server_close_all();
+        return 0;
       }
-
-      perror("accept");
-      continue;
-    }
-
-    if (inet_ntop(AF_INET, &client_addr.sin_addr, client->client_ip, sizeof(client->client_ip)) == NULL) {
-      strncpy(client->client_ip, "unknown", sizeof(client->client_ip));
-      client->client_ip[sizeof(client->client_ip) - 1] = '\0';  // Ensure null-termination
-    }
-
-    sem_wait(&client_slots);
-
-    pthread_t client_thread;
-    if (pthread_create(&client_thread, NULL, handle_client, client) != 0) {
-      perror("pthread_create");
-      close(client->socket_fd);
-      free(client);
-      sem_post(&client_slots);
-      continue;
+      worker_count++;
     }
+  }
 
-    pthread_detach(client_thread);
+  if (pthread_create(&server_thread, NULL, server_thread_loop, NULL) != 0) {
+    perror("pthread_create");
+    server_stop_workers();
+    server_close_all();
+    return 0;
   }
 
-  return NULL;
+  printf("Server listening on port %d\n", port);
+  return 1;
 }
 
-void* handle_client(void* arg) {
-  server_client_t* client = (server_client_t*)arg;
-
-  struct timeval recv_timeout = {RECEIVE_TIMEOUT_SEC, 0};
-  setsockopt(client->socket_fd, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout));
-
-  char buffer[BUFFER_SIZE];
-
-  while (1) {
-    memset(buffer, 0, sizeof(buffer));
-    ssize_t bytes = recv(client->socket_fd, buffer, sizeof(buffer) - 1, 0);
-
-    if (bytes < 0 && errno == EINTR) continue;
-    if (bytes <= 0) break;
+void* server_thread_loop(void* arg) {
+  (void)arg;
 
-    buffer[bytes] = '\0';
+  struct epoll_event events[NET_SERVER_MAX_EVENTS];
+  uint64_t next_sweep = server_now_ms() + NET_SERVER_SWEEP_MS;
 
-    if (strncmp(buffer, "GET ", 4) == 0 || strncmp(buffer, "POST", 4) == 0 || strncmp(buffer, "HEAD", 4) == 0) {
-      WARNING_PRINT("Rejected HTTP request from %s", client->client_ip);
+  while (atomic_load(&server_running)) {
+    int n = epoll_wait(epoll_fd, events, NET_SERVER_MAX_EVENTS, NET_SERVER_SWEEP_MS);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      perror("epoll_wait");
       break;
     }
 
-    unsigned char* decompressed = NULL;
-    size_t decompressed_len = 0;
-    if (!decompress_gzip_with_prefix((const unsigned char*)buffer, (size_t)bytes, &decompressed, &decompressed_len)) {
-      WARNING_PRINT("Failed to decompress message from %s", client->client_ip);
-      continue;
+    for (int i = 0; i < n; i++) {
+      void* tag = events[i].data.ptr;
+      if (tag == NULL) {
+        server_accept_ready();
+      } else if (tag == &wake_fd) {
+        uint64_t v;
+        while (read(wake_fd, &v, sizeof(v)) > 0) {}
+      } else {
+        server_conn_ready((server_conn_t*)tag);
+      }
     }
 
-    DEBUG_PRINT("[TCP] Message from %s: %.*s\n", client->client_ip, (int)decompressed_len, decompressed);
-    handle_srv_message((char*)decompressed, decompressed_len, client);
-    free(decompressed);
+    uint64_t now = server_now_ms();
+    if (now >= next_sweep) {
+      server_sweep_idle();
+      next_sweep = now + NET_SERVER_SWEEP_MS;
+    }
   }
 
-  close(client->socket_fd);
-  free(client);
-  sem_post(&client_slots);
   return NULL;
 }
 
@@ -141,7 +890,15 @@ static int send_all_nosig(int fd, const void* buf, size_t len) {
     ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
     if (n > 0) { p += (size_t)n; len -= (size_t)n; continue; }
     if (n < 0 && errno == EINTR) continue;
-    // If your socket is non-blocking, you may want to integrate with your poll/epoll here
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Server sockets are non-blocking; wait for room in the send buffer
+      struct pollfd pfd = {.fd = fd, .events = POLLOUT, .revents = 0};
+      int pr = poll(&pfd, 1, SEND_TIMEOUT_MS);
+      if (pr > 0) continue;
+      if (pr < 0 && errno == EINTR) continue;
+      if (pr == 0) errno = ETIMEDOUT;
+      return -1;
+    }
     return -1;
   }
   return 0;
@@ -198,19 +955,68 @@ void stop_tcp_server(void) {
 
   atomic_store(&server_running, false);
 
-  if (server_fd >= 0) {
-    shutdown(server_fd, SHUT_RDWR);
-    close(server_fd);
-    server_fd = -1;
+  // Wake the reactor out of epoll_wait
+  uint64_t one = 1;
+  if (write(wake_fd, &one, sizeof(one)) < 0) {
+    WARNING_PRINT("Failed to wake server thread: %s", strerror(errno));
   }
-
   pthread_join(server_thread, NULL);
 
-  sem_destroy(&client_slots);
+  server_stop_workers();
+  server_close_all();
 
   printf("TCP server stopped.\n");
 }
 
+/*---------------------------------------------------------------------------------------------------------
+Name: get_dispatch_queue_stats
+Description: Copies the counters of one dispatch queue.
+Parameters:
+  dclass - queue to read
+  out    - [out] counters; depth is the current queue length
+  reset  - true to clear the cumulative counters after reading (depth is unaffected)
+Return: None
+---------------------------------------------------------------------------------------------------------*/
+void get_dispatch_queue_stats(dispatch_class_t dclass, dispatch_queue_stats_t* out, bool reset) {
+  if (!out || dclass < 0 || dclass >= DISPATCH_CLASS_COUNT) return;
+
+  pthread_mutex_lock(&dispatch_lock);
+  dispatch_queue_t* q = &dispatch_queues[dclass];
+  *out = q->stats;
+  out->depth = q->len;
+  out->bytes = q->bytes;
+  if (reset) {
+    memset(&q->stats, 0, sizeof(q->stats));
+    q->stats.max_depth = q->len;
+  }
+  pthread_mutex_unlock(&dispatch_lock);
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: log_dispatch_queue_stats
+Description: Logs and resets the per-queue counters. Called once per round; drops or a slow consensus
+  queue are raised to a warning.
+Parameters: None
+Return: None
+---------------------------------------------------------------------------------------------------------*/
+void log_dispatch_queue_stats(void) {
+  for (int c = 0; c < DISPATCH_CLASS_COUNT; c++) {
+    dispatch_queue_stats_t st;
+    get_dispatch_queue_stats((dispatch_class_t)c, &st, true);
+    uint64_t avg_wait = st.processed ? st.wait_ms_total / st.processed : 0;
+
+    if (st.dropped > 0 || (c == DISPATCH_CONSENSUS && st.wait_ms_max >= NET_DISPATCH_WAIT_WARN_MS)) {
+      WARNING_PRINT("Dispatch queue %s: processed=%llu dropped=%llu depth=%zu bytes=%zu max_depth=%zu wait_avg=%llums wait_max=%llums",
+                    dispatch_class_names[c], (unsigned long long)st.processed, (unsigned long long)st.dropped,
+                    st.depth, st.bytes, st.max_depth, (unsigned long long)avg_wait, (unsigned long long)st.wait_ms_max);
+    } else {
+      DEBUG_PRINT("Dispatch queue %s: processed=%llu dropped=%llu depth=%zu bytes=%zu max_depth=%zu wait_avg=%llums wait_max=%llums",
+                  dispatch_class_names[c], (unsigned long long)st.processed, (unsigned long long)st.dropped,
+                  st.depth, st.bytes, st.max_depth, (unsigned long long)avg_wait, (unsigned long long)st.wait_ms_max);
+    }
+  }
+}
+
 int send_message_to_ip_or_hostname(const char* host_or_ip, int port, const char* message) {
   if (!host_or_ip || !message) {
     ERROR_PRINT("Invalid arguments to send_message_to_ip_or_hostname");
@@ -231,7 +1037,7 @@ int send_message_to_ip_or_hostname(const char* host_or_ip, int port, const char*
     char port_str[6];
     snprintf(port_str, sizeof(port_str), "%d", port);
 
-    int gai_rc = getaddrinfo(host_or_ip, port_str, &hints, &res);
+    int gai_rc = dns_cache_getaddrinfo(host_or_ip, port_str, &hints, &res);
     if (gai_rc != 0) {
       ERROR_PRINT("DNS resolution failed for host %s: %s", host_or_ip, gai_strerror(gai_rc));
       return XCASH_ERROR;
@@ -239,7 +1045,7 @@ int send_message_to_ip_or_hostname(const char* host_or_ip, int port, const char*
 
     struct sockaddr_in* resolved = (struct sockaddr_in*)res->ai_addr;
     addr.sin_addr = resolved->sin_addr;
-    freeaddrinfo(res);
+    dns_cache_freeaddrinfo(res);
   }
 
   int sock = socket(AF_INET, SOCK_STREAM, 0);
@@ -264,7 +1070,10 @@ int send_message_to_ip_or_hostname(const char* host_or_ip, int port, const char*
   unsigned char* compressed = NULL;
   size_t compressed_len = 0;
   size_t msg_len = strlen(message) + 1;
-  if (!compress_gzip_with_prefix((const unsigned char*)message, msg_len, &compressed, &compressed_len)) {
+  bool compressed_ok = (port == XCASH_DPOPS_PORT && framed_messages)
+                           ? compress_gzip_framed((const unsigned char*)message, msg_len, &compressed, &compressed_len)
+                           : compress_gzip_with_prefix((const unsigned char*)message, msg_len, &compressed, &compressed_len);
+  if (!compressed_ok) {
     ERROR_PRINT("Compression failed");
     close(sock);
     return XCASH_ERROR;
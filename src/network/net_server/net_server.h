@@ -5,27 +5,59 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
-#include <semaphore.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#ifndef ZLIB_CONST
+#define ZLIB_CONST  // z_stream.next_in is const, whichever header includes zlib.h first
+#endif
+#include <zlib.h>
 #include "config.h"
 #include "globals.h"
 #include "macro_functions.h"
+#include "dns_cache.h"
 
 typedef struct {
     int socket_fd;
     char client_ip[INET_ADDRSTRLEN];
 } server_client_t;
 
+// Inbound messages are queued per class; lower values have strict priority
+typedef enum {
+    DISPATCH_CONSENSUS,   // VRF data, vote majority, block verification
+    DISPATCH_SYNC,        // node-to-node DB sync, verifier list, seed and payout traffic
+    DISPATCH_PUBLIC,      // wallet register/update/vote/revote/status and unknown types
+    DISPATCH_CLASS_COUNT
+} dispatch_class_t;
+
+typedef struct {
+    size_t depth;              // jobs waiting now
+    size_t max_depth;
+    uint64_t enqueued;
+    uint64_t dropped;          // rejected: queue full, over the byte budget or over the sender's job cap
+    uint64_t processed;
+    uint64_t wait_ms_total;    // enqueue-to-worker time
+    uint64_t wait_ms_max;
+    size_t bytes;              // compressed bytes held by waiting and running jobs now
+} dispatch_queue_stats_t;
+
  
 #include "xcash_message.h"
 
 void* server_thread_loop(void* arg);
-void* handle_client(void* client_socket_ptr);
 int start_tcp_server(int port);
 void stop_tcp_server(void);
 int send_data(server_client_t* client, const unsigned char* data, size_t length);
 int send_message_to_ip_or_hostname(const char* host_or_ip, int port, const char* message);
+void get_dispatch_queue_stats(dispatch_class_t dclass, dispatch_queue_stats_t* out, bool reset);
+void log_dispatch_queue_stats(void);
 
 #endif
\ No newline at end of file
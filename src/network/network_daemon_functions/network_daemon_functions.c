@@ -30,16 +30,20 @@ bool is_blockchain_synced(char *target_height, char *height)
   target_height[0] = '\0';
   height[0] = '\0';
 
+  json_field_t fields[] = {
+    {"result.synchronized",  synced_flag,   sizeof(synced_flag),  false},
+    {"result.status",        status_flag,   sizeof(status_flag),  false},
+    {"result.busy_syncing",  bs_flag,       sizeof(bs_flag),      false},
+    {"result.height",        height,        BLOCK_HEIGHT_LENGTH,  false},
+    {"result.target_height", target_height, BLOCK_HEIGHT_LENGTH,  false},
+    {"result.offline",       offline_flag,  sizeof(offline_flag), false},
+  };
+
   if (send_http_request(response, SMALL_BUFFER_SIZE,
                         XCASH_DAEMON_IP, "/json_rpc", XCASH_DAEMON_PORT,
                         "POST", HTTP_HEADERS, HTTP_HEADERS_LENGTH, request_payload,
                         HTTP_TIMEOUT_SETTINGS) == XCASH_OK &&
-      parse_json_data(response, "result.synchronized",  synced_flag,  sizeof(synced_flag))  != 0 &&
-      parse_json_data(response, "result.status",        status_flag,  sizeof(status_flag))  != 0 &&
-      parse_json_data(response, "result.busy_syncing",  bs_flag,  sizeof(bs_flag))  != 0 &&
-      parse_json_data(response, "result.height",        height,       BLOCK_HEIGHT_LENGTH)  != 0 &&
-      parse_json_data(response, "result.target_height", target_height,BLOCK_HEIGHT_LENGTH)  != 0 &&
-      parse_json_data(response, "result.offline",       offline_flag, sizeof(offline_flag)) != 0)
+      parse_json_fields(response, fields, sizeof(fields) / sizeof(fields[0])) == XCASH_OK)
   {
     if (strcmp(synced_flag, "true") == 0 &&
         strcmp(status_flag, "OK") == 0 &&
@@ -194,8 +198,9 @@ int get_block_template(char* result, size_t result_size, size_t* reserved_offset
   // Send HTTP request
   if (send_http_request(response, result_size, XCASH_DAEMON_IP, RPC_ENDPOINT, XCASH_DAEMON_PORT, RPC_METHOD,
                         HTTP_HEADERS, HTTP_HEADERS_LENGTH, message, HTTP_TIMEOUT_SETTINGS) > 0 &&
-      parse_json_data(response, "result.blocktemplate_blob", result, result_size) == XCASH_OK &&
-      parse_json_data(response, "result.reserved_offset", reserved_offset_str, sizeof(reserved_offset_str)) == XCASH_OK) {
+      parse_json_fields(response, (json_field_t[]){
+          {"result.blocktemplate_blob", result, result_size, false},
+          {"result.reserved_offset", reserved_offset_str, sizeof(reserved_offset_str), false}}, 2) == XCASH_OK) {
     *reserved_offset_out = (size_t)strtoul(reserved_offset_str, NULL, 10);
 
     DEBUG_PRINT("Block Temp: %s", response);
@@ -312,17 +317,31 @@ int get_block_info_by_height(uint64_t height,
         return XCASH_ERROR;
     }
 
+    // one pass over the response for every requested header field
+    char reward_str[64] = {0};
+    char timestamp_str[32] = {0};
+    char orphan_str[8] = {0};
+    json_field_t fields[4] = {{"result.block_header.hash", out_hash, out_hash_len, false}};
+    size_t field_count = 1;
+    json_field_t *reward_field = out_reward ? &fields[field_count++] : NULL;
+    json_field_t *timestamp_field = out_timestamp ? &fields[field_count++] : NULL;
+    json_field_t *orphan_field = out_orphan ? &fields[field_count++] : NULL;
+    if (reward_field) *reward_field = (json_field_t){"result.block_header.reward", reward_str, sizeof(reward_str), false};
+    if (timestamp_field) *timestamp_field = (json_field_t){"result.block_header.timestamp", timestamp_str, sizeof(timestamp_str), false};
+    if (orphan_field) *orphan_field = (json_field_t){"result.block_header.orphan_status", orphan_str, sizeof(orphan_str), false};
+
+    parse_json_fields(response_data, fields, field_count);
+
     // hash (string)
-    if (parse_json_data(response_data, "result.block_header.hash",
-                        out_hash, out_hash_len) != XCASH_OK) {
+    if (!fields[0].found) {
         ERROR_PRINT("get_block_info_by_height: missing result.block_header.hash, Response: %s", response_data);
         return XCASH_ERROR;
     }
 
     // reward (uint64)
     if (out_reward) {
-        char tmp[64] = {0};
-        if (parse_json_data(response_data, "result.block_header.reward", tmp, sizeof(tmp)) != XCASH_OK) {
+        const char *tmp = reward_str;
+        if (!reward_field->found) {
             ERROR_PRINT("get_block_info_by_height: missing result.block_header.reward");
             return XCASH_ERROR;
         }
@@ -337,8 +356,8 @@ int get_block_info_by_height(uint64_t height,
 
     // timestamp (uint64)
     if (out_timestamp) {
-        char tmp[32] = {0};
-        if (parse_json_data(response_data, "result.block_header.timestamp", tmp, sizeof(tmp)) != XCASH_OK) {
+        const char *tmp = timestamp_str;
+        if (!timestamp_field->found) {
             ERROR_PRINT("get_block_info_by_height: missing result.block_header.timestamp");
             return XCASH_ERROR;
         }
@@ -353,8 +372,8 @@ int get_block_info_by_height(uint64_t height,
 
     // orphan_status (bool)
     if (out_orphan) {
-        char tmp[8] = {0};
-        if (parse_json_data(response_data, "result.block_header.orphan_status", tmp, sizeof(tmp)) != XCASH_OK) {
+        const char *tmp = orphan_str;
+        if (!orphan_field->found) {
             ERROR_PRINT("get_block_info_by_height: missing result.block_header.orphan_status");
             return XCASH_ERROR;
         }
@@ -44,12 +44,12 @@ bool hostname_to_ip(const char* name, char* ip_out, size_t ip_out_len) {
   struct addrinfo hints = {0}, *res = NULL;
   hints.ai_family = AF_UNSPEC;      // allow v4 or v6
   hints.ai_socktype = SOCK_STREAM;  // any
-  if (getaddrinfo(name, NULL, &hints, &res) != 0 || !res) return false;
+  if (dns_cache_getaddrinfo(name, NULL, &hints, &res) != 0 || !res) return false;
 
   char buf[NI_MAXHOST];
   bool ok = getnameinfo(res->ai_addr, res->ai_addrlen, buf, sizeof(buf), NULL, 0, NI_NUMERICHOST) == 0;
   if (ok) snprintf(ip_out, ip_out_len, "%s", buf);
-  freeaddrinfo(res);
+  dns_cache_freeaddrinfo(res);
   return ok;
 }
 
@@ -77,9 +77,148 @@ size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp)
     return total_size;
 }
 
+/*
+ * RPC client state.
+ *
+ * Every thread keeps one easy handle for its whole life (freed by the key destructor), and all
+ * handles share one connection cache and DNS cache through http_share. Connections to xcashd
+ * and the wallet therefore stay open between calls and between threads, so a round's RPCs reuse
+ * a warm keep-alive connection instead of paying a connect and a handle setup each time.
+ */
+static pthread_once_t http_once = PTHREAD_ONCE_INIT;
+static CURLSH* http_share = NULL;
+static pthread_mutex_t http_share_locks[CURL_LOCK_DATA_LAST];
+static pthread_key_t http_handle_key;
+static bool http_handle_key_ok = false;
+
+static pthread_mutex_t http_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static http_endpoint_stats_t http_stats[HTTP_STATS_MAX_ENDPOINTS];
+static size_t http_stats_used = 0;
+
+typedef struct {
+  char* data;
+  size_t capacity;
+  size_t size;
+  bool overflow;
+} http_result_buffer_t;
+
+static void http_share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr)
+{
+  (void)handle; (void)access; (void)userptr;
+  pthread_mutex_lock(&http_share_locks[data]);
+}
+
+static void http_share_unlock(CURL* handle, curl_lock_data data, void* userptr)
+{
+  (void)handle; (void)userptr;
+  pthread_mutex_unlock(&http_share_locks[data]);
+}
+
+static void http_handle_free(void* handle)
+{
+  curl_easy_cleanup((CURL*)handle);
+}
+
+static void http_client_init(void)
+{
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+  for (size_t i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+    pthread_mutex_init(&http_share_locks[i], NULL);
+  }
+  http_share = curl_share_init();
+  if (http_share) {
+    curl_share_setopt(http_share, CURLSHOPT_LOCKFUNC, http_share_lock);
+    curl_share_setopt(http_share, CURLSHOPT_UNLOCKFUNC, http_share_unlock);
+    curl_share_setopt(http_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(http_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  }
+  http_handle_key_ok = pthread_key_create(&http_handle_key, http_handle_free) == 0;
+}
+
+/* The calling thread's easy handle, reset to defaults; NULL if one cannot be created */
+static CURL* http_thread_handle(void)
+{
+  pthread_once(&http_once, http_client_init);
+  CURL* curl = http_handle_key_ok ? pthread_getspecific(http_handle_key) : NULL;
+  if (curl) {
+    curl_easy_reset(curl);  /* keeps the connection and DNS caches */
+  } else {
+    curl = curl_easy_init();
+    if (!curl) return NULL;
+    if (http_handle_key_ok && pthread_setspecific(http_handle_key, curl) != 0) {
+      curl_easy_cleanup(curl);
+      return NULL;
+    }
+  }
+  if (http_share) {
+    curl_easy_setopt(curl, CURLOPT_SHARE, http_share);
+  }
+  return curl;
+}
+
+static size_t http_result_write(void* contents, size_t size, size_t nmemb, void* userp)
+{
+  size_t total_size = size * nmemb;
+  http_result_buffer_t* buffer = (http_result_buffer_t*)userp;
+
+  if (buffer->size + total_size >= buffer->capacity) {
+    buffer->overflow = true;
+    return 0;  /* aborts the transfer with CURLE_WRITE_ERROR */
+  }
+  memcpy(buffer->data + buffer->size, contents, total_size);
+  buffer->size += total_size;
+  buffer->data[buffer->size] = '\0';
+  return total_size;
+}
+
+/* "port url method" where method is the JSON-RPC "method" member of the request body, if any */
+static void http_endpoint_name(char* out, size_t out_len, int port, const char* url, const char* data)
+{
+  char method[64] = "";
+  const char* m = data ? strstr(data, "\"method\"") : NULL;
+  if (m) {
+    m = strchr(m + 8, '"');
+    if (m) {
+      size_t n = 0;
+      for (m++; *m && *m != '"' && n < sizeof(method) - 1; m++) method[n++] = *m;
+      method[n] = '\0';
+    }
+  }
+  snprintf(out, out_len, "%d %s%s%s", port, url, method[0] ? " " : "", method);
+}
+
+static void http_record(int port, const char* url, const char* data, bool ok, bool reused, uint64_t elapsed_us)
+{
+  char name[HTTP_STATS_ENDPOINT_LENGTH];
+  http_endpoint_name(name, sizeof(name), port, url, data);
+
+  pthread_mutex_lock(&http_stats_lock);
+  http_endpoint_stats_t* st = NULL;
+  for (size_t i = 0; i < http_stats_used; i++) {
+    if (strcmp(http_stats[i].endpoint, name) == 0) {
+      st = &http_stats[i];
+      break;
+    }
+  }
+  if (!st && http_stats_used < HTTP_STATS_MAX_ENDPOINTS) {
+    st = &http_stats[http_stats_used++];
+    memset(st, 0, sizeof(*st));
+    snprintf(st->endpoint, sizeof(st->endpoint), "%s", name);
+  }
+  if (st) {
+    st->requests++;
+    if (!ok) st->failures++;
+    if (reused) st->reused++;
+    st->total_us += elapsed_us;
+    if (elapsed_us > st->max_us) st->max_us = elapsed_us;
+  }
+  pthread_mutex_unlock(&http_stats_lock);
+}
+
 /*---------------------------------------------------------------------------------------------------------
 Name: send_http_request
-Description: Sends a HTTP request
+Description: Sends a HTTP request on the calling thread's persistent handle, reusing an open connection
+             to the same host and port when one is available, and records the endpoint's latency
 Parameters:
   result - Where the result is stored
   HOST - The hostname or IP address
@@ -101,28 +240,21 @@ int send_http_request(char *result, size_t return_buffer_size, const char *host,
     CURLcode res;
     struct curl_slist *header_list = NULL;
 
-    // Initialize the response buffer
-    ResponseBuffer response = {malloc(1), 0};
-    if (!response.data) {
-        ERROR_PRINT("Memory allocation failed");
+    if (!result || return_buffer_size == 0) {
+        ERROR_PRINT("Invalid result buffer");
         return XCASH_ERROR;
     }
-    response.data[0] = '\0';
+    result[0] = '\0';
 
-    curl = curl_easy_init();
+    curl = http_thread_handle();
     if (!curl)
     {
         ERROR_PRINT("Failed to initialize libcurl");
-        free(response.data);
         return XCASH_ERROR;
     }
 
-    if (!result || return_buffer_size == 0) {
-        ERROR_PRINT("Invalid result buffer");
-        free(response.data);
-        curl_easy_cleanup(curl);
-        return XCASH_ERROR;
-    }
+    // The response goes straight into the caller's buffer
+    http_result_buffer_t response = {result, return_buffer_size, 0, false};
 
     // Construct full URL
     char full_url[256];
@@ -130,10 +262,12 @@ int send_http_request(char *result, size_t return_buffer_size, const char *host,
     DEBUG_PRINT("Making HTTP request to URL: %s", full_url);
     curl_easy_setopt(curl, CURLOPT_URL, full_url);
     curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L); // seconds
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, (long)timeout);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, http_result_write);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
     curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
 
     // Handle HTTP headers
     for (size_t i = 0; i < headers_length; i++)
@@ -151,51 +285,76 @@ int send_http_request(char *result, size_t return_buffer_size, const char *host,
 
     // Perform the request
     res = curl_easy_perform(curl);
-    if (res != CURLE_OK)
-    {
-        ERROR_PRINT("HTTP request failed: curl=%d (%s) url=%s", (int)res, curl_easy_strerror(res), full_url);
-        free(response.data);
-        curl_easy_cleanup(curl);
-        if (header_list) {
-            curl_slist_free_all(header_list);
-        }
-        return XCASH_ERROR;
-    }
 
-    DEBUG_PRINT("Curl result %s", response.data);
+    curl_off_t total_us = 0;
+    long new_connections = 0;
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total_us);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connections);
+    http_record(port, url, data, res == CURLE_OK, res == CURLE_OK && new_connections == 0,
+                total_us > 0 ? (uint64_t)total_us : 0);
 
-    // Validate response before copying
-    if (!response.data)
+    // the handle stays with the thread; only the request's header list is freed
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+    if (header_list)
+        curl_slist_free_all(header_list);
+
+    if (response.overflow)
     {
-        ERROR_PRINT("response.data is NULL");
-        free(response.data);
-        curl_easy_cleanup(curl);
-        if (header_list)
-            curl_slist_free_all(header_list);
+        ERROR_PRINT("Response data too large (more than %zu bytes)", return_buffer_size - 1);
+        result[0] = '\0';
         return XCASH_ERROR;
     }
 
-    size_t response_len = strlen(response.data);
-    DEBUG_PRINT("Response length: %zu", response_len);
-
-    if (response_len >= return_buffer_size)
+    if (res != CURLE_OK)
     {
-        ERROR_PRINT("Response data too large (%zu bytes)", response_len);
-        free(response.data);
-        curl_easy_cleanup(curl);
-        if (header_list)
-            curl_slist_free_all(header_list);
+        ERROR_PRINT("HTTP request failed: curl=%d (%s) url=%s", (int)res, curl_easy_strerror(res), full_url);
+        result[0] = '\0';
         return XCASH_ERROR;
     }
 
-    // Copy the response to result buffer
-    strncpy(result, response.data, return_buffer_size - 1);
-    result[return_buffer_size - 1] = '\0'; // Ensure null termination
-
-    // Cleanup
-    free(response.data);
-    curl_easy_cleanup(curl);
-    if (header_list)
-        curl_slist_free_all(header_list);
+    DEBUG_PRINT("Curl result %s", result);
+    DEBUG_PRINT("Response length: %zu", response.size);
     return XCASH_OK;
-}
\ No newline at end of file
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: http_client_get_stats
+Description: Copies the per-endpoint RPC counters
+Parameters:
+  out - Receives up to max endpoints
+  max - Capacity of out
+  reset - Clear the counters after copying them
+Return: The number of endpoints copied
+---------------------------------------------------------------------------------------------------------*/
+size_t http_client_get_stats(http_endpoint_stats_t* out, size_t max, bool reset)
+{
+  if (!out) return 0;
+  pthread_mutex_lock(&http_stats_lock);
+  size_t n = http_stats_used < max ? http_stats_used : max;
+  memcpy(out, http_stats, n * sizeof(*out));
+  if (reset) http_stats_used = 0;
+  pthread_mutex_unlock(&http_stats_lock);
+  return n;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+Name: log_http_client_stats
+Description: Logs and resets the per-endpoint RPC latency counters; endpoints with failures are logged as a warning
+---------------------------------------------------------------------------------------------------------*/
+void log_http_client_stats(void)
+{
+  http_endpoint_stats_t st[HTTP_STATS_MAX_ENDPOINTS];
+  size_t n = http_client_get_stats(st, HTTP_STATS_MAX_ENDPOINTS, true);
+  for (size_t i = 0; i < n; i++) {
+    double avg_ms = st[i].requests ? (double)st[i].total_us / (double)st[i].requests / 1000.0 : 0.0;
+    if (st[i].failures > 0) {
+      WARNING_PRINT("RPC %s: requests=%llu failures=%llu reused=%llu avg=%.2fms max=%.2fms", st[i].endpoint,
+                    (unsigned long long)st[i].requests, (unsigned long long)st[i].failures,
+                    (unsigned long long)st[i].reused, avg_ms, (double)st[i].max_us / 1000.0);
+    } else {
+      DEBUG_PRINT("RPC %s: requests=%llu failures=%llu reused=%llu avg=%.2fms max=%.2fms", st[i].endpoint,
+                  (unsigned long long)st[i].requests, (unsigned long long)st[i].failures,
+                  (unsigned long long)st[i].reused, avg_ms, (double)st[i].max_us / 1000.0);
+    }
+  }
+}
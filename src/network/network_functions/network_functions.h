@@ -7,9 +7,11 @@
 #include <curl/curl.h>
 #include <ctype.h>
 #include <arpa/inet.h>
+#include <pthread.h>
 #include "config.h"
 #include "globals.h"
 #include "macro_functions.h"
+#include "dns_cache.h"
 
 // Structure to capture response data
 typedef struct {
@@ -17,6 +19,16 @@ typedef struct {
     size_t size;
 } ResponseBuffer;
 
+// Per-endpoint RPC counters; an endpoint is "port url json-rpc-method"
+typedef struct {
+    char endpoint[HTTP_STATS_ENDPOINT_LENGTH];
+    uint64_t requests;
+    uint64_t failures;
+    uint64_t reused;      // served on an already open connection
+    uint64_t total_us;
+    uint64_t max_us;
+} http_endpoint_stats_t;
+
 #define IS_IP 1
 #define IS_HOSTNAME 2
 
@@ -26,5 +38,7 @@ int send_http_request(char *result, size_t return_buffer_size, const char *host,
     const char *method, const char **headers, size_t headers_length, 
     const char *data, int timeout);
 bool hostname_to_ip(const char* name, char* ip_out, size_t ip_out_len);
+size_t http_client_get_stats(http_endpoint_stats_t* out, size_t max, bool reset);
+void log_http_client_stats(void);
   
 #endif
\ No newline at end of file
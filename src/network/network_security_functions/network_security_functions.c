@@ -160,29 +160,24 @@ bool sign_txt_string(const char* txt_string, char* signature_out, size_t sig_out
  * Name: verify_data
  * Description:
  *   Verifies the authenticity and integrity of signed messages within the DPoPS protocol.
- *   Supports wallet-based JSON-RPC signatures.
+ *   Checks the XCK wallet signature in process (see wallet_verify_signature).
+ *   A message already verified this round is answered from the signature cache, after the registry
+ *   membership check and unless --signature-wallet-check is set.
  *
  * Parameters:
- *   message - The complete signed message (in JSON or delimited format).
- *   VERIFY_CURRENT_ROUND_PART_SETTING -
- *     Set to 1 to validate the "current_round_part" field against the expected round part.
- *     Set to 0 to skip round part validation.
+ *   env - The parsed signed message; env->type selects the round part waits.
  *
  * Return:
  *   0 if the signed data is not verified, 1 if successfull
 ---------------------------------------------------------------------------------------------------------*/
-int verify_data(const char* message, xcash_msg_t msg_type) {
-  const char* HTTP_HEADERS[] = {"Content-Type: application/json", "Accept: application/json"};
-  const size_t HTTP_HEADERS_LENGTH = sizeof(HTTP_HEADERS) / sizeof(HTTP_HEADERS[0]);
+int verify_data(const xcash_msg_env_t* env) {
+  const xcash_msg_t msg_type = env->type;
 
-  char data[SMALL_BUFFER_SIZE] = {0};
   char signature[XCASH_SIGN_DATA_LENGTH + 1] = {0};
   char ck_public_address[XCASH_WALLET_LENGTH + 1] = {0};
   char ck_round_part[3] = {0};
   char ck_previous_block_hash[BLOCK_HASH_LENGTH + 1] = {0};
   char raw_data[MEDIUM_BUFFER_SIZE] = {0};
-  char request[MEDIUM_BUFFER_SIZE * 2] = {0};
-  char response[MEDIUM_BUFFER_SIZE] = {0};
 
   // must wait at this point so it will pass type round_part check if trans is early, timing matters
   int wait_milliseconds = 0;
@@ -219,10 +214,10 @@ int verify_data(const char* message, xcash_msg_t msg_type) {
   }
 
   // Extract all required fields
-  if (parse_json_data(message, "XCASH_DPOPS_signature", signature, sizeof(signature)) != 1 ||
-      parse_json_data(message, "public_address", ck_public_address, sizeof(ck_public_address)) != 1 ||
-      parse_json_data(message, "v_previous_block_hash", ck_previous_block_hash, sizeof(ck_previous_block_hash)) != 1 ||
-      parse_json_data(message, "v_current_round_part", ck_round_part, sizeof(ck_round_part)) != 1) {
+  if (parse_msg_env_field(env, "XCASH_DPOPS_signature", signature, sizeof(signature)) != 1 ||
+      parse_msg_env_field(env, "public_address", ck_public_address, sizeof(ck_public_address)) != 1 ||
+      parse_msg_env_field(env, "v_previous_block_hash", ck_previous_block_hash, sizeof(ck_previous_block_hash)) != 1 ||
+      parse_msg_env_field(env, "v_current_round_part", ck_round_part, sizeof(ck_round_part)) != 1) {
     ERROR_PRINT("verify_data: Failed to parse one or more required fields."); 
     return XCASH_ERROR;
   }
@@ -241,13 +236,7 @@ int verify_data(const char* message, xcash_msg_t msg_type) {
     return XCASH_ERROR;
   }
 
-  snprintf(data, sizeof(data), "{\"public_address\":\"%s\"}", ck_public_address);
-  if (count_documents_in_collection(DATABASE_NAME, DB_COLLECTION_DELEGATES, data) == 0) {
-    WARNING_PRINT("The delegates public address in this transaction does not exist");
-    return XCASH_ERROR;
-  }
-
-  snprintf(raw_data, sizeof(raw_data), "%s", message);
+  snprintf(raw_data, sizeof(raw_data), "%s", env->data);
 
   char* sig_pos = strstr(raw_data, ",\"XCASH_DPOPS_signature\"");
   if (sig_pos) {
@@ -258,28 +247,14 @@ int verify_data(const char* message, xcash_msg_t msg_type) {
     return XCASH_ERROR;
   }
 
-  char escaped[MEDIUM_BUFFER_SIZE] = {0};
-  strncpy(escaped, raw_data, MEDIUM_BUFFER_SIZE);
-  string_replace(escaped, MEDIUM_BUFFER_SIZE, "\"", "\\\"");
-
-  // Prepare wallet verify request
-  snprintf(request, sizeof(request),
-           "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"method\":\"verify\",\"params\":{"
-           "\"data\":\"%s\","
-           "\"address\":\"%s\","
-           "\"signature\":\"%s\"}}",
-           escaped, ck_public_address, signature);
-
-  if (send_http_request(response, sizeof(response), XCASH_WALLET_IP, "/json_rpc", XCASH_WALLET_PORT,
-                        "POST", HTTP_HEADERS, HTTP_HEADERS_LENGTH,
-                        request, HTTP_TIMEOUT_SETTINGS) <= 0) {
-    ERROR_PRINT("verify_data: HTTP request failed");
+  // Membership is checked on every call, so a delegate removed mid-round is refused even for a cached signature
+  if (!delegates_registry_has(DELEGATES_KEY_ADDRESS, ck_public_address)) {
+    WARNING_PRINT("The delegates public address in this transaction does not exist");
     return XCASH_ERROR;
   }
 
-  // Parse response
-  char result[8] = {0};
-  if (parse_json_data(response, "result.good", result, sizeof(result)) == 1 && strcmp(result, "true") == 0) {
+  // A resent or replicated message already verified this round is answered from the signature cache
+  if (wallet_verify_signature(raw_data, ck_public_address, signature) == XCASH_OK) {
     return XCASH_OK;
   }
 
@@ -320,37 +295,33 @@ static bool is_local_address(const char* ip) {
 }
 
 /*---------------------------------------------------------------------------------------------------------
- * @brief Verifies a signed action message using the wallet's verify endpoint.
+ * @brief Verifies a signed action message against the sender's wallet signature.
  *
  * This function is used to validate the authenticity of a message that follows
  * a `|`-delimited format, where the final field is a signature generated by the
  * sender's wallet. The function:
  *   - Extracts the signature from the end of the message.
  *   - Extracts the public address from the 5th field (index 4).
- *   - Escapes the message contents for safe embedding in a JSON payload.
- *   - Constructs a JSON-RPC request and sends it to the wallet's `verify` endpoint.
- *   - Parses the response to confirm the validity of the signature.
+ *   - Verifies the signature over the message without it (see wallet_verify_signature).
  *
  * Expected message format:
  *   "TYPE|param1|param2|...|<public_address>|...|<signature>"
  *
- * @param message The original `|`-delimited message string including the signature.
+ * @param env The parsed message including the signature; env->type is the message type.
+ * @param client_ip The sender's IP address.
  *
  * @return XCASH_OK if the signature is valid, otherwise XCASH_ERROR.
 ---------------------------------------------------------------------------------------------------------*/
-int verify_action_data(const char* message, const char* client_ip, xcash_msg_t msg_type) {
-  const char* HTTP_HEADERS[] = {"Content-Type: application/json", "Accept: application/json"};
-  const size_t HTTP_HEADERS_LENGTH = sizeof(HTTP_HEADERS) / sizeof(HTTP_HEADERS[0]);
+int verify_action_data(const xcash_msg_env_t* env, const char* client_ip) {
+  const xcash_msg_t msg_type = env->type;
 
   char signature[XCASH_SIGN_DATA_LENGTH + 1] = {0};
   char ck_public_address[XCASH_WALLET_LENGTH + 1] = {0};
   char raw_data[MEDIUM_BUFFER_SIZE] = {0};
-  char request[MEDIUM_BUFFER_SIZE * 2] = {0};
-  char response[MEDIUM_BUFFER_SIZE] = {0};
 
   // Extract all required fields
-  if (parse_json_data(message, "signature", signature, sizeof(signature)) != 1 ||
-      parse_json_data(message, "public_address", ck_public_address, sizeof(ck_public_address)) != 1) {
+  if (parse_msg_env_field(env, "signature", signature, sizeof(signature)) != 1 ||
+      parse_msg_env_field(env, "public_address", ck_public_address, sizeof(ck_public_address)) != 1) {
     ERROR_PRINT("verify_data: Failed to parse one or more required fields.");
     return XCASH_ERROR;
   }
@@ -363,7 +334,7 @@ int verify_action_data(const char* message, const char* client_ip, xcash_msg_t m
     return XCASH_OK;
   }
 
-  snprintf(raw_data, sizeof(raw_data), "%s", message);
+  snprintf(raw_data, sizeof(raw_data), "%s", env->data);
 
   char* sig_pos = strstr(raw_data, ",\"signature\"");
   if (sig_pos) {
@@ -374,28 +345,7 @@ int verify_action_data(const char* message, const char* client_ip, xcash_msg_t m
     return XCASH_ERROR;
   }
 
-  char escaped[MEDIUM_BUFFER_SIZE] = {0};
-  strncpy(escaped, raw_data, MEDIUM_BUFFER_SIZE);
-  string_replace(escaped, MEDIUM_BUFFER_SIZE, "\"", "\\\"");
-
-  // Prepare wallet verify request
-  snprintf(request, sizeof(request),
-           "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"method\":\"verify\",\"params\":{"
-           "\"data\":\"%s\","
-           "\"address\":\"%s\","
-           "\"signature\":\"%s\"}}",
-           escaped, ck_public_address, signature);
-
-  if (send_http_request(response, sizeof(response), XCASH_WALLET_IP, "/json_rpc", XCASH_WALLET_PORT,
-                        "POST", HTTP_HEADERS, HTTP_HEADERS_LENGTH,
-                        request, HTTP_TIMEOUT_SETTINGS) <= 0) {
-    ERROR_PRINT("verify_data: HTTP request failed");
-    return XCASH_ERROR;
-  }
-
-  // Parse response
-  char result[8] = {0};
-  if (parse_json_data(response, "result.good", result, sizeof(result)) == 1 && strcmp(result, "true") == 0) {
+  if (wallet_verify_signature(raw_data, ck_public_address, signature) == XCASH_OK) {
     return XCASH_OK;
   }
 
@@ -420,22 +370,21 @@ static int sockaddr_to_numhost(const struct sockaddr* sa, char* out, size_t outs
  *   of a known delegate from the current verifier list.
  *
  * Parameters:
- *   message - The complete message (in JSON or delimited key-value format).
+ *   env - The parsed message.
  *   client_ip - The IP address from which the message was received.
  *
  * Return:
  *   XCASH_OK (1) if the IP matches a known delegate and (optionally) round part is valid.
  *   XCASH_ERROR (0) if the delegate is unknown, the IP does not match, or data is invalid.
 ---------------------------------------------------------------------------------------------------------*/
-int verify_the_ip(const char* message, const char* client_ip, bool seed_only) {
-  if (!message || !client_ip || client_ip[0] == '\0') {
+int verify_the_ip(const xcash_msg_env_t* env, const char* client_ip, bool seed_only) {
+  if (!env || !client_ip || client_ip[0] == '\0') {
     ERROR_PRINT("verify_ip: Null or empty client_ip passed");
     return XCASH_ERROR;
   }
 
   char ck_public_address[XCASH_WALLET_LENGTH + 1] = {0};
   char ip_address_trans[IP_LENGTH + 1] = {0};
-  char filter_json[256] = {0};
   char resolved_ip[INET_ADDRSTRLEN] = {0};   // v4 only, as before
   char client_canon[INET_ADDRSTRLEN] = {0};  // v4 only, as before
 
@@ -446,7 +395,7 @@ int verify_the_ip(const char* message, const char* client_ip, bool seed_only) {
   }
 
   // Extract the public address
-  if (parse_json_data(message, "public_address", ck_public_address, sizeof(ck_public_address)) != XCASH_OK) {
+  if (parse_msg_env_field(env, "public_address", ck_public_address, sizeof(ck_public_address)) != XCASH_OK) {
     ERROR_PRINT("verify_ip: Failed to parse public_address field");
     return XCASH_ERROR;
   }
@@ -458,11 +407,9 @@ int verify_the_ip(const char* message, const char* client_ip, bool seed_only) {
     }
   }
 
-  // Get the IP/hostname from DB
-  snprintf(filter_json, sizeof(filter_json), "{ \"public_address\": \"%s\" }", ck_public_address);
-  if (read_document_field_from_collection(DATABASE_NAME, DB_COLLECTION_DELEGATES,
-                                          filter_json, "IP_address",
-                                          ip_address_trans, sizeof(ip_address_trans)) != XCASH_OK) {
+  // Get the IP/hostname from the delegates registry
+  if (!delegates_registry_get_utf8(DELEGATES_KEY_ADDRESS, ck_public_address, "IP_address",
+                                   ip_address_trans, sizeof(ip_address_trans))) {
     ERROR_PRINT("Delegate '%s' not found in DB or missing IP_address", ck_public_address);
     return XCASH_ERROR;
   }
@@ -473,11 +420,11 @@ int verify_the_ip(const char* message, const char* client_ip, bool seed_only) {
     struct addrinfo hints = {0}, *cres = NULL;
     hints.ai_family = AF_INET;
     hints.ai_socktype = SOCK_STREAM;
-    if (getaddrinfo(client_ip, NULL, &hints, &cres) == 0 && cres) {
+    if (dns_cache_getaddrinfo(client_ip, NULL, &hints, &cres) == 0 && cres) {
       if (!sockaddr_to_numhost(cres->ai_addr, client_canon, sizeof(client_canon))) {
         snprintf(client_canon, sizeof(client_canon), "%s", client_ip);
       }
-      freeaddrinfo(cres);
+      dns_cache_freeaddrinfo(cres);
     } else {
       snprintf(client_canon, sizeof(client_canon), "%s", client_ip);
     }
@@ -488,7 +435,7 @@ int verify_the_ip(const char* message, const char* client_ip, bool seed_only) {
   hints.ai_family = AF_INET;
   hints.ai_socktype = SOCK_STREAM;
 
-  int gai_ret = getaddrinfo(ip_address_trans, NULL, &hints, &res);
+  int gai_ret = dns_cache_getaddrinfo(ip_address_trans, NULL, &hints, &res);
   bool match = false;
 
   if (gai_ret == 0 && res != NULL) {
@@ -501,9 +448,9 @@ int verify_the_ip(const char* message, const char* client_ip, bool seed_only) {
         break;
       }
     }
-    freeaddrinfo(res);
+    dns_cache_freeaddrinfo(res);
   } else {
-    WARNING_PRINT("getaddrinfo failed for '%s': %s", ip_address_trans, gai_strerror(gai_ret));
+    WARNING_PRINT("DNS resolution failed for '%s': %s", ip_address_trans, gai_strerror(gai_ret));
     // fallback: treat DB value as a literal IPv4 and compare
     snprintf(resolved_ip, sizeof(resolved_ip), "%s", ip_address_trans);
     match = (strcmp(resolved_ip, client_canon) == 0);
@@ -519,31 +466,19 @@ int verify_the_ip(const char* message, const char* client_ip, bool seed_only) {
 }
 
 /*---------------------------------------------------------------------------------------------------------
- * Name: wallet_verify_signature
+ * Name: wallet_rpc_verify_signature
  *
  * Description:
  *   Calls the local XCASH wallet JSON-RPC `verify` to check that `in_signature` is valid
- *   for (`sign_str`, `in_public_address`). Returns XCASH_OK on valid, XCASH_ERROR otherwise.
- *
- * Parameters:
- *   sign_str          - Canonical string that was signed (exact bytes).
- *   in_public_address - XCK public address of the claimed signer.
- *   in_signature      - Signature text to verify.
+ *   for (`sign_str`, `in_public_address`). Only used to cross-check the in-process verifier.
  *
  * Return:
  *   XCASH_OK    -> wallet says signature is valid
- *   XCASH_ERROR -> HTTP/parse error or wallet says invalid
- *
- * Notes:
- *   - If sign_str may contain quotes/backslashes/newlines, JSON-escape it before calling.
- *   - Uses XCASH_WALLET_IP / XCASH_WALLET_PORT / HTTP_TIMEOUT_SETTINGS.
+ *   XCASH_ERROR -> wallet says invalid
+ *   -1          -> HTTP/parse error, no answer
  *---------------------------------------------------------------------------------------------------------*/
-int wallet_verify_signature(const char *sign_str, const char *in_public_address, const char *in_signature)
+static int wallet_rpc_verify_signature(const char *sign_str, const char *in_public_address, const char *in_signature)
 {
-  if (!sign_str || !in_public_address || !in_signature) {
-    return XCASH_ERROR;
-  }
-
   static const char *HTTP_HEADERS[] = {
     "Content-Type: application/json",
     "Accept: application/json"
@@ -551,18 +486,21 @@ int wallet_verify_signature(const char *sign_str, const char *in_public_address,
   static const size_t HTTP_HEADERS_LENGTH =
       sizeof(HTTP_HEADERS) / sizeof(HTTP_HEADERS[0]);
 
+  char escaped[MEDIUM_BUFFER_SIZE] = {0};
   char request[MEDIUM_BUFFER_SIZE * 2] = {0};
   char response[MEDIUM_BUFFER_SIZE] = {0};
 
-  // NOTE: JSON-escape sign_str/address/signature if they can contain special chars.
+  snprintf(escaped, sizeof(escaped), "%s", sign_str);
+  string_replace(escaped, sizeof(escaped), "\"", "\\\"");
+
   int nw = snprintf(request, sizeof(request),
       "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"method\":\"verify\",\"params\":{"
         "\"data\":\"%s\","
         "\"address\":\"%s\","
         "\"signature\":\"%s\"}}",
-      sign_str, in_public_address, in_signature);
+      escaped, in_public_address, in_signature);
   if (nw < 0 || (size_t)nw >= sizeof(request)) {
-    return XCASH_ERROR;
+    return -1;
   }
 
   int sent = send_http_request(response, sizeof(response),
@@ -570,18 +508,72 @@ int wallet_verify_signature(const char *sign_str, const char *in_public_address,
                                "POST", HTTP_HEADERS, HTTP_HEADERS_LENGTH,
                                request, HTTP_TIMEOUT_SETTINGS);
   if (sent <= 0) {
-    return XCASH_ERROR;
+    return -1;
   }
 
   char result[8] = {0};
-  int parsed_ok = parse_json_data(response, "result.good", result, sizeof(result));
-  if (parsed_ok != XCASH_OK) {
-    return XCASH_ERROR;
+  if (parse_json_data(response, "result.good", result, sizeof(result)) != XCASH_OK) {
+    return -1;
   }
 
   return (strcmp(result, "true") == 0) ? XCASH_OK : XCASH_ERROR;
 }
 
+/*---------------------------------------------------------------------------------------------------------
+ * Name: wallet_verify_signature
+ *
+ * Description:
+ *   Checks that `in_signature` is a valid XCK wallet signature of `sign_str` by `in_public_address`.
+ *   The check runs in process (xcash_verify_signature). With --signature-wallet-check the local
+ *   wallet's `verify` RPC is asked as well; a disagreement is logged and the wallet's answer wins.
+ *   Valid signatures are remembered in the signature cache and answered from it on repeat; the cache
+ *   is bypassed with --signature-wallet-check so cached signatures are cross-checked too.
+ *
+ * Parameters:
+ *   sign_str          - Canonical string that was signed (exact bytes).
+ *   in_public_address - XCK public address of the claimed signer.
+ *   in_signature      - Signature text to verify.
+ *
+ * Return:
+ *   XCASH_OK    -> signature is valid
+ *   XCASH_ERROR -> signature is invalid or malformed
+ *---------------------------------------------------------------------------------------------------------*/
+int wallet_verify_signature(const char *sign_str, const char *in_public_address, const char *in_signature)
+{
+  if (!sign_str || !in_public_address || !in_signature) {
+    return XCASH_ERROR;
+  }
+
+  // The differential mode bypasses the cache so that every signature reaches the wallet comparison
+  size_t sign_len = strlen(sign_str);
+  sig_cache_key_t cache_key;
+  bool cacheable = !signature_wallet_check &&
+                   signature_cache_key(sign_str, sign_len, in_public_address, in_signature, &cache_key);
+  if (cacheable && signature_cache_lookup(&cache_key)) {
+    return XCASH_OK;
+  }
+
+  int result = xcash_verify_signature(sign_str, sign_len, in_public_address, in_signature);
+  if (signature_wallet_check) {
+    int wallet = wallet_rpc_verify_signature(sign_str, in_public_address, in_signature);
+    if (wallet < 0) {
+      WARNING_PRINT("Signature check: wallet verify unavailable, using in-process result for %.12s...", in_public_address);
+    } else {
+      if (wallet != result) {
+        WARNING_PRINT("Signature check mismatch for %.12s...: in-process=%s wallet=%s, data=%s",
+                      in_public_address, result == XCASH_OK ? "good" : "bad", wallet == XCASH_OK ? "good" : "bad", sign_str);
+      }
+      result = wallet;
+    }
+  }
+
+  // Only positive results are kept; data carrying the previous block hash is only reused within this round
+  if (result == XCASH_OK && cacheable) {
+    signature_cache_insert(&cache_key, strstr(sign_str, "\"v_previous_block_hash\"") != NULL);
+  }
+  return result;
+}
+
 /*---------------------------------------------------------------------------------------------------------
   dnssec_helper.c — DNSSEC helper for X-Cash
 
@@ -803,18 +795,18 @@ bool validate_server_IP(void) {
   hints.ai_family = AF_INET;  // IPv4
   hints.ai_socktype = SOCK_STREAM;
 
-  int gai_ret = getaddrinfo(ip_address, NULL, &hints, &res);
+  int gai_ret = dns_cache_getaddrinfo(ip_address, NULL, &hints, &res);
   if (gai_ret == 0 && res != NULL) {
     struct sockaddr_in* sa = (struct sockaddr_in*)res->ai_addr;
     if (!inet_ntop(AF_INET, &sa->sin_addr, delegate_ip, sizeof(delegate_ip))) {
       ERROR_PRINT("validate_server_IP: inet_ntop failed for delegate '%s' (%s)",
                   xcash_wallet_public_address, ip_address);
-      freeaddrinfo(res);
+      dns_cache_freeaddrinfo(res);
       return false;
     }
-    freeaddrinfo(res);
+    dns_cache_freeaddrinfo(res);
   } else {
-    // if getaddrinfo fails, assume ip_address is already a numeric IPv4 string
+    // if resolution fails, assume ip_address is already a numeric IPv4 string
     strncpy(delegate_ip, ip_address, sizeof(delegate_ip) - 1);
     delegate_ip[sizeof(delegate_ip) - 1] = '\0';
   }
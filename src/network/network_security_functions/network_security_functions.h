@@ -23,12 +23,14 @@
 #include "string_functions.h"
 #include "VRF_functions.h"
 #include "node_functions.h"
+#include "signature_functions.h"
+#include "signature_cache.h"
 
 void handle_error(const char *function_name, const char *message, char *buf1, char *buf2, char *buf3);
 int sign_data(char *message);
-int verify_data(const char *message, xcash_msg_t msg_type);
-int verify_action_data(const char *message, const char *client_ip, xcash_msg_t msg_type);
-int verify_the_ip(const char *message, const char *client_ip, bool seed_only);
+int verify_data(const xcash_msg_env_t *env);
+int verify_action_data(const xcash_msg_env_t *env, const char *client_ip);
+int verify_the_ip(const xcash_msg_env_t *env, const char *client_ip, bool seed_only);
 bool sign_txt_string(const char* txt_string, char* signature_out, size_t sig_out_len);
 int wallet_verify_signature(const char *sign_str, const char *in_public_address, const char *in_signature);
 dnssec_ctx_t* dnssec_init(void);
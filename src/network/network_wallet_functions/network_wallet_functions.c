@@ -87,9 +87,12 @@ int check_reserve_proofs(uint64_t vote_amount_atomic, const char* PUBLIC_ADDRESS
   char good[8] = {0};
   char spent[32] = {0};
   char total_str[64] = {0};
-  if (parse_json_data(response, "result.good", good, sizeof(good)) == 0 ||
-      parse_json_data(response, "result.spent", spent, sizeof(spent)) == 0 ||
-      parse_json_data(response, "result.total", total_str, sizeof(total_str)) == 0) {
+  json_field_t fields[] = {
+    {"result.good", good, sizeof(good), false},
+    {"result.spent", spent, sizeof(spent), false},
+    {"result.total", total_str, sizeof(total_str), false},
+  };
+  if (parse_json_fields(response, fields, sizeof(fields) / sizeof(fields[0])) == 0) {
     ERROR_PRINT("Reserve proof validation: missing fields");
     return XCASH_ERROR;
   }
@@ -194,9 +194,46 @@ xcash_msg_t get_message_type(const char* data) {
   return XMSG_NONE;  // Default case if no match is found
 }
 
+/*---------------------------------------------------------------------------------------------------------
+Name: xcash_msg_env_parse
+Description: Parses a server message once into an envelope holding the cJSON tree, message_settings,
+  message type and public_address. Fields are read afterwards with parse_msg_env_field.
+Parameters:
+  env - The envelope to fill; env->root must be freed with cJSON_Delete on success
+  data - The NUL terminated message
+Return: true on success, false if the message is not JSON or has no message_settings string
+---------------------------------------------------------------------------------------------------------*/
+bool xcash_msg_env_parse(xcash_msg_env_t* env, const char* data) {
+  memset(env, 0, sizeof(*env));
+  env->data = data;
+  env->root = cJSON_Parse(data);
+  if (!env->root) {
+    ERROR_PRINT("Invalid message received, JSON parsing error in handle_srv_message: %s", cJSON_GetErrorPtr());
+    return false;
+  }
+
+  cJSON* settings_obj = cJSON_GetObjectItemCaseSensitive(env->root, "message_settings");
+  if (!cJSON_IsString(settings_obj) || (settings_obj->valuestring == NULL)) {
+    ERROR_PRINT("Invalid message received, missing or invalid message_settings");
+    cJSON_Delete(env->root);
+    env->root = NULL;
+    return false;
+  }
+  snprintf(env->message_settings, sizeof(env->message_settings), "%s", settings_obj->valuestring);
+  env->type = get_message_type(env->message_settings);
+
+  cJSON* address_obj = cJSON_GetObjectItemCaseSensitive(env->root, "public_address");
+  if (cJSON_IsString(address_obj) && address_obj->valuestring != NULL) {
+    snprintf(env->public_address, sizeof(env->public_address), "%s", address_obj->valuestring);
+  }
+  return true;
+}
+
 //
 //  Handle Server Messages
 //
+static void dispatch_srv_message(const xcash_msg_env_t* env, server_client_t* client);
+
 void handle_srv_message(const char* data, size_t length, server_client_t* client) {
   if (data == NULL || length == 0) {
     ERROR_PRINT("Message received by server is null.");
@@ -210,31 +247,26 @@ void handle_srv_message(const char* data, size_t length, server_client_t* client
 
   DEBUG_PRINT("Processing message from client IP: %s", client->client_ip);
 
-  char trans_type[128] = {0};
-  if (strstr(data, "{") && strstr(data, "}")) {
-    cJSON* json_obj = cJSON_Parse(data);
-    if (!json_obj) {
-      ERROR_PRINT("Invalid message received, JSON parsing error in handle_srv_message: %s", cJSON_GetErrorPtr());
-      DEBUG_PRINT("Client IP: %s Message: %s", client->client_ip, data);
-      return;
-    }
-
-    cJSON* settings_obj = cJSON_GetObjectItemCaseSensitive(json_obj, "message_settings");
-    if (!cJSON_IsString(settings_obj) || (settings_obj->valuestring == NULL)) {
-      ERROR_PRINT("Invalid message received, missing or invalid message_settings");
-      cJSON_Delete(json_obj);
-      return;
-    }
-
-    snprintf(trans_type, sizeof(trans_type), "%s", settings_obj->valuestring);
-    cJSON_Delete(json_obj);
-
-  } else {
+  if (!strstr(data, "{") || !strstr(data, "}")) {
     ERROR_PRINT("Message does not match expected JSON format");
     return;
   }
- 
-  xcash_msg_t msg_type = get_message_type(trans_type);
+
+  // Parse once; validators and handlers read their fields from the envelope
+  xcash_msg_env_t env;
+  if (!xcash_msg_env_parse(&env, data)) {
+    DEBUG_PRINT("Client IP: %s Message: %s", client->client_ip, data);
+    return;
+  }
+
+  dispatch_srv_message(&env, client);
+  cJSON_Delete(env.root);
+}
+
+static void dispatch_srv_message(const xcash_msg_env_t* env, server_client_t* client) {
+  const char* data = env->data;
+  const char* trans_type = env->message_settings;
+  xcash_msg_t msg_type = env->type;
 
   // Validate the IP if not one of the following
   if ((msg_type != XMSG_NODES_TO_BLOCK_VERIFIERS_REGISTER_DELEGATE) &&
@@ -244,14 +276,14 @@ void handle_srv_message(const char* data, size_t length, server_client_t* client
       (msg_type != XMSG_NODES_TO_BLOCK_VERIFIERS_CHECK_VOTE_STATUS)) {
     // Maintenance tran must come from seed
     bool ckSeed = (msg_type == XMSG_SEED_TO_NODES_MAINTENANCE);
-    if (verify_the_ip(data, client->client_ip, ckSeed) != XCASH_OK) {
+    if (verify_the_ip(env, client->client_ip, ckSeed) != XCASH_OK) {
       ERROR_PRINT("IP check failed for msg_type=%s from %s", trans_type, client->client_ip);
       return;
     }
   }
 
   if (is_walletsign_type(msg_type)) {
-    if (verify_data(data, msg_type) == XCASH_ERROR) {
+    if (verify_data(env) == XCASH_ERROR) {
       if (startup_complete) {
         WARNING_PRINT("Failed to validate message sign data");
       }
@@ -260,7 +292,7 @@ void handle_srv_message(const char* data, size_t length, server_client_t* client
   }
 
   if (is_walletsign_action_type(msg_type)) {
-    if (verify_action_data(data, client->client_ip, msg_type) == XCASH_ERROR) {
+    if (verify_action_data(env, client->client_ip) == XCASH_ERROR) {
       ERROR_PRINT("Failed to validate action message sign data");
       return;
     }
@@ -270,57 +302,57 @@ void handle_srv_message(const char* data, size_t length, server_client_t* client
 
     case XMSG_BLOCK_VERIFIERS_TO_BLOCK_VERIFIERS_VRF_DATA:
       if (server_limit_IP_addresses(LIMIT_CHECK, client->client_ip) == 1) {
-        server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(data);
+        server_receive_data_socket_block_verifiers_to_block_verifiers_vrf_data(env);
         server_limit_IP_addresses(LIMIT_REMOVE, client->client_ip);
       }
       break;
 
     case XMSG_NODES_TO_NODES_VOTE_MAJORITY_RESULTS:
       if (server_limit_IP_addresses(LIMIT_CHECK, client->client_ip) == 1) {        
-        server_receive_data_socket_node_to_node_vote_majority(data);
-        server_limit_IP_addresses(LIMIT_REMOVE, data);
+        server_receive_data_socket_node_to_node_vote_majority(env);
+        server_limit_IP_addresses(LIMIT_REMOVE, client->client_ip);
       }
       break;
 
     case XMSG_NODE_TO_NETWORK_DATA_NODES_GET_CURRENT_BLOCK_VERIFIERS_LIST:
-      if (server_limit_public_addresses(LIMIT_CHECK, data) == 1) {
+      if (server_limit_public_addresses(LIMIT_CHECK, env) == 1) {
         server_receive_data_socket_node_to_network_data_nodes_get_current_block_verifiers_list(client);
-        server_limit_public_addresses(LIMIT_REMOVE, data);
+        server_limit_public_addresses(LIMIT_REMOVE, env);
       }
       break;
 
     case XMSG_NODES_TO_BLOCK_VERIFIERS_REGISTER_DELEGATE:
-      if (server_limit_public_addresses(LIMIT_CHECK, data) == 1) {
+      if (server_limit_public_addresses(LIMIT_CHECK, env) == 1) {
         server_receive_data_socket_nodes_to_block_verifiers_register_delegates(client, data);
-        server_limit_public_addresses(LIMIT_REMOVE, data);
+        server_limit_public_addresses(LIMIT_REMOVE, env);
       }
       break;
 
     case XMSG_NODES_TO_BLOCK_VERIFIERS_VOTE:
-      if (server_limit_public_addresses(LIMIT_CHECK, data) == 1) {
+      if (server_limit_public_addresses(LIMIT_CHECK, env) == 1) {
         server_receive_data_socket_node_to_block_verifiers_add_reserve_proof(client, data);
-        server_limit_public_addresses(LIMIT_REMOVE, data);
+        server_limit_public_addresses(LIMIT_REMOVE, env);
       }
       break;
 
     case XMSG_NODES_TO_BLOCK_VERIFIERS_REVOTE:
-      if (server_limit_public_addresses(LIMIT_CHECK, data) == 1) {
+      if (server_limit_public_addresses(LIMIT_CHECK, env) == 1) {
         server_receive_data_socket_node_to_block_verifiers_add_reserve_proof(client, data);
-        server_limit_public_addresses(LIMIT_REMOVE, data);
+        server_limit_public_addresses(LIMIT_REMOVE, env);
       }
       break;
 
     case XMSG_NODES_TO_BLOCK_VERIFIERS_CHECK_VOTE_STATUS:
-      if (server_limit_public_addresses(LIMIT_CHECK, data) == 1) {
+      if (server_limit_public_addresses(LIMIT_CHECK, env) == 1) {
         server_receive_data_socket_node_to_block_verifiers_check_vote_status(client, data);
-        server_limit_public_addresses(LIMIT_REMOVE, data);
+        server_limit_public_addresses(LIMIT_REMOVE, env);
       }
       break;
 
     case XMSG_NODES_TO_BLOCK_VERIFIERS_UPDATE_DELEGATE:
-      if (server_limit_public_addresses(LIMIT_CHECK, data) == 1) {
+      if (server_limit_public_addresses(LIMIT_CHECK, env) == 1) {
         server_receive_data_socket_nodes_to_block_verifiers_update_delegates(client, data);
-        server_limit_public_addresses(LIMIT_REMOVE, data);
+        server_limit_public_addresses(LIMIT_REMOVE, env);
       }
       break;
 
@@ -32,6 +32,7 @@ xcash_msg_t get_message_type(const char* data);
 int split(const char* str, char delimiter, char*** result_elements);
 void cleanup_char_list(char** element_list);
 
+bool xcash_msg_env_parse(xcash_msg_env_t* env, const char* data);
 void handle_srv_message(const char *data, size_t length, server_client_t* client);
 
 #endif  // XCASH_MESSAGE_H
\ No newline at end of file
@@ -1,17 +1,9 @@
 #include "xcash_net.h"
 
-// Sends a message to designated hosts
-bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***reply) {
-  bool result = false;
-  if (!reply) {
-    DEBUG_PRINT("reply parameter can't be NULL");
-    return false;
-  }
-  *reply = NULL;
-
+// Builds the NULL terminated host list for a destination; the caller frees the array
+static const char **xnet_dest_hosts(xcash_dest_t dest, int *port) {
   // Host array placeholders
   const char **hosts = NULL;
-  response_t **responses = NULL;
   bool send_to_payout = false;
 
   switch (dest) {
@@ -19,7 +11,7 @@ bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***
       const char **all_hosts = malloc((network_data_nodes_amount + 1) * sizeof(char *));
       if (!all_hosts) {
         ERROR_PRINT("Failed to allocate memory for all_hosts");
-        return false;  // Handle memory allocation failure
+        return NULL;  // Handle memory allocation failure
       }
 
       int i = 0, di = 0;  // `di` is for destination index to compact the array
@@ -46,7 +38,7 @@ bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***
       const char **delegates_online_hosts_xseeds = malloc((BLOCK_VERIFIERS_TOTAL_AMOUNT + 1) * sizeof(char *));
       if (!delegates_online_hosts_xseeds) {
         ERROR_PRINT("Failed to allocate memory for delegates_online_hosts");
-        return false;
+        return NULL;
       }
 
       size_t host_index = 0;
@@ -70,7 +62,7 @@ bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***
       const char **delegates_online_hosts_xseeds = malloc((BLOCK_VERIFIERS_TOTAL_AMOUNT + 1) * sizeof(char *));
       if (!delegates_online_hosts_xseeds) {
         ERROR_PRINT("Failed to allocate memory for delegates_online_hosts");
-        return false;
+        return NULL;
       }
 
       size_t host_index = 0;
@@ -94,7 +86,7 @@ bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***
       const char **delegates_hosts = malloc((BLOCK_VERIFIERS_TOTAL_AMOUNT + 1) * sizeof(char *));
       if (!delegates_hosts) {
         ERROR_PRINT("Failed to allocate memory for delegates_hosts");
-        return false;  // Handle memory allocation failure
+        return NULL;  // Handle memory allocation failure
       }
 
       size_t host_index = 0;
@@ -122,7 +114,7 @@ bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***
       const char **delegates_online_committee = malloc((max_entries + 1) * sizeof(char *));
       if (!delegates_online_committee) {
         ERROR_PRINT("Failed to allocate memory for delegates_online_committee");
-        return false;
+        return NULL;
       }
 
       size_t host_index = 0;
@@ -153,22 +145,37 @@ bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***
 
     default: {
       ERROR_PRINT("Invalid xcash_dest_t: %d", dest);
-      return false;
+      return NULL;
     }
   }
 
   if (!hosts) {
     ERROR_PRINT("Host array is NULL or not initialized properly.");
+    return NULL;
+  }
+
+  *port = send_to_payout ? XCASH_PAYOUTS_PORT : XCASH_DPOPS_PORT;
+  return hosts;
+}
+
+// Sends a message to designated hosts
+bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***reply) {
+  bool result = false;
+  if (!reply) {
+    DEBUG_PRINT("reply parameter can't be NULL");
     return false;
   }
+  *reply = NULL;
 
-  if (send_to_payout) {
-    responses = send_multi_request(hosts, XCASH_PAYOUTS_PORT, message);
-  } else {
-    responses = send_multi_request(hosts, XCASH_DPOPS_PORT, message);
+  int port = XCASH_DPOPS_PORT;
+  const char **hosts = xnet_dest_hosts(dest, &port);
+  if (!hosts) {
+    return false;
   }
 
-  if (hosts) free((void*)hosts);
+  response_t **responses = send_multi_request(hosts, port, message);
+
+  free((void*)hosts);
   if (responses) {
     result = true;
   }
@@ -176,6 +183,35 @@ bool xnet_send_data_multi(xcash_dest_t dest, const char *message, response_t ***
   return result;
 }
 
+// Sends a message to designated hosts and returns once min_ok of them accepted it or timeout_ms passed.
+// The remaining hosts finish in the background; read their final status with multi_request_results().
+bool xnet_send_data_multi_quorum(xcash_dest_t dest, const char *message, size_t min_ok, long timeout_ms,
+                                 multi_request_t **request) {
+  if (!request) {
+    DEBUG_PRINT("request parameter can't be NULL");
+    return false;
+  }
+  *request = NULL;
+
+  int port = XCASH_DPOPS_PORT;
+  const char **hosts = xnet_dest_hosts(dest, &port);
+  if (!hosts) {
+    return false;
+  }
+
+  multi_request_t *req = send_multi_request_start(hosts, port, message);
+  free((void*)hosts);
+  if (!req) {
+    return false;
+  }
+
+  size_t ok = multi_request_wait(req, min_ok, timeout_ms);
+  DEBUG_PRINT("Quorum broadcast: %zu accepted, %zu needed", ok, min_ok);
+
+  *request = req;
+  return true;
+}
+
 // Wrappers for sending messages with parameter lists or variadic arguments
 bool send_message_param_list(xcash_dest_t dest, xcash_msg_t msg, response_t ***reply, const char **pair_params) {
   bool result = false;
@@ -21,6 +21,8 @@ typedef enum XNET_DEST{
 } xcash_dest_t;
 
 bool xnet_send_data_multi(xcash_dest_t dest, const char* message, response_t ***reply);
+bool xnet_send_data_multi_quorum(xcash_dest_t dest, const char* message, size_t min_ok, long timeout_ms,
+                                 multi_request_t **request);
 bool send_message_param_list(xcash_dest_t dest, xcash_msg_t msg, response_t ***reply, const char** pair_params);
 bool send_message_param(xcash_dest_t dest, xcash_msg_t msg, response_t ***reply, ...);
 bool send_message(xcash_dest_t dest, xcash_msg_t msg, response_t ***reply);
@@ -41,7 +41,8 @@ int read_organize_delegates(delegates_t* delegates, size_t* delegates_count_resu
   bson_error_t error;
   bson_t* delegates_db_data = bson_new();
 
-  if (!db_find_all_doc(DATABASE_NAME, DB_COLLECTION_DELEGATES, delegates_db_data, &error)) {
+  if (!delegates_registry_export(delegates_db_data) &&
+      !db_find_all_doc(DATABASE_NAME, DB_COLLECTION_DELEGATES, delegates_db_data, &error)) {
     FATAL_ERROR_EXIT("Failed to read delegates from db. %s", error.message);
     bson_destroy(delegates_db_data);
     return XCASH_ERROR;
@@ -15,6 +15,7 @@ BRIGHT_WHITE_TEXT("General Options:\n")
 BRIGHT_WHITE_TEXT("Debug Options:\n")
 "  --log-level                             The log-level displays log messages based on the level passed:\n"
 "                                          Critial - 0, Error - 1, Warning - 2, Info - 3, Debug - 4\n"
+"  --signature-wallet-check                Also verify every wallet signature (cache bypassed) with the wallet RPC and log any disagreement.\n"
 "\n"
 BRIGHT_WHITE_TEXT("Website Options: (deprecated)\n")
 "  --delegates-website                    Run the delegate's website.\n"
@@ -23,6 +24,8 @@ BRIGHT_WHITE_TEXT("Website Options: (deprecated)\n")
 BRIGHT_WHITE_TEXT("Advanced Options:\n")
 "  --generate-key                         Generate public/private key for block verifiers.\n"
 "  --quorum-bootstrap                     Ensures quorum before checking sync status, only used to start things rolling when first starting chain.\n"
+"  --framed-messages                      Send length-prefixed messages to other delegates and keep connections to them open.\n"
+"                                         Only enable once every delegate runs a version that accepts them.\n"
 "\n"
 "For more details on each option, refer to the documentation or use the --help option.\n";
 
@@ -33,6 +36,8 @@ static struct argp_option options[] = {
   {"delegates-website", OPTION_DELEGATES_WEBSITE, 0, 0, "Run the delegate's website.", 0},
   {"shared-delegates-website", OPTION_SHARED_DELEGATES_WEBSITE, 0, 0, "Run shared delegate's website with specified minimum amount.", 0},
   {"generate-key", OPTION_GENERATE_KEY, 0, 0, "Generate public/private key for block verifiers.", 0},
+  {"signature-wallet-check", OPTION_SIGNATURE_WALLET_CHECK, 0, 0, "Also verify wallet signatures with the wallet RPC.", 0},
+  {"framed-messages", OPTION_FRAMED_MESSAGES, 0, 0, "Send length-prefixed messages to other delegates.", 0},
   {0}
 };
 
@@ -66,6 +71,12 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
   case OPTION_GENERATE_KEY:
     create_key = true;
     break;
+  case OPTION_SIGNATURE_WALLET_CHECK:
+    signature_wallet_check = true;
+    break;
+  case OPTION_FRAMED_MESSAGES:
+    framed_messages = true;
+    break;
   default:
     return ARGP_ERR_UNKNOWN;
   }
@@ -105,6 +116,7 @@ void cleanup_data_structures(void) {
   memset(current_block_height, 0, sizeof(current_block_height));
   memset(previous_block_hash, 0, sizeof(previous_block_hash));
   memset(delegates_hash, 0, sizeof(delegates_hash));
+  memset(delegates_hash_md5, 0, sizeof(delegates_hash_md5));
 
   // Destroy mutexes
   pthread_mutex_destroy(&delegates_all_lock);
@@ -220,6 +232,9 @@ int main(int argc, char *argv[]) {
     FATAL_ERROR_EXIT("Please enable ntp for your server");
   }
 
+  INFO_PRINT("Hashing: sha256 %s, sha256 multi-message %s, sha512 %s", sha_el_impl_name(sha256EL_get_impl()),
+             sha_el_impl_name(sha256EL_get_multi_impl()), sha_el_impl_name(sha512EL_get_impl()));
+
   if (!arg_config.block_verifiers_secret_key || strlen(arg_config.block_verifiers_secret_key) != VRF_SECRET_KEY_LENGTH) {
     FATAL_ERROR_EXIT("The --block-verifiers-secret-key is mandatory and should be %d characters long!", VRF_SECRET_KEY_LENGTH);
   }
@@ -250,6 +265,11 @@ int main(int argc, char *argv[]) {
     ERROR_PRINT("Failed in call get_node_data, shutting down...");
   }
 
+  // Seeds share a replica set: follow delegate writes made on the other seeds
+  if (is_seed_node && !delegates_registry_start_watch()) {
+    WARNING_PRINT("Delegates change stream not started, only local writes will update the registry");
+  }
+
 // start the daily scheduler on seeds (ONE thread)
   pthread_t timer_tid = 0;
   bool sched_started = false;
@@ -298,9 +318,11 @@ int main(int argc, char *argv[]) {
     g_ctx = NULL;
   }
 
+  delegates_registry_stop_watch();
   shutdown_db();
   INFO_PRINT("Database shutdown successfully");
   stop_tcp_server();
+  cleanup_connection_pool();
   cleanup_data_structures();
   return 0;
 }
\ No newline at end of file
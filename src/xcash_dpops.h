@@ -18,6 +18,7 @@
 #include "node_functions.h"
 #include "init_processing.h"
 #include "xcash_timer_thread.h"
+#include "signature_functions.h"
 
 // Define an enum for option IDs
 typedef enum {
@@ -26,7 +27,9 @@ typedef enum {
     OPTION_SHARED_DELEGATES_WEBSITE,
     OPTION_FEE,
     OPTION_MINIMUM_AMOUNT,
-    OPTION_LOG_LEVEL
+    OPTION_LOG_LEVEL,
+    OPTION_SIGNATURE_WALLET_CHECK,
+    OPTION_FRAMED_MESSAGES
 } option_ids;
 
 #endif
\ No newline at end of file
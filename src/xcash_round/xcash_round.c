@@ -159,6 +159,7 @@ static int build_committee_list_from_online_list(const block_verifiers_list_t* s
 
   pthread_mutex_lock(&current_block_verifiers_lock);
   current_block_verifiers_list = out_list;
+  current_block_verifiers_generation++;
   pthread_mutex_unlock(&current_block_verifiers_lock);
 
   return XCASH_OK;
@@ -188,6 +189,8 @@ static int compare_hashes(const void* a, const void* b) {
 xcash_round_result_t process_round(void) {
   memset(&producer_refs, 0, sizeof(producer_refs));
   blockchain_stuck = false;
+  signature_cache_new_round();
+  vrf_data_reset_pending();
 
   INFO_STAGE_PRINT("Part 1 - Check Delegates");
   snprintf(current_round_part, sizeof(current_round_part), "%d", 1);
@@ -231,8 +234,9 @@ xcash_round_result_t process_round(void) {
 
   // Get hash for delegates collection
   memset(delegates_hash, 0, sizeof(delegates_hash));
-  if (!hash_delegates_collection(delegates_hash)) {
-    ERROR_PRINT("Failed to create delegates MD5 hash");
+  memset(delegates_hash_md5, 0, sizeof(delegates_hash_md5));
+  if (!hash_delegates_collection(delegates_hash, delegates_hash_md5)) {
+    ERROR_PRINT("Failed to create delegates hash");
     return ROUND_ERROR;
   }
 
@@ -258,15 +262,19 @@ xcash_round_result_t process_round(void) {
   snprintf(current_round_part, sizeof(current_round_part), "%d", 4);
   atomic_store(&wait_for_vrf_message, false);
 
-  response_t** responses = NULL;
+  // Return once a majority accepted the VRF data; unreachable delegates keep trying in the background
+  // and their final status is read in Part 5
+  multi_request_t* vrf_request = NULL;
   char* vrf_message = NULL;
   if (generate_and_request_vrf_data_sync(&vrf_message)) {
-    if (xnet_send_data_multi(XNET_DELEGATES_ALL, vrf_message, &responses)) {
+    int send_delegates_num = (total_delegates < BLOCK_VERIFIERS_AMOUNT) ? total_delegates : BLOCK_VERIFIERS_AMOUNT;
+    size_t send_quorum = (size_t)((send_delegates_num * MAJORITY_PERCENT + 99) / 100);
+    if (xnet_send_data_multi_quorum(XNET_DELEGATES_ALL, vrf_message, send_quorum, NET_QUORUM_BROADCAST_TIMEOUT_MS,
+                                    &vrf_request)) {
       free(vrf_message);
     } else {
       ERROR_PRINT("Failed to send VRF message.");
       free(vrf_message);
-      cleanup_responses(responses);
       return ROUND_ERROR;
     }
   } else {
@@ -277,27 +285,37 @@ xcash_round_result_t process_round(void) {
     return ROUND_ERROR;
   }
 
-  size_t responses_count = 0;
-  if (responses) {
-    while (responses[responses_count] != NULL) {
-      responses_count++;
-    }
-  }
-
   INFO_STAGE_PRINT("Waiting for Sync and VRF Data from all nodes...");
   if (sync_block_verifiers_minutes_and_seconds(0, 20) == XCASH_ERROR) {
     INFO_PRINT("Failed to sync Delegates in the allotted  time, skipping round");
-    cleanup_responses(responses);
+    multi_request_release(vrf_request);
     return ROUND_ERROR;
   }
 
   INFO_STAGE_PRINT("Part 5 - Checking Block Verifiers Majority and Minimum Online Requirement");
   snprintf(current_round_part, sizeof(current_round_part), "%d", 5);
+  // Send results as of now, including the delegates that answered after Part 4 moved on
+  response_t** responses = multi_request_results(vrf_request);
+  multi_request_release(vrf_request);
+  vrf_request = NULL;
+
+  size_t responses_count = 0;
+  if (responses) {
+    while (responses[responses_count] != NULL) {
+      responses_count++;
+    }
+  }
+
+  // Verify the VRF proofs collected during Part 4 in one batch
+  size_t vrf_verified = vrf_data_verify_pending();
+  DEBUG_PRINT("Stored %zu verified VRF proofs", vrf_verified);
+
   // Fill block verifiers list with proven online nodes
   int online_count = 0;
 
   pthread_mutex_lock(&current_block_verifiers_lock);
   memset(&current_block_verifiers_list, 0, sizeof(current_block_verifiers_list));
+  current_block_verifiers_generation++;
   for (size_t i = 0, j = 0; i < BLOCK_VERIFIERS_AMOUNT; i++) {
     if (delegates_all[i].public_address[0] != '\0') {
 
@@ -496,6 +514,9 @@ xcash_round_result_t process_round(void) {
   INFO_PRINT("Confirmed Block Winner: %s with %d votes", current_block_verifiers_list.block_verifiers_name[max_index], max_votes);
 
   uint8_t vote_hashes[COMMITTEE_SIZE + SEED_COUNT][SHA256_EL_HASH_SIZE];
+  uint8_t vote_hash_inputs[COMMITTEE_SIZE + SEED_COUNT][crypto_vrf_OUTPUTBYTES + crypto_vrf_PUBLICKEYBYTES + 64];
+  const uint8_t* vote_hash_msgs[COMMITTEE_SIZE + SEED_COUNT];
+  size_t vote_hash_lens[COMMITTEE_SIZE + SEED_COUNT];
   uint8_t final_vote_hash[SHA256_EL_HASH_SIZE] = {0};
   size_t valid_vote_count = 0;
 
@@ -524,7 +545,7 @@ xcash_round_result_t process_round(void) {
         return ROUND_ERROR;
       }
 
-      uint8_t hash_input[crypto_vrf_OUTPUTBYTES + crypto_vrf_PUBLICKEYBYTES + 64];
+      uint8_t* hash_input = vote_hash_inputs[valid_vote_count];
       size_t offset = 0;
       if (!hex_to_byte_array(current_block_verifiers_list.block_verifiers_vrf_beta_hex[i],
                              hash_input + offset,
@@ -550,18 +571,22 @@ xcash_round_result_t process_round(void) {
              sizeof(signature_bin));
       offset += sizeof(signature_bin);
 
-      if (offset != sizeof(hash_input)) {
-        ERROR_PRINT("Vote hash input length mismatch: got %zu, expected %zu", offset, sizeof(hash_input));
+      if (offset != sizeof(vote_hash_inputs[0])) {
+        ERROR_PRINT("Vote hash input length mismatch: got %zu, expected %zu", offset, sizeof(vote_hash_inputs[0]));
         pthread_mutex_unlock(&current_block_verifiers_lock);
         return ROUND_ERROR;
       }
 
-      sha256EL(hash_input, offset, vote_hashes[valid_vote_count]);
+      vote_hash_msgs[valid_vote_count] = hash_input;
+      vote_hash_lens[valid_vote_count] = offset;
       valid_vote_count++;
     }
   }
   pthread_mutex_unlock(&current_block_verifiers_lock);
 
+  // all vote hashes in one pass, outside the lock
+  sha256EL_multi(vote_hash_msgs, vote_hash_lens, valid_vote_count, vote_hashes);
+
   if (valid_vote_count != (size_t)max_votes) {
     INFO_PRINT("Unexpected vote count when creating final vote hash: valid_vote_count = %zu, max_votes = %d",
                valid_vote_count, max_votes);
@@ -744,6 +769,11 @@ void start_block_production(void) {
       atomic_store(&wait_for_vrf_message, false);
       atomic_store(&wait_for_consensus_vote, false);
     }
+    log_dispatch_queue_stats();
+    log_dns_cache_stats();
+    log_signature_cache_stats();
+    log_http_client_stats();
+    log_delegates_registry_stats();
 
     // 10 secs to perform cleanup or add stats and other info
     if (sync_block_verifiers_minutes_and_seconds(0, 50) == XCASH_ERROR) {
@@ -755,29 +785,76 @@ void start_block_production(void) {
     atomic_store(&wait_for_block_height_init, true);
 
     if (round_result == ROUND_OK) {
-      // Update online status
-      for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
-        if (strlen(delegates_all[i].public_address) > 0 && strlen(delegates_all[i].public_key) > 0) {
-          if (strcmp(delegates_all[i].online_status, delegates_all[i].online_status_original) != 0) {
-            char tmp_status[6] = "false";
-            if (strcmp(delegates_all[i].online_status, "true") == 0) {
-              strcpy(tmp_status, "true");
-            }
+      // Update online status, all changed delegates in one ordered bulk write
+      {
+        mongoc_client_t* sc = mongoc_client_pool_pop(database_client_thread_pool);
+        mongoc_collection_t* dcoll = sc ? mongoc_client_get_collection(sc, DATABASE_NAME, DB_COLLECTION_DELEGATES) : NULL;
+        if (!dcoll) {
+          ERROR_PRINT("Failed to get delegates collection for online_status update");
+          if (sc) mongoc_client_pool_push(database_client_thread_pool, sc);
+          goto end_of_round_skip_block;
+        }
+
+        size_t status_idx[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+        size_t status_count = 0;
+        db_bulk_t bulk;
+        db_bulk_result_t bulk_result;
+        db_bulk_init(&bulk, dcoll, true, 0);
+
+        for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+          if (strlen(delegates_all[i].public_address) > 0 && strlen(delegates_all[i].public_key) > 0) {
+            if (strcmp(delegates_all[i].online_status, delegates_all[i].online_status_original) != 0) {
+              char tmp_status[6] = "false";
+              if (strcmp(delegates_all[i].online_status, "true") == 0) {
+                strcpy(tmp_status, "true");
+              }
 
-            bson_t filter;
-            bson_t update_fields;
-            bson_init(&filter);
-            BSON_APPEND_UTF8(&filter, "public_key", delegates_all[i].public_key);
-            bson_init(&update_fields);
-            BSON_APPEND_UTF8(&update_fields, "online_status", tmp_status);
-            if (update_document_from_collection_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, &filter, &update_fields) != XCASH_OK) {
-              ERROR_PRINT("Failed to update online_status for delegate %s", delegates_all[i].public_address);
-              goto end_of_round_skip_block;
+              bson_t filter;
+              bson_t update_fields;
+              bson_t update;
+              bson_init(&filter);
+              BSON_APPEND_UTF8(&filter, "public_key", delegates_all[i].public_key);
+              bson_init(&update_fields);
+              BSON_APPEND_UTF8(&update_fields, "online_status", tmp_status);
+              bson_init(&update);
+              BSON_APPEND_DOCUMENT(&update, "$set", &update_fields);
+              db_bulk_update(&bulk, &filter, &update, false);
+              status_idx[status_count++] = i;
+
+              bson_destroy(&update);
+              bson_destroy(&filter);
+              bson_destroy(&update_fields);
             }
+          }
+        }
 
-            bson_destroy(&filter);
-            bson_destroy(&update_fields);
+        bool status_ok = db_bulk_finish(&bulk, &bulk_result);
+        mongoc_collection_destroy(dcoll);
+        mongoc_client_pool_push(database_client_thread_pool, sc);
+
+        // The registry takes the written statuses as they are; only a write it cannot place is re-read
+        bool status_reported = false;
+        for (size_t k = 0; k < status_count; k++) {
+          const char* public_key = delegates_all[status_idx[k]].public_key;
+          if (!db_bulk_item_ok(&bulk_result, k)) {
+            if (!status_reported) {
+              ERROR_PRINT("Failed to update online_status for delegate %s", delegates_all[status_idx[k]].public_address);
+              status_reported = true;
+            }
+            continue;
+          }
+          bson_t* set = BCON_NEW("online_status",
+                                 BCON_UTF8(strcmp(delegates_all[status_idx[k]].online_status, "true") == 0 ? "true" : "false"));
+          if (!delegates_registry_apply_set(DELEGATES_KEY_PUBLIC_KEY, public_key, set)) {
+            bson_t* filter = BCON_NEW("public_key", BCON_UTF8(public_key));
+            delegates_registry_refresh(filter);
+            bson_destroy(filter);
           }
+          bson_destroy(set);
+        }
+
+        if (!status_ok) {
+          goto end_of_round_skip_block;
         }
       }
 
@@ -868,6 +945,12 @@ void start_block_production(void) {
           goto end_of_round_skip_block;
         }
 
+        size_t stats_idx[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+        size_t stats_count = 0;
+        db_bulk_t bulk;
+        db_bulk_result_t bulk_result;
+        db_bulk_init(&bulk, stats, false, 0);
+
         for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
           if (!delegates_all[i].public_key[0]) continue;
           if (!delegates_all[i].public_address[0]) continue;
@@ -924,11 +1007,8 @@ void start_block_production(void) {
           BSON_APPEND_DOCUMENT(&update, "$set", &set);
 
           // IMPORTANT: no upsert here (docs are created at startup/registration)
-          bson_error_t err;
-          if (!mongoc_collection_update_one(stats, &filter, &update, /*opts*/ NULL, NULL, &err)) {
-            ERROR_PRINT("stats update failed pk=%.12s… h=%llu: %s",
-                        delegates_all[i].public_key, (unsigned long long)cbheight, err.message);
-          }
+          db_bulk_update(&bulk, &filter, &update, false);
+          stats_idx[stats_count++] = i;
 
           // cleanup
           bson_destroy(&update);
@@ -937,6 +1017,18 @@ void start_block_production(void) {
           bson_destroy(&filter);
         }
 
+        // One round trip for every delegate's counters instead of one each
+        if (!db_bulk_finish(&bulk, &bulk_result)) {
+          for (size_t k = 0; k < stats_count; k++) {
+            const db_bulk_error_t* e = db_bulk_item_error(&bulk_result, k);
+            if (!db_bulk_item_ok(&bulk_result, k)) {
+              ERROR_PRINT("stats update failed pk=%.12s… h=%llu: %s",
+                          delegates_all[stats_idx[k]].public_key, (unsigned long long)cbheight,
+                          e ? e->message : "not sent");
+            }
+          }
+        }
+
         mongoc_collection_destroy(stats);
       }
 
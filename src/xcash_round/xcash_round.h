@@ -16,7 +16,9 @@
 #include "network_daemon_functions.h"
 #include "db_sync.h"
 #include "block_verifiers_functions.h"
+#include "block_verifiers_server_functions.h"
 #include "string_functions.h"
+#include "signature_cache.h"
 
 typedef struct {
     char public_address[XCASH_WALLET_LENGTH + 1];
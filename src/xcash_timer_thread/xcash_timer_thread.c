@@ -154,33 +154,15 @@ static void free_buckets(payout_bucket_t buckets[], size_t bucket_count) {
   }
 }
 
-// Small helper to keep per-delegate running totals
-static void add_vote_sum(char addrs[][XCASH_WALLET_LENGTH + 1],
-                         int64_t totals[],
-                         size_t* pcount,
-                         const char* addr,
-                         int64_t amt) {
-  // Find existing bucket
-  for (size_t i = 0; i < *pcount; ++i) {
-    if (strcmp(addrs[i], addr) == 0) {
-      totals[i] += amt;
-      return;
-    }
-  }
-  // New bucket
-  if (*pcount >= BLOCK_VERIFIERS_TOTAL_AMOUNT) {
-    ERROR_PRINT("vote_sums full; dropping contribution for %.12s…", addr);
-    return;
-  }
-  size_t n = strnlen(addr, XCASH_WALLET_LENGTH + 1);
-  if (n == 0 || n > XCASH_WALLET_LENGTH) {
-    ERROR_PRINT("bad delegate address length=%zu, skipping", n);
-    return;
+// Mirrors a total_vote_count write into the delegates registry without re-reading the collection
+static void registry_set_total(const char* public_address, int64_t total) {
+  bson_t* set = BCON_NEW("total_vote_count", BCON_INT64(total));
+  if (!delegates_registry_apply_set(DELEGATES_KEY_ADDRESS, public_address, set)) {
+    bson_t* filter = BCON_NEW("public_address", BCON_UTF8(public_address));
+    delegates_registry_refresh(filter);
+    bson_destroy(filter);
   }
-  memcpy(addrs[*pcount], addr, n);
-  addrs[*pcount][n] = '\0';
-  totals[*pcount] = amt;
-  ++(*pcount);
+  bson_destroy(set);
 }
 
 static int sbuf_init(sbuf_t* s, size_t cap) {
@@ -228,7 +210,8 @@ Description:
     1) Scans the `reserve_proofs` collection, validates each proof, and prunes invalid entries.
     2) Aggregates per-delegate vote totals from valid proofs.
     3) Snapshots the currently-online delegates (address/IP) at a fixed clock boundary.
-    4) Writes updated `total_vote_count` values into the `delegates` collection (skip if unchanged).
+    4) Writes updated `total_vote_count` values into the `delegates` collection (skip if unchanged),
+       batched into bulk writes like the invalid-proof deletes and the zeroing pass.
     5) Broadcasts a seed→nodes vote-count update message on successful DB updates.
     6) (Per delegate) Builds payout instructions from collected voter outputs, hashes/signs the payload,
        and prepares a JSON message for network transmission.
@@ -263,6 +246,7 @@ static void run_proof_check(sched_ctx_t* ctx) {
       "total_vote", BCON_INT32(1),
       "reserve_proof", BCON_INT32(1),
       "}",
+      "batchSize", BCON_INT32(RESERVE_PROOF_CURSOR_BATCH),
       "noCursorTimeout", BCON_BOOL(true));
   if (!query || !opts) {
     ERROR_PRINT("reserve_proofs: OOM building query/options");
@@ -283,115 +267,83 @@ static void run_proof_check(sched_ctx_t* ctx) {
     return;
   }
 
-  // Per-delegate aggregators (bounded by number of delegates)
-  char agg_addr[BLOCK_VERIFIERS_TOTAL_AMOUNT][XCASH_WALLET_LENGTH + 1];
-  int64_t agg_total[BLOCK_VERIFIERS_TOTAL_AMOUNT];
-  memset(agg_addr, 0, sizeof agg_addr);
-  memset(agg_total, 0, sizeof agg_total);
-  size_t agg_count = 0;
+  // Validate every proof with the verifier pool; totals come back per delegate
+  reserve_proof_scan_t* scan = calloc(1, sizeof(*scan));
+  if (!scan) {
+    ERROR_PRINT("reserve_proofs: OOM allocating scan state");
+    mongoc_cursor_destroy(cur);
+    bson_destroy(opts);
+    bson_destroy(query);
+    mongoc_collection_destroy(coll);
+    mongoc_client_pool_push(ctx->pool, c);
+    return;
+  }
+
+  // Proofs the ledger still vouches for skip the wallet; without a ledger every proof is checked
+  mongoc_collection_t* lcoll =
+      mongoc_client_get_collection(c, DATABASE_NAME, DB_COLLECTION_RESERVE_PROOF_LEDGER);
+  reserve_proof_ledger_t ledger;
+  bool have_ledger = lcoll && reserve_proof_ledger_load(lcoll, strtoull(current_block_height, NULL, 10), &ledger);
+  if (!have_ledger) {
+    WARNING_PRINT("reserve_proofs ledger unavailable; checking every proof with the wallet");
+  }
+
+  reserve_proof_scan(cur, have_ledger ? &ledger : NULL, scan);
+  if (have_ledger && !atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
+    reserve_proof_ledger_commit(lcoll, &ledger, scan);
+  }
+  if (have_ledger) reserve_proof_ledger_free(&ledger);
+  if (lcoll) mongoc_collection_destroy(lcoll);
 
-  const bson_t* doc = NULL;
-  bson_error_t cerr;
-  size_t seen = 0, invalid = 0, deleted = 0, skipped = 0;
+  char (*agg_addr)[XCASH_WALLET_LENGTH + 1] = scan->delegates;
+  const int64_t* agg_total = scan->totals;
+  size_t agg_count = scan->delegate_count;
+  size_t deleted = 0;
 
   payout_bucket_t pay_buckets[BLOCK_VERIFIERS_TOTAL_AMOUNT];
   memset(pay_buckets, 0, sizeof pay_buckets);
   size_t pay_bucket_count = 0;
 
-  while (mongoc_cursor_next(cur, &doc)) {
-    if (atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
-      break;
-    }
-    ++seen;
-    bson_iter_t it;
-    const char* voter = NULL;     // _id (voter public address)
-    const char* delegate = NULL;  // public_address_voted_for
-    const char* proof = NULL;     // reserve_proof
-    int64_t claimed_total = 0;
-
-    if (bson_iter_init_find(&it, doc, "_id") && BSON_ITER_HOLDS_UTF8(&it))
-      voter = bson_iter_utf8(&it, NULL);
-
-    if (bson_iter_init_find(&it, doc, "public_address_voted_for") && BSON_ITER_HOLDS_UTF8(&it))
-      delegate = bson_iter_utf8(&it, NULL);
-
-    if (bson_iter_init_find(&it, doc, "reserve_proof") && BSON_ITER_HOLDS_UTF8(&it))
-      proof = bson_iter_utf8(&it, NULL);
-
-    // total_vote must be integer and positive
-    if (bson_iter_init_find(&it, doc, "total_vote")) {
-      if (BSON_ITER_HOLDS_INT64(&it))
-        claimed_total = bson_iter_int64(&it);
-      else if (BSON_ITER_HOLDS_INT32(&it))
-        claimed_total = (int64_t)bson_iter_int32(&it);
-      else {
-        ERROR_PRINT("reserve_proofs: total_vote has unexpected type=%d for id=%.12s…",
-                    (int)bson_iter_type(&it), voter ? voter : "(unknown)");
-        ++skipped;
-        continue;
-      }
-    } else {
-      ERROR_PRINT("reserve_proofs: missing total_vote for id=%.12s…",
-                  voter ? voter : "(unknown)");
-      ++skipped;
-      continue;
-    }
-
-    if (claimed_total <= 0) {
-      ERROR_PRINT("reserve_proofs: non-positive total_vote=%lld for id=%.12s… — skipping",
-                  (long long)claimed_total, voter ? voter : "(unknown)");
-      ++skipped;
-      continue;
-    }
+  // Invalid proofs are deleted by _id (voter) in batches rather than one round trip each
+  db_bulk_t del_bulk;
+  db_bulk_result_t del_result;
+  db_bulk_init(&del_bulk, coll, false, 0);
 
-    if (!voter || !delegate || !proof) {
-      ++skipped;
-      ERROR_PRINT("reserve_proofs: missing required field(s), skipping one doc");
-      continue;
-    }
-
-    // Validate the proof against the voter address & claimed amount
-    int rc = check_reserve_proofs((uint64_t)claimed_total, voter, proof);
-    bool ok = (rc == XCASH_OK);
+  for (size_t r = 0; r < scan->result_count; ++r) {
+    const reserve_proof_result_t* res = &scan->results[r];
 
-    if (!ok) {
-      ++invalid;
-
-      // delete invalid proof by _id (voter)
+    if (!res->valid) {
       bson_t del_filter;
       bson_init(&del_filter);
-      BSON_APPEND_UTF8(&del_filter, "_id", voter);
-      bson_error_t derr;
-      if (mongoc_collection_delete_one(coll, &del_filter, NULL, NULL, &derr)) {
-        ++deleted;
-      } else {
-        ERROR_PRINT("Failed to delete invalid reserve_proof id=%.12s… : %s",
-                    voter, derr.message);
-      }
+      BSON_APPEND_UTF8(&del_filter, "_id", res->voter);
+      db_bulk_remove(&del_bulk, &del_filter);
       bson_destroy(&del_filter);
       continue;
     }
 
-    // Valid proof → accumulate into delegate bucket
-    add_vote_sum(agg_addr, agg_total, &agg_count, delegate, claimed_total);
-
-    // Also accumulate per-voter outputs for this delegate
-    int idx = get_bucket_index(pay_buckets, &pay_bucket_count, delegate);
+    // Valid proof → accumulate per-voter outputs for this delegate
+    int idx = get_bucket_index(pay_buckets, &pay_bucket_count, scan->delegates[res->delegate]);
     if (idx < 0) {
       ERROR_PRINT("Too many delegate buckets while collecting outputs; skipping one entry");
     } else {
-      if (!bucket_push_output(&pay_buckets[idx], voter, (uint64_t)claimed_total)) {
+      if (!bucket_push_output(&pay_buckets[idx], res->voter, res->amount)) {
         ERROR_PRINT("OOM while appending payout output; skipping one entry");
       }
     }
   }
 
-  if (mongoc_cursor_error(cur, &cerr)) {
-    ERROR_PRINT("reserve_proofs cursor error: %s", cerr.message);
-  } else {
-    INFO_PRINT("reserve_proofs scan complete: seen=%zu invalid=%zu deleted=%zu skipped=%zu",
-      seen, invalid, deleted, skipped);
+  if (!db_bulk_finish(&del_bulk, &del_result)) {
+    for (size_t e = 0; e < del_result.error_entries; ++e) {
+      ERROR_PRINT("Failed to delete %zu invalid reserve_proof(s) from #%zu : %s",
+                  del_result.errors[e].count, del_result.errors[e].index, del_result.errors[e].message);
+    }
   }
+  deleted = (size_t)del_result.removed;
+
+  INFO_PRINT("reserve_proofs scan complete: seen=%zu invalid=%zu deleted=%zu skipped=%zu trusted=%zu "
+    "rechecked=%zu fresh=%zu elapsed=%.1fs%s",
+    scan->seen, scan->invalid, deleted, scan->skipped, scan->trusted, scan->rechecked, scan->fresh,
+    scan->elapsed_sec, scan->complete ? "" : " (incomplete)");
 
   mongoc_cursor_destroy(cur);
   bson_destroy(opts);
@@ -401,6 +353,8 @@ static void run_proof_check(sched_ctx_t* ctx) {
   if (atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
     mongoc_client_pool_push(ctx->pool, c);
     free_buckets(pay_buckets, pay_bucket_count);
+    reserve_proof_scan_free(scan);
+    free(scan);
     return;
   }
 
@@ -439,58 +393,33 @@ static void run_proof_check(sched_ctx_t* ctx) {
       ERROR_PRINT("delegates: get_collection failed; cannot write totals");
     } else {
 
-      for (size_t i = 0; i < agg_count; ++i) {
-        bson_t filter;
-        bson_init(&filter);
-        BSON_APPEND_UTF8(&filter, "public_address", agg_addr[i]);
-
-        // --- Projection: only fetch total_vote_count, and limit 1
-        bson_t opts_ck;
-        bson_init(&opts_ck);
-        bson_t proj;
-        bson_init(&proj);
-        BSON_APPEND_INT32(&proj, "total_vote_count", 1);
-        BSON_APPEND_DOCUMENT(&opts_ck, "projection", &proj);
-        BSON_APPEND_INT64(&opts_ck, "limit", 1);
+      // Queue every changed total, send them together, then announce the ones that were written
+      size_t changed[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+      bool initialized[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+      size_t changed_count = 0;
+      db_bulk_t bulk;
+      db_bulk_result_t bulk_result;
+      db_bulk_init(&bulk, dcoll, false, 0);
 
-        // --- Query current value
+      for (size_t i = 0; i < agg_count; ++i) {
+        // --- Current value from the delegates registry
         int64_t current_total = -1;  // -1 => "missing/unknown"
-        bool have_current = false;
-
-        mongoc_cursor_t* cur_ck = mongoc_collection_find_with_opts(dcoll, &filter, &opts_ck, NULL);
-        if (!cur_ck) {
-          ERROR_PRINT("delegate total read failed addr=%.12s… (cursor init)", agg_addr[i]);
-        } else {
-          const bson_t* doc_ck;
-          if (mongoc_cursor_next(cur_ck, &doc_ck)) {
-            bson_iter_t it;
-            if (bson_iter_init_find(&it, doc_ck, "total_vote_count") &&
-                (BSON_ITER_HOLDS_INT32(&it) || BSON_ITER_HOLDS_INT64(&it))) {
-              current_total = bson_iter_as_int64(&it);
-              have_current = true;
-            }
-          }
-          bson_error_t ck_err;
-          if (mongoc_cursor_error(cur_ck, &ck_err)) {
-            ERROR_PRINT("delegate total read failed addr=%.12s… : %s", agg_addr[i], ck_err.message);
-          }
-          mongoc_cursor_destroy(cur_ck);
-        }
-
-        bson_destroy(&proj);
-        bson_destroy(&opts_ck);
+        bool have_current = delegates_registry_get_int64(DELEGATES_KEY_ADDRESS, agg_addr[i],
+                                                         "total_vote_count", &current_total);
 
         // --- Compare and skip update if no change
         int64_t new_total = (int64_t)agg_total[i];
         if (have_current && current_total == new_total) {
           DEBUG_PRINT("delegate total unchanged addr=%.12s… total=%lld (skip)",
                       agg_addr[i], (long long)new_total);
-
-          bson_destroy(&filter);
           continue;
         }
 
         // --- Apply update only when needed
+        bson_t filter;
+        bson_init(&filter);
+        BSON_APPEND_UTF8(&filter, "public_address", agg_addr[i]);
+
         bson_t set;
         bson_init(&set);
         BSON_APPEND_INT64(&set, "total_vote_count", new_total);
@@ -499,41 +428,47 @@ static void run_proof_check(sched_ctx_t* ctx) {
         bson_init(&update);
         BSON_APPEND_DOCUMENT(&update, "$set", &set);
 
-        bson_error_t uerr;
-        bool update_ok = false;
-        if (!mongoc_collection_update_one(dcoll, &filter, &update,
-                                          /*opts=*/NULL, /*reply=*/NULL, &uerr)) {
-          ERROR_PRINT("delegate total update failed addr=%.12s… : %s",
-                      agg_addr[i], uerr.message);
-        } else {
-          update_ok = true;
-          DEBUG_PRINT("delegate total %s addr=%.12s… total=%lld",
-                      have_current ? "updated" : "initialized",
-                      agg_addr[i], (long long)new_total);
-        }
+        // Indexes in the bulk follow changed[]
+        db_bulk_update(&bulk, &filter, &update, false);
+        initialized[changed_count] = !have_current;
+        changed[changed_count++] = i;
 
         bson_destroy(&update);
         bson_destroy(&set);
         bson_destroy(&filter);
+      }
+
+      db_bulk_finish(&bulk, &bulk_result);
 
-        if (update_ok) {
-          sync_minutes_and_seconds(0, 47);
-          response_t** responses = NULL;
-          char* upd_vote_message = NULL;
-          if (build_seed_to_nodes_vote_count_update(agg_addr[i], new_total, &upd_vote_message)) {
-            if (xnet_send_data_multi(XNET_DELEGATES_ALL_ONLINE_NOSEEDS, upd_vote_message, &responses)) {
-              free(upd_vote_message);
-              cleanup_responses(responses);
-            } else {
-              ERROR_PRINT("Failed to send vote count update message.");
-              free(upd_vote_message);
-              cleanup_responses(responses);
-            }
+      for (size_t k = 0; k < changed_count; ++k) {
+        size_t i = changed[k];
+        int64_t new_total = (int64_t)agg_total[i];
+        if (!db_bulk_item_ok(&bulk_result, k)) {
+          const db_bulk_error_t* e = db_bulk_item_error(&bulk_result, k);
+          ERROR_PRINT("delegate total update failed addr=%.12s… : %s", agg_addr[i], e ? e->message : "not sent");
+          continue;
+        }
+        registry_set_total(agg_addr[i], new_total);
+        DEBUG_PRINT("delegate total %s addr=%.12s… total=%lld",
+                    initialized[k] ? "initialized" : "updated",
+                    agg_addr[i], (long long)new_total);
+
+        sync_minutes_and_seconds(0, 47);
+        response_t** responses = NULL;
+        char* upd_vote_message = NULL;
+        if (build_seed_to_nodes_vote_count_update(agg_addr[i], new_total, &upd_vote_message)) {
+          if (xnet_send_data_multi(XNET_DELEGATES_ALL_ONLINE_NOSEEDS, upd_vote_message, &responses)) {
+            free(upd_vote_message);
+            cleanup_responses(responses);
           } else {
-            ERROR_PRINT("Failed to generate vote count update message");
-            if (upd_vote_message != NULL) {
-              free(upd_vote_message);
-            }
+            ERROR_PRINT("Failed to send vote count update message.");
+            free(upd_vote_message);
+            cleanup_responses(responses);
+          }
+        } else {
+          ERROR_PRINT("Failed to generate vote count update message");
+          if (upd_vote_message != NULL) {
+            free(upd_vote_message);
           }
         }
       }
@@ -554,6 +489,13 @@ static void run_proof_check(sched_ctx_t* ctx) {
       if (rcoll) mongoc_collection_destroy(rcoll);
       if (dcoll) mongoc_collection_destroy(dcoll);
     } else {
+      // Delegates to zero; their updates go out in one bulk write
+      const char* zero_addr[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+      size_t zero_count = 0;
+      db_bulk_t bulk;
+      db_bulk_result_t bulk_result;
+      db_bulk_init(&bulk, dcoll, false, 0);
+
       for (size_t i = 0; i < online_count; ++i) {
         if (atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
           break;
@@ -583,9 +525,8 @@ static void run_proof_check(sched_ctx_t* ctx) {
 
         bson_destroy(&f_res);
 
-        // ---- If no reserve proofs exist, zero the local total and broadcast
+        // ---- If no reserve proofs exist, queue zeroing the local total
         if (rp_count == 0) {
-          // Local update on this seed FIRST:
           // filter: { public_address: addr, total_vote_count: { $gt: 0 } }
           bson_t f_del;
           bson_init(&f_del);
@@ -605,48 +546,56 @@ static void run_proof_check(sched_ctx_t* ctx) {
           BSON_APPEND_DOCUMENT(&u_doc, "$set", &u_set);
           bson_destroy(&u_set);
 
-          bson_t reply;
-          bson_init(&reply);
-          bson_error_t uerr = {0};
-
-          bool ok = mongoc_collection_update_one(
-              dcoll, &f_del, &u_doc, /*opts*/ NULL, &reply, &uerr);
+          // Indexes in the bulk follow zero_addr[]
+          db_bulk_update(&bulk, &f_del, &u_doc, false);
+          zero_addr[zero_count++] = addr;
 
-          if (!ok) {
-            ERROR_PRINT("delegate zero update failed addr=%.12s… : %s", addr, uerr.message);
-            bson_destroy(&reply);
-            bson_destroy(&u_doc);
-            bson_destroy(&f_del);
-            continue;
-          }
-
-          bson_destroy(&reply);
           bson_destroy(&u_doc);
           bson_destroy(&f_del);
+        }  // rp_count == 0
+      }  // for online_count
+
+      // Local update on this seed FIRST, then broadcast what was written
+      db_bulk_finish(&bulk, &bulk_result);
+
+      for (size_t k = 0; k < zero_count; ++k) {
+        if (atomic_load_explicit(&shutdown_requested, memory_order_relaxed)) {
+          break;
+        }
+        const char* addr = zero_addr[k];
+        if (!db_bulk_item_ok(&bulk_result, k)) {
+          const db_bulk_error_t* e = db_bulk_item_error(&bulk_result, k);
+          ERROR_PRINT("delegate zero update failed addr=%.12s… : %s", addr, e ? e->message : "not sent");
+          continue;
+        }
+        // The write only matched a positive total
+        int64_t current_total = 0;
+        if (delegates_registry_get_int64(DELEGATES_KEY_ADDRESS, addr, "total_vote_count", &current_total) &&
+            current_total > 0) {
+          registry_set_total(addr, 0);
+        }
 
-          DEBUG_PRINT("delegate total zeroed locally addr=%.12s… (no reserve proofs)", addr);
-
-          // Now that THIS SEED is consistent, broadcast to others
-          sync_minutes_and_seconds(0, 47);
-          response_t** responses = NULL;
-          char* upd_vote_message = NULL;
-          if (build_seed_to_nodes_vote_count_update(addr, 0, &upd_vote_message)) {
-            if (xnet_send_data_multi(XNET_DELEGATES_ALL_ONLINE_NOSEEDS,
-                                     upd_vote_message, &responses)) {
-              free(upd_vote_message);
-              cleanup_responses(responses);
-            } else {
-              ERROR_PRINT("Failed to send vote count zero update message.");
-              free(upd_vote_message);
-              cleanup_responses(responses);
-            }
+        DEBUG_PRINT("delegate total zeroed locally addr=%.12s… (no reserve proofs)", addr);
+
+        // Now that THIS SEED is consistent, broadcast to others
+        sync_minutes_and_seconds(0, 47);
+        response_t** responses = NULL;
+        char* upd_vote_message = NULL;
+        if (build_seed_to_nodes_vote_count_update(addr, 0, &upd_vote_message)) {
+          if (xnet_send_data_multi(XNET_DELEGATES_ALL_ONLINE_NOSEEDS,
+                                   upd_vote_message, &responses)) {
+            free(upd_vote_message);
+            cleanup_responses(responses);
           } else {
-            ERROR_PRINT("Failed to generate vote count zero update message");
-            if (upd_vote_message) free(upd_vote_message);
+            ERROR_PRINT("Failed to send vote count zero update message.");
+            free(upd_vote_message);
+            cleanup_responses(responses);
           }
-
-        }  // rp_count == 0
-      }  // for online_count
+        } else {
+          ERROR_PRINT("Failed to generate vote count zero update message");
+          if (upd_vote_message) free(upd_vote_message);
+        }
+      }
 
       mongoc_collection_destroy(rcoll);
       mongoc_collection_destroy(dcoll);
@@ -891,6 +840,8 @@ static void run_proof_check(sched_ctx_t* ctx) {
 
   mongoc_client_pool_push(ctx->pool, c);
   free_buckets(pay_buckets, pay_bucket_count);
+  reserve_proof_scan_free(scan);
+  free(scan);
   return;
 }
 
@@ -15,6 +15,7 @@
 #include "db_functions.h"
 #include "xcash_net.h"
 #include "network_wallet_functions.h"
+#include "reserve_proof_pipeline.h"
 #include "network_security_functions.h"
 #include "block_verifiers_functions.h"
 #include "block_verifiers_synchronize_server_functions.h"
@@ -0,0 +1,179 @@
+#include "db_bulk.h"
+#include "test_common.h"
+#include "mongoc_fake.h"
+
+/*
+ * db_bulk sends queued writes batch_size at a time and maps what the server reports back onto the
+ * index each write was added at. Against writes the server fails (an update moving _id), writes the
+ * driver rejects before sending (an update without operators) and a batch lost to a socket error,
+ * every write must be reported ok exactly when it was applied, an ordered bulk must stop after its
+ * first failure, and a result with more failures than DB_BULK_MAX_ERRORS must not claim unknown
+ * writes succeeded.
+ *
+ * The collection lives in tests/mongoc_fake.h, which fails the chosen bulk execute for the socket
+ * error.
+ */
+
+#define MAX_ITEMS 2000
+
+typedef enum { ITEM_OK, ITEM_FAILS, ITEM_REJECTED } item_kind_t;
+
+static mongoc_collection_t* items;
+static item_kind_t kinds[MAX_ITEMS];
+
+static void item_id(size_t i, char out[32]) {
+  snprintf(out, 32, "item%05zu", i);
+}
+
+// Resets the collection to n documents with v 0
+static void seed(size_t n) {
+  mongoc_collection_drop(items, NULL);
+  for (size_t i = 0; i < n; i++) {
+    char id[32];
+    item_id(i, id);
+    bson_t* doc = BCON_NEW("_id", BCON_UTF8(id), "v", BCON_INT32(0));
+    mongoc_collection_insert_one(items, doc, NULL, NULL, NULL);
+    bson_destroy(doc);
+  }
+}
+
+// Whether the update of item i reached the collection
+static bool item_applied(size_t i) {
+  const mongoc_fake_collection_t* c = (const mongoc_fake_collection_t*)items;
+  bson_iter_t it;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bool applied = i < c->count && bson_iter_init_find(&it, c->docs[i], "v") && bson_iter_as_int64(&it) == 1;
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return applied;
+}
+
+// Queues an update of each of n items, of the kind in kinds[], and finishes the bulk
+static void run(bool ordered, size_t batch_size, size_t n, db_bulk_result_t* r) {
+  seed(n);
+  db_bulk_t bulk;
+  CHECK(db_bulk_init(&bulk, items, ordered, batch_size), "init");
+  for (size_t i = 0; i < n; i++) {
+    char id[32];
+    item_id(i, id);
+    bson_t* filter = BCON_NEW("_id", BCON_UTF8(id));
+    bson_t* update = kinds[i] == ITEM_FAILS      ? BCON_NEW("$set", "{", "_id", BCON_UTF8("moved"), "}")
+                     : kinds[i] == ITEM_REJECTED ? BCON_NEW("v", BCON_INT32(1))
+                                                 : BCON_NEW("$set", "{", "v", BCON_INT32(1), "}");
+    db_bulk_update(&bulk, filter, update, false);
+    bson_destroy(update);
+    bson_destroy(filter);
+  }
+  bool ok = db_bulk_finish(&bulk, r);
+  CHECK(ok == (r->error_count == 0 && r->stopped_at == SIZE_MAX), "finish returned %d with %zu errors", ok,
+        r->error_count);
+}
+
+// Every item is ok exactly when its update reached the collection
+static void check_items(const char* when, const db_bulk_result_t* r, size_t n) {
+  size_t wrong = 0, first = SIZE_MAX;
+  for (size_t i = 0; i < n; i++) {
+    if (db_bulk_item_ok(r, i) != item_applied(i)) {
+      wrong++;
+      if (first == SIZE_MAX) first = i;
+    }
+  }
+  CHECK(wrong == 0, "%s: %zu items misreported, first %zu", when, wrong, first);
+}
+
+static void check_clean(void) {
+  db_bulk_result_t r;
+  memset(kinds, 0, sizeof(kinds));
+  run(false, 0, 55, &r);
+  CHECK(r.batches == 1 && r.modified == 55 && r.error_count == 0 && r.executed == 55, "55 writes: %zu batches",
+        r.batches);
+  check_items("clean", &r, 55);
+  CHECK(!db_bulk_item_ok(&r, 55), "item past the end reported ok");
+
+  run(false, 10, 95, &r);
+  CHECK(r.batches == 10 && r.executed == 95 && r.modified == 95, "95 writes by 10: %zu batches", r.batches);
+}
+
+// Unordered: server failures at 3 and 27 (second batch) and a driver rejection at 33
+static void check_unordered_errors(void) {
+  db_bulk_result_t r;
+  memset(kinds, 0, sizeof(kinds));
+  kinds[3] = kinds[27] = ITEM_FAILS;
+  kinds[33] = ITEM_REJECTED;
+  run(false, 20, 60, &r);
+  CHECK(r.error_count == 3 && r.modified == 57 && r.batches == 4, "%zu errors, %lld modified, %zu batches",
+        r.error_count, (long long)r.modified, r.batches);
+  check_items("unordered", &r, 60);
+  const db_bulk_error_t* e27 = db_bulk_item_error(&r, 27);
+  const db_bulk_error_t* e33 = db_bulk_item_error(&r, 33);
+  CHECK(e27 && e27->code == 66 && e27->count == 1, "item 27 error");
+  CHECK(e33 && e33->code == MONGOC_ERROR_COMMAND_INVALID_ARG && e33->count == 1, "item 33 error");
+  CHECK(!db_bulk_item_error(&r, 28), "item 28 has an error");
+}
+
+// Ordered: the first failure stops everything after it
+static void check_ordered_errors(void) {
+  db_bulk_result_t r;
+  memset(kinds, 0, sizeof(kinds));
+  kinds[27] = ITEM_FAILS;
+  run(true, 20, 60, &r);
+  CHECK(r.stopped_at == 28 && r.batches == 2 && r.modified == 27, "failure at 27: stopped at %zu, %zu batches, "
+        "%lld modified", r.stopped_at, r.batches, (long long)r.modified);
+  check_items("ordered failure", &r, 60);
+
+  // A rejection sends what was queued before it and nothing after
+  memset(kinds, 0, sizeof(kinds));
+  kinds[30] = ITEM_REJECTED;
+  run(true, 1000, 60, &r);
+  CHECK(r.stopped_at == 31 && r.batches == 1 && r.modified == 30, "rejection at 30: stopped at %zu, %zu batches",
+        r.stopped_at, r.batches);
+  check_items("ordered rejection", &r, 60);
+}
+
+// A batch lost to a socket error fails every write in it and no other
+static void check_lost_batch(void) {
+  db_bulk_result_t r;
+  memset(kinds, 0, sizeof(kinds));
+  mongoc_fake_bulk_fail_execute = mongoc_fake_bulk_executes + 2;
+  run(false, 20, 60, &r);
+  mongoc_fake_bulk_fail_execute = 0;
+  CHECK(r.error_count == 20 && r.error_entries == 1 && r.batches == 3 && r.modified == 40,
+        "lost batch: %zu errors in %zu entries", r.error_count, r.error_entries);
+  check_items("lost batch", &r, 60);
+  const db_bulk_error_t* e = db_bulk_item_error(&r, 20);
+  CHECK(e && e->index == 20 && e->count == 20 && e->code == MONGOC_ERROR_STREAM_SOCKET, "lost batch error");
+}
+
+// More failures than DB_BULK_MAX_ERRORS: writes without a recorded error are not claimed ok
+static void check_error_overflow(void) {
+  db_bulk_result_t r;
+  for (size_t i = 0; i < 100; i++) kinds[i] = i % 2 ? ITEM_FAILS : ITEM_OK;
+  run(false, 0, 100, &r);
+  CHECK(r.error_count == 50 && r.error_entries == DB_BULK_MAX_ERRORS, "%zu errors in %zu entries", r.error_count,
+        r.error_entries);
+  for (size_t i = 0; i < 100; i++) CHECK(!db_bulk_item_ok(&r, i), "item %zu reported ok after the overflow", i);
+}
+
+// Round trips: one per batch instead of one per write
+static void report_round_trips(void) {
+  const size_t sizes[] = {55, 500, MAX_ITEMS};
+  memset(kinds, 0, sizeof(kinds));
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    db_bulk_result_t r;
+    size_t before = mongoc_fake_bulk_executes;
+    run(false, 0, sizes[s], &r);
+    CHECK(mongoc_fake_bulk_executes - before == r.batches && r.modified == (int64_t)sizes[s],
+          "%zu writes: %zu executes for %zu batches", sizes[s], mongoc_fake_bulk_executes - before, r.batches);
+    printf("%5zu writes: %zu round trips in bulk, %zu one by one\n", sizes[s], r.batches, sizes[s]);
+  }
+}
+
+int main(void) {
+  items = mongoc_fake_collection("bulk_items");
+  check_clean();
+  check_unordered_errors();
+  check_ordered_errors();
+  check_lost_batch();
+  check_error_overflow();
+  report_round_trips();
+  TEST_DONE("db_bulk_test");
+}
@@ -0,0 +1,159 @@
+#include "db_snapshot.h"
+#include "delegates_registry.h"
+#include "test_common.h"
+#include "mongoc_fake.h"
+
+/*
+ * A snapshot sync exports the delegates collection as raw BSON behind a SHA-256, sends it deflated and
+ * base64 encoded, and the receiver verifies it and upserts every document. For several collection
+ * sizes the round trip must rebuild the collection byte for byte and reload the registry, the delta
+ * layout must re-encode to the same snapshot, and any flipped byte or truncation must fail
+ * verification. Strings that are not snapshots must never decode to one that verifies.
+ *
+ * The collection lives in tests/mongoc_fake.h.
+ */
+
+#define TAMPER_TRIALS 200
+
+static uint64_t rng = 0x5851f42d4c957f2dull;
+
+static uint32_t rnd(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return (uint32_t)(rng >> 16);
+}
+
+static bson_t* delegate_doc(size_t n) {
+  char id[25], address[XCASH_WALLET_LENGTH + 1], key[80], name[32], ip[32];
+  snprintf(id, sizeof(id), "%024zx", n);
+  snprintf(address, sizeof(address), "%s%095zu", XCASH_WALLET_PREFIX, n);
+  snprintf(key, sizeof(key), "%064zx", n * 2654435761u);
+  snprintf(name, sizeof(name), "delegate_%zu", n);
+  snprintf(ip, sizeof(ip), "10.%zu.%zu.%zu", (n >> 16) & 255, (n >> 8) & 255, n & 255);
+
+  bson_t* doc = bson_new();
+  BSON_APPEND_UTF8(doc, "_id", id);
+  BSON_APPEND_UTF8(doc, "public_address", address);
+  BSON_APPEND_UTF8(doc, "IP_address", ip);
+  BSON_APPEND_UTF8(doc, "delegate_name", name);
+  BSON_APPEND_UTF8(doc, "about", "");
+  BSON_APPEND_UTF8(doc, "website", "");
+  BSON_APPEND_UTF8(doc, "team", "");
+  BSON_APPEND_UTF8(doc, "delegate_type", "shared");
+  BSON_APPEND_UTF8(doc, "server_specs", "");
+  BSON_APPEND_UTF8(doc, "online_status", n % 2 ? "true" : "false");
+  BSON_APPEND_UTF8(doc, "public_key", key);
+  BSON_APPEND_INT64(doc, "total_vote_count", (int64_t)rnd() * 1000003);
+  BSON_APPEND_DOUBLE(doc, "delegate_fee", 5.0);
+  BSON_APPEND_INT32(doc, "minimum_payout", 5000);
+  BSON_APPEND_DATE_TIME(doc, "registration_timestamp", (int64_t)(1700000000 + n) * 1000);
+  return doc;
+}
+
+// Whether the collection holds exactly the reference documents, byte for byte and in order
+static bool collection_matches(mongoc_collection_t* coll, bson_t** ref, size_t n) {
+  const mongoc_fake_collection_t* c = (const mongoc_fake_collection_t*)coll;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bool same = c->count == n;
+  for (size_t i = 0; same && i < n; i++) {
+    same = c->docs[i]->len == ref[i]->len &&
+           memcmp(bson_get_data(c->docs[i]), bson_get_data(ref[i]), ref[i]->len) == 0;
+  }
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return same;
+}
+
+static void check_round_trip(size_t n) {
+  mongoc_collection_t* coll = mongoc_fake_collection(DB_COLLECTION_DELEGATES);
+  mongoc_collection_drop(coll, NULL);
+  bson_t** ref = calloc(n, sizeof(*ref));
+  for (size_t i = 0; i < n; i++) {
+    ref[i] = delegate_doc(i);
+    mongoc_collection_insert_one(coll, ref[i], NULL, NULL, NULL);
+  }
+
+  // Responder: cursor to snapshot to string
+  db_snapshot_t snap;
+  uint64_t t0 = test_now_ns();
+  CHECK(db_snapshot_export(DATABASE_NAME, DB_COLLECTION_DELEGATES, &snap), "%zu: export", n);
+  char* encoded = db_snapshot_encode(&snap);
+  uint64_t t1 = test_now_ns();
+  CHECK(encoded && snap.count == n, "%zu: encode of %u documents", n, snap.count);
+
+  // Receiver: string to verified snapshot to collection
+  size_t len = 0;
+  uint32_t count = 0;
+  uint64_t t2 = test_now_ns();
+  uint8_t* data = db_snapshot_decode(encoded, &len);
+  bool verified = data && db_snapshot_verify(data, len, &count);
+  uint64_t t3 = test_now_ns();
+  CHECK(verified && count == n, "%zu: decoded snapshot does not verify (%u documents)", n, count);
+  CHECK(len == snap.len && memcmp(data, snap.data, len) == 0, "%zu: decoded snapshot differs from the export", n);
+
+  mongoc_collection_drop(coll, NULL);
+  bson_error_t error = {0};
+  CHECK(db_snapshot_import(DATABASE_NAME, DB_COLLECTION_DELEGATES, data, len, &error), "%zu: import: %s", n,
+        error.message);
+  CHECK(collection_matches(coll, ref, n), "%zu: imported collection differs (%zu documents)", n,
+        mongoc_fake_count(coll));
+  CHECK(delegates_registry_count() == (int)n, "%zu: registry holds %d delegates after the import", n,
+        delegates_registry_count());
+
+  // The delta layout re-encodes to the same snapshot
+  bson_t docs = BSON_INITIALIZER;
+  db_snapshot_t again;
+  CHECK(db_snapshot_to_bson(data, len, &docs) && bson_count_keys(&docs) == n, "%zu: to_bson", n);
+  CHECK(db_snapshot_begin(&again) && db_snapshot_add_all(&again, &docs) && db_snapshot_finish(&again) &&
+            again.len == len && memcmp(again.data, data, len) == 0,
+        "%zu: add_all does not rebuild the snapshot", n);
+
+  // Every flipped byte and every truncation is caught
+  size_t caught = 0, trials = 0;
+  uint8_t* copy = malloc(len);
+  for (size_t k = 0; k < TAMPER_TRIALS; k++, trials++) {
+    memcpy(copy, data, len);
+    copy[rnd() % len] ^= (uint8_t)(1 + rnd() % 255);
+    if (!db_snapshot_verify(copy, len, NULL)) caught++;
+  }
+  for (size_t cut = 1; cut <= 64; cut += 7, trials++) {
+    if (!db_snapshot_verify(data, len - cut, NULL)) caught++;
+  }
+  CHECK(caught == trials, "%zu: %zu of %zu damaged snapshots verified", n, trials - caught, trials);
+
+  char* json = bson_as_canonical_extended_json(&docs, NULL);
+  printf("%5zu delegates: snapshot %8zu bytes, encoded %8zu bytes, extended JSON %8zu bytes, "
+         "export+encode %.2f ms, decode+verify %.2f ms\n",
+         n, len, strlen(encoded), json ? strlen(json) : 0, (double)(t1 - t0) / 1e6, (double)(t3 - t2) / 1e6);
+  bson_free(json);
+
+  free(copy);
+  bson_destroy(&docs);
+  db_snapshot_free(&again);
+  free(data);
+  free(encoded);
+  db_snapshot_free(&snap);
+  for (size_t i = 0; i < n; i++) bson_destroy(ref[i]);
+  free(ref);
+}
+
+// Strings that are not snapshots never decode to one that verifies
+static void check_junk(void) {
+  const char* junk[] = {"", "abc", "====", "XDS1AAAA", "!!!!", "/////////AAA", "AAAAAAAAAAAA"};
+  for (size_t i = 0; i < sizeof(junk) / sizeof(junk[0]); i++) {
+    size_t len = 0;
+    uint8_t* data = db_snapshot_decode(junk[i], &len);
+    CHECK(!data || !db_snapshot_verify(data, len, NULL), "junk \"%s\" accepted", junk[i]);
+    free(data);
+  }
+}
+
+int main(void) {
+  // db_functions and the registry only need a pool to pop from; the fake hands out one client
+  database_client_thread_pool = (mongoc_client_pool_t*)&mongoc_fake_client;
+
+  const size_t sizes[] = {55, 500, 5000};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) check_round_trip(sizes[s]);
+  check_junk();
+  TEST_DONE("db_snapshot_test");
+}
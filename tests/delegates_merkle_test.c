@@ -0,0 +1,199 @@
+#include "delegates_merkle.h"
+#include "test_common.h"
+#include "mongoc_fake.h"
+
+/*
+ * A delegates sync sends the requester's Merkle tree, the responder answers with the documents of the
+ * leaves that differ, and the requester replaces those leaves. Starting from a responder with
+ * DELEGATES delegates and a requester holding them with a number of delegates modified, missing or
+ * extra, one round trip through the hex encodings must leave both with the same root, the same
+ * delegates hash and the same count, while sending only the documents of the differing leaves.
+ *
+ * The collection lives in tests/mongoc_fake.h; each side's state is written to it and reloaded into
+ * the registry before that side acts.
+ */
+
+#define DELEGATES 55
+#define MAX_DELEGATES 128
+#define TRIALS_PER_SIZE 20
+
+typedef struct {
+  bson_t* docs[MAX_DELEGATES];
+  size_t count;
+} delegates_state_t;
+
+static uint64_t rng = 0x9e3779b97f4a7c15ull;
+
+static uint32_t rnd(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return (uint32_t)(rng >> 16);
+}
+
+// Delegate n; version changes the IP address and the vote total as an update would
+static bson_t* delegate_doc(size_t n, size_t version) {
+  char address[XCASH_WALLET_LENGTH + 1], key[80], name[32], ip[32];
+  snprintf(address, sizeof(address), "%s%095zu", XCASH_WALLET_PREFIX, n);
+  snprintf(key, sizeof(key), "%064zx", n * 2654435761u);
+  snprintf(name, sizeof(name), "delegate%zu", n);
+  snprintf(ip, sizeof(ip), "10.%zu.%zu.%zu", version & 255, (n >> 8) & 255, n & 255);
+
+  bson_t* doc = bson_new();
+  BSON_APPEND_UTF8(doc, "_id", key);
+  BSON_APPEND_UTF8(doc, "public_address", address);
+  BSON_APPEND_INT64(doc, "total_vote_count", (int64_t)(rnd() % 100000));
+  BSON_APPEND_UTF8(doc, "IP_address", ip);
+  BSON_APPEND_UTF8(doc, "delegate_name", name);
+  BSON_APPEND_UTF8(doc, "about", "about this delegate, a fairly long description field");
+  BSON_APPEND_UTF8(doc, "website", "https://example.org/delegate");
+  BSON_APPEND_UTF8(doc, "team", "team");
+  BSON_APPEND_UTF8(doc, "delegate_type", n % 3 ? "shared" : "solo");
+  BSON_APPEND_DOUBLE(doc, "delegate_fee", (double)(n % 10));
+  BSON_APPEND_UTF8(doc, "server_specs", "8 cores 32GB");
+  BSON_APPEND_UTF8(doc, "online_status", "false");
+  BSON_APPEND_UTF8(doc, "public_key", key);
+  BSON_APPEND_DATE_TIME(doc, "registration_timestamp", (int64_t)n * 1000);
+  BSON_APPEND_INT64(doc, "minimum_payout", (int64_t)n);
+  return doc;
+}
+
+static size_t delegate_number(const bson_t* doc) {
+  bson_iter_t it;
+  bson_iter_init_find(&it, doc, "public_address");
+  return (size_t)strtoull(bson_iter_utf8(&it, NULL) + strlen(XCASH_WALLET_PREFIX), NULL, 10);
+}
+
+static void free_state(delegates_state_t* s) {
+  for (size_t i = 0; i < s->count; i++) bson_destroy(s->docs[i]);
+  s->count = 0;
+}
+
+// Makes the collection and the registry hold one side's delegates
+static void load_state(const delegates_state_t* s) {
+  mongoc_collection_t* coll = mongoc_fake_collection(DB_COLLECTION_DELEGATES);
+  mongoc_collection_drop(coll, NULL);
+  for (size_t i = 0; i < s->count; i++) mongoc_collection_insert_one(coll, s->docs[i], NULL, NULL, NULL);
+  CHECK(delegates_registry_load(), "registry load");
+}
+
+// The requester's copy: the responder's delegates with changes modified, removed or added
+static void diverge(const delegates_state_t* from, delegates_state_t* to, size_t changes, size_t trial) {
+  for (size_t i = 0; i < from->count; i++) to->docs[i] = bson_copy(from->docs[i]);
+  to->count = from->count;
+  for (size_t c = 0; c < changes; c++) {
+    size_t op = rnd() % 3, j = rnd() % to->count;
+    if (op == 0) {
+      size_t n = delegate_number(to->docs[j]);
+      bson_destroy(to->docs[j]);
+      to->docs[j] = delegate_doc(n, c + 1);
+    } else if (op == 1 && to->count > 1) {
+      bson_destroy(to->docs[j]);
+      memmove(&to->docs[j], &to->docs[j + 1], (to->count - j - 1) * sizeof(*to->docs));
+      to->count--;
+    } else {
+      to->docs[to->count++] = delegate_doc(1000 + trial * 100 + c, 0);
+    }
+  }
+}
+
+static void run_trial(size_t changes, size_t trial) {
+  delegates_state_t responder = {0}, requester = {0};
+  for (size_t n = 0; n < DELEGATES; n++) responder.docs[responder.count++] = delegate_doc(n, 0);
+  diverge(&responder, &requester, changes, trial);
+
+  // Requester: the tree goes out as hex
+  char root_hex[(SHA256_HASH_SIZE * 2) + 1], nodes_hex[DELEGATES_MERKLE_NODES_HEX_LENGTH + 1],
+      leaves_hex[DELEGATES_MERKLE_LEAVES_HEX_LENGTH + 1];
+  delegates_merkle_t requester_tree;
+  load_state(&requester);
+  CHECK(delegates_merkle_build(&requester_tree), "changes %zu trial %zu: requester build", changes, trial);
+  delegates_merkle_to_hex(&requester_tree, root_hex, nodes_hex, leaves_hex);
+
+  // Responder: decode, compare and export the differing leaves
+  delegates_merkle_t responder_tree, peer_tree;
+  bool differ[DELEGATES_MERKLE_LEAVES], all[DELEGATES_MERKLE_LEAVES];
+  char mask_hex[DELEGATES_MERKLE_MASK_HEX_LENGTH + 1], responder_hash[(SHA256_HASH_SIZE * 2) + 1];
+  bson_t payload = BSON_INITIALIZER, full = BSON_INITIALIZER;
+  load_state(&responder);
+  CHECK(delegates_merkle_from_hex(root_hex, nodes_hex, leaves_hex, &peer_tree), "changes %zu trial %zu: decode",
+        changes, trial);
+  CHECK(delegates_merkle_build(&responder_tree), "changes %zu trial %zu: responder build", changes, trial);
+  size_t differing = delegates_merkle_diff(&responder_tree, &peer_tree, differ);
+  CHECK(delegates_registry_export_leaves(differ, DELEGATES_MERKLE_LEAVES, &payload), "export leaves");
+  for (size_t l = 0; l < DELEGATES_MERKLE_LEAVES; l++) all[l] = true;
+  CHECK(delegates_registry_export_leaves(all, DELEGATES_MERKLE_LEAVES, &full), "export all leaves");
+  delegates_merkle_mask_to_hex(differ, mask_hex);
+  CHECK(delegates_registry_hash(responder_hash), "responder hash");
+
+  CHECK(changes != 0 || differing == 0, "trial %zu: %zu leaves differ between equal collections", trial, differing);
+  CHECK(changes == 0 || differing <= changes, "changes %zu trial %zu: %zu leaves differ", changes, trial, differing);
+  CHECK(bson_count_keys(&payload) <= bson_count_keys(&full), "changes %zu trial %zu: reply larger than the export",
+        changes, trial);
+
+  // Requester: replace the leaves the responder named
+  bool mask[DELEGATES_MERKLE_LEAVES];
+  size_t upserted = 0, removed = 0;
+  char requester_hash[(SHA256_HASH_SIZE * 2) + 1];
+  delegates_merkle_t after;
+  load_state(&requester);
+  CHECK(delegates_merkle_mask_from_hex(mask_hex, mask), "changes %zu trial %zu: mask decode", changes, trial);
+  bool applied = delegates_merkle_apply(mask, &payload, &upserted, &removed);
+  CHECK(applied && delegates_merkle_build(&after) && delegates_registry_hash(requester_hash),
+        "changes %zu trial %zu: apply", changes, trial);
+  CHECK(memcmp(after.root, responder_tree.root, SHA256_HASH_SIZE) == 0 &&
+            strcmp(requester_hash, responder_hash) == 0 && delegates_registry_count() == (int)responder.count,
+        "changes %zu trial %zu: did not converge (%d delegates, responder %zu)", changes, trial,
+        delegates_registry_count(), responder.count);
+  CHECK(upserted == bson_count_keys(&payload), "changes %zu trial %zu: %zu of %u documents written", changes, trial,
+        upserted, bson_count_keys(&payload));
+
+  if (trial == 0) {
+    printf("changes %2zu: %2zu leaves differ, %2u documents sent, %2zu written, %2zu removed, reply %6u bytes "
+           "vs full %6u bytes\n",
+           changes, differing, bson_count_keys(&payload), upserted, removed, payload.len, full.len);
+  }
+  bson_destroy(&payload);
+  bson_destroy(&full);
+  free_state(&responder);
+  free_state(&requester);
+}
+
+// A document outside the leaves being replaced rejects the whole payload before anything is written
+static void check_foreign_document(void) {
+  delegates_state_t state = {0};
+  for (size_t n = 0; n < DELEGATES; n++) state.docs[state.count++] = delegate_doc(n, 0);
+  load_state(&state);
+
+  char before[(SHA256_HASH_SIZE * 2) + 1], after[(SHA256_HASH_SIZE * 2) + 1];
+  CHECK(delegates_registry_hash(before), "hash");
+  bson_t* outsider = delegate_doc(5000, 7);
+  bool mask[DELEGATES_MERKLE_LEAVES] = {false};
+  bson_iter_t it;
+  bson_iter_init_find(&it, outsider, "public_address");
+  size_t home = delegates_registry_leaf_of(bson_iter_utf8(&it, NULL), DELEGATES_MERKLE_LEAVES);
+  mask[(home + 1) % DELEGATES_MERKLE_LEAVES] = true;
+
+  bson_t payload = BSON_INITIALIZER;
+  BSON_APPEND_DOCUMENT(&payload, "0", outsider);
+  size_t upserted = 1, removed = 1;
+  CHECK(!delegates_merkle_apply(mask, &payload, &upserted, &removed), "foreign document accepted");
+  CHECK(upserted == 0 && removed == 0 && delegates_registry_hash(after) && strcmp(before, after) == 0 &&
+            delegates_registry_count() == DELEGATES,
+        "rejected payload changed the collection");
+  bson_destroy(&payload);
+  bson_destroy(outsider);
+  free_state(&state);
+}
+
+int main(void) {
+  // The registry and db_functions only need a pool to pop from; the fake hands out one client
+  database_client_thread_pool = (mongoc_client_pool_t*)&mongoc_fake_client;
+
+  const size_t sizes[] = {0, 1, 2, 5, 10, 25, DELEGATES};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for (size_t trial = 0; trial < TRIALS_PER_SIZE; trial++) run_trial(sizes[s], trial);
+  }
+  check_foreign_document();
+  TEST_DONE("delegates_merkle_test");
+}
@@ -0,0 +1,549 @@
+#include <stdatomic.h>
+#include "delegates_registry.h"
+#include "db_functions.h"
+#include "db_bulk.h"
+#include "test_common.h"
+#include "mongoc_fake.h"
+
+/*
+ * The delegates registry answers delegate lookups and the delegates hash from memory, so it has to
+ * follow every write to the collection. Seeded random inserts, IP changes, renames, vote totals,
+ * replaces, deletes, rejected duplicates and whole-collection syncs go through the db_functions write
+ * paths while reader threads query the registry, and every CHECK_EVERY writes the registry is compared
+ * with the collection: count, per-key lookups (including keys that were renamed or deleted away), the
+ * export, the summed SHA-256 digest, the MD5 hash and the digest stored next to the data. A change
+ * stream then carries writes made behind the registry's back, as another seed's arrive, ending with a
+ * drop. Steady-state rounds must not read the delegates collection at all.
+ *
+ * The collections live in tests/mongoc_fake.h.
+ */
+
+#define SEED_DELEGATES 150
+#define RANDOM_WRITES 3000
+#define CHECK_EVERY 100
+#define SYNC_EVERY 250
+#define STREAM_WRITES 300
+#define READERS 2
+#define RETIRED_KEYS 64
+#define WATCH_TIMEOUT_MS 20000
+#define STATUS_ROUNDS 20
+
+typedef struct {
+  delegates_key_t key;
+  char value[XCASH_WALLET_LENGTH + 1];
+} retired_key_t;
+
+static mongoc_collection_t* delegates;
+static uint64_t rng = 0x2545f4914f6cdd1dull;
+static atomic_size_t next_delegate;
+static retired_key_t retired[RETIRED_KEYS];
+static size_t retired_count;
+static atomic_bool readers_stop;
+static atomic_ulong reader_ops, reader_errors;
+
+static uint64_t rnd_r(uint64_t* s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 7;
+  *s ^= *s << 17;
+  return *s;
+}
+
+static uint32_t rnd(void) {
+  return (uint32_t)(rnd_r(&rng) >> 16);
+}
+
+static void delegate_address(size_t n, char out[XCASH_WALLET_LENGTH + 1]) {
+  snprintf(out, XCASH_WALLET_LENGTH + 1, "%s%095zu", XCASH_WALLET_PREFIX, n);
+}
+
+// A delegates document as registration writes it; _id is added by the insert path
+static bson_t* delegate_doc(size_t n) {
+  char address[XCASH_WALLET_LENGTH + 1], key[80], name[32], ip[32];
+  delegate_address(n, address);
+  snprintf(key, sizeof(key), "%064zx", n * 2654435761u);
+  snprintf(name, sizeof(name), "delegate%zu", n);
+  snprintf(ip, sizeof(ip), "10.%zu.%zu.%zu", (n >> 16) & 255, (n >> 8) & 255, n & 255);
+
+  bson_t* doc = bson_new();
+  BSON_APPEND_UTF8(doc, "public_address", address);
+  BSON_APPEND_INT64(doc, "total_vote_count", (int64_t)(rnd() % 100000));
+  BSON_APPEND_UTF8(doc, "IP_address", ip);
+  BSON_APPEND_UTF8(doc, "delegate_name", name);
+  BSON_APPEND_UTF8(doc, "about", "about");
+  BSON_APPEND_UTF8(doc, "website", "example.com");
+  BSON_APPEND_UTF8(doc, "team", "team");
+  BSON_APPEND_UTF8(doc, "delegate_type", n % 3 ? "shared" : "solo");
+  BSON_APPEND_DOUBLE(doc, "delegate_fee", (double)(n % 10));
+  BSON_APPEND_UTF8(doc, "server_specs", "specs");
+  BSON_APPEND_UTF8(doc, "online_status", "false");
+  BSON_APPEND_UTF8(doc, "public_key", key);
+  BSON_APPEND_DATE_TIME(doc, "registration_timestamp", (int64_t)n * 1000);
+  BSON_APPEND_INT64(doc, "minimum_payout", (int64_t)n);
+  return doc;
+}
+
+static const char* doc_utf8(const bson_t* doc, const char* field) {
+  bson_iter_t it;
+  return bson_iter_init_find(&it, doc, field) && BSON_ITER_HOLDS_UTF8(&it) ? bson_iter_utf8(&it, NULL) : "";
+}
+
+static int doc_id_cmp(const void* a, const void* b) {
+  return strcmp(doc_utf8(*(const bson_t* const*)a, "_id"), doc_utf8(*(const bson_t* const*)b, "_id"));
+}
+
+// Copies of the documents in the delegates collection, sorted by _id
+static size_t snapshot(bson_t*** out) {
+  const mongoc_fake_collection_t* c = (const mongoc_fake_collection_t*)delegates;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  size_t n = c->count;
+  bson_t** docs = calloc(n + 1, sizeof(*docs));
+  for (size_t i = 0; i < n; i++) docs[i] = bson_copy(c->docs[i]);
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  qsort(docs, n, sizeof(*docs), doc_id_cmp);
+  *out = docs;
+  return n;
+}
+
+static void free_snapshot(bson_t** docs, size_t n) {
+  for (size_t i = 0; i < n; i++) bson_destroy(docs[i]);
+  free(docs);
+}
+
+// Copy of a random document, NULL when the collection is empty
+static bson_t* pick_delegate(void) {
+  const mongoc_fake_collection_t* c = (const mongoc_fake_collection_t*)delegates;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bson_t* doc = c->count ? bson_copy(c->docs[rnd() % c->count]) : NULL;
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return doc;
+}
+
+// Remembers a key a write took away from a delegate, so later checks can see it is gone
+static void retire(delegates_key_t key, const char* value) {
+  retired_key_t* r = &retired[retired_count++ % RETIRED_KEYS];
+  r->key = key;
+  snprintf(r->value, sizeof(r->value), "%s", value);
+}
+
+static const char* const key_fields[DELEGATES_KEY_COUNT] = {"public_address", "delegate_name", "IP_address",
+                                                            "public_key"};
+
+// Compares the registry with the collection it mirrors
+static void check_registry(const char* when) {
+  bson_t** docs;
+  size_t n = snapshot(&docs);
+
+  CHECK(delegates_registry_count() == (int)n, "%s: registry holds %d delegates, collection %zu", when,
+        delegates_registry_count(), n);
+
+  // The delegates hash: sum of the document digests, whatever their order
+  uint8_t sum[SHA256_HASH_SIZE] = {0};
+  for (size_t i = 0; i < n; i++) {
+    uint8_t digest[SHA256_HASH_SIZE];
+    CHECK(delegates_doc_digest(docs[i], digest), "%s: digest of document %zu", when, i);
+    delegates_digest_add(sum, digest);
+  }
+  char want[(SHA256_HASH_SIZE * 2) + 1], got[(SHA256_HASH_SIZE * 2) + 1];
+  bin_to_hex(sum, SHA256_HASH_SIZE, want);
+  CHECK(delegates_registry_hash(got) && strcmp(got, want) == 0, "%s: hash %s, collection %s", when, got, want);
+
+  // The digest kept next to the data
+  bson_t* selector = BCON_NEW("_id", BCON_UTF8(DB_COLLECTION_DELEGATES));
+  mongoc_cursor_t* cur =
+      mongoc_collection_find_with_opts(mongoc_fake_collection(DB_COLLECTION_DELEGATES_DIGEST), selector, NULL, NULL);
+  const bson_t* stored;
+  bson_iter_t it;
+  bool have = mongoc_cursor_next(cur, &stored);
+  CHECK(have && strcmp(doc_utf8(stored, "digest"), want) == 0 && bson_iter_init_find(&it, stored, "count") &&
+            bson_iter_as_int64(&it) == (int64_t)n,
+        "%s: stored digest %s", when, have ? doc_utf8(stored, "digest") : "missing");
+  mongoc_cursor_destroy(cur);
+  bson_destroy(selector);
+
+  // The MD5 hash, over the documents in _id order
+  unsigned char md5[MD5_HASH_SIZE];
+  char want_md5[(MD5_HASH_SIZE * 2) + 1], got_md5[(MD5_HASH_SIZE * 2) + 1];
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  EVP_DigestInit_ex(ctx, EVP_md5(), NULL);
+  for (size_t i = 0; i < n; i++) delegates_doc_md5_update(ctx, docs[i]);
+  EVP_DigestFinal_ex(ctx, md5, NULL);
+  EVP_MD_CTX_free(ctx);
+  bin_to_hex(md5, MD5_HASH_SIZE, want_md5);
+  CHECK(delegates_registry_hash_md5(got_md5) && strcmp(got_md5, want_md5) == 0, "%s: MD5 hash %s, collection %s",
+        when, got_md5, want_md5);
+
+  // The export holds the stored bytes of each document, in _id order, without _id
+  bson_t exported = BSON_INITIALIZER;
+  size_t export_mismatches = 0, exported_count = 0;
+  CHECK(delegates_registry_export(&exported), "%s: export", when);
+  bson_iter_init(&it, &exported);
+  while (bson_iter_next(&it)) {
+    uint32_t len;
+    const uint8_t* data;
+    bson_t want_doc = BSON_INITIALIZER;
+    if (exported_count < n) bson_copy_to_excluding_noinit(docs[exported_count], &want_doc, "_id", NULL);
+    bson_iter_document(&it, &len, &data);
+    if (exported_count >= n || len != want_doc.len || memcmp(data, bson_get_data(&want_doc), len) != 0) {
+      export_mismatches++;
+    }
+    bson_destroy(&want_doc);
+    exported_count++;
+  }
+  bson_destroy(&exported);
+  CHECK(exported_count == n && export_mismatches == 0, "%s: export of %zu documents, %zu differ", when,
+        exported_count, export_mismatches);
+
+  // Every key of every document finds it, and finds its current values
+  size_t lookup_mismatches = 0;
+  for (size_t i = 0; i < n; i++) {
+    const char* address = doc_utf8(docs[i], "public_address");
+    char value[XCASH_WALLET_LENGTH + 1];
+    int64_t votes = -1;
+    bson_iter_init_find(&it, docs[i], "total_vote_count");
+    int64_t want_votes = bson_iter_as_int64(&it);
+    if (!delegates_registry_get_utf8(DELEGATES_KEY_ADDRESS, address, "IP_address", value, sizeof(value)) ||
+        strcmp(value, doc_utf8(docs[i], "IP_address")) != 0) {
+      lookup_mismatches++;
+    }
+    if (!delegates_registry_get_int64(DELEGATES_KEY_ADDRESS, address, "total_vote_count", &votes) ||
+        votes != want_votes) {
+      lookup_mismatches++;
+    }
+    for (int k = DELEGATES_KEY_NAME; k < DELEGATES_KEY_COUNT; k++) {
+      if (!delegates_registry_get_utf8((delegates_key_t)k, doc_utf8(docs[i], key_fields[k]), "public_address", value,
+                                       sizeof(value)) ||
+          strcmp(value, address) != 0) {
+        lookup_mismatches++;
+      }
+    }
+  }
+  CHECK(lookup_mismatches == 0, "%s: %zu lookups disagree with the collection", when, lookup_mismatches);
+
+  // Keys writes took away are found only if some document still has them
+  size_t stale = 0;
+  for (size_t r = 0; r < retired_count && r < RETIRED_KEYS; r++) {
+    bool present = false;
+    for (size_t i = 0; i < n && !present; i++) {
+      present = strcmp(doc_utf8(docs[i], key_fields[retired[r].key]), retired[r].value) == 0;
+    }
+    if (delegates_registry_has(retired[r].key, retired[r].value) != present) stale++;
+  }
+  CHECK(stale == 0, "%s: %zu removed keys still answer", when, stale);
+
+  free_snapshot(docs, n);
+}
+
+static void* reader_main(void* arg) {
+  uint64_t state = 0x9e3779b97f4a7c15ull * ((uintptr_t)arg + 1);
+  char address[XCASH_WALLET_LENGTH + 1], value[XCASH_WALLET_LENGTH + 1], hash[(SHA256_HASH_SIZE * 2) + 1];
+  while (!atomic_load(&readers_stop)) {
+    size_t n = (size_t)(rnd_r(&state) % (atomic_load(&next_delegate) + 1));
+    delegate_address(n, address);
+    if (delegates_registry_get_utf8(DELEGATES_KEY_ADDRESS, address, "public_address", value, sizeof(value)) &&
+        strcmp(value, address) != 0) {
+      atomic_fetch_add(&reader_errors, 1);
+    }
+    if (n % 16 == 0 && !delegates_registry_hash(hash)) atomic_fetch_add(&reader_errors, 1);
+    if (n % 64 == 0) {
+      bson_t exported = BSON_INITIALIZER;
+      if (!delegates_registry_export(&exported)) atomic_fetch_add(&reader_errors, 1);
+      bson_destroy(&exported);
+    }
+    atomic_fetch_add(&reader_ops, 1);
+  }
+  return NULL;
+}
+
+// Exports the collection, drops it and writes the export back, as a DB sync does
+static void sync_collection(void) {
+  bson_t exported;
+  bson_error_t error;
+  CHECK(db_export_collection_to_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, &exported, &error), "export");
+  CHECK(db_drop(DATABASE_NAME, DB_COLLECTION_DELEGATES, &error), "drop: %s", error.message);
+  CHECK(db_upsert_multi_docs(DATABASE_NAME, DB_COLLECTION_DELEGATES, &exported, &error), "upsert: %s",
+        error.message);
+  bson_destroy(&exported);
+}
+
+// One write through db_functions; returns which kind it was
+static int random_write(int step) {
+  // Inserts are drawn twice as often, as many as the two kinds of delete, so the size stays near the
+  // seed; a duplicate (logged as an error) is tried once per CHECK_EVERY writes
+  static const int weights[] = {0, 0, 1, 2, 3, 4, 5, 6};
+  bson_t* victim = pick_delegate();
+  int op = victim ? weights[rnd() % (sizeof(weights) / sizeof(weights[0]))] : 0;
+  if (victim && step % CHECK_EVERY == 0) op = 7;
+  bson_error_t error;
+  char value[64];
+
+  switch (op) {
+    case 0: {
+      bson_t* doc = delegate_doc(atomic_fetch_add(&next_delegate, 1));
+      CHECK(insert_document_into_collection_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, doc) == XCASH_OK, "insert");
+      bson_destroy(doc);
+      break;
+    }
+    case 1: {
+      bson_t* filter = BCON_NEW("public_address", BCON_UTF8(doc_utf8(victim, "public_address")));
+      snprintf(value, sizeof(value), "11.%u.%u.%u", rnd() % 256, rnd() % 256, rnd() % 256);
+      bson_t* set = BCON_NEW("IP_address", BCON_UTF8(value));
+      retire(DELEGATES_KEY_IP, doc_utf8(victim, "IP_address"));
+      CHECK(update_document_from_collection_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, filter, set) == XCASH_OK,
+            "IP update");
+      bson_destroy(set);
+      bson_destroy(filter);
+      break;
+    }
+    case 2: {
+      bson_t* filter = BCON_NEW("delegate_name", BCON_UTF8(doc_utf8(victim, "delegate_name")));
+      snprintf(value, sizeof(value), "renamed%d", step);
+      bson_t* set = BCON_NEW("delegate_name", BCON_UTF8(value));
+      retire(DELEGATES_KEY_NAME, doc_utf8(victim, "delegate_name"));
+      CHECK(update_document_from_collection_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, filter, set) == XCASH_OK,
+            "rename");
+      bson_destroy(set);
+      bson_destroy(filter);
+      break;
+    }
+    case 3:
+      CHECK(delegates_apply_vote_total(doc_utf8(victim, "public_address"), (int64_t)(rnd() % 1000000)), "vote total");
+      break;
+    case 4: {
+      char json[256];
+      snprintf(json, sizeof(json), "{\"public_address\":\"%s\"}", doc_utf8(victim, "public_address"));
+      retire(DELEGATES_KEY_ADDRESS, doc_utf8(victim, "public_address"));
+      CHECK(delete_document_from_collection(DATABASE_NAME, DB_COLLECTION_DELEGATES, json) == XCASH_OK, "delete");
+      break;
+    }
+    case 5: {
+      // Replace the whole document, changing one field
+      bson_t* doc = bson_new();
+      bson_iter_t it;
+      snprintf(value, sizeof(value), "about%d", step);
+      bson_iter_init(&it, victim);
+      while (bson_iter_next(&it)) {
+        if (strcmp(bson_iter_key(&it), "about") == 0) {
+          BSON_APPEND_UTF8(doc, "about", value);
+        } else {
+          bson_append_iter(doc, bson_iter_key(&it), -1, &it);
+        }
+      }
+      CHECK(db_upsert_doc(DATABASE_NAME, DB_COLLECTION_DELEGATES, doc, &error), "replace: %s", error.message);
+      bson_destroy(doc);
+      break;
+    }
+    case 6: {
+      bson_t* query = BCON_NEW("delegate_name", BCON_UTF8(doc_utf8(victim, "delegate_name")));
+      retire(DELEGATES_KEY_PUBLIC_KEY, doc_utf8(victim, "public_key"));
+      CHECK(db_delete_doc(DATABASE_NAME, DB_COLLECTION_DELEGATES, query, &error), "delete many: %s", error.message);
+      bson_destroy(query);
+      break;
+    }
+    case 7: {
+      // Registering an existing public key again fails and changes nothing
+      bson_t* doc = bson_new();
+      bson_copy_to_excluding_noinit(victim, doc, "_id", NULL);
+      CHECK(insert_document_into_collection_bson(DATABASE_NAME, DB_COLLECTION_DELEGATES, doc) == XCASH_ERROR,
+            "duplicate insert accepted");
+      bson_destroy(doc);
+      break;
+    }
+  }
+  if (victim) bson_destroy(victim);
+  return op;
+}
+
+static void wait_watch_idle(const char* when) {
+  uint64_t deadline = test_now_ns() + (uint64_t)WATCH_TIMEOUT_MS * 1000000;
+  while (!mongoc_fake_watch_idle(delegates) && test_now_ns() < deadline) usleep(1000);
+  CHECK(mongoc_fake_watch_idle(delegates), "%s: change stream not drained after %d ms", when, WATCH_TIMEOUT_MS);
+}
+
+// Writes straight to the collection, bypassing db_functions, as another seed's writes arrive
+static void stream_write(int step, bool insert) {
+  bson_t* victim = insert ? NULL : pick_delegate();
+  int op = victim ? (int)(rnd() % 4) : 0;
+  char value[64];
+
+  if (op == 0) {
+    bson_t* doc = delegate_doc(atomic_fetch_add(&next_delegate, 1));
+    BSON_APPEND_UTF8(doc, "_id", doc_utf8(doc, "public_key"));
+    mongoc_collection_insert_one(delegates, doc, NULL, NULL, NULL);
+    bson_destroy(doc);
+  } else {
+    bson_t* filter = BCON_NEW("_id", BCON_UTF8(doc_utf8(victim, "_id")));
+    if (op == 1) {
+      snprintf(value, sizeof(value), "12.0.%d.%d", step / 256, step % 256);
+      bson_t* update = BCON_NEW("$set", "{", "IP_address", BCON_UTF8(value), "}");
+      retire(DELEGATES_KEY_IP, doc_utf8(victim, "IP_address"));
+      mongoc_collection_update_one(delegates, filter, update, NULL, NULL, NULL);
+      bson_destroy(update);
+    } else if (op == 2) {
+      bson_t* doc = bson_new();
+      bson_copy_to_excluding_noinit(victim, doc, "_id", "delegate_name", NULL);
+      snprintf(value, sizeof(value), "seed%d", step);
+      BSON_APPEND_UTF8(doc, "delegate_name", value);
+      retire(DELEGATES_KEY_NAME, doc_utf8(victim, "delegate_name"));
+      mongoc_collection_replace_one(delegates, filter, doc, NULL, NULL, NULL);
+      bson_destroy(doc);
+    } else {
+      retire(DELEGATES_KEY_ADDRESS, doc_utf8(victim, "public_address"));
+      mongoc_collection_delete_one(delegates, filter, NULL, NULL, NULL);
+    }
+    bson_destroy(filter);
+  }
+  if (victim) bson_destroy(victim);
+}
+
+// Rounds of hashing, exporting and per-message lookups, none of which may read the collection
+static void check_steady_state(const char* when) {
+  bson_t** docs;
+  size_t n = snapshot(&docs);
+  CHECK(n > 0, "%s: empty collection", when);
+  snprintf(xcash_wallet_public_address, sizeof(xcash_wallet_public_address), "%s", doc_utf8(docs[0], "public_address"));
+
+  size_t reads = mongoc_fake_reads(delegates);
+  char hash[(SHA256_HASH_SIZE * 2) + 1], md5[(MD5_HASH_SIZE * 2) + 1], value[64];
+  double fee;
+  for (int round = 0; round < 100; round++) {
+    bson_t exported = BSON_INITIALIZER;
+    CHECK(delegates_registry_hash(hash) && delegates_registry_hash_md5(md5) && delegates_registry_export(&exported),
+          "%s: round %d", when, round);
+    bson_destroy(&exported);
+    CHECK(delegates_registry_count() == (int)n, "%s: count", when);
+    for (int message = 0; message < 100; message++) {
+      const bson_t* doc = docs[rnd() % n];
+      if (!delegates_registry_has(DELEGATES_KEY_ADDRESS, doc_utf8(doc, "public_address")) ||
+          !delegates_registry_get_utf8(DELEGATES_KEY_ADDRESS, doc_utf8(doc, "public_address"), "IP_address", value,
+                                       sizeof(value))) {
+        CHECK(0, "%s: lookup of a registered delegate failed", when);
+      }
+    }
+    CHECK(get_delegate_fee(&fee) == XCASH_OK, "%s: delegate fee", when);
+  }
+  CHECK(mongoc_fake_reads(delegates) == reads, "%s: %zu reads of the delegates collection in steady state", when,
+        mongoc_fake_reads(delegates) - reads);
+  free_snapshot(docs, n);
+}
+
+// The per-round online_status and vote total bulks go straight to the collection and are applied to
+// the registry with delegates_registry_apply_set, without reading the collection back
+static void check_round_sets(void) {
+  size_t reads = mongoc_fake_reads(delegates);
+  for (int round = 0; round < STATUS_ROUNDS; round++) {
+    bson_t** docs;
+    size_t n = snapshot(&docs);
+    db_bulk_t bulk;
+    db_bulk_result_t result;
+    bson_t* sets[16];
+    const char* keys[16];
+    size_t count = n < 16 ? n : 16;
+    CHECK(db_bulk_init(&bulk, delegates, false, 0), "round %d: bulk", round);
+    for (size_t k = 0; k < count; k++) {
+      const bson_t* doc = docs[rnd() % n];
+      keys[k] = doc_utf8(doc, "public_key");
+      if (k % 3 == 0) {
+        sets[k] = BCON_NEW("online_status", BCON_UTF8(strcmp(doc_utf8(doc, "online_status"), "true") ? "true" : "false"));
+      } else if (k % 3 == 1) {
+        sets[k] = BCON_NEW("total_vote_count", BCON_INT64((int64_t)(rnd() % 1000000)));
+      } else {
+        // A field the document does not have yet is appended
+        sets[k] = BCON_NEW("last_round_seen", BCON_INT64(round));
+      }
+      bson_t* filter = BCON_NEW("public_key", BCON_UTF8(keys[k]));
+      bson_t* update = BCON_NEW("$set", BCON_DOCUMENT(sets[k]));
+      db_bulk_update(&bulk, filter, update, false);
+      bson_destroy(update);
+      bson_destroy(filter);
+    }
+    CHECK(db_bulk_finish(&bulk, &result), "round %d: bulk write", round);
+    for (size_t k = 0; k < count; k++) {
+      CHECK(db_bulk_item_ok(&result, k) && delegates_registry_apply_set(DELEGATES_KEY_PUBLIC_KEY, keys[k], sets[k]),
+            "round %d: apply_set %zu", round, k);
+      bson_destroy(sets[k]);
+    }
+    free_snapshot(docs, n);
+
+    char when[32];
+    snprintf(when, sizeof(when), "status round %d", round);
+    size_t before = mongoc_fake_reads(delegates);
+    check_registry(when);
+    reads += mongoc_fake_reads(delegates) - before;
+  }
+  CHECK(mongoc_fake_reads(delegates) == reads, "%zu reads of the delegates collection for round status writes",
+        mongoc_fake_reads(delegates) - reads);
+}
+
+int main(void) {
+  // The registry and db_functions only need a pool to pop from; the fake hands out one client
+  database_client_thread_pool = (mongoc_client_pool_t*)&mongoc_fake_client;
+  delegates = mongoc_fake_collection(DB_COLLECTION_DELEGATES);
+
+  for (size_t i = 0; i < SEED_DELEGATES; i++) {
+    bson_t* doc = delegate_doc(i);
+    BSON_APPEND_UTF8(doc, "_id", doc_utf8(doc, "public_key"));
+    mongoc_collection_insert_one(delegates, doc, NULL, NULL, NULL);
+    bson_destroy(doc);
+  }
+  atomic_store(&next_delegate, SEED_DELEGATES);
+  check_registry("initial load");
+  check_steady_state("after the initial load");
+
+  // Write-through: every db_functions write refreshes the registry
+  pthread_t readers[READERS];
+  for (uintptr_t i = 0; i < READERS; i++) pthread_create(&readers[i], NULL, reader_main, (void*)i);
+  int ops[8] = {0};
+  size_t syncs = 0;
+  for (int step = 1; step <= RANDOM_WRITES; step++) {
+    ops[random_write(step)]++;
+    if (step % SYNC_EVERY == 0) {
+      sync_collection();
+      syncs++;
+    }
+    if (step % CHECK_EVERY == 0) {
+      char when[32];
+      snprintf(when, sizeof(when), "write %d", step);
+      check_registry(when);
+    }
+  }
+  delegates_registry_stats_t st;
+  delegates_registry_get_stats(&st, true);
+  CHECK(st.loads == syncs + 1, "%llu full loads for %zu syncs: a write fell back to reading everything",
+        (unsigned long long)st.loads, syncs);
+  printf("write-through: %d inserts, %d IP changes, %d renames, %d vote totals, %d deletes, %d replaces, "
+         "%d delete_many, %d duplicates, %zu syncs; %llu documents re-read, %llu removed, %zu delegates\n",
+         ops[0], ops[1], ops[2], ops[3], ops[4], ops[5], ops[6], ops[7], syncs, (unsigned long long)st.refreshes,
+         (unsigned long long)st.removals, st.delegates);
+  check_steady_state("after the random writes");
+  check_round_sets();
+  check_steady_state("after the round status writes");
+
+  // Change stream: writes that reach Mongo without passing through this node
+  CHECK(delegates_registry_start_watch(), "start watch");
+  wait_watch_idle("watch start");
+  for (int step = 0; step < STREAM_WRITES; step++) {
+    stream_write(step, false);
+    if (step % 10 == 0) random_write(RANDOM_WRITES + step);
+  }
+  wait_watch_idle("stream writes");
+  check_registry("stream writes");
+
+  // A drop invalidates the stream; what is written before it reopens is picked up by its reload
+  mongoc_collection_drop(delegates, NULL);
+  for (int step = 0; step < SEED_DELEGATES; step++) stream_write(STREAM_WRITES + step, step < SEED_DELEGATES / 2);
+  wait_watch_idle("drop");
+  check_registry("drop and rewrite");
+  delegates_registry_get_stats(&st, false);
+  CHECK(st.events > STREAM_WRITES, "%llu change events applied", (unsigned long long)st.events);
+  printf("change stream: %d writes from another seed and a drop; %llu events applied, %llu loads, %zu delegates\n",
+         STREAM_WRITES + SEED_DELEGATES, (unsigned long long)st.events, (unsigned long long)st.loads, st.delegates);
+
+  atomic_store(&readers_stop, true);
+  for (int i = 0; i < READERS; i++) pthread_join(readers[i], NULL);
+  delegates_registry_stop_watch();
+  check_steady_state("after the change stream");
+  CHECK(atomic_load(&reader_errors) == 0, "%lu reader errors", atomic_load(&reader_errors));
+  printf("readers: %lu concurrent lookups\n", atomic_load(&reader_ops));
+
+  TEST_DONE("delegates_registry_test");
+}
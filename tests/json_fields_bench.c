@@ -0,0 +1,69 @@
+#include "string_functions.h"
+#include "test_common.h"
+
+/*
+ * CPU per RPC response for the fields each caller reads: one parse_json_data call per field (a
+ * cJSON tree per call) against a single parse_json_fields pass.
+ */
+
+#define BENCH_ROUNDS 20000
+#define MAX_FIELDS 6
+
+typedef struct {
+  const char* name;
+  const char* fixture;
+  const char* paths[MAX_FIELDS];
+} bench_case_t;
+
+static const bench_case_t CASES[] = {
+  {"is_blockchain_synced", "daemon_get_info.json", {"result.synchronized", "result.status", "result.busy_syncing",
+                                                    "result.height", "result.target_height", "result.offline"}},
+  {"get_block_template", "daemon_get_block_template.json", {"result.blocktemplate_blob", "result.reserved_offset"}},
+  {"get_block_info_by_height", "daemon_get_block_header.json", {"result.block_header.hash",
+    "result.block_header.reward", "result.block_header.timestamp", "result.block_header.orphan_status"}},
+  {"check_reserve_proof", "wallet_check_reserve_proof.json", {"result.good", "result.spent", "result.total"}},
+};
+
+static char values[MAX_FIELDS][BUFFER_SIZE_NETWORK_BLOCK_DATA * 4];
+
+static void bench(const bench_case_t* c) {
+  char* data = test_read_fixture(c->fixture, NULL);
+  json_field_t fields[MAX_FIELDS];
+  size_t count = 0;
+  for (; count < MAX_FIELDS && c->paths[count]; count++) {
+    fields[count] = (json_field_t){c->paths[count], values[count], sizeof(values[count]), false};
+  }
+
+  uint64_t start = test_now_ns();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    for (size_t i = 0; i < count; i++) {
+      if (parse_json_data(data, fields[i].path, fields[i].out, fields[i].out_size) != XCASH_OK) {
+        CHECK(0, "%s: parse_json_data %s", c->fixture, fields[i].path);
+        goto done;
+      }
+    }
+  }
+  uint64_t old_ns = test_now_ns() - start;
+
+  start = test_now_ns();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    if (parse_json_fields(data, fields, count) != XCASH_OK) {
+      CHECK(0, "%s: parse_json_fields", c->fixture);
+      goto done;
+    }
+  }
+  uint64_t new_ns = test_now_ns() - start;
+
+  printf("%-26s %5zu bytes %zu fields  parse_json_data %7.2f us  parse_json_fields %7.2f us  (%.1fx)\n", c->name,
+         strlen(data), count, (double)old_ns / BENCH_ROUNDS / 1000.0, (double)new_ns / BENCH_ROUNDS / 1000.0,
+         new_ns ? (double)old_ns / (double)new_ns : 0.0);
+done:
+  free(data);
+}
+
+int main(void) {
+  for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+    bench(&CASES[i]);
+  }
+  return test_failures ? 1 : 0;
+}
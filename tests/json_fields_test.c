@@ -0,0 +1,143 @@
+#include "string_functions.h"
+#include "test_common.h"
+
+/*
+ * parse_json_fields replaced per field parse_json_data calls on daemon and wallet RPC responses. For
+ * every path those callers read, with their buffer sizes, the one pass scanner must return what
+ * parse_json_data returns. Numbers are the exception by design: they must be non-negative integers
+ * and are copied digit for digit, so values above 2^53 stay exact and fractions or negatives are
+ * rejected instead of rounded.
+ *
+ * The fixtures under tests/data are in the daemon and wallet JSON-RPC response formats. They were
+ * written for these tests rather than captured from a live node.
+ */
+
+#define MAX_FIELDS 8
+
+typedef struct {
+  const char* path;
+  size_t size;  // the caller's output buffer size
+} caller_field_t;
+
+typedef struct {
+  const char* fixture;
+  caller_field_t fields[MAX_FIELDS];
+} caller_case_t;
+
+static const caller_case_t CASES[] = {
+  // is_blockchain_synced
+  {"daemon_get_info.json", {
+    {"result.synchronized", 16}, {"result.status", 16}, {"result.busy_syncing", 16},
+    {"result.height", BLOCK_HEIGHT_LENGTH}, {"result.target_height", BLOCK_HEIGHT_LENGTH}, {"result.offline", 16}}},
+  {"daemon_get_info_syncing.json", {
+    {"result.synchronized", 16}, {"result.status", 16}, {"result.busy_syncing", 16},
+    {"result.height", BLOCK_HEIGHT_LENGTH}, {"result.target_height", BLOCK_HEIGHT_LENGTH}, {"result.offline", 16}}},
+  // get_block_template
+  {"daemon_get_block_template.json", {
+    {"result.blocktemplate_blob", BUFFER_SIZE_NETWORK_BLOCK_DATA * 4}, {"result.reserved_offset", 16}}},
+  // get_block_info_by_height
+  {"daemon_get_block_header.json", {
+    {"result.block_header.hash", BLOCK_HASH_LENGTH + 1}, {"result.block_header.reward", 64},
+    {"result.block_header.timestamp", 32}, {"result.block_header.orphan_status", 8}}},
+  // check_reserve_proof
+  {"wallet_check_reserve_proof.json", {{"result.good", 8}, {"result.spent", 32}, {"result.total", 64}}},
+  {"wallet_check_reserve_proof_spent.json", {{"result.good", 8}, {"result.spent", 32}, {"result.total", 64}}},
+  // array paths, escapes and UTF-8 in strings
+  {"wallet_get_address.json", {
+    {"result.address", XCASH_WALLET_LENGTH + 1}, {"result.addresses[1].address", XCASH_WALLET_LENGTH + 1},
+    {"result.addresses[0].label", 64}, {"result.addresses[0].used", 8}, {"result.addresses[1].used", 8},
+    {"result.addresses[1].address_index", 8}}},
+};
+
+static void check_case(const caller_case_t* c) {
+  char* data = test_read_fixture(c->fixture, NULL);
+  json_field_t fields[MAX_FIELDS];
+  size_t count = 0;
+  for (; count < MAX_FIELDS && c->fields[count].path; count++) {
+    fields[count] = (json_field_t){c->fields[count].path, calloc(1, c->fields[count].size), c->fields[count].size, false};
+  }
+
+  CHECK(parse_json_fields(data, fields, count) == XCASH_OK, "%s: parse_json_fields failed", c->fixture);
+  for (size_t i = 0; i < count; i++) {
+    char* old_value = calloc(1, fields[i].out_size);
+    int old_rc = parse_json_data(data, fields[i].path, old_value, fields[i].out_size);
+    CHECK(old_rc == XCASH_OK, "%s: parse_json_data %s failed", c->fixture, fields[i].path);
+    CHECK(fields[i].found && strcmp(fields[i].out, old_value) == 0, "%s: %s '%s' != '%s'", c->fixture,
+          fields[i].path, fields[i].out, old_value);
+    free(old_value);
+  }
+
+  // The same paths one at a time, and in reverse order, give the same values
+  for (size_t i = 0; i < count; i++) {
+    char value[BUFFER_SIZE_NETWORK_BLOCK_DATA * 4];
+    json_field_t one = {fields[count - 1 - i].path, value, fields[count - 1 - i].out_size, false};
+    CHECK(parse_json_fields(data, &one, 1) == XCASH_OK && strcmp(value, fields[count - 1 - i].out) == 0,
+          "%s: %s alone '%s'", c->fixture, one.path, value);
+  }
+
+  for (size_t i = 0; i < count; i++) free(fields[i].out);
+  free(data);
+}
+
+static void check_exact_integers(void) {
+  char* info = test_read_fixture("daemon_get_info.json", NULL);
+  char* proof = test_read_fixture("wallet_check_reserve_proof.json", NULL);
+  char* spent = test_read_fixture("wallet_check_reserve_proof_spent.json", NULL);
+  char v1[32], v2[32], v3[32];
+  json_field_t f1 = {"result.free_space", v1, sizeof(v1), false};
+  json_field_t f2 = {"result.total", v2, sizeof(v2), false};
+  json_field_t f3 = {"result.total", v3, sizeof(v3), false};
+  CHECK(parse_json_fields(info, &f1, 1) == XCASH_OK && strcmp(v1, "18446744073709551615") == 0, "free_space '%s'", v1);
+  CHECK(parse_json_fields(proof, &f2, 1) == XCASH_OK && strcmp(v2, "18446744073709551615") == 0, "total '%s'", v2);
+  CHECK(parse_json_fields(spent, &f3, 1) == XCASH_OK && strcmp(v3, "9007199254740993") == 0, "2^53+1 '%s'", v3);
+  free(info);
+  free(proof);
+  free(spent);
+}
+
+static void check_rejects(void) {
+  static const char* BAD_NUMBERS[] = {
+    "{\"result\":{\"reward\":1.5}}",
+    "{\"result\":{\"reward\":-3}}",
+    "{\"result\":{\"reward\":1e9}}",
+    "{\"result\":{\"reward\":null}}",
+    "{\"result\":{\"reward\":{\"amount\":1}}}",
+  };
+  char value[64];
+  for (size_t i = 0; i < sizeof(BAD_NUMBERS) / sizeof(BAD_NUMBERS[0]); i++) {
+    json_field_t f = {"result.reward", value, sizeof(value), false};
+    CHECK(parse_json_fields(BAD_NUMBERS[i], &f, 1) == XCASH_ERROR && !f.found, "accepted %s as '%s'",
+          BAD_NUMBERS[i], value);
+  }
+
+  // A number longer than the buffer is an error, not a truncated value
+  json_field_t small = {"result.total", value, 8, false};
+  CHECK(parse_json_fields("{\"result\":{\"total\":18446744073709551615}}", &small, 1) == XCASH_ERROR,
+        "oversized number accepted as '%s'", value);
+
+  // Missing fields and malformed documents fail like parse_json_data does
+  json_field_t missing[] = {{"result.good", value, sizeof(value), false}, {"result.nope", value, sizeof(value), false}};
+  CHECK(parse_json_fields("{\"result\":{\"good\":true}}", missing, 2) == XCASH_ERROR, "missing field accepted");
+  CHECK(parse_json_data("{\"result\":{\"good\":true}}", "result.nope", value, sizeof(value)) == XCASH_ERROR,
+        "parse_json_data accepted a missing field");
+  json_field_t good = {"result.good", value, sizeof(value), false};
+  CHECK(parse_json_fields("{\"result\":{\"spent\":0,\"good\":", &good, 1) == XCASH_ERROR, "truncated document accepted");
+  CHECK(parse_json_fields("", &good, 1) == XCASH_ERROR, "empty document accepted");
+
+  // String escapes decode like cJSON does
+  const char* escaped = "{\"result\":{\"label\":\"caf\\u00e9 \\\"a\\\\b\\\" \\ud83d\\ude00\"}}";
+  char old_value[64];
+  json_field_t label = {"result.label", value, sizeof(value), false};
+  CHECK(parse_json_fields(escaped, &label, 1) == XCASH_OK &&
+        parse_json_data(escaped, "result.label", old_value, sizeof(old_value)) == XCASH_OK &&
+        strcmp(value, old_value) == 0, "escapes '%s' != '%s'", value, old_value);
+}
+
+int main(void) {
+  for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+    check_case(&CASES[i]);
+  }
+  check_exact_integers();
+  check_rejects();
+  TEST_DONE("json_fields_test");
+}
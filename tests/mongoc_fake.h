@@ -0,0 +1,940 @@
+#ifndef MONGOC_FAKE_H_   /* Include guard */
+#define MONGOC_FAKE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <mongoc/mongoc.h>
+#include <bson/bson.h>
+
+/*
+ * In-memory stand-in for the MongoDB server, so database code runs in tests without one. A test that
+ * includes this header links with $(MONGOC_FAKE_WRAP) from the Makefile, which sends the mongoc calls
+ * listed there to the __wrap_ functions below. Collections are found by name (the database name and
+ * the client are ignored) and hold copies of the written documents, in insertion order, with unique
+ * _ids when they have one. Filters match top level fields by equality or with $lt, $lte, $gt, $gte, $ne
+ * and $in, and combine with $or / $and; finds honour sort, skip, limit and projection; updates support
+ * $set and upsert. Writes are reported to open change streams as the server does with fullDocument set
+ * to updateLookup. Include it from one file per test program.
+ */
+
+#define MONGOC_FAKE_MAX_COLLECTIONS 16
+
+struct mongoc_fake_stream_s;
+
+typedef struct {
+  char name[64];
+  bson_t** docs;
+  size_t count;
+  size_t cap;
+  bool exists;                           // written to since the last drop
+  size_t reads;                          // finds and counts run against it
+  struct mongoc_fake_stream_s* streams;  // open change streams
+} mongoc_fake_collection_t;
+
+typedef struct {
+  bson_t** docs;   // copies taken when the cursor was opened
+  size_t count;
+  size_t next;
+  bool failed;
+} mongoc_fake_cursor_t;
+
+typedef struct mongoc_fake_stream_s {
+  mongoc_fake_collection_t* coll;
+  bson_t** events;   // queued, not yet returned
+  size_t head;
+  size_t count;
+  size_t cap;
+  bson_t* current;   // returned by the last mongoc_change_stream_next, valid until the next call
+  int64_t await_ms;
+  bool waiting;      // blocked in mongoc_change_stream_next with nothing queued
+  bool invalidated;
+  struct mongoc_fake_stream_s* next;
+} mongoc_fake_stream_t;
+
+typedef enum { MONGOC_FAKE_BULK_REPLACE, MONGOC_FAKE_BULK_UPDATE, MONGOC_FAKE_BULK_REMOVE } mongoc_fake_bulk_kind_t;
+
+typedef struct {
+  mongoc_fake_bulk_kind_t kind;
+  bson_t* selector;
+  bson_t* doc;       // replacement or $set fields, NULL for a remove
+  bool upsert;
+} mongoc_fake_bulk_op_t;
+
+typedef struct {
+  mongoc_fake_collection_t* coll;
+  bool ordered;
+  mongoc_fake_bulk_op_t* ops;
+  size_t count;
+  size_t cap;
+} mongoc_fake_bulk_t;
+
+static mongoc_fake_collection_t mongoc_fake_collections[MONGOC_FAKE_MAX_COLLECTIONS];
+static pthread_mutex_t mongoc_fake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mongoc_fake_cond = PTHREAD_COND_INITIALIZER;   // signalled when an event is queued
+static int mongoc_fake_client;                                      // what every pool pop hands out
+static const bson_t* mongoc_fake_sort_spec;                         // for mongoc_fake_sort_cmp, under the lock
+
+// When non zero, cursors opened from now on fail after returning this many documents
+static size_t mongoc_fake_cursor_error_after = 0;
+
+// Bulk executes so far; when it reaches a non zero mongoc_fake_bulk_fail_execute, that execute fails
+// before applying anything, as a lost connection does
+static size_t mongoc_fake_bulk_executes = 0;
+static size_t mongoc_fake_bulk_fail_execute = 0;
+
+// The collection called name, created empty on first use
+static inline mongoc_collection_t* mongoc_fake_collection(const char* name) {
+  mongoc_fake_collection_t* free_slot = NULL;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  for (size_t i = 0; i < MONGOC_FAKE_MAX_COLLECTIONS; i++) {
+    mongoc_fake_collection_t* c = &mongoc_fake_collections[i];
+    if (c->name[0] && strcmp(c->name, name) == 0) {
+      pthread_mutex_unlock(&mongoc_fake_lock);
+      return (mongoc_collection_t*)c;
+    }
+    if (!c->name[0] && !free_slot) free_slot = c;
+  }
+  if (!free_slot) {
+    fprintf(stderr, "mongoc_fake: more than %d collections\n", MONGOC_FAKE_MAX_COLLECTIONS);
+    abort();
+  }
+  snprintf(free_slot->name, sizeof(free_slot->name), "%s", name);
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return (mongoc_collection_t*)free_slot;
+}
+
+// Number of documents in a collection
+static inline size_t mongoc_fake_count(mongoc_collection_t* coll) {
+  pthread_mutex_lock(&mongoc_fake_lock);
+  size_t n = ((mongoc_fake_collection_t*)coll)->count;
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return n;
+}
+
+// Number of finds and counts run against a collection
+static inline size_t mongoc_fake_reads(mongoc_collection_t* coll) {
+  pthread_mutex_lock(&mongoc_fake_lock);
+  size_t n = ((mongoc_fake_collection_t*)coll)->reads;
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return n;
+}
+
+// Whether a change stream is open on the collection and every open stream has handed out all its
+// events and is waiting for more, so its reader has applied each write made so far
+static inline bool mongoc_fake_watch_idle(mongoc_collection_t* coll) {
+  mongoc_fake_collection_t* c = (mongoc_fake_collection_t*)coll;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bool idle = c->streams != NULL;
+  for (mongoc_fake_stream_t* s = c->streams; s && idle; s = s->next) idle = s->count == 0 && s->waiting;
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return idle;
+}
+
+static inline void mongoc_fake_set_error(bson_error_t* error, uint32_t domain, uint32_t code, const char* message) {
+  if (!error) return;
+  memset(error, 0, sizeof(*error));
+  error->domain = domain;
+  error->code = code;
+  snprintf(error->message, sizeof(error->message), "mongoc_fake: %s", message);
+}
+
+// -1, 0 or 1 for comparable values (numbers with numbers, strings with strings, ...), 2 otherwise
+static inline int mongoc_fake_value_cmp(const bson_iter_t* a, const bson_iter_t* b) {
+  bson_type_t ta = bson_iter_type(a), tb = bson_iter_type(b);
+  bool int_a = ta == BSON_TYPE_INT32 || ta == BSON_TYPE_INT64;
+  bool int_b = tb == BSON_TYPE_INT32 || tb == BSON_TYPE_INT64;
+  if (int_a && int_b) {
+    int64_t x = bson_iter_as_int64(a), y = bson_iter_as_int64(b);
+    return (x > y) - (x < y);
+  }
+  if ((int_a || ta == BSON_TYPE_DOUBLE) && (int_b || tb == BSON_TYPE_DOUBLE)) {
+    double x = int_a ? (double)bson_iter_as_int64(a) : bson_iter_double(a);
+    double y = int_b ? (double)bson_iter_as_int64(b) : bson_iter_double(b);
+    return (x > y) - (x < y);
+  }
+  if (ta != tb) return 2;
+  switch (ta) {
+    case BSON_TYPE_UTF8: {
+      int r = strcmp(bson_iter_utf8(a, NULL), bson_iter_utf8(b, NULL));
+      return (r > 0) - (r < 0);
+    }
+    case BSON_TYPE_BOOL:
+      return (int)bson_iter_bool(a) - (int)bson_iter_bool(b);
+    case BSON_TYPE_DOCUMENT: {
+      uint32_t la, lb;
+      const uint8_t *da, *db;
+      bson_iter_document(a, &la, &da);
+      bson_iter_document(b, &lb, &db);
+      return (la == lb && memcmp(da, db, la) == 0) ? 0 : 2;
+    }
+    default:
+      return 2;
+  }
+}
+
+// Whether the document value v (absent when has_value is false) satisfies {"$op": operand, ...}
+static inline bool mongoc_fake_match_ops(const bson_iter_t* v, bool has_value, const bson_iter_t* ops) {
+  bson_iter_t op;
+  bson_iter_recurse(ops, &op);
+  while (bson_iter_next(&op)) {
+    const char* name = bson_iter_key(&op);
+    int cmp = has_value ? mongoc_fake_value_cmp(v, &op) : 2;
+    bool ok;
+    if (strcmp(name, "$lt") == 0) {
+      ok = cmp == -1;
+    } else if (strcmp(name, "$lte") == 0) {
+      ok = cmp == -1 || cmp == 0;
+    } else if (strcmp(name, "$gt") == 0) {
+      ok = cmp == 1;
+    } else if (strcmp(name, "$gte") == 0) {
+      ok = cmp == 1 || cmp == 0;
+    } else if (strcmp(name, "$ne") == 0) {
+      ok = cmp != 0;
+    } else if (strcmp(name, "$in") == 0) {
+      bson_iter_t arr;
+      ok = false;
+      if (has_value && BSON_ITER_HOLDS_ARRAY(&op) && bson_iter_recurse(&op, &arr)) {
+        while (!ok && bson_iter_next(&arr)) ok = mongoc_fake_value_cmp(v, &arr) == 0;
+      }
+    } else {
+      fprintf(stderr, "mongoc_fake: unsupported filter operator %s\n", name);
+      abort();
+    }
+    if (!ok) return false;
+  }
+  return true;
+}
+
+static inline bool mongoc_fake_is_operator_doc(const bson_iter_t* f) {
+  bson_iter_t op;
+  return BSON_ITER_HOLDS_DOCUMENT(f) && bson_iter_recurse(f, &op) && bson_iter_next(&op) &&
+         bson_iter_key(&op)[0] == '$';
+}
+
+static inline bool mongoc_fake_match(const bson_t* doc, const bson_t* filter);
+
+// {"$or": [filter, ...]} when any is set, {"$and": [filter, ...]} otherwise
+static inline bool mongoc_fake_match_list(const bson_t* doc, const bson_iter_t* list, bool any) {
+  bson_iter_t arr;
+  if (!BSON_ITER_HOLDS_ARRAY(list) || !bson_iter_recurse(list, &arr)) {
+    fprintf(stderr, "mongoc_fake: %s needs an array\n", bson_iter_key(list));
+    abort();
+  }
+  while (bson_iter_next(&arr)) {
+    uint32_t len;
+    const uint8_t* data;
+    bson_t sub;
+    bson_iter_document(&arr, &len, &data);
+    bson_init_static(&sub, data, len);
+    if (mongoc_fake_match(doc, &sub) == any) return any;
+  }
+  return !any;
+}
+
+static inline bool mongoc_fake_match(const bson_t* doc, const bson_t* filter) {
+  bson_iter_t f;
+  if (!filter || !bson_iter_init(&f, filter)) return true;
+  while (bson_iter_next(&f)) {
+    const char* key = bson_iter_key(&f);
+    if (strcmp(key, "$or") == 0 || strcmp(key, "$and") == 0) {
+      if (!mongoc_fake_match_list(doc, &f, key[1] == 'o')) return false;
+      continue;
+    }
+    bson_iter_t v;
+    bool has_value = bson_iter_init_find(&v, doc, key);
+    if (mongoc_fake_is_operator_doc(&f)) {
+      if (!mongoc_fake_match_ops(&v, has_value, &f)) return false;
+    } else if (!has_value || mongoc_fake_value_cmp(&v, &f) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Index of the first document matching filter, or -1; the caller holds mongoc_fake_lock
+static inline long mongoc_fake_find_first(const mongoc_fake_collection_t* c, const bson_t* filter) {
+  for (size_t i = 0; i < c->count; i++) {
+    if (mongoc_fake_match(c->docs[i], filter)) return (long)i;
+  }
+  return -1;
+}
+
+// Orders documents by mongoc_fake_sort_spec ({field: 1 or -1, ...}); a missing field sorts first
+static int mongoc_fake_sort_cmp(const void* a, const void* b) {
+  const bson_t* x = *(const bson_t* const*)a;
+  const bson_t* y = *(const bson_t* const*)b;
+  bson_iter_t k;
+  bson_iter_init(&k, mongoc_fake_sort_spec);
+  while (bson_iter_next(&k)) {
+    bson_iter_t vx, vy;
+    bool has_x = bson_iter_init_find(&vx, x, bson_iter_key(&k));
+    bool has_y = bson_iter_init_find(&vy, y, bson_iter_key(&k));
+    int r = (int)has_x - (int)has_y;
+    if (has_x && has_y) {
+      r = mongoc_fake_value_cmp(&vx, &vy);
+      if (r == 2) r = (int)bson_iter_type(&vx) - (int)bson_iter_type(&vy);
+    }
+    if (r != 0) return bson_iter_as_int64(&k) < 0 ? -r : r;
+  }
+  return 0;
+}
+
+// A copy of doc with the fields a projection keeps: {field: 1, ...} names those kept and
+// {field: 0, ...} those dropped; _id is kept unless it is set to 0
+static inline bson_t* mongoc_fake_project(const bson_t* doc, const bson_t* projection) {
+  bool inclusive = false, keep_id = true;
+  bson_iter_t p;
+  bson_iter_init(&p, projection);
+  while (bson_iter_next(&p)) {
+    bool on = BSON_ITER_HOLDS_BOOL(&p) ? bson_iter_bool(&p) : bson_iter_as_int64(&p) != 0;
+    if (strcmp(bson_iter_key(&p), "_id") == 0) {
+      keep_id = on;
+    } else if (on) {
+      inclusive = true;
+    }
+  }
+  bson_t* out = bson_new();
+  bson_iter_t it;
+  bson_iter_init(&it, doc);
+  while (bson_iter_next(&it)) {
+    const char* key = bson_iter_key(&it);
+    bool listed = bson_iter_init_find(&p, projection, key);
+    bool keep = strcmp(key, "_id") == 0 ? keep_id : (inclusive == listed);
+    if (keep) bson_append_iter(out, key, -1, &it);
+  }
+  return out;
+}
+
+// Appends a document to a collection; the caller holds mongoc_fake_lock
+static inline void mongoc_fake_append(mongoc_fake_collection_t* c, bson_t* doc) {
+  if (c->count == c->cap) {
+    c->cap = c->cap ? c->cap * 2 : 64;
+    c->docs = realloc(c->docs, c->cap * sizeof(*c->docs));
+  }
+  c->docs[c->count++] = doc;
+  c->exists = true;
+}
+
+// Removes the document at i, keeping the order of the others; the caller holds mongoc_fake_lock
+static inline void mongoc_fake_remove(mongoc_fake_collection_t* c, size_t i) {
+  bson_destroy(c->docs[i]);
+  memmove(&c->docs[i], &c->docs[i + 1], (c->count - i - 1) * sizeof(*c->docs));
+  c->count--;
+}
+
+// A copy of doc with every field of set replaced or appended
+static inline bson_t* mongoc_fake_apply_set(const bson_t* doc, const bson_t* set) {
+  bson_t* out = bson_new();
+  bson_iter_t it, sv;
+  bson_iter_init(&it, doc);
+  while (bson_iter_next(&it)) {
+    if (bson_iter_init_find(&sv, set, bson_iter_key(&it))) {
+      bson_append_iter(out, bson_iter_key(&it), -1, &sv);
+    } else {
+      bson_append_iter(out, bson_iter_key(&it), -1, &it);
+    }
+  }
+  bson_iter_init(&it, set);
+  while (bson_iter_next(&it)) {
+    if (!bson_iter_init_find(&sv, doc, bson_iter_key(&it))) bson_append_iter(out, bson_iter_key(&it), -1, &it);
+  }
+  return out;
+}
+
+static inline bool mongoc_fake_opt_bool(const bson_t* opts, const char* name) {
+  bson_iter_t it;
+  return opts && bson_iter_init_find(&it, opts, name) && BSON_ITER_HOLDS_BOOL(&it) && bson_iter_bool(&it);
+}
+
+static inline int64_t mongoc_fake_opt_int64(const bson_t* opts, const char* name, int64_t fallback) {
+  bson_iter_t it;
+  return opts && bson_iter_init_find(&it, opts, name) ? bson_iter_as_int64(&it) : fallback;
+}
+
+// Points out at the sub document opts[name] when there is one
+static inline bool mongoc_fake_opt_doc(const bson_t* opts, const char* name, bson_t* out) {
+  bson_iter_t it;
+  uint32_t len;
+  const uint8_t* data;
+  if (!opts || !bson_iter_init_find(&it, opts, name) || !BSON_ITER_HOLDS_DOCUMENT(&it)) return false;
+  bson_iter_document(&it, &len, &data);
+  return bson_init_static(out, data, len);
+}
+
+// Queues a change event on every stream open on c; the caller holds mongoc_fake_lock
+static inline void mongoc_fake_emit(mongoc_fake_collection_t* c, const char* op, const bson_t* full,
+                                    const bson_iter_t* id) {
+  if (!c->streams) return;
+  bson_t* ev = bson_new();
+  BSON_APPEND_UTF8(ev, "operationType", op);
+  if (full) BSON_APPEND_DOCUMENT(ev, "fullDocument", full);
+  if (id) {
+    bson_t key;
+    BSON_APPEND_DOCUMENT_BEGIN(ev, "documentKey", &key);
+    bson_append_iter(&key, "_id", -1, id);
+    bson_append_document_end(ev, &key);
+  }
+  for (mongoc_fake_stream_t* s = c->streams; s; s = s->next) {
+    if (s->head + s->count == s->cap) {
+      if (s->head) memmove(s->events, s->events + s->head, s->count * sizeof(*s->events));
+      s->head = 0;
+      if (s->count == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 64;
+        s->events = realloc(s->events, s->cap * sizeof(*s->events));
+      }
+    }
+    s->events[s->head + s->count++] = bson_copy(ev);
+  }
+  bson_destroy(ev);
+  pthread_cond_broadcast(&mongoc_fake_cond);
+}
+
+// Reports a written document, keyed by its _id; the caller holds mongoc_fake_lock
+static inline void mongoc_fake_emit_doc(mongoc_fake_collection_t* c, const char* op, const bson_t* doc) {
+  bson_iter_t id;
+  bool has_id = bson_iter_init_find(&id, doc, "_id");
+  mongoc_fake_emit(c, op, doc, has_id ? &id : NULL);
+}
+
+// Stores a copy of doc, refusing a second document with the same _id; the caller holds mongoc_fake_lock
+static inline bool mongoc_fake_insert_locked(mongoc_fake_collection_t* c, const bson_t* doc, bson_error_t* error) {
+  bson_iter_t id, other;
+  if (bson_iter_init_find(&id, doc, "_id")) {
+    for (size_t i = 0; i < c->count; i++) {
+      if (bson_iter_init_find(&other, c->docs[i], "_id") && mongoc_fake_value_cmp(&id, &other) == 0) {
+        mongoc_fake_set_error(error, MONGOC_ERROR_SERVER, 11000, "E11000 duplicate key error");
+        return false;
+      }
+    }
+  }
+  mongoc_fake_append(c, bson_copy(doc));
+  mongoc_fake_emit_doc(c, "insert", doc);
+  return true;
+}
+
+// Applies {"$set": {...}} to the first document matching filter, or inserts the equality fields of the
+// filter plus the $set fields when nothing matches and upsert is set. Setting a different _id fails as
+// on the server; any other update operator aborts. The caller holds mongoc_fake_lock.
+static inline bool mongoc_fake_update_locked(mongoc_fake_collection_t* c, const bson_t* filter,
+                                             const bson_t* update, bool upsert, int32_t* matched,
+                                             int32_t* upserted, bson_error_t* error) {
+  bson_iter_t it, id, old_id;
+  uint32_t len;
+  const uint8_t* data;
+  bson_t set;
+  if (!bson_iter_init_find(&it, update, "$set") || !BSON_ITER_HOLDS_DOCUMENT(&it) || bson_count_keys(update) != 1) {
+    fprintf(stderr, "mongoc_fake: only $set updates are supported\n");
+    abort();
+  }
+  bson_iter_document(&it, &len, &data);
+  bson_init_static(&set, data, len);
+
+  long i = mongoc_fake_find_first(c, filter);
+  if (i >= 0 && bson_iter_init_find(&id, &set, "_id") &&
+      (!bson_iter_init_find(&old_id, c->docs[i], "_id") || mongoc_fake_value_cmp(&id, &old_id) != 0)) {
+    mongoc_fake_set_error(error, MONGOC_ERROR_SERVER, 66,
+                          "Performing an update on the path '_id' would modify the immutable field '_id'");
+    return false;
+  }
+  if (i >= 0) {
+    bson_t* updated = mongoc_fake_apply_set(c->docs[i], &set);
+    bson_destroy(c->docs[i]);
+    c->docs[i] = updated;
+    mongoc_fake_emit_doc(c, "update", updated);
+    (*matched)++;
+  } else if (upsert) {
+    bson_t* base = bson_new();
+    bson_iter_init(&it, filter);
+    while (bson_iter_next(&it)) {
+      if (bson_iter_key(&it)[0] != '$' && !mongoc_fake_is_operator_doc(&it)) {
+        bson_append_iter(base, bson_iter_key(&it), -1, &it);
+      }
+    }
+    bson_t* doc = mongoc_fake_apply_set(base, &set);
+    bson_destroy(base);
+    mongoc_fake_append(c, doc);
+    mongoc_fake_emit_doc(c, "insert", doc);
+    (*upserted)++;
+  }
+  return true;
+}
+
+// Replaces the first document matching filter, keeping its _id, or inserts doc (with the _id of the
+// filter if doc has none) when nothing matches and upsert is set. The caller holds mongoc_fake_lock.
+static inline bool mongoc_fake_replace_locked(mongoc_fake_collection_t* c, const bson_t* filter, const bson_t* doc,
+                                              bool upsert, int32_t* matched, int32_t* upserted,
+                                              bson_error_t* error) {
+  bson_iter_t id, old_id, it;
+  bool has_id = bson_iter_init_find(&id, doc, "_id");
+  long i = mongoc_fake_find_first(c, filter);
+  if (i < 0 && !upsert) return true;
+
+  bson_t* out = bson_new();
+  if (i >= 0) {
+    bool had_id = bson_iter_init_find(&old_id, c->docs[i], "_id");
+    if (has_id && (!had_id || mongoc_fake_value_cmp(&id, &old_id) != 0)) {
+      bson_destroy(out);
+      mongoc_fake_set_error(error, MONGOC_ERROR_SERVER, 66, "the (immutable) field '_id' was found to have been altered");
+      return false;
+    }
+    if (had_id) bson_append_iter(out, "_id", -1, &old_id);
+  } else if (has_id) {
+    bson_append_iter(out, "_id", -1, &id);
+  } else if (bson_iter_init_find(&id, filter, "_id") && !mongoc_fake_is_operator_doc(&id)) {
+    bson_append_iter(out, "_id", -1, &id);
+  }
+  bson_iter_init(&it, doc);
+  while (bson_iter_next(&it)) {
+    if (strcmp(bson_iter_key(&it), "_id") != 0) bson_append_iter(out, bson_iter_key(&it), -1, &it);
+  }
+
+  if (i >= 0) {
+    bson_destroy(c->docs[i]);
+    c->docs[i] = out;
+    mongoc_fake_emit_doc(c, "replace", out);
+    (*matched)++;
+  } else {
+    mongoc_fake_append(c, out);
+    mongoc_fake_emit_doc(c, "insert", out);
+    (*upserted)++;
+  }
+  return true;
+}
+
+// Removes the first document matching filter, or all of them; the caller holds mongoc_fake_lock
+static inline int32_t mongoc_fake_delete_locked(mongoc_fake_collection_t* c, const bson_t* filter, bool many) {
+  int32_t deleted = 0;
+  for (size_t i = 0; i < c->count;) {
+    if (!mongoc_fake_match(c->docs[i], filter)) {
+      i++;
+      continue;
+    }
+    bson_iter_t id;
+    if (bson_iter_init_find(&id, c->docs[i], "_id")) mongoc_fake_emit(c, "delete", NULL, &id);
+    mongoc_fake_remove(c, i);
+    deleted++;
+    if (!many) break;
+  }
+  return deleted;
+}
+
+mongoc_client_t* __wrap_mongoc_client_pool_pop(mongoc_client_pool_t* pool) {
+  (void)pool;
+  return (mongoc_client_t*)&mongoc_fake_client;
+}
+
+void __wrap_mongoc_client_pool_push(mongoc_client_pool_t* pool, mongoc_client_t* client) {
+  (void)pool;
+  (void)client;
+}
+
+mongoc_collection_t* __wrap_mongoc_client_get_collection(mongoc_client_t* client, const char* db, const char* name) {
+  (void)client;
+  (void)db;
+  return mongoc_fake_collection(name);
+}
+
+// Collections live as long as the program
+void __wrap_mongoc_collection_destroy(mongoc_collection_t* coll) {
+  (void)coll;
+}
+
+mongoc_database_t* __wrap_mongoc_client_get_database(mongoc_client_t* client, const char* name) {
+  (void)client;
+  (void)name;
+  return (mongoc_database_t*)&mongoc_fake_client;
+}
+
+void __wrap_mongoc_database_destroy(mongoc_database_t* database) {
+  (void)database;
+}
+
+bool __wrap_mongoc_database_has_collection(mongoc_database_t* database, const char* name, bson_error_t* error) {
+  (void)database;
+  bool exists = false;
+  if (error) memset(error, 0, sizeof(*error));
+  pthread_mutex_lock(&mongoc_fake_lock);
+  for (size_t i = 0; i < MONGOC_FAKE_MAX_COLLECTIONS; i++) {
+    const mongoc_fake_collection_t* c = &mongoc_fake_collections[i];
+    if (c->name[0] && strcmp(c->name, name) == 0) exists = c->exists;
+  }
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return exists;
+}
+
+mongoc_cursor_t* __wrap_mongoc_collection_find_with_opts(mongoc_collection_t* coll, const bson_t* filter,
+                                                         const bson_t* opts, const mongoc_read_prefs_t* prefs) {
+  (void)prefs;
+  mongoc_fake_collection_t* c = (mongoc_fake_collection_t*)coll;
+  mongoc_fake_cursor_t* cur = calloc(1, sizeof(*cur));
+  bson_t sort, projection;
+  bool sorted = mongoc_fake_opt_doc(opts, "sort", &sort);
+  bool projected = mongoc_fake_opt_doc(opts, "projection", &projection);
+  int64_t skip = mongoc_fake_opt_int64(opts, "skip", 0);
+  int64_t limit = mongoc_fake_opt_int64(opts, "limit", 0);
+
+  pthread_mutex_lock(&mongoc_fake_lock);
+  c->reads++;
+  cur->docs = calloc(c->count + 1, sizeof(*cur->docs));
+  for (size_t i = 0; i < c->count; i++) {
+    if (mongoc_fake_match(c->docs[i], filter)) cur->docs[cur->count++] = c->docs[i];
+  }
+  if (sorted && cur->count > 1) {
+    mongoc_fake_sort_spec = &sort;
+    qsort(cur->docs, cur->count, sizeof(*cur->docs), mongoc_fake_sort_cmp);
+    mongoc_fake_sort_spec = NULL;
+  }
+  size_t first = skip > 0 ? ((size_t)skip < cur->count ? (size_t)skip : cur->count) : 0;
+  size_t n = cur->count - first;
+  if (limit > 0 && (size_t)limit < n) n = (size_t)limit;
+  for (size_t i = 0; i < n; i++) {
+    const bson_t* doc = cur->docs[first + i];
+    cur->docs[i] = projected ? mongoc_fake_project(doc, &projection) : bson_copy(doc);
+  }
+  cur->count = n;
+  pthread_mutex_unlock(&mongoc_fake_lock);
+
+  if (mongoc_fake_cursor_error_after && mongoc_fake_cursor_error_after < cur->count) {
+    for (size_t i = mongoc_fake_cursor_error_after; i < cur->count; i++) bson_destroy(cur->docs[i]);
+    cur->count = mongoc_fake_cursor_error_after;
+    cur->failed = true;
+  }
+  return (mongoc_cursor_t*)cur;
+}
+
+bool __wrap_mongoc_cursor_next(mongoc_cursor_t* cursor, const bson_t** doc) {
+  mongoc_fake_cursor_t* cur = (mongoc_fake_cursor_t*)cursor;
+  if (cur->next >= cur->count) return false;
+  *doc = cur->docs[cur->next++];
+  return true;
+}
+
+bool __wrap_mongoc_cursor_error(mongoc_cursor_t* cursor, bson_error_t* error) {
+  mongoc_fake_cursor_t* cur = (mongoc_fake_cursor_t*)cursor;
+  if (!cur->failed || cur->next < cur->count) return false;
+  mongoc_fake_set_error(error, MONGOC_ERROR_SERVER, 6, "connection lost");
+  return true;
+}
+
+void __wrap_mongoc_cursor_destroy(mongoc_cursor_t* cursor) {
+  mongoc_fake_cursor_t* cur = (mongoc_fake_cursor_t*)cursor;
+  if (!cur) return;
+  for (size_t i = 0; i < cur->count; i++) bson_destroy(cur->docs[i]);
+  free(cur->docs);
+  free(cur);
+}
+
+int64_t __wrap_mongoc_collection_count_documents(mongoc_collection_t* coll, const bson_t* filter, const bson_t* opts,
+                                                 const mongoc_read_prefs_t* prefs, bson_t* reply,
+                                                 bson_error_t* error) {
+  (void)opts;
+  (void)prefs;
+  (void)error;
+  mongoc_fake_collection_t* c = (mongoc_fake_collection_t*)coll;
+  int64_t n = 0;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  c->reads++;
+  for (size_t i = 0; i < c->count; i++) n += mongoc_fake_match(c->docs[i], filter);
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  if (reply) bson_init(reply);
+  return n;
+}
+
+bool __wrap_mongoc_collection_insert_one(mongoc_collection_t* coll, const bson_t* doc, const bson_t* opts,
+                                         bson_t* reply, bson_error_t* error) {
+  (void)opts;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bool ok = mongoc_fake_insert_locked((mongoc_fake_collection_t*)coll, doc, error);
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  if (reply) {
+    bson_init(reply);
+    BSON_APPEND_INT32(reply, "insertedCount", ok ? 1 : 0);
+  }
+  return ok;
+}
+
+bool __wrap_mongoc_collection_update_one(mongoc_collection_t* coll, const bson_t* filter, const bson_t* update,
+                                         const bson_t* opts, bson_t* reply, bson_error_t* error) {
+  int32_t matched = 0, upserted = 0;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bool ok = mongoc_fake_update_locked((mongoc_fake_collection_t*)coll, filter, update,
+                                      mongoc_fake_opt_bool(opts, "upsert"), &matched, &upserted, error);
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  if (reply) {
+    bson_init(reply);
+    BSON_APPEND_INT32(reply, "matchedCount", matched);
+    BSON_APPEND_INT32(reply, "modifiedCount", matched);
+    BSON_APPEND_INT32(reply, "upsertedCount", upserted);
+  }
+  return ok;
+}
+
+bool __wrap_mongoc_collection_replace_one(mongoc_collection_t* coll, const bson_t* selector, const bson_t* replacement,
+                                          const bson_t* opts, bson_t* reply, bson_error_t* error) {
+  int32_t matched = 0, upserted = 0;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bool ok = mongoc_fake_replace_locked((mongoc_fake_collection_t*)coll, selector, replacement,
+                                       mongoc_fake_opt_bool(opts, "upsert"), &matched, &upserted, error);
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  if (reply) {
+    bson_init(reply);
+    BSON_APPEND_INT32(reply, "matchedCount", matched);
+    BSON_APPEND_INT32(reply, "modifiedCount", matched);
+    BSON_APPEND_INT32(reply, "upsertedCount", upserted);
+  }
+  return ok;
+}
+
+static inline bool mongoc_fake_delete(mongoc_collection_t* coll, const bson_t* filter, bool many, bson_t* reply) {
+  pthread_mutex_lock(&mongoc_fake_lock);
+  int32_t deleted = mongoc_fake_delete_locked((mongoc_fake_collection_t*)coll, filter, many);
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  if (reply) {
+    bson_init(reply);
+    BSON_APPEND_INT32(reply, "deletedCount", deleted);
+  }
+  return true;
+}
+
+bool __wrap_mongoc_collection_delete_one(mongoc_collection_t* coll, const bson_t* filter, const bson_t* opts,
+                                         bson_t* reply, bson_error_t* error) {
+  (void)opts;
+  (void)error;
+  return mongoc_fake_delete(coll, filter, false, reply);
+}
+
+bool __wrap_mongoc_collection_delete_many(mongoc_collection_t* coll, const bson_t* filter, const bson_t* opts,
+                                          bson_t* reply, bson_error_t* error) {
+  (void)opts;
+  (void)error;
+  return mongoc_fake_delete(coll, filter, true, reply);
+}
+
+// Empties the collection; open change streams see a drop event, then an invalidate
+bool __wrap_mongoc_collection_drop(mongoc_collection_t* coll, bson_error_t* error) {
+  mongoc_fake_collection_t* c = (mongoc_fake_collection_t*)coll;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  bool existed = c->exists;
+  if (existed) {
+    while (c->count) mongoc_fake_remove(c, c->count - 1);
+    c->exists = false;
+    mongoc_fake_emit(c, "drop", NULL, NULL);
+    mongoc_fake_emit(c, "invalidate", NULL, NULL);
+  }
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  if (!existed) mongoc_fake_set_error(error, MONGOC_ERROR_SERVER, 26, "ns not found");
+  return existed;
+}
+
+// Reports the writes made from now on; every update carries the document as it was written
+mongoc_change_stream_t* __wrap_mongoc_collection_watch(const mongoc_collection_t* coll, const bson_t* pipeline,
+                                                       const bson_t* opts) {
+  (void)pipeline;
+  mongoc_fake_stream_t* s = calloc(1, sizeof(*s));
+  s->coll = (mongoc_fake_collection_t*)(uintptr_t)coll;
+  s->await_ms = mongoc_fake_opt_int64(opts, "maxAwaitTimeMS", 1000);
+  pthread_mutex_lock(&mongoc_fake_lock);
+  s->next = s->coll->streams;
+  s->coll->streams = s;
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return (mongoc_change_stream_t*)s;
+}
+
+// Waits up to maxAwaitTimeMS for an event; none come after an invalidate
+bool __wrap_mongoc_change_stream_next(mongoc_change_stream_t* stream, const bson_t** bson) {
+  mongoc_fake_stream_t* s = (mongoc_fake_stream_t*)stream;
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += s->await_ms / 1000;
+  deadline.tv_nsec += (s->await_ms % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&mongoc_fake_lock);
+  if (s->current) {
+    bson_destroy(s->current);
+    s->current = NULL;
+  }
+  s->waiting = true;
+  while (s->count == 0 && !s->invalidated &&
+         pthread_cond_timedwait(&mongoc_fake_cond, &mongoc_fake_lock, &deadline) == 0) {
+  }
+  s->waiting = false;
+  bool got = s->count > 0 && !s->invalidated;
+  if (got) {
+    bson_iter_t it;
+    s->current = s->events[s->head++];
+    if (--s->count == 0) s->head = 0;
+    s->invalidated = bson_iter_init_find(&it, s->current, "operationType") &&
+                     strcmp(bson_iter_utf8(&it, NULL), "invalidate") == 0;
+    *bson = s->current;
+  }
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  return got;
+}
+
+bool __wrap_mongoc_change_stream_error_document(const mongoc_change_stream_t* stream, bson_error_t* err,
+                                                const bson_t** reply) {
+  (void)stream;
+  if (err) memset(err, 0, sizeof(*err));
+  if (reply) *reply = NULL;
+  return false;
+}
+
+void __wrap_mongoc_change_stream_destroy(mongoc_change_stream_t* stream) {
+  mongoc_fake_stream_t* s = (mongoc_fake_stream_t*)stream;
+  if (!s) return;
+  pthread_mutex_lock(&mongoc_fake_lock);
+  for (mongoc_fake_stream_t** p = &s->coll->streams; *p; p = &(*p)->next) {
+    if (*p == s) {
+      *p = s->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mongoc_fake_lock);
+  for (size_t i = 0; i < s->count; i++) bson_destroy(s->events[s->head + i]);
+  free(s->events);
+  if (s->current) bson_destroy(s->current);
+  free(s);
+}
+
+mongoc_bulk_operation_t* __wrap_mongoc_collection_create_bulk_operation_with_opts(mongoc_collection_t* coll,
+                                                                                  const bson_t* opts) {
+  mongoc_fake_bulk_t* b = calloc(1, sizeof(*b));
+  bson_iter_t it;
+  b->coll = (mongoc_fake_collection_t*)coll;
+  b->ordered = !(opts && bson_iter_init_find(&it, opts, "ordered") && BSON_ITER_HOLDS_BOOL(&it) && !bson_iter_bool(&it));
+  return (mongoc_bulk_operation_t*)b;
+}
+
+// The driver checks a write when it is added: an update must use $ operators and a replacement none
+static inline bool mongoc_fake_bulk_add(mongoc_bulk_operation_t* bulk, mongoc_fake_bulk_kind_t kind,
+                                        const bson_t* selector, const bson_t* doc, const bson_t* opts,
+                                        bson_error_t* error) {
+  mongoc_fake_bulk_t* b = (mongoc_fake_bulk_t*)bulk;
+  bson_iter_t it;
+  if (doc) {
+    bool operators = bson_iter_init(&it, doc) && bson_iter_next(&it) && bson_iter_key(&it)[0] == '$';
+    if (operators != (kind == MONGOC_FAKE_BULK_UPDATE)) {
+      mongoc_fake_set_error(error, MONGOC_ERROR_COMMAND, MONGOC_ERROR_COMMAND_INVALID_ARG,
+                            operators ? "replacement document contains $ operators"
+                                      : "update only works with $ operators");
+      return false;
+    }
+  }
+  if (b->count == b->cap) {
+    b->cap = b->cap ? b->cap * 2 : 64;
+    b->ops = realloc(b->ops, b->cap * sizeof(*b->ops));
+  }
+  b->ops[b->count++] = (mongoc_fake_bulk_op_t){kind, bson_copy(selector), doc ? bson_copy(doc) : NULL,
+                                               mongoc_fake_opt_bool(opts, "upsert")};
+  return true;
+}
+
+bool __wrap_mongoc_bulk_operation_replace_one_with_opts(mongoc_bulk_operation_t* bulk, const bson_t* selector,
+                                                        const bson_t* document, const bson_t* opts,
+                                                        bson_error_t* error) {
+  return mongoc_fake_bulk_add(bulk, MONGOC_FAKE_BULK_REPLACE, selector, document, opts, error);
+}
+
+bool __wrap_mongoc_bulk_operation_update_one_with_opts(mongoc_bulk_operation_t* bulk, const bson_t* selector,
+                                                       const bson_t* document, const bson_t* opts,
+                                                       bson_error_t* error) {
+  return mongoc_fake_bulk_add(bulk, MONGOC_FAKE_BULK_UPDATE, selector, document, opts, error);
+}
+
+bool __wrap_mongoc_bulk_operation_remove_one_with_opts(mongoc_bulk_operation_t* bulk, const bson_t* selector,
+                                                       const bson_t* opts, bson_error_t* error) {
+  return mongoc_fake_bulk_add(bulk, MONGOC_FAKE_BULK_REMOVE, selector, NULL, opts, error);
+}
+
+// Applies the writes in order, an ordered bulk stopping at the first failure, and replies with the
+// counts and writeErrors the server sends
+uint32_t __wrap_mongoc_bulk_operation_execute(mongoc_bulk_operation_t* bulk, bson_t* reply, bson_error_t* error) {
+  mongoc_fake_bulk_t* b = (mongoc_fake_bulk_t*)bulk;
+  int32_t matched = 0, upserted = 0, removed = 0;
+  bson_t errors;
+  bson_error_t first = {0};
+  uint32_t failed = 0;
+
+  pthread_mutex_lock(&mongoc_fake_lock);
+  if (++mongoc_fake_bulk_executes == mongoc_fake_bulk_fail_execute) {
+    pthread_mutex_unlock(&mongoc_fake_lock);
+    if (reply) bson_init(reply);
+    mongoc_fake_set_error(error, MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "socket error or timeout");
+    return 0;
+  }
+  bson_init(&errors);
+  for (size_t i = 0; i < b->count; i++) {
+    const mongoc_fake_bulk_op_t* op = &b->ops[i];
+    bson_error_t e = {0};
+    bool ok = true;
+    if (op->kind == MONGOC_FAKE_BULK_REPLACE) {
+      ok = mongoc_fake_replace_locked(b->coll, op->selector, op->doc, op->upsert, &matched, &upserted, &e);
+    } else if (op->kind == MONGOC_FAKE_BULK_UPDATE) {
+      ok = mongoc_fake_update_locked(b->coll, op->selector, op->doc, op->upsert, &matched, &upserted, &e);
+    } else {
+      removed += mongoc_fake_delete_locked(b->coll, op->selector, false);
+    }
+    if (ok) continue;
+
+    char key[16];
+    bson_t item;
+    snprintf(key, sizeof(key), "%u", failed);
+    BSON_APPEND_DOCUMENT_BEGIN(&errors, key, &item);
+    BSON_APPEND_INT32(&item, "index", (int32_t)i);
+    BSON_APPEND_INT32(&item, "code", (int32_t)e.code);
+    BSON_APPEND_UTF8(&item, "errmsg", e.message);
+    bson_append_document_end(&errors, &item);
+    if (failed++ == 0) first = e;
+    if (b->ordered) break;
+  }
+  pthread_mutex_unlock(&mongoc_fake_lock);
+
+  if (reply) {
+    bson_t arr;
+    bson_init(reply);
+    BSON_APPEND_INT32(reply, "nInserted", 0);
+    BSON_APPEND_INT32(reply, "nMatched", matched);
+    BSON_APPEND_INT32(reply, "nModified", matched);
+    BSON_APPEND_INT32(reply, "nRemoved", removed);
+    BSON_APPEND_INT32(reply, "nUpserted", upserted);
+    BSON_APPEND_ARRAY_BEGIN(reply, "writeErrors", &arr);
+    bson_concat(&arr, &errors);
+    bson_append_array_end(reply, &arr);
+  }
+  bson_destroy(&errors);
+
+  if (b->count == 0) {
+    mongoc_fake_set_error(error, MONGOC_ERROR_COMMAND, MONGOC_ERROR_COMMAND_INVALID_ARG, "Cannot do an empty bulk write");
+    return 0;
+  }
+  if (failed) {
+    if (error) {
+      *error = first;
+      error->domain = MONGOC_ERROR_COMMAND;
+    }
+    return 0;
+  }
+  return 1;
+}
+
+void __wrap_mongoc_bulk_operation_destroy(mongoc_bulk_operation_t* bulk) {
+  mongoc_fake_bulk_t* b = (mongoc_fake_bulk_t*)bulk;
+  if (!b) return;
+  for (size_t i = 0; i < b->count; i++) {
+    bson_destroy(b->ops[i].selector);
+    if (b->ops[i].doc) bson_destroy(b->ops[i].doc);
+  }
+  free(b->ops);
+  free(b);
+}
+
+#endif
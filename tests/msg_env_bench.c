@@ -0,0 +1,71 @@
+#include "xcash_message.h"
+#include "string_functions.h"
+#include "test_common.h"
+
+/*
+ * CPU per received VRF_DATA / vote message for the field reads done between the server and the
+ * handler: reparsing the raw message once per field with parse_json_data (the old readers) against
+ * parsing it once into the envelope and reading every field from the tree.
+ */
+
+#define BENCH_ROUNDS 20000
+
+static const char* VRF_DATA_FIELDS[] = {
+  "message_settings", "XCASH_DPOPS_signature", "public_address", "v_previous_block_hash",
+  "v_current_round_part", "vrf_public_key", "vrf_proof", "vrf_beta", "block-height", "delegates_hash",
+};
+
+static const char* VOTE_FIELDS[] = {
+  "message_settings", "XCASH_DPOPS_signature", "public_address", "v_previous_block_hash",
+  "v_current_round_part", "proposed_producer", "vrf_public_key", "vrf_proof", "vrf_beta",
+  "block_height", "vote_signature",
+};
+
+// Sized like the handlers' field buffers; strncpy pads the whole destination
+static char sink[VRF_PROOF_LENGTH + 1];
+
+static void bench(const char* fixture, const char** fields, size_t count) {
+  char* data = test_read_fixture(fixture, NULL);
+  size_t len = strlen(data);
+
+  uint64_t start = test_now_ns();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    for (size_t i = 0; i < count; i++) {
+      if (parse_json_data(data, fields[i], sink, sizeof(sink)) != XCASH_OK) {
+        CHECK(0, "%s: parse_json_data %s", fixture, fields[i]);
+        goto done;
+      }
+    }
+  }
+  uint64_t old_ns = test_now_ns() - start;
+
+  start = test_now_ns();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    xcash_msg_env_t env;
+    if (!xcash_msg_env_parse(&env, data)) {
+      CHECK(0, "%s: envelope parse failed", fixture);
+      goto done;
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (parse_msg_env_field(&env, fields[i], sink, sizeof(sink)) != XCASH_OK) {
+        CHECK(0, "%s: parse_msg_env_field %s", fixture, fields[i]);
+        cJSON_Delete(env.root);
+        goto done;
+      }
+    }
+    cJSON_Delete(env.root);
+  }
+  uint64_t new_ns = test_now_ns() - start;
+
+  printf("%-28s %5zu bytes %2zu fields  per field parse %7.2f us/msg  envelope %7.2f us/msg  (%.1fx)\n", fixture, len,
+         count, (double)old_ns / BENCH_ROUNDS / 1000.0, (double)new_ns / BENCH_ROUNDS / 1000.0,
+         new_ns ? (double)old_ns / (double)new_ns : 0.0);
+done:
+  free(data);
+}
+
+int main(void) {
+  bench("vrf_data_message.json", VRF_DATA_FIELDS, sizeof(VRF_DATA_FIELDS) / sizeof(VRF_DATA_FIELDS[0]));
+  bench("vote_majority_message.json", VOTE_FIELDS, sizeof(VOTE_FIELDS) / sizeof(VOTE_FIELDS[0]));
+  return test_failures ? 1 : 0;
+}
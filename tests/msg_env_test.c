@@ -0,0 +1,99 @@
+#include "xcash_message.h"
+#include "string_functions.h"
+#include "test_common.h"
+
+/*
+ * The server parses a message once into an xcash_msg_env_t and every validator and handler reads its
+ * fields from that tree. Each field read that way must equal what parse_json_data returns when it
+ * reparses the raw message, which is what those readers did before.
+ *
+ * The fixtures follow the wire format: create_message_param_list output with the
+ * v_previous_block_hash, v_current_round_part, v_random_data and XCASH_DPOPS_signature fields that
+ * sign_data appends.
+ */
+
+// Fields read by verify_data plus the ones the VRF_DATA handler reads
+static const char* VRF_DATA_FIELDS[] = {
+  "message_settings", "XCASH_DPOPS_signature", "public_address", "v_previous_block_hash",
+  "v_current_round_part", "vrf_public_key", "vrf_proof", "vrf_beta", "block-height", "delegates_hash",
+};
+
+// Fields read by verify_data plus the ones the vote handler reads
+static const char* VOTE_FIELDS[] = {
+  "message_settings", "XCASH_DPOPS_signature", "public_address", "v_previous_block_hash",
+  "v_current_round_part", "proposed_producer", "vrf_public_key", "vrf_proof", "vrf_beta",
+  "block_height", "vote_signature",
+};
+
+static void check_fields(const char* fixture, xcash_msg_t expected_type, const char** fields, size_t count) {
+  char* data = test_read_fixture(fixture, NULL);
+  xcash_msg_env_t env;
+  CHECK(xcash_msg_env_parse(&env, data), "%s: envelope parse failed", fixture);
+  if (!env.root) {
+    free(data);
+    return;
+  }
+  CHECK(env.type == expected_type, "%s: type %d", fixture, (int)env.type);
+  CHECK(env.data == data, "%s: envelope does not point at the message", fixture);
+
+  char old_value[BUFFER_SIZE];
+  char new_value[BUFFER_SIZE];
+  CHECK(parse_json_data(data, "message_settings", old_value, sizeof(old_value)) == XCASH_OK &&
+        strcmp(env.message_settings, old_value) == 0, "%s: message_settings '%s'", fixture, env.message_settings);
+  CHECK(parse_json_data(data, "public_address", old_value, sizeof(old_value)) == XCASH_OK &&
+        strcmp(env.public_address, old_value) == 0, "%s: public_address '%s'", fixture, env.public_address);
+
+  for (size_t i = 0; i < count; i++) {
+    memset(old_value, 'x', sizeof(old_value));
+    memset(new_value, 'y', sizeof(new_value));
+    int old_rc = parse_json_data(data, fields[i], old_value, sizeof(old_value));
+    int new_rc = parse_msg_env_field(&env, fields[i], new_value, sizeof(new_value));
+    CHECK(old_rc == XCASH_OK, "%s: %s missing from fixture", fixture, fields[i]);
+    CHECK(old_rc == new_rc && strcmp(old_value, new_value) == 0, "%s: %s '%s' != '%s'", fixture, fields[i],
+          new_value, old_value);
+
+    // Truncation into a short buffer matches too
+    int old_short = parse_json_data(data, fields[i], old_value, 9);
+    int new_short = parse_msg_env_field(&env, fields[i], new_value, 9);
+    CHECK(old_short == new_short && strcmp(old_value, new_value) == 0, "%s: %s truncated '%s' != '%s'", fixture,
+          fields[i], new_value, old_value);
+  }
+
+  // A field that is not in the message fails both ways
+  CHECK(parse_json_data(data, "no_such_field", old_value, sizeof(old_value)) == XCASH_ERROR &&
+        parse_msg_env_field(&env, "no_such_field", new_value, sizeof(new_value)) == XCASH_ERROR,
+        "%s: missing field accepted", fixture);
+
+  cJSON_Delete(env.root);
+  free(data);
+}
+
+static void check_rejects(void) {
+  xcash_msg_env_t env;
+  CHECK(!xcash_msg_env_parse(&env, "{\"message_settings\": \"NODES_TO_NODES_VOTE_MAJORITY_RESULTS\""),
+        "truncated message accepted");
+  CHECK(env.root == NULL, "tree kept after a parse error");
+  CHECK(!xcash_msg_env_parse(&env, "{\"public_address\": \"XCK1\"}"), "message without message_settings accepted");
+  CHECK(env.root == NULL, "tree kept without message_settings");
+  CHECK(!xcash_msg_env_parse(&env, "{\"message_settings\": 7}"), "numeric message_settings accepted");
+
+  // No public_address is allowed; the envelope leaves it empty
+  CHECK(xcash_msg_env_parse(&env, "{\"message_settings\": \"NODE_TO_NETWORK_DATA_NODES_GET_CURRENT_BLOCK_VERIFIERS_LIST\"}"),
+        "message without public_address rejected");
+  CHECK(env.public_address[0] == '\0', "public_address '%s'", env.public_address);
+  CHECK(parse_msg_env_field(&env, "public_address", env.public_address, sizeof(env.public_address)) == XCASH_ERROR,
+        "absent public_address read");
+  cJSON_Delete(env.root);
+
+  CHECK(parse_msg_env_field(NULL, "public_address", env.public_address, sizeof(env.public_address)) == XCASH_ERROR,
+        "NULL envelope read");
+}
+
+int main(void) {
+  check_fields("vrf_data_message.json", XMSG_BLOCK_VERIFIERS_TO_BLOCK_VERIFIERS_VRF_DATA, VRF_DATA_FIELDS,
+               sizeof(VRF_DATA_FIELDS) / sizeof(VRF_DATA_FIELDS[0]));
+  check_fields("vote_majority_message.json", XMSG_NODES_TO_NODES_VOTE_MAJORITY_RESULTS, VOTE_FIELDS,
+               sizeof(VOTE_FIELDS) / sizeof(VOTE_FIELDS[0]));
+  check_rejects();
+  TEST_DONE("msg_env_test");
+}
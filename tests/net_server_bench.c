@@ -0,0 +1,308 @@
+#include "test_common.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include "net_server.h"
+#include "string_functions.h"
+
+/*
+ * Connect-to-dispatch latency of the epoll server against the thread-per-connection model it replaced.
+ *
+ * N peers, each from its own loopback address (127.1.x.y, so the per-peer job cap does not apply), connect
+ * at the same moment and send one VRF_DATA sized message with the legacy gzip prefix, as every sender does
+ * unless --framed-messages is set. Linked with --wrap=handle_srv_message: the wrapper stamps the time the
+ * message reaches a handler instead of running it. The reference server is the former server_thread_loop /
+ * handle_client: blocking accept, a semaphore of MAX_ACTIVE_CLIENTS (200) slots and one detached thread
+ * with a BUFFER_SIZE stack buffer per connection.
+ *
+ * At MAX_CONNECTIONS live connections the epoll server stops accepting and leaves further clients in the
+ * listen backlog until a connection closes, so every peer's message must be dispatched: the bench fails
+ * if any is lost, at 2000 peers as at 50.
+ */
+
+#define BENCH_EPOLL_PORT 18390
+#define BENCH_THREAD_PORT 18391
+#define BENCH_MAX_PEERS 2000
+#define BENCH_REFERENCE_SLOTS 200      /* MAX_ACTIVE_CLIENTS of the thread-per-connection server */
+#define BENCH_TIMEOUT_MS 20000
+
+static const size_t bench_peer_counts[] = {50, 200, 2000};
+
+static uint64_t connect_ns[BENCH_MAX_PEERS];
+static _Atomic uint64_t dispatch_ns[BENCH_MAX_PEERS];
+static atomic_size_t dispatched;
+
+void __real_handle_srv_message(const char* data, size_t length, server_client_t* client);
+
+void __wrap_handle_srv_message(const char* data, size_t length, server_client_t* client) {
+  (void)client;
+  char head[256];
+  size_t n = length < sizeof(head) - 1 ? length : sizeof(head) - 1;
+  memcpy(head, data, n);
+  head[n] = '\0';
+
+  const char* p = strstr(head, "\"peer\":\"");
+  if (!p) return;
+  long i = strtol(p + 8, NULL, 10);
+  if (i < 0 || i >= BENCH_MAX_PEERS) return;
+
+  uint64_t expected = 0;
+  if (atomic_compare_exchange_strong(&dispatch_ns[i], &expected, test_now_ns())) {
+    atomic_fetch_add(&dispatched, 1);
+  }
+}
+
+// ---- Reference: thread per connection ----
+
+static int reference_fd = -1;
+static sem_t reference_slots;
+static atomic_bool reference_running;
+static pthread_t reference_thread;
+
+static void* reference_handle_client(void* arg) {
+  server_client_t* client = (server_client_t*)arg;
+
+  struct timeval recv_timeout = {RECEIVE_TIMEOUT_SEC, 0};
+  setsockopt(client->socket_fd, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout));
+
+  char buffer[BUFFER_SIZE];
+  for (;;) {
+    memset(buffer, 0, sizeof(buffer));
+    ssize_t bytes = recv(client->socket_fd, buffer, sizeof(buffer) - 1, 0);
+    if (bytes < 0 && errno == EINTR) continue;
+    if (bytes <= 0) break;
+
+    unsigned char* decompressed = NULL;
+    size_t decompressed_len = 0;
+    if (!decompress_gzip_with_prefix((const unsigned char*)buffer, (size_t)bytes, &decompressed, &decompressed_len)) {
+      continue;
+    }
+    __wrap_handle_srv_message((char*)decompressed, decompressed_len, client);
+    free(decompressed);
+  }
+
+  close(client->socket_fd);
+  free(client);
+  sem_post(&reference_slots);
+  return NULL;
+}
+
+static void* reference_accept_loop(void* arg) {
+  (void)arg;
+  while (atomic_load(&reference_running)) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    server_client_t* client = malloc(sizeof(server_client_t));
+    if (!client) continue;
+
+    client->socket_fd = accept(reference_fd, (struct sockaddr*)&addr, &addr_len);
+    if (client->socket_fd < 0) {
+      free(client);
+      if (errno == EINTR) continue;
+      break;
+    }
+    inet_ntop(AF_INET, &addr.sin_addr, client->client_ip, sizeof(client->client_ip));
+
+    sem_wait(&reference_slots);
+    pthread_t t;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, BUFFER_SIZE + 256 * 1024);
+    if (pthread_create(&t, &attr, reference_handle_client, client) != 0) {
+      close(client->socket_fd);
+      free(client);
+      sem_post(&reference_slots);
+    } else {
+      pthread_detach(t);
+    }
+    pthread_attr_destroy(&attr);
+  }
+  return NULL;
+}
+
+static bool reference_start(int port) {
+  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = INADDR_ANY};
+  int opt = 1;
+  reference_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (reference_fd < 0) return false;
+  setsockopt(reference_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  if (bind(reference_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(reference_fd, MAX_CONNECTIONS) != 0) {
+    close(reference_fd);
+    return false;
+  }
+  sem_init(&reference_slots, 0, BENCH_REFERENCE_SLOTS);
+  atomic_store(&reference_running, true);
+  return pthread_create(&reference_thread, NULL, reference_accept_loop, NULL) == 0;
+}
+
+static void reference_stop(void) {
+  atomic_store(&reference_running, false);
+  shutdown(reference_fd, SHUT_RDWR);
+  pthread_join(reference_thread, NULL);
+  close(reference_fd);
+  // let the detached handlers drain before the slots go away
+  for (int i = 0; i < BENCH_REFERENCE_SLOTS; i++) sem_wait(&reference_slots);
+  sem_destroy(&reference_slots);
+}
+
+// ---- Peers ----
+
+typedef struct {
+  unsigned char* data;
+  size_t len;
+} bench_payload_t;
+
+static bench_payload_t payloads[BENCH_MAX_PEERS];
+
+static bool build_payloads(void) {
+  char message[2048];
+  char hex[321];
+  for (size_t i = 0; i < sizeof(hex) - 1; i++) hex[i] = "0123456789abcdef"[(i * 7 + 3) % 16];
+  hex[sizeof(hex) - 1] = '\0';
+
+  for (size_t i = 0; i < BENCH_MAX_PEERS; i++) {
+    snprintf(message, sizeof(message),
+             "{\"message_settings\":\"BLOCK_VERIFIERS_TO_BLOCK_VERIFIERS_VRF_DATA\",\"peer\":\"%zu\","
+             "\"public_address\":\"XCK1%094zu\",\"vrf_public_key\":\"%.64s\",\"vrf_proof\":\"%.160s\","
+             "\"vrf_beta\":\"%.128s\",\"block-height\":\"2500000\",\"delegates_hash\":\"%.64s\","
+             "\"XCASH_DPOPS_signature\":\"SigV2%.88s\"}",
+             i, i, hex + (i % 64), hex + 10, hex + 20, hex + 30, hex);
+    if (!compress_gzip_with_prefix((const unsigned char*)message, strlen(message), &payloads[i].data, &payloads[i].len)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+typedef struct {
+  size_t peers;
+  size_t sent;
+  size_t dispatched;
+  double wall_ms;
+  double p50_ms, p99_ms, max_ms;
+} bench_result_t;
+
+static void run_peers(int port, size_t n, bench_result_t* r) {
+  static int fds[BENCH_MAX_PEERS];
+  static uint64_t latency[BENCH_MAX_PEERS];
+  memset(r, 0, sizeof(*r));
+  r->peers = n;
+  for (size_t i = 0; i < n; i++) atomic_store(&dispatch_ns[i], 0);
+  atomic_store(&dispatched, 0);
+
+  int ep = epoll_create1(0);
+  const uint64_t start = test_now_ns();
+  for (size_t i = 0; i < n; i++) {
+    fds[i] = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_in src = {.sin_family = AF_INET};
+    src.sin_addr.s_addr = htonl((127u << 24) | (1u << 16) | ((uint32_t)(i / 250) << 8) | (uint32_t)(i % 250 + 1));
+    struct sockaddr_in dst = {.sin_family = AF_INET, .sin_port = htons(port)};
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fds[i], (struct sockaddr*)&src, sizeof(src));
+
+    connect_ns[i] = test_now_ns();
+    if (connect(fds[i], (struct sockaddr*)&dst, sizeof(dst)) != 0 && errno != EINPROGRESS) {
+      close(fds[i]);
+      fds[i] = -1;
+      continue;
+    }
+    struct epoll_event ev = {.events = EPOLLOUT, .data.u64 = i};
+    epoll_ctl(ep, EPOLL_CTL_ADD, fds[i], &ev);
+  }
+
+  // send as soon as each connection completes, then close like a one-shot sender
+  size_t pending = 0;
+  for (size_t i = 0; i < n; i++) pending += fds[i] >= 0;
+  struct epoll_event events[256];
+  while (pending > 0 && test_now_ns() - start < (uint64_t)BENCH_TIMEOUT_MS * 1000000ull) {
+    int k = epoll_wait(ep, events, 256, 100);
+    for (int e = 0; e < k; e++) {
+      size_t i = (size_t)events[e].data.u64;
+      int err = 0;
+      socklen_t len = sizeof(err);
+      getsockopt(fds[i], SOL_SOCKET, SO_ERROR, &err, &len);
+      if (err == 0 && send(fds[i], payloads[i].data, payloads[i].len, MSG_NOSIGNAL) == (ssize_t)payloads[i].len) {
+        r->sent++;
+      }
+      epoll_ctl(ep, EPOLL_CTL_DEL, fds[i], NULL);
+      close(fds[i]);
+      fds[i] = -1;
+      pending--;
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (fds[i] >= 0) close(fds[i]);
+  }
+  close(ep);
+
+  while (atomic_load(&dispatched) < r->sent && test_now_ns() - start < (uint64_t)BENCH_TIMEOUT_MS * 1000000ull) {
+    usleep(1000);
+  }
+  r->wall_ms = (double)(test_now_ns() - start) / 1e6;
+
+  size_t m = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint64_t d = atomic_load(&dispatch_ns[i]);
+    if (d) latency[m++] = d - connect_ns[i];
+  }
+  r->dispatched = m;
+  r->p50_ms = (double)test_percentile(latency, m, 50) / 1e6;
+  r->p99_ms = (double)test_percentile(latency, m, 99) / 1e6;
+  r->max_ms = (double)test_percentile(latency, m, 100) / 1e6;
+}
+
+static void print_result(const char* model, const bench_result_t* r) {
+  printf("%-16s peers %5zu  refused %5zu  lost %5zu  dispatched %5zu  wall %8.1f ms  "
+         "connect-to-dispatch p50 %7.2f  p99 %7.2f  max %7.2f ms\n",
+         model, r->peers, r->peers - r->sent, r->peers - r->dispatched, r->dispatched, r->wall_ms, r->p50_ms,
+         r->p99_ms, r->max_ms);
+}
+
+int main(void) {
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < 4 * BENCH_MAX_PEERS + 256) {
+    rl.rlim_cur = rl.rlim_max < 4 * BENCH_MAX_PEERS + 256 ? rl.rlim_max : 4 * BENCH_MAX_PEERS + 256;
+    setrlimit(RLIMIT_NOFILE, &rl);
+  }
+
+  if (!build_payloads()) {
+    fprintf(stderr, "could not compress the bench messages\n");
+    return 1;
+  }
+  if (!start_tcp_server(BENCH_EPOLL_PORT) || !reference_start(BENCH_THREAD_PORT)) {
+    fprintf(stderr, "could not start the servers on ports %d/%d\n", BENCH_EPOLL_PORT, BENCH_THREAD_PORT);
+    return 1;
+  }
+
+  int failures = 0;
+  for (size_t c = 0; c < sizeof(bench_peer_counts) / sizeof(bench_peer_counts[0]); c++) {
+    bench_result_t epoll_result, thread_result;
+    run_peers(BENCH_EPOLL_PORT, bench_peer_counts[c], &epoll_result);
+    usleep(200000);
+    run_peers(BENCH_THREAD_PORT, bench_peer_counts[c], &thread_result);
+    usleep(200000);
+    print_result("epoll + workers", &epoll_result);
+    print_result("thread per conn", &thread_result);
+
+    // Zero lost: every peer connected, sent and reached a handler
+    if (epoll_result.sent != epoll_result.peers || epoll_result.dispatched != epoll_result.peers) {
+      fprintf(stderr, "epoll server lost %zu of %zu messages (%zu sent, %zu dispatched)\n",
+              epoll_result.peers - epoll_result.dispatched, epoll_result.peers, epoll_result.sent,
+              epoll_result.dispatched);
+      failures++;
+    }
+  }
+
+  dispatch_queue_stats_t stats;
+  get_dispatch_queue_stats(DISPATCH_CONSENSUS, &stats, false);
+  printf("consensus queue: enqueued %llu  dropped %llu  max depth %zu  wait max %llu ms\n",
+         (unsigned long long)stats.enqueued, (unsigned long long)stats.dropped, stats.max_depth,
+         (unsigned long long)stats.wait_ms_max);
+
+  stop_tcp_server();
+  reference_stop();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+#include <stdatomic.h>
+#include "reserve_proof_pipeline.h"
+#include "test_common.h"
+#include "mongoc_fake.h"
+
+/*
+ * The reserve proof ledger lets a scan count unchanged proofs without calling the wallet. These runs go
+ * through load, scan and commit against in-memory reserve_proofs and ledger collections
+ * (tests/mongoc_fake.h), with the wallet replaced through -Wl,--wrap=check_reserve_proofs. They check
+ * that:
+ *   - the first run verifies everything and later runs only a slice of the unchanged proofs;
+ *   - a changed proof or amount always goes back to the wallet;
+ *   - spent proofs are all caught within RESERVE_PROOF_RECHECK_SLICES runs;
+ *   - a run RESERVE_PROOF_MAX_AGE_BLOCKS later re-verifies every proof;
+ *   - entries of voters who left are pruned.
+ * After every run, anything taken from the ledger must be a proof the wallet accepted before, and the
+ * delegate totals must add up to the valid results.
+ */
+
+#define PROOF_DOCS 2000
+#define PROOF_DELEGATES 8
+#define FIRST_HEIGHT 100000
+
+static char proofs[PROOF_DOCS][128];
+static int64_t amounts[PROOF_DOCS];
+static bool spent[PROOF_DOCS];
+static bool removed[PROOF_DOCS];
+static atomic_int wallet_calls;
+static atomic_int wallet_mismatches;
+
+typedef struct {
+  size_t trusted, rechecked, fresh, valid, invalid, results;
+  int wallet_calls;
+  bool totals_exact;   // the totals equal the sums of the proofs the wallet would accept today
+} run_result_t;
+
+static void voter_address(size_t i, char out[XCASH_WALLET_LENGTH + 1]) {
+  snprintf(out, XCASH_WALLET_LENGTH + 1, "%s%095zu", XCASH_WALLET_PREFIX, i);
+}
+
+static void delegate_address(size_t d, char out[XCASH_WALLET_LENGTH + 1]) {
+  snprintf(out, XCASH_WALLET_LENGTH + 1, "%sD%094zu", XCASH_WALLET_PREFIX, d);
+}
+
+static size_t voter_index(const char* voter) {
+  return (size_t)strtoull(voter + strlen(XCASH_WALLET_PREFIX), NULL, 10);
+}
+
+static size_t delegate_index(const char* delegate) {
+  return (size_t)strtoull(delegate + strlen(XCASH_WALLET_PREFIX) + 1, NULL, 10);
+}
+
+static bool doc_skipped(size_t i) {
+  return i % 97 == 5;
+}
+
+// What the wallet answers today
+static bool proof_valid(size_t i) {
+  return i % 13 != 0 && !spent[i];
+}
+
+static bool doc_counted(size_t i) {
+  return !removed[i] && !doc_skipped(i) && proof_valid(i);
+}
+
+int __wrap_check_reserve_proofs(uint64_t vote_amount_atomic, const char* PUBLIC_ADDRESS, const char* RESERVE_PROOF) {
+  atomic_fetch_add(&wallet_calls, 1);
+  size_t i = voter_index(PUBLIC_ADDRESS);
+  if (i >= PROOF_DOCS || vote_amount_atomic != (uint64_t)amounts[i] || strcmp(RESERVE_PROOF, proofs[i]) != 0) {
+    atomic_fetch_add(&wallet_mismatches, 1);
+    return XCASH_ERROR;
+  }
+  return proof_valid(i) ? XCASH_OK : XCASH_ERROR;
+}
+
+// Writes document i of reserve_proofs from proofs[i] and amounts[i]
+static void store_doc(mongoc_collection_t* coll, size_t i) {
+  char voter[XCASH_WALLET_LENGTH + 1], delegate[XCASH_WALLET_LENGTH + 1];
+  voter_address(i, voter);
+  delegate_address(i % PROOF_DELEGATES, delegate);
+
+  bson_t filter;
+  bson_init(&filter);
+  BSON_APPEND_UTF8(&filter, "_id", voter);
+  bson_t* set = bson_new();
+  BSON_APPEND_UTF8(set, "public_address_voted_for", delegate);
+  BSON_APPEND_UTF8(set, "reserve_proof", proofs[i]);
+  if (!doc_skipped(i)) BSON_APPEND_INT64(set, "total_vote", amounts[i]);
+  bson_t* update = BCON_NEW("$set", BCON_DOCUMENT(set));
+  bson_t* opts = BCON_NEW("upsert", BCON_BOOL(true));
+  mongoc_collection_update_one(coll, &filter, update, opts, NULL, NULL);
+  bson_destroy(opts);
+  bson_destroy(update);
+  bson_destroy(set);
+  bson_destroy(&filter);
+}
+
+// One scan cycle as the timer thread runs it; label NULL runs it without printing a line
+static run_result_t run(mongoc_collection_t* proofs_coll, mongoc_collection_t* ledger_coll, uint64_t height,
+                        const char* label) {
+  const char* name = label ? label : "run";
+  run_result_t out;
+  memset(&out, 0, sizeof(out));
+  atomic_store(&wallet_calls, 0);
+
+  reserve_proof_ledger_t ledger;
+  bool have_ledger = reserve_proof_ledger_load(ledger_coll, height, &ledger);
+  CHECK(have_ledger, "%s: ledger not loaded", name);
+
+  reserve_proof_scan_t* scan = calloc(1, sizeof(*scan));
+  mongoc_cursor_t* cur = mongoc_collection_find_with_opts(proofs_coll, NULL, NULL, NULL);
+  bool complete = reserve_proof_scan(cur, have_ledger ? &ledger : NULL, scan);
+  mongoc_cursor_destroy(cur);
+  CHECK(complete, "%s: scan incomplete", name);
+  if (have_ledger) {
+    reserve_proof_ledger_commit(ledger_coll, &ledger, scan);
+    reserve_proof_ledger_free(&ledger);
+  }
+
+  out.trusted = scan->trusted;
+  out.rechecked = scan->rechecked;
+  out.fresh = scan->fresh;
+  out.valid = scan->valid;
+  out.invalid = scan->invalid;
+  out.results = scan->result_count;
+  out.wallet_calls = atomic_load(&wallet_calls);
+
+  CHECK(atomic_load(&wallet_mismatches) == 0, "%s: wallet called with a stale amount or proof", name);
+  CHECK((size_t)out.wallet_calls == out.rechecked + out.fresh, "%s: %d wallet calls for %zu rechecked + %zu fresh",
+        name, out.wallet_calls, out.rechecked, out.fresh);
+  CHECK(out.trusted + out.rechecked + out.fresh == out.results && out.valid + out.invalid == out.results,
+        "%s: counters do not add up", name);
+
+  // Wallet answers are today's; ledger answers can only be proofs that were valid before and have
+  // been spent since
+  int64_t result_totals[PROOF_DELEGATES] = {0};
+  for (size_t r = 0; r < scan->result_count; r++) {
+    const reserve_proof_result_t* res = &scan->results[r];
+    size_t i = voter_index(res->voter);
+    if (res->cached) {
+      CHECK(res->valid && (proof_valid(i) || spent[i]), "%s: document %zu taken from the ledger", name, i);
+    } else {
+      CHECK(res->valid == proof_valid(i), "%s: document %zu verdict", name, i);
+    }
+    if (res->valid) result_totals[i % PROOF_DELEGATES] += (int64_t)res->amount;
+  }
+
+  int64_t expected_totals[PROOF_DELEGATES] = {0};
+  for (size_t i = 0; i < PROOF_DOCS; i++) {
+    if (doc_counted(i)) expected_totals[i % PROOF_DELEGATES] += amounts[i];
+  }
+  out.totals_exact = true;
+  for (size_t d = 0; d < scan->delegate_count; d++) {
+    size_t k = delegate_index(scan->delegates[d]);
+    CHECK(scan->totals[d] == result_totals[k], "%s: delegate %zu total differs from its results", name, k);
+    if (scan->totals[d] != expected_totals[k]) out.totals_exact = false;
+  }
+
+  if (label) {
+    printf("%-28s height %llu  wallet calls %4d  trusted %4zu  rechecked %4zu  fresh %4zu  valid %4zu  invalid %3zu\n",
+           label, (unsigned long long)height, out.wallet_calls, out.trusted, out.rechecked, out.fresh, out.valid,
+           out.invalid);
+  }
+  reserve_proof_scan_free(scan);
+  free(scan);
+  return out;
+}
+
+static size_t counted_docs(void) {
+  size_t n = 0;
+  for (size_t i = 0; i < PROOF_DOCS; i++) n += doc_counted(i);
+  return n;
+}
+
+static size_t verified_docs(void) {
+  size_t n = 0;
+  for (size_t i = 0; i < PROOF_DOCS; i++) n += !removed[i] && !doc_skipped(i);
+  return n;
+}
+
+int main(void) {
+  mongoc_collection_t* proofs_coll = mongoc_fake_collection("reserve_proofs");
+  mongoc_collection_t* ledger_coll = mongoc_fake_collection("reserve_proofs_ledger");
+  for (size_t i = 0; i < PROOF_DOCS; i++) {
+    snprintf(proofs[i], sizeof(proofs[i]), "ReserveProofV11%064zxa", i * 2654435761u);
+    amounts[i] = 1000000 + (int64_t)i * 7;
+    store_doc(proofs_coll, i);
+  }
+
+  reserve_proof_ledger_t unused;
+  CHECK(!reserve_proof_ledger_load(ledger_coll, 0, &unused), "ledger loaded without a chain height");
+
+  // An empty ledger sends every proof to the wallet and stores the valid ones
+  uint64_t height = FIRST_HEIGHT;
+  run_result_t r = run(proofs_coll, ledger_coll, height, "first run (empty ledger)");
+  CHECK(r.fresh == verified_docs() && r.trusted == 0 && r.totals_exact, "first run");
+  CHECK(mongoc_fake_count(ledger_coll) == counted_docs(), "%zu ledger entries after the first run",
+        mongoc_fake_count(ledger_coll));
+
+  // A malformed entry is ignored on load and pruned as soon as it is twice the maximum age old
+  bson_t* junk = BCON_NEW("_id", BCON_UTF8("junk"), "key", BCON_UTF8("not hex"), "height", BCON_INT64(5));
+  mongoc_collection_insert_one(ledger_coll, junk, NULL, NULL, NULL);
+  bson_destroy(junk);
+
+  // Unchanged proofs come from the ledger except for one slice; rejected ones are never stored
+  height += 720;
+  r = run(proofs_coll, ledger_coll, height, "second run");
+  CHECK(r.totals_exact, "second run totals");
+  CHECK(r.trusted + r.rechecked == counted_docs() && r.fresh == verified_docs() - counted_docs(),
+        "second run: trusted %zu rechecked %zu fresh %zu", r.trusted, r.rechecked, r.fresh);
+  CHECK(r.rechecked > 0 && r.rechecked < counted_docs() / 8, "second run rechecked %zu", r.rechecked);
+  CHECK(mongoc_fake_count(ledger_coll) == counted_docs(), "%zu ledger entries after the second run",
+        mongoc_fake_count(ledger_coll));
+
+  // Changed proofs and amounts are verified again, whatever their slice
+  for (size_t k = 1; k <= 20; k++) {
+    proofs[k * 7][strlen(proofs[k * 7]) - 1] = 'b';
+    store_doc(proofs_coll, k * 7);
+  }
+  for (size_t k = 1; k <= 5; k++) {
+    amounts[k * 11] += 5;
+    store_doc(proofs_coll, k * 11);
+  }
+  size_t changed_valid = 0;
+  for (size_t k = 1; k <= 20; k++) changed_valid += doc_counted(k * 7);
+  for (size_t k = 1; k <= 5; k++) changed_valid += doc_counted(k * 11);
+  height += 720;
+  r = run(proofs_coll, ledger_coll, height, "25 changed proofs");
+  CHECK(r.totals_exact, "changed proofs totals");
+  CHECK(r.fresh == verified_docs() - counted_docs() + changed_valid, "changed proofs: fresh %zu", r.fresh);
+
+  // Spent proofs may still be trusted for a while, but one pass over the slices catches all of them
+  for (size_t i = 0; i < PROOF_DOCS; i++) {
+    if (i % 10 == 1) spent[i] = true;
+  }
+  for (int k = 0; k < RESERVE_PROOF_RECHECK_SLICES; k++) {
+    char label[64];
+    snprintf(label, sizeof(label), "10%% spent, run %d", k + 1);
+    height += 10;
+    r = run(proofs_coll, ledger_coll, height, (k == 0 || k == RESERVE_PROOF_RECHECK_SLICES - 1) ? label : NULL);
+  }
+  CHECK(r.totals_exact, "spent proofs still counted after %d runs", RESERVE_PROOF_RECHECK_SLICES);
+  CHECK(mongoc_fake_count(ledger_coll) == counted_docs(), "%zu ledger entries after the spent proofs",
+        mongoc_fake_count(ledger_coll));
+
+  // Past the maximum age every proof goes back to the wallet
+  height += RESERVE_PROOF_MAX_AGE_BLOCKS;
+  r = run(proofs_coll, ledger_coll, height, "past max age (full sweep)");
+  CHECK(r.trusted == 0 && r.wallet_calls == (int)verified_docs() && r.totals_exact, "full sweep");
+  height += 720;
+  r = run(proofs_coll, ledger_coll, height, "after the sweep");
+  CHECK(r.totals_exact && r.trusted > 0, "after the sweep");
+
+  // Voters who left keep their entries until they are twice the maximum age old
+  for (size_t i = 0; i < PROOF_DOCS; i += 40) {
+    char voter[XCASH_WALLET_LENGTH + 1];
+    voter_address(i, voter);
+    bson_t* filter = BCON_NEW("_id", BCON_UTF8(voter));
+    mongoc_collection_delete_one(proofs_coll, filter, NULL, NULL, NULL);
+    bson_destroy(filter);
+    removed[i] = true;
+  }
+  height += 720;
+  r = run(proofs_coll, ledger_coll, height, "50 voters left");
+  CHECK(r.totals_exact, "voters left totals");
+  CHECK(mongoc_fake_count(ledger_coll) > counted_docs(), "entries of the voters who left pruned early");
+  height += 2 * RESERVE_PROOF_MAX_AGE_BLOCKS;
+  r = run(proofs_coll, ledger_coll, height, "twice the max age later");
+  CHECK(r.totals_exact, "pruned run totals");
+  CHECK(mongoc_fake_count(ledger_coll) == counted_docs(), "%zu ledger entries after pruning, expected %zu",
+        mongoc_fake_count(ledger_coll), counted_docs());
+
+  TEST_DONE("reserve_proof_ledger_test");
+}
@@ -0,0 +1,185 @@
+#include <stdatomic.h>
+#include "reserve_proof_pipeline.h"
+#include "test_common.h"
+#include "mongoc_fake.h"
+
+/*
+ * reserve_proof_scan verifies a reserve_proofs cursor with RESERVE_PROOF_VERIFIERS concurrent wallet
+ * calls. Over a collection with malformed documents and proofs the wallet rejects, every proof must
+ * reach the wallet exactly once with its own amount, the per-delegate totals must equal the sum of the
+ * valid claims, and the results must come back in cursor order whatever thread verified them.
+ *
+ * The collection lives in tests/mongoc_fake.h and the wallet is replaced through
+ * -Wl,--wrap=check_reserve_proofs.
+ */
+
+#define PROOF_DOCS 2000
+#define PROOF_DELEGATES 8
+
+static atomic_int wallet_calls;
+static atomic_int wallet_mismatches;
+static atomic_int wallet_seen[PROOF_DOCS];
+
+static void voter_address(size_t i, char out[XCASH_WALLET_LENGTH + 1]) {
+  snprintf(out, XCASH_WALLET_LENGTH + 1, "%s%095zu", XCASH_WALLET_PREFIX, i);
+}
+
+static void delegate_address(size_t d, char out[XCASH_WALLET_LENGTH + 1]) {
+  snprintf(out, XCASH_WALLET_LENGTH + 1, "%sD%094zu", XCASH_WALLET_PREFIX, d);
+}
+
+static void proof_string(size_t i, char* out, size_t size) {
+  snprintf(out, size, "ReserveProofV11%064zx", i * 2654435761u);
+}
+
+// Documents the scan must skip before the wallet: no total_vote, a double total_vote, a zero
+// total_vote or no reserve_proof
+static bool doc_skipped(size_t i) {
+  return i % 97 == 5 || i % 50 == 7 || i % 151 == 9 || i % 89 == 3;
+}
+
+static bool wallet_accepts(size_t i) {
+  return i % 13 != 0;
+}
+
+static int64_t doc_amount(size_t i) {
+  return 1000000 + (int64_t)i * 7;
+}
+
+int __wrap_check_reserve_proofs(uint64_t vote_amount_atomic, const char* PUBLIC_ADDRESS, const char* RESERVE_PROOF) {
+  atomic_fetch_add(&wallet_calls, 1);
+  size_t i = (size_t)strtoull(PUBLIC_ADDRESS + strlen(XCASH_WALLET_PREFIX), NULL, 10);
+  char proof[128];
+  proof_string(i, proof, sizeof(proof));
+  if (i >= PROOF_DOCS || doc_skipped(i) || vote_amount_atomic != (uint64_t)doc_amount(i) ||
+      strcmp(RESERVE_PROOF, proof) != 0) {
+    atomic_fetch_add(&wallet_mismatches, 1);
+    return XCASH_ERROR;
+  }
+  atomic_fetch_add(&wallet_seen[i], 1);
+  return wallet_accepts(i) ? XCASH_OK : XCASH_ERROR;
+}
+
+static void fill_collection(mongoc_collection_t* coll) {
+  for (size_t i = 0; i < PROOF_DOCS; i++) {
+    char voter[XCASH_WALLET_LENGTH + 1], delegate[XCASH_WALLET_LENGTH + 1], proof[128];
+    voter_address(i, voter);
+    delegate_address(i % PROOF_DELEGATES, delegate);
+    proof_string(i, proof, sizeof(proof));
+
+    bson_t* doc = bson_new();
+    BSON_APPEND_UTF8(doc, "_id", voter);
+    BSON_APPEND_UTF8(doc, "public_address_voted_for", delegate);
+    if (i % 89 != 3) BSON_APPEND_UTF8(doc, "reserve_proof", proof);
+    if (i % 97 == 5) {
+      // no total_vote
+    } else if (i % 50 == 7) {
+      BSON_APPEND_DOUBLE(doc, "total_vote", (double)doc_amount(i));
+    } else if (i % 151 == 9) {
+      BSON_APPEND_INT64(doc, "total_vote", 0);
+    } else if (i % 61 == 2) {
+      BSON_APPEND_INT32(doc, "total_vote", (int32_t)doc_amount(i));
+    } else {
+      BSON_APPEND_INT64(doc, "total_vote", doc_amount(i));
+    }
+    mongoc_collection_insert_one(coll, doc, NULL, NULL, NULL);
+    bson_destroy(doc);
+  }
+}
+
+static void check_full_scan(mongoc_collection_t* coll) {
+  int64_t expected_totals[PROOF_DELEGATES] = {0};
+  size_t expected_valid = 0, expected_invalid = 0, expected_skipped = 0;
+  for (size_t i = 0; i < PROOF_DOCS; i++) {
+    if (doc_skipped(i)) {
+      expected_skipped++;
+    } else if (wallet_accepts(i)) {
+      expected_valid++;
+      expected_totals[i % PROOF_DELEGATES] += doc_amount(i);
+    } else {
+      expected_invalid++;
+    }
+  }
+
+  reserve_proof_scan_t* scan = calloc(1, sizeof(*scan));
+  mongoc_cursor_t* cur = mongoc_collection_find_with_opts(coll, NULL, NULL, NULL);
+  bool complete = reserve_proof_scan(cur, NULL, scan);
+  mongoc_cursor_destroy(cur);
+
+  CHECK(complete && scan->complete, "scan incomplete");
+  CHECK(scan->seen == PROOF_DOCS, "seen %zu", scan->seen);
+  CHECK(scan->valid == expected_valid, "valid %zu, expected %zu", scan->valid, expected_valid);
+  CHECK(scan->invalid == expected_invalid, "invalid %zu, expected %zu", scan->invalid, expected_invalid);
+  CHECK(scan->skipped == expected_skipped, "skipped %zu, expected %zu", scan->skipped, expected_skipped);
+  CHECK(scan->fresh == expected_valid + expected_invalid && scan->trusted == 0 && scan->rechecked == 0,
+        "fresh %zu trusted %zu rechecked %zu without a ledger", scan->fresh, scan->trusted, scan->rechecked);
+
+  // Each proof reached the wallet once, with the amount and proof of its own document
+  CHECK(atomic_load(&wallet_mismatches) == 0, "%d wallet calls with the wrong voter, amount or proof",
+        atomic_load(&wallet_mismatches));
+  CHECK((size_t)atomic_load(&wallet_calls) == expected_valid + expected_invalid, "%d wallet calls",
+        atomic_load(&wallet_calls));
+  for (size_t i = 0; i < PROOF_DOCS; i++) {
+    int calls = atomic_load(&wallet_seen[i]);
+    CHECK(calls == (doc_skipped(i) ? 0 : 1), "document %zu verified %d times", i, calls);
+  }
+
+  CHECK(scan->delegate_count == PROOF_DELEGATES, "%zu delegates", scan->delegate_count);
+  for (size_t d = 0; d < scan->delegate_count; d++) {
+    char delegate[XCASH_WALLET_LENGTH + 1];
+    size_t k = 0;
+    for (; k < PROOF_DELEGATES; k++) {
+      delegate_address(k, delegate);
+      if (strcmp(delegate, scan->delegates[d]) == 0) break;
+    }
+    CHECK(k < PROOF_DELEGATES && scan->totals[d] == expected_totals[k], "delegate %zu total %lld", d,
+          (long long)scan->totals[d]);
+  }
+
+  // Results are in cursor order and carry their own document's verdict
+  CHECK(scan->result_count == expected_valid + expected_invalid, "%zu results", scan->result_count);
+  for (size_t r = 0; r < scan->result_count; r++) {
+    const reserve_proof_result_t* res = &scan->results[r];
+    size_t i = (size_t)strtoull(res->voter + strlen(XCASH_WALLET_PREFIX), NULL, 10);
+    CHECK(r == 0 || res->seq > scan->results[r - 1].seq, "result %zu out of order", r);
+    CHECK(res->seq == i + 1, "result %zu seq %llu for document %zu", r, (unsigned long long)res->seq, i);
+    CHECK(res->valid == wallet_accepts(i) && !res->cached && res->amount == (uint64_t)doc_amount(i),
+          "result %zu for document %zu", r, i);
+  }
+
+  reserve_proof_progress_t progress;
+  reserve_proof_get_progress(&progress);
+  CHECK(!progress.running && progress.in_flight == 0, "progress still running");
+  CHECK(progress.queued == expected_valid + expected_invalid && progress.verified == progress.queued,
+        "progress queued %llu verified %llu", (unsigned long long)progress.queued,
+        (unsigned long long)progress.verified);
+  CHECK(progress.valid == expected_valid && progress.invalid == expected_invalid &&
+        progress.skipped == expected_skipped, "progress counters");
+
+  reserve_proof_scan_free(scan);
+  free(scan);
+}
+
+// A cursor that fails part way leaves an incomplete scan holding what was verified before the error
+static void check_cursor_error(mongoc_collection_t* coll) {
+  reserve_proof_scan_t* scan = calloc(1, sizeof(*scan));
+  mongoc_fake_cursor_error_after = 500;
+  mongoc_cursor_t* cur = mongoc_collection_find_with_opts(coll, NULL, NULL, NULL);
+  mongoc_fake_cursor_error_after = 0;
+  bool complete = reserve_proof_scan(cur, NULL, scan);
+  mongoc_cursor_destroy(cur);
+
+  CHECK(!complete && !scan->complete, "scan complete after a cursor error");
+  CHECK(scan->seen == 500, "seen %zu", scan->seen);
+  CHECK(scan->result_count + scan->skipped == 500, "%zu results and %zu skipped", scan->result_count, scan->skipped);
+  reserve_proof_scan_free(scan);
+  free(scan);
+}
+
+int main(void) {
+  mongoc_collection_t* coll = mongoc_fake_collection("reserve_proofs");
+  fill_collection(coll);
+  check_full_scan(coll);
+  check_cursor_error(coll);
+  TEST_DONE("reserve_proof_pipeline_test");
+}
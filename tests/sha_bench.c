@@ -0,0 +1,184 @@
+#include "test_common.h"
+
+#include "VRF_functions.h"
+
+/*
+ * SHA-256 and SHA-512 back ends: correctness on every one this CPU supports, then their speed.
+ *
+ * Each of the portable, SHA-NI and AVX2 back ends is selected in turn and checked against the NIST example
+ * digests (the million 'a' message is fed to SHA-512 in uneven pieces), sha256EL_multi is checked against
+ * sha256EL on messages of every length class, and a round of random vote hash inputs must hash to the
+ * same bytes as under the portable back end. Then vote sized SHA-256 inputs are timed one at a time and
+ * through sha256EL_multi, and VRF sized SHA-512 inputs, over BENCH_ROUNDS rounds of
+ * BLOCK_VERIFIERS_TOTAL_AMOUNT hashes. A back end the CPU lacks is reported and skipped.
+ */
+
+#define BENCH_ROUNDS 20000
+#define SHA_KAT_MILLION 1000000
+#define SHA_MULTI_KAT_MESSAGES 37
+
+// FIPS 180-2 / NIST CAVP example messages; the last entry is one million 'a'
+static const char* const SHA_KAT_MESSAGES[] = {
+  "",
+  "abc",
+  "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+  "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+  NULL
+};
+static const char* const SHA256_KAT_DIGESTS[] = {
+  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+  "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+};
+static const char* const SHA512_KAT_DIGESTS[] = {
+  "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+  "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+  "204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c33596fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445",
+  "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+  "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b"
+};
+
+// the vote hash input is beta || VRF public key || signature
+static uint8_t votes[BLOCK_VERIFIERS_TOTAL_AMOUNT][crypto_vrf_OUTPUTBYTES + crypto_vrf_PUBLICKEYBYTES + 64];
+static const uint8_t* msgs[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+static size_t lens[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+static uint8_t hashes[BLOCK_VERIFIERS_TOTAL_AMOUNT][SHA256_EL_HASH_SIZE];
+static uint8_t portable256[BLOCK_VERIFIERS_TOTAL_AMOUNT][SHA256_EL_HASH_SIZE];
+static uint8_t portable512[BLOCK_VERIFIERS_TOTAL_AMOUNT][crypto_hash_sha512_BYTES];
+
+static bool sha_kat_hex_equal(const unsigned char* data, size_t len, const char* hex) {
+  char buf[2 * crypto_hash_sha512_BYTES + 1];
+  if (len * 2 >= sizeof(buf) || strlen(hex) != len * 2) return false;
+  for (size_t i = 0; i < len; i++) snprintf(buf + 2 * i, sizeof(buf) - 2 * i, "%02x", data[i]);
+  return strcmp(buf, hex) == 0;
+}
+
+// The NIST digests, and sha256EL_multi against sha256EL on empty, one block, spilling and multi-block messages
+static void check_known_answers(const char* name, const unsigned char* million_a) {
+  unsigned char d256[SHA256_EL_HASH_SIZE];
+  unsigned char d512[crypto_hash_sha512_BYTES];
+  crypto_hash_sha512_state st;
+
+  for (size_t i = 0; i < sizeof(SHA256_KAT_DIGESTS) / sizeof(SHA256_KAT_DIGESTS[0]); i++) {
+    const unsigned char* msg = SHA_KAT_MESSAGES[i] ? (const unsigned char*)SHA_KAT_MESSAGES[i] : million_a;
+    size_t len = SHA_KAT_MESSAGES[i] ? strlen(SHA_KAT_MESSAGES[i]) : SHA_KAT_MILLION;
+
+    sha256EL(msg, len, d256);
+    CHECK(sha_kat_hex_equal(d256, sizeof(d256), SHA256_KAT_DIGESTS[i]), "%s: sha256 example %zu", name, i);
+
+    crypto_hash_sha512_init(&st);
+    for (size_t off = 0, step = 1; off < len; off += step, step = step * 3 + 1) {
+      crypto_hash_sha512_update(&st, msg + off, (unsigned long long)(len - off < step ? len - off : step));
+    }
+    crypto_hash_sha512_final(&st, d512);
+    CHECK(sha_kat_hex_equal(d512, sizeof(d512), SHA512_KAT_DIGESTS[i]), "%s: sha512 example %zu", name, i);
+  }
+
+  const uint8_t* kat_msgs[SHA_MULTI_KAT_MESSAGES];
+  size_t kat_lens[SHA_MULTI_KAT_MESSAGES];
+  uint8_t multi[SHA_MULTI_KAT_MESSAGES][SHA256_EL_HASH_SIZE];
+  for (size_t i = 0; i < SHA_MULTI_KAT_MESSAGES; i++) {
+    kat_msgs[i] = million_a + i;
+    kat_lens[i] = (i * 29) % 200;
+  }
+  sha256EL_multi(kat_msgs, kat_lens, SHA_MULTI_KAT_MESSAGES, multi);
+  for (size_t i = 0; i < SHA_MULTI_KAT_MESSAGES; i++) {
+    sha256EL(kat_msgs[i], kat_lens[i], d256);
+    CHECK(memcmp(d256, multi[i], sizeof(d256)) == 0, "%s: sha256_multi message %zu (%zu bytes)", name, i,
+          kat_lens[i]);
+  }
+}
+
+// Random vote inputs hash to the same bytes as under the portable back end, one at a time and batched
+static void check_against_portable(const char* name) {
+  unsigned char d512[crypto_hash_sha512_BYTES];
+  size_t wrong256 = 0, wrong_multi = 0, wrong512 = 0;
+
+  sha256EL_multi(msgs, lens, BLOCK_VERIFIERS_TOTAL_AMOUNT, hashes);
+  for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+    wrong_multi += memcmp(hashes[i], portable256[i], SHA256_EL_HASH_SIZE) != 0;
+    sha256EL(msgs[i], lens[i], hashes[i]);
+    wrong256 += memcmp(hashes[i], portable256[i], SHA256_EL_HASH_SIZE) != 0;
+    crypto_hash_sha512(d512, votes[i], sizeof(votes[i]));
+    wrong512 += memcmp(d512, portable512[i], sizeof(d512)) != 0;
+  }
+  CHECK(wrong256 == 0 && wrong_multi == 0 && wrong512 == 0,
+        "%s differs from the portable back end: sha256 %zu, sha256_multi %zu, sha512 %zu", name, wrong256,
+        wrong_multi, wrong512);
+}
+
+static void time_backend(const char* name) {
+  const double total = (double)BENCH_ROUNDS * BLOCK_VERIFIERS_TOTAL_AMOUNT;
+  unsigned char d512[crypto_hash_sha512_BYTES];
+
+  uint64_t t0 = test_now_ns();
+  for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+    for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) sha256EL(msgs[i], lens[i], hashes[i]);
+  }
+  const double single_ns = (double)(test_now_ns() - t0) / total;
+
+  t0 = test_now_ns();
+  for (size_t r = 0; r < BENCH_ROUNDS; r++) sha256EL_multi(msgs, lens, BLOCK_VERIFIERS_TOTAL_AMOUNT, hashes);
+  const double multi_ns = (double)(test_now_ns() - t0) / total;
+
+  // hash_points input size: suite, two, four 32-byte points
+  t0 = test_now_ns();
+  for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+    for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) crypto_hash_sha512(d512, votes[i], 2 + 4 * 32);
+  }
+  const double sha512_ns = (double)(test_now_ns() - t0) / total;
+
+  printf("%-6s  sha256 vote %.0f ns, sha256_multi vote %.0f ns (%s), sha512 130B %.0f ns (%s)\n", name, single_ns,
+         multi_ns, sha_el_impl_name(sha256EL_get_multi_impl()), sha512_ns, sha_el_impl_name(sha512EL_get_impl()));
+}
+
+int main(void) {
+  static const sha_el_impl_t impls[] = {SHA_EL_IMPL_SCALAR, SHA_EL_IMPL_SHANI, SHA_EL_IMPL_AVX2};
+
+  unsigned char* million_a = malloc(SHA_KAT_MILLION);
+  if (!million_a) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  memset(million_a, 'a', SHA_KAT_MILLION);
+  for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+    if (getrandom(votes[i], sizeof(votes[i]), 0) != (ssize_t)sizeof(votes[i])) {
+      fprintf(stderr, "could not create test data\n");
+      free(million_a);
+      return 1;
+    }
+    msgs[i] = votes[i];
+    lens[i] = sizeof(votes[i]);
+  }
+
+  sha256EL_set_impl(SHA_EL_IMPL_SCALAR);
+  sha512EL_set_impl(SHA_EL_IMPL_SCALAR);
+  for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+    sha256EL(msgs[i], lens[i], portable256[i]);
+    crypto_hash_sha512(portable512[i], votes[i], sizeof(votes[i]));
+  }
+
+  for (size_t m = 0; m < sizeof(impls) / sizeof(impls[0]); m++) {
+    const char* name = sha_el_impl_name(impls[m]);
+    if (!sha256EL_set_impl(impls[m])) {
+      printf("%-6s  not supported by this CPU\n", name);
+      continue;
+    }
+    if (sha512EL_set_impl(impls[m]) != 1) sha512EL_set_impl(SHA_EL_IMPL_SCALAR);
+
+    const int failures_before = test_failures;
+    check_known_answers(name, million_a);
+    check_against_portable(name);
+    if (test_failures != failures_before) continue;
+    time_backend(name);
+  }
+
+  sha256EL_set_impl(SHA_EL_IMPL_AUTO);
+  sha512EL_set_impl(SHA_EL_IMPL_AUTO);
+  printf("selected sha256 %s, sha256_multi %s, sha512 %s\n", sha_el_impl_name(sha256EL_get_impl()),
+         sha_el_impl_name(sha256EL_get_multi_impl()), sha_el_impl_name(sha512EL_get_impl()));
+  free(million_a);
+  return test_failures ? 1 : 0;
+}
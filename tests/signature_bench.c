@@ -0,0 +1,57 @@
+#include "test_common.h"
+
+#include "signature_functions.h"
+#include "signature_signer.h"
+
+/*
+ * Throughput of the in-process wallet signature verifier.
+ *
+ * Runs the known-answer test, signs a consensus-sized NODES_TO_NODES_VOTE_MAJORITY_RESULTS message with
+ * a throwaway wallet from tests/signature_signer.h, checks that xcash_verify_signature accepts it and
+ * rejects a tampered copy, then times BENCH_ITERATIONS verifications. Every one of them must pass.
+ */
+
+#define BENCH_ITERATIONS 20000
+
+int main(void) {
+  signature_test_wallet_t wallet;
+  char signature[XCASH_SIGN_DATA_LENGTH + 1] = {0};
+  char message[SMALL_BUFFER_SIZE] = {0};
+
+  if (signature_known_answer_test() != 1) {
+    fprintf(stderr, "signature known-answer test failed\n");
+    return 1;
+  }
+  printf("known-answer test passed\n");
+
+  if (!signature_test_wallet_create(&wallet)) {
+    fprintf(stderr, "could not create a test wallet from the seed address\n");
+    return 1;
+  }
+  snprintf(message, sizeof(message),
+           "{\"message_settings\":\"NODES_TO_NODES_VOTE_MAJORITY_RESULTS\",\"public_address\":\"%s\","
+           "\"v_previous_block_hash\":\"%064d\",\"v_current_round_part\":\"2\",\"v_random_data\":\"%0100d\"}",
+           wallet.address, 0, 0);
+  const size_t message_len = strlen(message);
+  signature_test_wallet_sign(&wallet, message, message_len, signature);
+
+  CHECK(xcash_verify_signature(message, message_len, wallet.address, signature) == XCASH_OK,
+        "a valid signature was rejected");
+  message[message_len - 2] ^= 1;
+  CHECK(xcash_verify_signature(message, message_len, wallet.address, signature) != XCASH_OK,
+        "a tampered message was accepted");
+  message[message_len - 2] ^= 1;
+  if (test_failures) return 1;
+
+  size_t ok = 0;
+  const uint64_t t0 = test_now_ns();
+  for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+    ok += (xcash_verify_signature(message, message_len, wallet.address, signature) == XCASH_OK);
+  }
+  const double sec = (double)(test_now_ns() - t0) / 1e9;
+
+  printf("%zu/%d valid, %.3f s, %.0f verifications/s, %.1f us each\n", ok, BENCH_ITERATIONS, sec,
+         sec > 0 ? BENCH_ITERATIONS / sec : 0.0, sec * 1e6 / BENCH_ITERATIONS);
+  CHECK(ok == BENCH_ITERATIONS, "%zu of %d verifications failed", BENCH_ITERATIONS - ok, BENCH_ITERATIONS);
+  return test_failures ? 1 : 0;
+}
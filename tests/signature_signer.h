@@ -0,0 +1,169 @@
+#ifndef SIGNATURE_SIGNER_H_   /* Include guard */
+#define SIGNATURE_SIGNER_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "globals.h"
+#include "ed25519_ref10.h"
+#include "signature_functions.h"
+#include "string_functions.h"
+
+/*
+ * Throwaway wallets that sign the way the wallet's sign RPC does (SigV2 over the spend key), so tests
+ * and benchmarks can produce signatures for xcash_verify_signature without a wallet. Production code
+ * only verifies; the signer lives here. The SigV2 hash and the base58 block encoding are written out
+ * again rather than taken from signature_functions.c, so a signature made here checks the verifier
+ * against a second implementation. Include it from one file per test program.
+ */
+
+#define SIGNER_ADDRESS_CHECKSUM_SIZE 4
+#define SIGNER_ADDRESS_MAX_BYTES 80
+
+typedef struct {
+  uint8_t spend_pub[XCASH_KEY_LENGTH];
+  uint8_t spend_sec[XCASH_KEY_LENGTH];
+  uint8_t view_pub[XCASH_KEY_LENGTH];
+  uint8_t view_sec[XCASH_KEY_LENGTH];
+  char address[XCASH_WALLET_LENGTH + 1];
+} signature_test_wallet_t;
+
+static const char signer_b58_alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+static const size_t signer_b58_block_sizes[] = {0, 2, 3, 5, 6, 7, 9, 10, 11};
+
+// CryptoNote block base58: every 8 bytes become 11 characters, a shorter last block fewer
+static void signer_b58_encode(const uint8_t* in, size_t in_len, char* out) {
+  for (size_t off = 0; off < in_len; off += 8) {
+    size_t n = in_len - off < 8 ? in_len - off : 8;
+    uint64_t num = 0;
+    for (size_t i = 0; i < n; i++) num = (num << 8) | in[off + i];
+    for (size_t i = signer_b58_block_sizes[n]; i-- > 0;) {
+      out[i] = signer_b58_alphabet[num % 58];
+      num /= 58;
+    }
+    out += signer_b58_block_sizes[n];
+  }
+  *out = '\0';
+}
+
+// Decodes full 11 character blocks and a shorter last one; returns the byte count or 0
+static size_t signer_b58_decode(const char* in, uint8_t* out, size_t out_max) {
+  size_t len = strlen(in), total = 0;
+  for (size_t off = 0; off < len; off += 11) {
+    size_t enc = len - off < 11 ? len - off : 11, n = 0;
+    while (n <= 8 && signer_b58_block_sizes[n] != enc) n++;
+    if (n > 8 || total + n > out_max) return 0;
+    unsigned __int128 num = 0;
+    for (size_t i = 0; i < enc; i++) {
+      const char* p = strchr(signer_b58_alphabet, in[off + i]);
+      if (!p || in[off + i] == '\0') return 0;
+      num = num * 58 + (unsigned)(p - signer_b58_alphabet);
+    }
+    for (size_t i = n; i-- > 0;) {
+      out[total + i] = (uint8_t)num;
+      num >>= 8;
+    }
+    total += n;
+  }
+  return total;
+}
+
+static void signer_random_keypair(uint8_t pub[32], uint8_t sec[32]) {
+  uint8_t wide[64];
+  ge25519_p3 P;
+  get_random_bytes(wide, sizeof(wide));
+  sc25519_reduce(wide);
+  memcpy(sec, wide, 32);
+  ge25519_scalarmult_base(&P, sec);
+  ge25519_p3_tobytes(pub, &P);
+}
+
+// SigV2 message hash with the spend key: H(domain || spend_pub || view_pub || 0 || varint(len) || data)
+static void signer_message_hash(const signature_test_wallet_t* wallet, const char* data, size_t data_len,
+                                uint8_t out32[32]) {
+  const size_t head = sizeof(XCASH_MESSAGE_SIGNING_DOMAIN) + 2 * XCASH_KEY_LENGTH + 1;
+  uint8_t* buf = malloc(head + 10 + data_len);
+  if (!buf) abort();
+  memcpy(buf, XCASH_MESSAGE_SIGNING_DOMAIN, sizeof(XCASH_MESSAGE_SIGNING_DOMAIN));
+  memcpy(buf + sizeof(XCASH_MESSAGE_SIGNING_DOMAIN), wallet->spend_pub, XCASH_KEY_LENGTH);
+  memcpy(buf + sizeof(XCASH_MESSAGE_SIGNING_DOMAIN) + XCASH_KEY_LENGTH, wallet->view_pub, XCASH_KEY_LENGTH);
+  buf[head - 1] = 0;  // key mode: spend
+  size_t len = head;
+  size_t v = data_len;
+  do {
+    buf[len++] = (uint8_t)((v & 0x7f) | (v > 0x7f ? 0x80 : 0));
+    v >>= 7;
+  } while (v);
+  memcpy(buf + len, data, data_len);
+  keccak_256(buf, len + data_len, out32);
+  free(buf);
+}
+
+// CryptoNote generate_signature: c = H(hash || pub || k*G), r = k - c*sec
+static void signer_generate(const uint8_t hash[32], const uint8_t pub[32], const uint8_t sec[32],
+                            uint8_t sig[SIGNATURE_BIN_LEN]) {
+  /* l - 1, so that sec * (l - 1) = -sec */
+  static const uint8_t l_minus_one[32] = {
+    0xec, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+  };
+  static const uint8_t zero[32] = {0};
+  uint8_t k[64], neg_sec[32], buf[96], wide[64] = {0};
+  ge25519_p3 K;
+
+  get_random_bytes(k, sizeof(k));
+  sc25519_reduce(k);
+  ge25519_scalarmult_base(&K, k);
+  memcpy(buf, hash, 32);
+  memcpy(buf + 32, pub, 32);
+  ge25519_p3_tobytes(buf + 64, &K);
+  keccak_256(buf, sizeof(buf), wide);
+  sc25519_reduce(wide);
+  memcpy(sig, wide, 32);
+
+  sc25519_muladd(neg_sec, sec, l_minus_one, zero);
+  sc25519_muladd(sig + 32, sig, neg_sec, k);
+}
+
+// Random keys and an address with the network tag of the first seed node; false if that address is unusable
+static bool signature_test_wallet_create(signature_test_wallet_t* wallet) {
+  uint8_t raw[SIGNER_ADDRESS_MAX_BYTES], hash[32];
+  char address[XCASH_WALLET_LENGTH * 2] = {0};
+
+  memset(wallet, 0, sizeof(*wallet));
+  signer_random_keypair(wallet->spend_pub, wallet->spend_sec);
+  signer_random_keypair(wallet->view_pub, wallet->view_sec);
+
+  size_t n = signer_b58_decode(network_nodes[0].seed_public_address, raw, sizeof(raw));
+  size_t tag_len = 0;
+  while (tag_len < n && (raw[tag_len] & 0x80)) tag_len++;
+  tag_len++;
+  if (n == 0 || tag_len + 2 * XCASH_KEY_LENGTH + SIGNER_ADDRESS_CHECKSUM_SIZE != n) return false;
+
+  memcpy(raw + tag_len, wallet->spend_pub, XCASH_KEY_LENGTH);
+  memcpy(raw + tag_len + XCASH_KEY_LENGTH, wallet->view_pub, XCASH_KEY_LENGTH);
+  keccak_256(raw, tag_len + 2 * XCASH_KEY_LENGTH, hash);
+  memcpy(raw + tag_len + 2 * XCASH_KEY_LENGTH, hash, SIGNER_ADDRESS_CHECKSUM_SIZE);
+  signer_b58_encode(raw, n, address);
+  if (strlen(address) != XCASH_WALLET_LENGTH) return false;
+  memcpy(wallet->address, address, XCASH_WALLET_LENGTH + 1);
+  return true;
+}
+
+// Signs data with the wallet's spend key as a SigV2 signature
+static void signature_test_wallet_sign(const signature_test_wallet_t* wallet, const char* data, size_t data_len,
+                                       char signature[XCASH_SIGN_DATA_LENGTH + 1]) {
+  uint8_t hash[32], sig[SIGNATURE_BIN_LEN];
+  _Static_assert(sizeof(XCASH_SIGN_DATA_PREFIX) - 1 + SIGNATURE_BIN_LEN / 8 * 11 == XCASH_SIGN_DATA_LENGTH,
+                 "a SigV2 signature is the prefix and 8 full base58 blocks");
+
+  signer_message_hash(wallet, data, data_len, hash);
+  signer_generate(hash, wallet->spend_pub, wallet->spend_sec, sig);
+  memcpy(signature, XCASH_SIGN_DATA_PREFIX, sizeof(XCASH_SIGN_DATA_PREFIX) - 1);
+  signer_b58_encode(sig, sizeof(sig), signature + sizeof(XCASH_SIGN_DATA_PREFIX) - 1);
+}
+
+#endif
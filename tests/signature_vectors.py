@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Independent reference for the X-Cash wallet signer; prints known-answer vectors."""
+import sys
+
+# Keccak-256, original 0x01 padding
+RC = [0x0000000000000001, 0x0000000000008082, 0x800000000000808A, 0x8000000080008000, 0x000000000000808B,
+      0x0000000080000001, 0x8000000080008081, 0x8000000000008009, 0x000000000000008A, 0x0000000000000088,
+      0x0000000080008009, 0x000000008000000A, 0x000000008000808B, 0x800000000000008B, 0x8000000000008089,
+      0x8000000000008003, 0x8000000000008002, 0x8000000000000080, 0x000000000000800A, 0x800000008000000A,
+      0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008]
+ROT = [[0, 36, 3, 41, 18], [1, 44, 10, 45, 2], [62, 6, 43, 15, 61], [28, 55, 25, 21, 56], [27, 20, 39, 8, 14]]
+M64 = (1 << 64) - 1
+def rol(v, n): return ((v << n) | (v >> (64 - n))) & M64 if n else v
+def keccak_f(A):
+    for rc in RC:
+        C = [A[x][0] ^ A[x][1] ^ A[x][2] ^ A[x][3] ^ A[x][4] for x in range(5)]
+        D = [C[(x - 1) % 5] ^ rol(C[(x + 1) % 5], 1) for x in range(5)]
+        A = [[A[x][y] ^ D[x] for y in range(5)] for x in range(5)]
+        B = [[0] * 5 for _ in range(5)]
+        for x in range(5):
+            for y in range(5):
+                B[y][(2 * x + 3 * y) % 5] = rol(A[x][y], ROT[x][y])
+        A = [[B[x][y] ^ ((~B[(x + 1) % 5][y]) & B[(x + 2) % 5][y]) for y in range(5)] for x in range(5)]
+        A[0][0] ^= rc
+    return A
+def keccak256(data):
+    rate = 136
+    m = bytearray(data) + b"\x01" + b"\x00" * ((-len(data) - 1) % rate)
+    m[-1] |= 0x80
+    A = [[0] * 5 for _ in range(5)]
+    for off in range(0, len(m), rate):
+        for i in range(rate // 8):
+            A[i % 5][i // 5] ^= int.from_bytes(m[off + 8 * i:off + 8 * i + 8], "little")
+        A = keccak_f(A)
+    return b"".join(A[i % 5][i // 5].to_bytes(8, "little") for i in range(4))
+
+# ed25519
+p = 2**255 - 19
+L = 2**252 + 27742317777372353535851937790883648493
+d = -121665 * pow(121666, p - 2, p) % p
+I = pow(2, (p - 1) // 4, p)
+def inv(x): return pow(x, p - 2, p)
+def xrecover(y):
+    xx = (y * y - 1) * inv(d * y * y + 1)
+    x = pow(xx, (p + 3) // 8, p)
+    if (x * x - xx) % p: x = x * I % p
+    if (x * x - xx) % p: return None
+    return x
+By = 4 * inv(5) % p
+G = (xrecover(By) if xrecover(By) % 2 == 0 else p - xrecover(By), By)
+def add(P, Q):
+    (x1, y1), (x2, y2) = P, Q
+    t = d * x1 * x2 * y1 * y2
+    return ((x1 * y2 + x2 * y1) * inv(1 + t) % p, (y1 * y2 + x1 * x2) * inv(1 - t) % p)
+def mul(k, P):
+    R = (0, 1)
+    while k:
+        if k & 1: R = add(R, P)
+        P = add(P, P); k >>= 1
+    return R
+def enc(P): return (P[1] | ((P[0] & 1) << 255)).to_bytes(32, "little")
+def dec(s):
+    """Monero ge_frombytes_vartime: rejects y >= p and x = 0 with the sign bit set"""
+    v = int.from_bytes(s, "little"); y = v & ((1 << 255) - 1); sign = v >> 255
+    if y >= p: return None
+    x = xrecover(y)
+    if x is None: return None
+    if x == 0 and sign: return None
+    if (x & 1) != sign: x = p - x
+    return (x, y)
+def hs(b): return int.from_bytes(keccak256(b), "little") % L
+
+# CryptoNote base58
+ALPHA = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"
+ENC_SIZES = [0, 2, 3, 5, 6, 7, 9, 10, 11]
+def b58enc(b):
+    out = ""
+    for off in range(0, len(b), 8):
+        blk = b[off:off + 8]; n = int.from_bytes(blk, "big"); s = ""
+        for _ in range(ENC_SIZES[len(blk)]): s = ALPHA[n % 58] + s; n //= 58
+        out += s
+    return out
+def b58dec(s):
+    out = b""
+    for off in range(0, len(s), 11):
+        blk = s[off:off + 11]; n = 0
+        for c in blk: n = n * 58 + ALPHA.index(c)
+        out += n.to_bytes(ENC_SIZES.index(len(blk)), "big")
+    return out
+
+def check_signature(h, pub, sig):
+    c = int.from_bytes(sig[:32], "little"); r = int.from_bytes(sig[32:], "little")
+    A = dec(pub)
+    if A is None or c >= L or r >= L or c == 0: return False
+    R = add(mul(c, A), mul(r, G))
+    if enc(R) == enc((0, 1)): return False
+    return hs(h + pub + enc(R)) == c
+def generate_signature(h, pub, sec, k):
+    c = hs(h + pub + enc(mul(k, G)))
+    return c.to_bytes(32, "little") + ((k - c * sec) % L).to_bytes(32, "little")
+def varint(n):
+    out = b""
+    while True:
+        out += bytes([(n & 0x7f) | (0x80 if n > 0x7f else 0)])
+        if n <= 0x7f: return out
+        n >>= 7
+def message_hash_v2(data, spend, view, mode):
+    return keccak256(b"MoneroMessageSignature\x00" + spend + view + bytes([mode]) + varint(len(data)) + data)
+
+def main():
+    seeds = ["XCK1gUSXCuV4KANQz78YYFQuxeGzPwUtzToqnNGXwjFgjULzWQiYbdC9iJRPiLDqn1ijo9HpfXsDzSRjgKZAwK7x2fTAQZBLXF"]
+    raw = b58dec(seeds[0])
+    assert keccak256(raw[:-4])[:4] == raw[-4:]
+    tag = raw[:len(raw) - 68]
+    print("seed", seeds[0]); print("seed_spend", raw[len(tag):len(tag) + 32].hex()); print("seed_view", raw[len(tag) + 32:len(tag) + 64].hex())
+
+    spend_sec = hs(b"xcash-dpops signature vector spend key")
+    view_sec = hs(b"xcash-dpops signature vector view key")
+    spend = enc(mul(spend_sec, G)); view = enc(mul(view_sec, G))
+    body = tag + spend + view
+    addr = b58enc(body + keccak256(body)[:4])
+    assert len(addr) == 98
+    print("address", addr); print("spend", spend.hex()); print("view", view.hex())
+    msg = b'{"message_settings":"NODES_TO_NODES_VOTE_MAJORITY_RESULTS","v_current_round_part":"2"}'
+    print("message", msg.decode())
+    k1 = hs(b"nonce v2 spend"); k2 = hs(b"nonce v2 view"); k3 = hs(b"nonce v1")
+    s2 = generate_signature(message_hash_v2(msg, spend, view, 0), spend, spend_sec, k1)
+    s2v = generate_signature(message_hash_v2(msg, spend, view, 1), view, view_sec, k2)
+    s1 = generate_signature(keccak256(msg), spend, spend_sec, k3)
+    for name, s in (("sigv2_spend", "SigV2" + b58enc(s2)), ("sigv2_view", "SigV2" + b58enc(s2v)), ("sigv1", "SigV1" + b58enc(s1))):
+        print(name, s)
+    assert check_signature(message_hash_v2(msg, spend, view, 0), spend, s2)
+    assert check_signature(message_hash_v2(msg, spend, view, 1), view, s2v)
+    assert check_signature(keccak256(msg), spend, s1)
+    assert not check_signature(keccak256(msg), spend, s2)
+    # x = 0 with the sign bit: the identity encoded with the sign bit set is rejected by the wallet decoder
+    assert dec(bytes([1] + [0] * 30 + [0x80])) is None
+    assert dec((p + 1).to_bytes(32, "little")) is None
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,81 @@
+#ifndef TEST_COMMON_H_   /* Include guard */
+#define TEST_COMMON_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Shared helpers for the programs under tests/. A test counts failed checks and exits non zero if
+ * there were any; a benchmark prints its measurements and only fails when its own sanity checks do.
+ */
+
+#define TEST_DATA_DIR "tests/data"
+
+static int test_failures __attribute__((unused)) = 0;
+
+#define CHECK(cond, ...)                                                  \
+  do {                                                                    \
+    if (!(cond)) {                                                        \
+      test_failures++;                                                    \
+      fprintf(stderr, "FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);     \
+      fprintf(stderr, __VA_ARGS__);                                       \
+      fputc('\n', stderr);                                                \
+    }                                                                     \
+  } while (0)
+
+#define TEST_DONE(name)                                                   \
+  do {                                                                    \
+    if (test_failures) {                                                  \
+      fprintf(stderr, "%s: %d check(s) failed\n", name, test_failures);   \
+      return 1;                                                           \
+    }                                                                     \
+    printf("%s: passed\n", name);                                         \
+    return 0;                                                             \
+  } while (0)
+
+static inline uint64_t test_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Reads TEST_DATA_DIR/name into a NUL terminated heap buffer; exits when the fixture is missing
+static inline char* test_read_fixture(const char* name, size_t* len_out) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", TEST_DATA_DIR, name);
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "missing fixture %s (run from the repository root)\n", path);
+    exit(2);
+  }
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char* buf = malloc((size_t)n + 1);
+  if (!buf || fread(buf, 1, (size_t)n, f) != (size_t)n) {
+    fprintf(stderr, "could not read fixture %s\n", path);
+    exit(2);
+  }
+  fclose(f);
+  buf[n] = '\0';
+  if (len_out) *len_out = (size_t)n;
+  return buf;
+}
+
+static inline int test_u64_cmp(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Sorts v in place and returns the p-th percentile (0..100); 0 for an empty set
+static inline uint64_t test_percentile(uint64_t* v, size_t n, double p) {
+  if (n == 0) return 0;
+  qsort(v, n, sizeof(*v), test_u64_cmp);
+  size_t i = (size_t)(p / 100.0 * (double)(n - 1) + 0.5);
+  return v[i < n ? i : n - 1];
+}
+
+#endif
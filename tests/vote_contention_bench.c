@@ -0,0 +1,268 @@
+#include "test_common.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "block_verifiers_server_functions.h"
+#include "signature_functions.h"
+#include "signature_signer.h"
+#include "xcash_message.h"
+
+/*
+ * current_block_verifiers_lock contention while simultaneous NODES_TO_NODES_VOTE_MAJORITY_RESULTS
+ * messages are handled.
+ *
+ * Every voter thread hands one signed vote to server_receive_data_socket_node_to_node_vote_majority,
+ * which checks the signature with no lock held. The reference is the former handler body: take the
+ * lock, check the signature against the shared list, record the vote, unlock. Meanwhile a reader
+ * thread stands in for process_round() and block_verifiers_create_vote_majority_result(): it takes
+ * and releases the lock every BENCH_READER_GAP_US and records how long each acquisition waited.
+ *
+ * Votes are signed with throwaway wallets (signature_test_wallet_*) over the hash the handler
+ * rebuilds. Every round uses a new block height so no signature is served from the signature cache.
+ * All votes of every round must be counted.
+ */
+
+#define BENCH_ROUNDS 50
+#define BENCH_READER_GAP_US 50
+#define BENCH_HEIGHT_BASE 3000000
+
+static const size_t bench_voter_counts[] = {14, BLOCK_VERIFIERS_AMOUNT};
+
+typedef struct {
+  signature_test_wallet_t wallet;
+  char vrf_public_key[VRF_PUBLIC_KEY_LENGTH + 1];
+  char vote_signature[XCASH_SIGN_DATA_LENGTH + 1];
+  char* message;
+  xcash_msg_env_t env;
+} bench_voter_t;
+
+static bench_voter_t voters[BLOCK_VERIFIERS_AMOUNT];
+static char producer_proof[VRF_PROOF_LENGTH + 1];
+static char producer_beta[VRF_BETA_LENGTH + 1];
+
+static pthread_barrier_t start_barrier;
+static atomic_bool reader_stop;
+static uint64_t* reader_waits;
+static size_t reader_wait_count;
+static size_t reader_wait_capacity;
+
+static void random_hex(char* out, size_t bytes) {
+  unsigned char buf[128];
+  get_random_bytes(buf, bytes);
+  for (size_t i = 0; i < bytes; i++) snprintf(out + i * 2, 3, "%02x", buf[i]);
+}
+
+static int key_cmp(const void* a, const void* b) {
+  return memcmp(a, b, crypto_vrf_PUBLICKEYBYTES);
+}
+
+// The data verify_vrf_vote_signature checks: height || beta || producer key || hash of the sorted round keys
+static void vote_hash_hex(size_t voter_count, char hash_hex[(SHA256_EL_HASH_SIZE * 2) + 1]) {
+  uint8_t pks[BLOCK_VERIFIERS_AMOUNT][crypto_vrf_PUBLICKEYBYTES];
+  for (size_t i = 0; i < voter_count; i++) {
+    hex_to_byte_array(voters[i].vrf_public_key, pks[i], crypto_vrf_PUBLICKEYBYTES);
+  }
+  qsort(pks, voter_count, crypto_vrf_PUBLICKEYBYTES, key_cmp);
+
+  uint8_t buf[5 + 16 + 8 + BLOCK_VERIFIERS_AMOUNT * crypto_vrf_PUBLICKEYBYTES];
+  size_t off = 0;
+  memcpy(buf + off, "PKSET", 5);
+  off += 5;
+  size_t hlen = strlen(current_block_height);
+  buf[off++] = (uint8_t)hlen;
+  memcpy(buf + off, current_block_height, hlen);
+  off += hlen;
+  buf[off++] = (uint8_t)voter_count;
+  memcpy(buf + off, pks, voter_count * crypto_vrf_PUBLICKEYBYTES);
+  off += voter_count * crypto_vrf_PUBLICKEYBYTES;
+  uint8_t round_hash[SHA256_EL_HASH_SIZE];
+  sha256EL(buf, off, round_hash);
+
+  uint8_t input[160];
+  off = 0;
+  memcpy(input + off, current_block_height, hlen);
+  off += hlen;
+  hex_to_byte_array(producer_beta, input + off, crypto_vrf_OUTPUTBYTES);
+  off += crypto_vrf_OUTPUTBYTES;
+  hex_to_byte_array(voters[0].vrf_public_key, input + off, crypto_vrf_PUBLICKEYBYTES);
+  off += crypto_vrf_PUBLICKEYBYTES;
+  memcpy(input + off, round_hash, sizeof(round_hash));
+  off += sizeof(round_hash);
+
+  uint8_t hash[SHA256_EL_HASH_SIZE];
+  sha256EL(input, off, hash);
+  for (size_t i = 0; i < SHA256_EL_HASH_SIZE; i++) snprintf(hash_hex + i * 2, 3, "%02x", hash[i]);
+}
+
+// Fills the verifier list for a new round and gives every voter a signed vote for voter 0
+static bool prepare_round(size_t voter_count, unsigned height) {
+  char hash_hex[(SHA256_EL_HASH_SIZE * 2) + 1];
+
+  pthread_mutex_lock(&current_block_verifiers_lock);
+  memset(&current_block_verifiers_list, 0, sizeof(current_block_verifiers_list));
+  for (size_t i = 0; i < voter_count; i++) {
+    memcpy(current_block_verifiers_list.block_verifiers_public_address[i], voters[i].wallet.address, XCASH_WALLET_LENGTH + 1);
+    memcpy(current_block_verifiers_list.block_verifiers_public_key[i], voters[i].vrf_public_key, VRF_PUBLIC_KEY_LENGTH + 1);
+  }
+  memcpy(current_block_verifiers_list.block_verifiers_vrf_proof_hex[0], producer_proof, sizeof(producer_proof));
+  memcpy(current_block_verifiers_list.block_verifiers_vrf_beta_hex[0], producer_beta, sizeof(producer_beta));
+  current_block_verifiers_generation++;
+  snprintf(current_block_height, sizeof(current_block_height), "%u", height);
+  pthread_mutex_unlock(&current_block_verifiers_lock);
+
+  vote_hash_hex(voter_count, hash_hex);
+  for (size_t i = 0; i < voter_count; i++) {
+    bench_voter_t* v = &voters[i];
+    signature_test_wallet_sign(&v->wallet, hash_hex, strlen(hash_hex), v->vote_signature);
+
+    free(v->message);
+    v->message = malloc(SMALL_BUFFER_SIZE);
+    snprintf(v->message, SMALL_BUFFER_SIZE,
+             "{\r\n \"message_settings\": \"NODES_TO_NODES_VOTE_MAJORITY_RESULTS\",\r\n \"public_address\": \"%s\","
+             "\r\n \"proposed_producer\": \"%s\",\r\n \"block_height\": \"%s\",\r\n \"vrf_beta\": \"%s\","
+             "\r\n \"vrf_proof\": \"%s\",\r\n \"vrf_public_key\": \"%s\",\r\n \"vote_signature\": \"%s\"\r\n}",
+             v->wallet.address, voters[0].wallet.address, current_block_height, producer_beta, producer_proof,
+             voters[0].vrf_public_key, v->vote_signature);
+    if (!xcash_msg_env_parse(&v->env, v->message)) return false;
+  }
+  return true;
+}
+
+// The handler before the change: the signature is checked with current_block_verifiers_lock held
+static void reference_vote(const bench_voter_t* v) {
+  pthread_mutex_lock(&current_block_verifiers_lock);
+  for (size_t i = 0; i < BLOCK_VERIFIERS_AMOUNT; i++) {
+    if (strcmp(v->wallet.address, current_block_verifiers_list.block_verifiers_public_address[i]) != 0) continue;
+    if (!verify_vrf_vote_signature(current_block_height, producer_beta, voters[0].vrf_public_key, v->wallet.address,
+                                   v->vote_signature, (const char (*)[VRF_PUBLIC_KEY_LENGTH + 1])current_block_verifiers_list.block_verifiers_public_key,
+                                   BLOCK_VERIFIERS_AMOUNT) ||
+        current_block_verifiers_list.block_verifiers_voted[i] != 0) {
+      break;
+    }
+    current_block_verifiers_list.block_verifiers_voted[i] = 1;
+    memcpy(current_block_verifiers_list.block_verifiers_vote_signature[i], v->vote_signature, XCASH_SIGN_DATA_LENGTH + 1);
+    memcpy(current_block_verifiers_list.block_verifiers_selected_public_address[i], voters[0].wallet.address, XCASH_WALLET_LENGTH + 1);
+    current_block_verifiers_list.block_verifiers_vote_total[0] += 1;
+    break;
+  }
+  pthread_mutex_unlock(&current_block_verifiers_lock);
+}
+
+typedef struct {
+  size_t index;
+  bool reference;
+} voter_arg_t;
+
+static void* voter_thread(void* arg) {
+  const voter_arg_t* a = (const voter_arg_t*)arg;
+  pthread_barrier_wait(&start_barrier);
+  if (a->reference) {
+    reference_vote(&voters[a->index]);
+  } else {
+    server_receive_data_socket_node_to_node_vote_majority(&voters[a->index].env);
+  }
+  return NULL;
+}
+
+static void* reader_thread(void* arg) {
+  (void)arg;
+  pthread_barrier_wait(&start_barrier);
+  while (!atomic_load(&reader_stop)) {
+    uint64_t t0 = test_now_ns();
+    pthread_mutex_lock(&current_block_verifiers_lock);
+    uint64_t waited = test_now_ns() - t0;
+    pthread_mutex_unlock(&current_block_verifiers_lock);
+    if (reader_wait_count < reader_wait_capacity) reader_waits[reader_wait_count++] = waited;
+    struct timespec gap = {0, BENCH_READER_GAP_US * 1000L};
+    nanosleep(&gap, NULL);
+  }
+  return NULL;
+}
+
+static void run(size_t voter_count, bool reference) {
+  uint64_t* round_ns = calloc(BENCH_ROUNDS, sizeof(uint64_t));
+  reader_wait_capacity = 1 << 20;
+  reader_wait_count = 0;
+  reader_waits = calloc(reader_wait_capacity, sizeof(uint64_t));
+  size_t counted = 0;
+
+  for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+    // a height per mode, voter count and round keeps every signature out of the cache
+    unsigned height = BENCH_HEIGHT_BASE + (reference ? 100000u : 0u) + (unsigned)voter_count * 1000u + r;
+    if (!prepare_round(voter_count, height)) {
+      CHECK(0, "could not build the vote messages");
+      break;
+    }
+
+    pthread_t threads[BLOCK_VERIFIERS_AMOUNT];
+    voter_arg_t args[BLOCK_VERIFIERS_AMOUNT];
+    pthread_t reader;
+    pthread_barrier_init(&start_barrier, NULL, (unsigned)voter_count + 2);
+    atomic_store(&reader_stop, false);
+    pthread_create(&reader, NULL, reader_thread, NULL);
+    for (size_t i = 0; i < voter_count; i++) {
+      args[i] = (voter_arg_t){i, reference};
+      pthread_create(&threads[i], NULL, voter_thread, &args[i]);
+    }
+    // every other thread is already waiting, so the votes start as this wait returns
+    uint64_t t0 = test_now_ns();
+    pthread_barrier_wait(&start_barrier);
+    for (size_t i = 0; i < voter_count; i++) pthread_join(threads[i], NULL);
+    round_ns[r] = test_now_ns() - t0;
+    atomic_store(&reader_stop, true);
+    pthread_join(reader, NULL);
+    pthread_barrier_destroy(&start_barrier);
+
+    pthread_mutex_lock(&current_block_verifiers_lock);
+    int total = current_block_verifiers_list.block_verifiers_vote_total[0];
+    size_t voted = 0;
+    for (size_t i = 0; i < voter_count; i++) voted += current_block_verifiers_list.block_verifiers_voted[i] != 0;
+    pthread_mutex_unlock(&current_block_verifiers_lock);
+    CHECK(total == (int)voter_count && voted == voter_count, "%s, %zu voters, round %u: %d of %zu votes counted",
+          reference ? "reference" : "handler", voter_count, r, total, voter_count);
+    counted += (size_t)total;
+
+    for (size_t i = 0; i < voter_count; i++) {
+      cJSON_Delete(voters[i].env.root);
+      voters[i].env.root = NULL;
+    }
+  }
+
+  uint64_t round_p50 = test_percentile(round_ns, BENCH_ROUNDS, 50);
+  size_t samples = reader_wait_count;
+  uint64_t wait_p50 = test_percentile(reader_waits, samples, 50);
+  uint64_t wait_p99 = test_percentile(reader_waits, samples, 99);
+  uint64_t wait_max = samples ? reader_waits[samples - 1] : 0;
+  printf("%-28s %2zu voters  votes %4zu/%-4zu  all votes p50 %7.2f ms  reader lock wait p50 %7.1f us  p99 %8.1f us"
+         "  max %8.1f us  (%zu samples)\n",
+         reference ? "lock held across check" : "check outside the lock", voter_count, counted,
+         voter_count * BENCH_ROUNDS, (double)round_p50 / 1e6, (double)wait_p50 / 1e3, (double)wait_p99 / 1e3,
+         (double)wait_max / 1e3, samples);
+
+  free(reader_waits);
+  free(round_ns);
+}
+
+int main(void) {
+  if (signature_known_answer_test() != 1) {
+    fprintf(stderr, "signature known-answer test failed\n");
+    return 1;
+  }
+  for (size_t i = 0; i < BLOCK_VERIFIERS_AMOUNT; i++) {
+    if (!signature_test_wallet_create(&voters[i].wallet)) {
+      fprintf(stderr, "could not create a test wallet\n");
+      return 1;
+    }
+    random_hex(voters[i].vrf_public_key, crypto_vrf_PUBLICKEYBYTES);
+  }
+  random_hex(producer_proof, VRF_PROOF_LENGTH / 2);
+  random_hex(producer_beta, crypto_vrf_OUTPUTBYTES);
+
+  for (size_t i = 0; i < sizeof(bench_voter_counts) / sizeof(bench_voter_counts[0]); i++) {
+    run(bench_voter_counts[i], true);
+    run(bench_voter_counts[i], false);
+  }
+
+  for (size_t i = 0; i < BLOCK_VERIFIERS_AMOUNT; i++) free(voters[i].message);
+  return test_failures ? 1 : 0;
+}
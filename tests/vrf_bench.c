@@ -0,0 +1,204 @@
+#include "test_common.h"
+
+#include "VRF_functions.h"
+
+/*
+ * VRF proving and verification throughput for one round of VRF_DATA.
+ *
+ * First the known-answer test: the draft-irtf-cfrg-vrf-03 example and VRF_KAT_VECTORS derived vectors
+ * through crypto_vrf_prove, crypto_vrf_proof_to_hash, crypto_vrf_verify and the batch verifier, so the
+ * fe_25_5 and fe_51 field backends can be shown to produce identical bytes. Then a round of
+ * BLOCK_VERIFIERS_TOTAL_AMOUNT proofs with throwaway keys, a few of them tampered with: the batch must
+ * reject exactly what crypto_vrf_verify rejects and return the same outputs for the rest. Last, proving,
+ * per-proof verification, the batch and the batch with the keys in the VRF key cache are timed over
+ * BENCH_ROUNDS rounds, and every timed verification must pass.
+ */
+
+#define BENCH_ROUNDS 20
+#define VRF_KAT_VECTORS 32
+
+#ifdef HAVE_TI_MODE
+#define VRF_FIELD_BACKEND "fe_51"
+#else
+#define VRF_FIELD_BACKEND "fe_25_5"
+#endif
+
+// draft-irtf-cfrg-vrf-03 ECVRF-ED25519-SHA512-Elligator2 example 1 (RFC 8032 test key, empty alpha)
+static const char VRF_KAT_SEED[] = "9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60";
+static const char VRF_KAT_PROOF[] = "b6b4699f87d56126c9117a7da55bd0085246f4c56dbc95d20172612e9d38e8d7"
+                                    "ca65e573a126ed88d4e30a46f80a666854d675cf3ba81de0de043c3774f06156"
+                                    "0f55edc256a787afe701677c0f602900";
+static const char VRF_KAT_BETA[] = "5b49b554d05c0cd5a5325376b3387de59d924fd1e13ded44648ab33c21349a60"
+                                   "3f25b84ec5ed887995b33da5e3bfcb87cd2f64521c4c62cf825cffabbe5d31cc";
+// first 32 bytes of SHA-512 over pk || proof || beta of the VRF_KAT_VECTORS derived vectors
+static const char VRF_KAT_DIGEST[] = "7e4fa188950048cc8182dbc9fca09c7a518d12d893e3d8affcf852752e0a317f";
+
+static bool vrf_kat_equal(const unsigned char* data, size_t len, const char* hex) {
+  char buf[2 * crypto_vrf_PROOFBYTES + 2 * crypto_vrf_OUTPUTBYTES + 1];
+  if (len * 2 >= sizeof(buf) || strlen(hex) != len * 2) return false;
+  for (size_t i = 0; i < len; i++) snprintf(buf + 2 * i, sizeof(buf) - 2 * i, "%02x", data[i]);
+  return strcmp(buf, hex) == 0;
+}
+
+static bool vrf_known_answer_test(void) {
+  unsigned char seed[crypto_vrf_SEEDBYTES];
+  unsigned char pk[crypto_vrf_PUBLICKEYBYTES];
+  unsigned char sk[crypto_vrf_SECRETKEYBYTES];
+  unsigned char proof[crypto_vrf_PROOFBYTES];
+  unsigned char beta[crypto_vrf_OUTPUTBYTES];
+  unsigned char output[crypto_vrf_OUTPUTBYTES];
+  unsigned char alpha[3 * VRF_KAT_VECTORS];
+  unsigned char digest[crypto_hash_sha512_BYTES];
+  crypto_hash_sha512_state st;
+  char hex_byte[3] = {0};
+
+  for (size_t i = 0; i < sizeof(seed); i++) {
+    memcpy(hex_byte, &VRF_KAT_SEED[2 * i], 2);
+    seed[i] = (unsigned char)strtol(hex_byte, NULL, 16);
+  }
+  crypto_vrf_keypair_from_seed(pk, sk, seed);
+  if (crypto_vrf_prove(proof, sk, alpha, 0) != 0 || !vrf_kat_equal(proof, sizeof(proof), VRF_KAT_PROOF) ||
+      crypto_vrf_proof_to_hash(beta, proof) != 0 || !vrf_kat_equal(beta, sizeof(beta), VRF_KAT_BETA) ||
+      crypto_vrf_verify(output, pk, proof, alpha, 0) != 0 || memcmp(output, beta, sizeof(beta)) != 0) {
+    return false;
+  }
+
+  crypto_hash_sha512_init(&st);
+  for (size_t i = 0; i < VRF_KAT_VECTORS; i++) {
+    const unsigned long long alpha_len = 3 * i;
+    for (size_t j = 0; j < sizeof(seed); j++) seed[j] = (unsigned char)(i * 31 + j * 7 + 1);
+    for (size_t j = 0; j < alpha_len; j++) alpha[j] = (unsigned char)(i ^ (j * 13));
+
+    crypto_vrf_keypair_from_seed(pk, sk, seed);
+    if (crypto_vrf_prove(proof, sk, alpha, alpha_len) != 0 || crypto_vrf_proof_to_hash(beta, proof) != 0 ||
+        crypto_vrf_verify(output, pk, proof, alpha, alpha_len) != 0 || memcmp(output, beta, sizeof(beta)) != 0) {
+      return false;
+    }
+
+    const unsigned char* msg = alpha;
+    int result = -1;
+    crypto_vrf_verify_batch(output, pk, proof, &msg, &alpha_len, 1, &result);
+    if (result != 0 || memcmp(output, beta, sizeof(beta)) != 0) return false;
+
+    // a flipped bit anywhere in the proof must be rejected by both verifiers
+    proof[(i * 5) % sizeof(proof)] ^= (unsigned char)(1U << (i % 8));
+    crypto_vrf_verify_batch(output, pk, proof, &msg, &alpha_len, 1, &result);
+    if (result == 0 || crypto_vrf_verify(output, pk, proof, alpha, alpha_len) == 0) return false;
+    proof[(i * 5) % sizeof(proof)] ^= (unsigned char)(1U << (i % 8));
+
+    crypto_hash_sha512_update(&st, pk, sizeof(pk));
+    crypto_hash_sha512_update(&st, proof, sizeof(proof));
+    crypto_hash_sha512_update(&st, beta, sizeof(beta));
+  }
+  crypto_hash_sha512_final(&st, digest);
+  return vrf_kat_equal(digest, 32, VRF_KAT_DIGEST);
+}
+
+static unsigned char pks[BLOCK_VERIFIERS_TOTAL_AMOUNT * crypto_vrf_PUBLICKEYBYTES];
+static unsigned char proofs[BLOCK_VERIFIERS_TOTAL_AMOUNT * crypto_vrf_PROOFBYTES];
+static unsigned char outputs[BLOCK_VERIFIERS_TOTAL_AMOUNT * crypto_vrf_OUTPUTBYTES];
+static unsigned char alpha[BLOCK_VERIFIERS_TOTAL_AMOUNT][72];
+static unsigned char sk[crypto_vrf_SECRETKEYBYTES];
+static const unsigned char* msgs[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+static unsigned long long msg_lens[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+static int results[BLOCK_VERIFIERS_TOTAL_AMOUNT];
+
+// One VRF_DATA style proof per verifier: alpha is 40 random bytes and the prover's public key
+static bool build_round(void) {
+  for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+    unsigned char* pk = pks + i * crypto_vrf_PUBLICKEYBYTES;
+    if (create_random_VRF_keys(pk, sk) != 1 || getrandom(alpha[i], 40, 0) != 40) return false;
+    memcpy(alpha[i] + 40, pk, crypto_vrf_PUBLICKEYBYTES);
+    if (crypto_vrf_prove(proofs + i * crypto_vrf_PROOFBYTES, sk, alpha[i], sizeof(alpha[i])) != 0) return false;
+    msgs[i] = alpha[i];
+    msg_lens[i] = sizeof(alpha[i]);
+  }
+  return true;
+}
+
+// With a few proofs and one message tampered with, the batch rejects exactly what crypto_vrf_verify rejects
+static void check_batch_matches_single(void) {
+  unsigned char beta[crypto_vrf_OUTPUTBYTES];
+  size_t rejected = 0;
+
+  proofs[5 * crypto_vrf_PROOFBYTES + 50] ^= 1;
+  proofs[17 * crypto_vrf_PROOFBYTES + 10] ^= 4;
+  alpha[40][3] ^= 1;
+  crypto_vrf_verify_batch(outputs, pks, proofs, msgs, msg_lens, BLOCK_VERIFIERS_TOTAL_AMOUNT, results);
+  for (size_t i = 0; i < BLOCK_VERIFIERS_TOTAL_AMOUNT; i++) {
+    int ref = crypto_vrf_verify(beta, pks + i * crypto_vrf_PUBLICKEYBYTES, proofs + i * crypto_vrf_PROOFBYTES,
+                                msgs[i], msg_lens[i]);
+    CHECK((ref == 0) == (results[i] == 0), "proof %zu: batch %d, single %d", i, results[i], ref);
+    CHECK(ref != 0 || memcmp(beta, outputs + i * crypto_vrf_OUTPUTBYTES, sizeof(beta)) == 0,
+          "proof %zu: batch output differs", i);
+    rejected += ref != 0;
+  }
+  CHECK(rejected == 3, "%zu tampered proofs rejected, expected 3", rejected);
+  proofs[5 * crypto_vrf_PROOFBYTES + 50] ^= 1;
+  proofs[17 * crypto_vrf_PROOFBYTES + 10] ^= 4;
+  alpha[40][3] ^= 1;
+}
+
+static void report(const char* what, const char* verb, size_t done, size_t total, uint64_t ns) {
+  const double sec = (double)ns / 1e9;
+  printf("%-9s %zu/%zu %s, %8.0f proofs/s, %7.1f us each\n", what, done, total, verb,
+         sec > 0 ? (double)total / sec : 0.0, total ? sec * 1e6 / (double)total : 0.0);
+}
+
+int main(void) {
+  const size_t n = BLOCK_VERIFIERS_TOTAL_AMOUNT;
+  const size_t total = BENCH_ROUNDS * n;
+  unsigned char proof[crypto_vrf_PROOFBYTES];
+  unsigned char beta[crypto_vrf_OUTPUTBYTES];
+
+  if (!vrf_known_answer_test()) {
+    fprintf(stderr, "VRF known-answer test failed for the " VRF_FIELD_BACKEND " field backend\n");
+    return 1;
+  }
+  printf("known-answer test passed (%s field backend)\n", VRF_FIELD_BACKEND);
+
+  if (!build_round()) {
+    fprintf(stderr, "could not create the test keys and proofs\n");
+    return 1;
+  }
+  check_batch_matches_single();
+  if (test_failures) return 1;
+
+  size_t proved = 0;
+  uint64_t t0 = test_now_ns();
+  for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+    for (size_t i = 0; i < n; i++) proved += (crypto_vrf_prove(proof, sk, alpha[i], sizeof(alpha[i])) == 0);
+  }
+  report("prove", "made", proved, total, test_now_ns() - t0);
+
+  size_t ok = 0;
+  t0 = test_now_ns();
+  for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+    for (size_t i = 0; i < n; i++) {
+      ok += (crypto_vrf_verify(beta, pks + i * crypto_vrf_PUBLICKEYBYTES, proofs + i * crypto_vrf_PROOFBYTES,
+                               msgs[i], msg_lens[i]) == 0);
+    }
+  }
+  report("per-proof", "valid", ok, total, test_now_ns() - t0);
+
+  size_t batch_ok = 0;
+  t0 = test_now_ns();
+  for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+    batch_ok += crypto_vrf_verify_batch(outputs, pks, proofs, msgs, msg_lens, n, results);
+  }
+  report("batch", "valid", batch_ok, total, test_now_ns() - t0);
+
+  // same batch with every key already decoded, as after fill_delegates_from_db
+  size_t cached_ok = 0;
+  crypto_vrf_key_cache_set(pks, n);
+  t0 = test_now_ns();
+  for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+    cached_ok += crypto_vrf_verify_batch(outputs, pks, proofs, msgs, msg_lens, n, results);
+  }
+  report("cached", "valid", cached_ok, total, test_now_ns() - t0);
+  crypto_vrf_key_cache_set(pks, 0);
+
+  CHECK(proved == total && ok == total && batch_ok == total && cached_ok == total,
+        "timed runs: %zu made, %zu / %zu / %zu valid of %zu", proved, ok, batch_ok, cached_ok, total);
+  return test_failures ? 1 : 0;
+}